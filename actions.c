@@ -30,6 +30,7 @@
 #include "actions.h"
 #include "gpio.h"
 #include "toolbar.h"
+#include "rigctl.h"
 #ifdef LOCALCW
 #include "iambic.h"
 #endif
@@ -238,11 +239,169 @@ static inline double KnobOrWheel(PROCESS_ACTION *a, double oldval, double minval
 }
 
 //
-// This interface puts an "action" into the GTK idle queue,
-// but CW actions are processed immediately
+// The action queue
+//
+// Encoders, MIDI wheels and MIDI knobs produce up to several hundred
+// events per second. Instead of putting each of them into the GTK idle
+// queue, all events go into one queue and are processed in the order they
+// arrived by a single dispatcher (action_dispatch). It is a GTK idle
+// callback, and thus runs after the screen has been redrawn: everything
+// that arrives while a frame is drawn is processed in one go.
+//
+// An event of a wheel or knob is merged into the latest queued event of
+// the same action, even if events of other wheels or knobs came in
+// between, as long as no PRESSED/RELEASED event has been queued since
+// (queue_barrier), so these keep their place relative to the wheels:
+//  - RELATIVE values (wheels, encoders) are summed up
+//  - ABSOLUTE values (knobs) only keep the latest value
+//
+// The producers (MIDI, GPIO/I2C, toolbar) may run in any thread. They
+// hold action_mutex only to put an event into the queue. If the queue
+// is full, it is doubled, so no event is lost or reordered.
+//
+#define ACTION_QUEUE_SIZE 256   // initial size, power of two
+
+typedef struct _queued_action {
+  enum ACTION_SOURCE source;
+  PROCESS_ACTION action;
+} QUEUED_ACTION;
+
+static GMutex action_mutex;
+static QUEUED_ACTION *action_queue=NULL;
+static guint queue_size=0;
+static guint queue_head=0;              // next position to write
+static guint queue_tail=0;              // next position to read
+static guint queue_barrier=0;           // position after the latest PRESSED/RELEASED event
+static guint last_position[ACTIONS];    // latest wheel or knob event of each action
+static gboolean dispatch_scheduled=FALSE;
+
+//
+// Statistics per source: events received, events merged into a queued
+// event of the same wheel or knob, and how often the queue was doubled
+// because it was full
+//
+static gint source_events[ACTION_SOURCES];
+static gint source_coalesced[ACTION_SOURCES];
+static gint source_overflows[ACTION_SOURCES];
+
+static const char *source_name[ACTION_SOURCES]={"GPIO", "MIDI", "toolbar"};
+
+//
+// Double the queue, the positions of the queued events stay valid.
+// Called with action_mutex held.
 //
-void schedule_action(enum ACTION action, enum ACTION_MODE mode, gint val) {
+static void action_queue_grow() {
+  QUEUED_ACTION *queue;
+  guint size=queue_size ? 2*queue_size : ACTION_QUEUE_SIZE;
+  guint pos;
+
+  queue=g_new(QUEUED_ACTION, size);
+  for(pos=queue_tail;pos!=queue_head;pos++) {
+    queue[pos & (size-1)]=action_queue[pos & (queue_size-1)];
+  }
+  g_free(action_queue);
+  action_queue=queue;
+  queue_size=size;
+}
+
+//
+// Merge a wheel or knob event into the latest queued event of the same
+// action, if there is one after queue_barrier. Called with action_mutex held.
+//
+static gboolean action_queue_merge(enum ACTION action, enum ACTION_MODE mode, gint val) {
+  guint pos=last_position[action];
+  QUEUED_ACTION *q;
+
+  if(pos-queue_tail>=queue_head-queue_tail) return FALSE;        // processed
+  if(pos-queue_barrier>=queue_head-queue_barrier) return FALSE;  // before a key event
+  q=&action_queue[pos & (queue_size-1)];
+  if(q->action.action!=action || q->action.mode!=mode) return FALSE;
+  if(mode==RELATIVE) {
+    q->action.val+=val;
+  } else {
+    q->action.val=val;
+  }
+  return TRUE;
+}
+
+static void action_queue_put(enum ACTION_SOURCE source, enum ACTION action, enum ACTION_MODE mode, gint val) {
+  QUEUED_ACTION *q;
+
+  source_events[source]++;
+  if((mode==RELATIVE || mode==ABSOLUTE) && action_queue_merge(action, mode, val)) {
+    source_coalesced[source]++;
+    return;
+  }
+  if(queue_head-queue_tail>=queue_size) {
+    if(queue_size!=0) source_overflows[source]++;
+    action_queue_grow();
+  }
+  q=&action_queue[queue_head & (queue_size-1)];
+  q->source=source;
+  q->action.action=action;
+  q->action.mode=mode;
+  q->action.val=val;
+  if(mode==RELATIVE || mode==ABSOLUTE) {
+    last_position[action]=queue_head;
+    queue_head++;
+  } else {
+    queue_head++;
+    queue_barrier=queue_head;
+  }
+}
+
+static int action_dispatch(gpointer data) {
   PROCESS_ACTION *a;
+
+  g_mutex_lock(&action_mutex);
+  dispatch_scheduled=FALSE;
+  while(queue_tail!=queue_head) {
+    a=g_new(PROCESS_ACTION, 1);
+    *a=action_queue[queue_tail & (queue_size-1)].action;
+    queue_tail++;
+    g_mutex_unlock(&action_mutex);
+    if(a->mode==RELATIVE && a->val==0) {
+      // the steps of a wheel cancelled out
+      g_free(a);
+    } else {
+      process_action(a);
+    }
+    g_mutex_lock(&action_mutex);
+  }
+  g_mutex_unlock(&action_mutex);
+
+  //
+  // CAT queries answered from the rigctl state snapshot must see
+  // the result
+  //
+  rigctl_publish_state();
+  return FALSE;
+}
+
+void action_queue_stats(enum ACTION_SOURCE source, int *events, int *coalesced, int *overflows) {
+  g_mutex_lock(&action_mutex);
+  *events=source_events[source];
+  *coalesced=source_coalesced[source];
+  *overflows=source_overflows[source];
+  g_mutex_unlock(&action_mutex);
+}
+
+void action_queue_report() {
+  int i, events, coalesced, overflows;
+
+  for(i=0;i<ACTION_SOURCES;i++) {
+    action_queue_stats(i, &events, &coalesced, &overflows);
+    if(events==0) continue;
+    g_print("%s: %-7s events=%d coalesced=%d overflows=%d\n",
+            __FUNCTION__, source_name[i], events, coalesced, overflows);
+  }
+}
+
+//
+// This interface puts an "action" into the action queue,
+// but CW actions are processed immediately
+//
+void schedule_action(enum ACTION_SOURCE source, enum ACTION action, enum ACTION_MODE mode, gint val) {
   switch (action) {
     case CW_LEFT:
     case CW_RIGHT:
@@ -268,14 +427,13 @@ void schedule_action(enum ACTION action, enum ACTION_MODE mode, gint val) {
       }
       break;
     default:
-      //
-      // schedule action through GTK idle queue
-      //
-      a=g_new(PROCESS_ACTION, 1);
-      a->action=action;
-      a->mode=mode;
-      a->val=val;
-      g_idle_add(process_action, a);
+      g_mutex_lock(&action_mutex);
+      action_queue_put(source, action, mode, val);
+      if(!dispatch_scheduled) {
+        dispatch_scheduled=TRUE;
+        g_idle_add(action_dispatch, NULL);
+      }
+      g_mutex_unlock(&action_mutex);
       break;
   }
 }
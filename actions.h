@@ -185,6 +185,18 @@ typedef struct process_action {
 
 extern ACTION_TABLE ActionTable[ACTIONS+1];
 
+//
+// Where an action comes from (statistics of the action queue)
+//
+enum ACTION_SOURCE {
+  SOURCE_GPIO,     // GPIO and I2C controller
+  SOURCE_MIDI,
+  SOURCE_TOOLBAR,
+  ACTION_SOURCES
+};
+
 extern int process_action(void *data);
-extern void schedule_action(enum ACTION action, enum ACTION_MODE mode, gint val);
+extern void schedule_action(enum ACTION_SOURCE source, enum ACTION action, enum ACTION_MODE mode, gint val);
+extern void action_queue_stats(enum ACTION_SOURCE source, int *events, int *coalesced, int *overflows);
+extern void action_queue_report(void);
 
@@ -0,0 +1,358 @@
+/*
+ * File audio_codec.c
+ *
+ * Low bit rate formats for the remote audio stream, see audio_codec.h.
+ *
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "audio_codec.h"
+
+//
+// Max. number of frames per call of audio_encode/audio_decode
+//
+#define AUDIO_CODEC_MAX_FRAMES 4096
+
+#define ULAW_BIAS 0x84
+#define ULAW_CLIP 32635
+
+static const int adpcm_index_table[16] = {
+  -1, -1, -1, -1, 2, 4, 6, 8,
+  -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int adpcm_step_table[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+  19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+  130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+  337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+  876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+  2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+  5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+const char *audio_codec_name(int codec) {
+  switch (codec) {
+    case AUDIO_CODEC_PCM:   return "PCM";
+    case AUDIO_CODEC_ULAW:  return "mu-law";
+    case AUDIO_CODEC_ADPCM: return "IMA-ADPCM";
+  }
+  return "unknown";
+}
+
+static short clip(float v) {
+  if (v > 32767.0f) return 32767;
+  if (v < -32768.0f) return -32768;
+  return (short) lrintf(v);
+}
+
+//
+// Windowed-sinc low pass with the cutoff at 45% of the output sample rate
+//
+static void design_lowpass(float *h, int taps, int decimation) {
+  double fc=0.45/(double) decimation;
+  double sum=0.0;
+  double m=0.5*(double)(taps-1);
+  int i;
+
+  for (i=0; i<taps; i++) {
+    double x=(double) i - m;
+    double s=(x == 0.0) ? 2.0*fc : sin(2.0*M_PI*fc*x)/(M_PI*x);
+    double w=0.54 - 0.46*cos(2.0*M_PI*(double) i/(double)(taps-1));
+    h[i]=(float)(s*w);
+    sum+=s*w;
+  }
+  for (i=0; i<taps; i++) h[i]=(float)(h[i]/sum);
+}
+
+static int check_format(int codec, int rate, int channels) {
+  int decimation;
+  if (codec < 0 || codec >= AUDIO_CODECS) return -1;
+  if (channels != 1 && channels != 2) return -1;
+  if (rate <= 0 || AUDIO_CODEC_INPUT_RATE % rate != 0) return -1;
+  decimation=AUDIO_CODEC_INPUT_RATE/rate;
+  if (decimation > AUDIO_CODEC_MAX_DECIMATION) return -1;
+  return decimation;
+}
+
+int audio_encoder_init(AUDIO_ENCODER *encoder, int codec, int rate, int channels) {
+  int decimation=check_format(codec, rate, channels);
+  if (decimation < 0) return -1;
+  memset(encoder, 0, sizeof(AUDIO_ENCODER));
+  encoder->codec=codec;
+  encoder->rate=rate;
+  encoder->channels=channels;
+  encoder->decimation=decimation;
+  encoder->taps=AUDIO_CODEC_TAPS_PER_PHASE*decimation;
+  if (decimation > 1) design_lowpass(encoder->filter, encoder->taps, decimation);
+  return 0;
+}
+
+int audio_decoder_init(AUDIO_DECODER *decoder, int codec, int rate, int channels) {
+  int decimation=check_format(codec, rate, channels);
+  if (decimation < 0) return -1;
+  memset(decoder, 0, sizeof(AUDIO_DECODER));
+  decoder->codec=codec;
+  decoder->rate=rate;
+  decoder->channels=channels;
+  decoder->interpolation=decimation;
+  decoder->taps=AUDIO_CODEC_TAPS_PER_PHASE*decimation;
+  if (decimation > 1) design_lowpass(decoder->filter, decoder->taps, decimation);
+  return 0;
+}
+
+static unsigned char ulaw_encode(short sample) {
+  int s=sample;
+  int sign=0;
+  int exponent, mantissa, mask;
+
+  if (s < 0) {
+    sign=0x80;
+    s=-s;
+  }
+  if (s > ULAW_CLIP) s=ULAW_CLIP;
+  s+=ULAW_BIAS;
+  exponent=7;
+  for (mask=0x4000; !(s & mask) && exponent > 0; mask>>=1) exponent--;
+  mantissa=(s >> (exponent+3)) & 0x0F;
+  return (unsigned char) ~(sign | (exponent << 4) | mantissa);
+}
+
+static short ulaw_decode(unsigned char u) {
+  int sign, exponent, mantissa, s;
+  u=~u;
+  sign=u & 0x80;
+  exponent=(u >> 4) & 0x07;
+  mantissa=u & 0x0F;
+  s=(((mantissa << 3) + ULAW_BIAS) << exponent) - ULAW_BIAS;
+  return (short)(sign ? -s : s);
+}
+
+static int adpcm_encode_sample(ADPCM_STATE *state, short sample) {
+  int step=adpcm_step_table[state->index];
+  int diff=sample - state->predictor;
+  int code=0;
+  int vpdiff=step >> 3;
+
+  if (diff < 0) {
+    code=8;
+    diff=-diff;
+  }
+  if (diff >= step) {
+    code|=4;
+    diff-=step;
+    vpdiff+=step;
+  }
+  step>>=1;
+  if (diff >= step) {
+    code|=2;
+    diff-=step;
+    vpdiff+=step;
+  }
+  step>>=1;
+  if (diff >= step) {
+    code|=1;
+    vpdiff+=step;
+  }
+  if (code & 8) {
+    state->predictor-=vpdiff;
+  } else {
+    state->predictor+=vpdiff;
+  }
+  if (state->predictor > 32767) state->predictor=32767;
+  if (state->predictor < -32768) state->predictor=-32768;
+  state->index+=adpcm_index_table[code];
+  if (state->index < 0) state->index=0;
+  if (state->index > 88) state->index=88;
+  return code;
+}
+
+static short adpcm_decode_sample(ADPCM_STATE *state, int code) {
+  int step=adpcm_step_table[state->index];
+  int vpdiff=step >> 3;
+
+  if (code & 4) vpdiff+=step;
+  if (code & 2) vpdiff+=step >> 1;
+  if (code & 1) vpdiff+=step >> 2;
+  if (code & 8) {
+    state->predictor-=vpdiff;
+  } else {
+    state->predictor+=vpdiff;
+  }
+  if (state->predictor > 32767) state->predictor=32767;
+  if (state->predictor < -32768) state->predictor=-32768;
+  state->index+=adpcm_index_table[code];
+  if (state->index < 0) state->index=0;
+  if (state->index > 88) state->index=88;
+  return (short) state->predictor;
+}
+
+int audio_encode(AUDIO_ENCODER *e, const short *in, int frames, unsigned char *out, int *samples) {
+  short buffer[2][AUDIO_CODEC_MAX_FRAMES];
+  unsigned char *p=out;
+  int i, c, n=0;
+
+  if (frames > AUDIO_CODEC_MAX_FRAMES) frames=AUDIO_CODEC_MAX_FRAMES;
+
+  //
+  // downmix and decimate
+  //
+  for (i=0; i<frames; i++) {
+    float x[2];
+    if (e->channels == 1) {
+      x[0]=0.5f*((float) in[2*i] + (float) in[2*i+1]);
+    } else {
+      x[0]=(float) in[2*i];
+      x[1]=(float) in[2*i+1];
+    }
+    if (e->decimation == 1) {
+      for (c=0; c<e->channels; c++) buffer[c][n]=clip(x[c]);
+      n++;
+      continue;
+    }
+    //
+    // the history is stored twice, so that the last "taps" values
+    // are always contiguous, ending at pos+taps
+    //
+    e->pos++;
+    if (e->pos >= e->taps) e->pos=0;
+    for (c=0; c<e->channels; c++) {
+      e->history[c][e->pos]=x[c];
+      e->history[c][e->pos+e->taps]=x[c];
+    }
+    if (++e->phase < e->decimation) continue;
+    e->phase=0;
+    for (c=0; c<e->channels; c++) {
+      const float *h=&e->history[c][e->pos+e->taps];
+      float sum=0.0f;
+      int k;
+      for (k=0; k<e->taps; k++) sum+=e->filter[k] * h[-k];
+      buffer[c][n]=clip(sum);
+    }
+    n++;
+  }
+  *samples=n;
+
+  switch (e->codec) {
+    case AUDIO_CODEC_PCM:
+      for (i=0; i<n; i++) {
+        for (c=0; c<e->channels; c++) {
+          *p++=(unsigned char)((unsigned short) buffer[c][i] >> 8);
+          *p++=(unsigned char)(buffer[c][i] & 0xFF);
+        }
+      }
+      break;
+    case AUDIO_CODEC_ULAW:
+      for (i=0; i<n; i++) {
+        for (c=0; c<e->channels; c++) *p++=ulaw_encode(buffer[c][i]);
+      }
+      break;
+    case AUDIO_CODEC_ADPCM:
+      //
+      // block header: the coder state before the first sample
+      //
+      for (c=0; c<e->channels; c++) {
+        *p++=(unsigned char)((unsigned int) e->adpcm[c].predictor >> 8);
+        *p++=(unsigned char)(e->adpcm[c].predictor & 0xFF);
+        *p++=(unsigned char) e->adpcm[c].index;
+        *p++=0;
+      }
+      memset(p, 0, (n*e->channels+1)/2);
+      for (i=0; i<n; i++) {
+        for (c=0; c<e->channels; c++) {
+          int nibble=i*e->channels+c;
+          int code=adpcm_encode_sample(&e->adpcm[c], buffer[c][i]);
+          p[nibble >> 1]|=(nibble & 1) ? (code << 4) : code;
+        }
+      }
+      p+=(n*e->channels+1)/2;
+      break;
+  }
+  return (int)(p-out);
+}
+
+int audio_decode(AUDIO_DECODER *d, const unsigned char *in, int length, int samples,
+                 short *out, int max_frames) {
+  short buffer[2][AUDIO_CODEC_MAX_FRAMES];
+  ADPCM_STATE adpcm[2];
+  const unsigned char *p=in;
+  int i, c, needed, frames=0;
+
+  if (samples < 0 || samples > AUDIO_CODEC_MAX_FRAMES) return -1;
+  switch (d->codec) {
+    case AUDIO_CODEC_PCM:   needed=2*samples*d->channels; break;
+    case AUDIO_CODEC_ULAW:  needed=samples*d->channels; break;
+    case AUDIO_CODEC_ADPCM: needed=4*d->channels+(samples*d->channels+1)/2; break;
+    default: return -1;
+  }
+  if (length < needed) return -1;
+
+  switch (d->codec) {
+    case AUDIO_CODEC_PCM:
+      for (i=0; i<samples; i++) {
+        for (c=0; c<d->channels; c++) {
+          buffer[c][i]=(short)((p[0] << 8) | p[1]);
+          p+=2;
+        }
+      }
+      break;
+    case AUDIO_CODEC_ULAW:
+      for (i=0; i<samples; i++) {
+        for (c=0; c<d->channels; c++) buffer[c][i]=ulaw_decode(*p++);
+      }
+      break;
+    case AUDIO_CODEC_ADPCM:
+      for (c=0; c<d->channels; c++) {
+        adpcm[c].predictor=(short)((p[0] << 8) | p[1]);
+        adpcm[c].index=p[2] > 88 ? 88 : p[2];
+        p+=4;
+      }
+      for (i=0; i<samples; i++) {
+        for (c=0; c<d->channels; c++) {
+          int nibble=i*d->channels+c;
+          int code=(nibble & 1) ? (p[nibble >> 1] >> 4) : (p[nibble >> 1] & 0x0F);
+          buffer[c][i]=adpcm_decode_sample(&adpcm[c], code);
+        }
+      }
+      break;
+  }
+
+  //
+  // interpolate to 48 kHz and spread mono to both channels
+  //
+  for (i=0; i<samples; i++) {
+    int phase;
+    if (d->interpolation == 1) {
+      if (frames >= max_frames) break;
+      out[2*frames]=buffer[0][i];
+      out[2*frames+1]=buffer[d->channels-1][i];
+      frames++;
+      continue;
+    }
+    d->pos++;
+    if (d->pos >= AUDIO_CODEC_TAPS_PER_PHASE) d->pos=0;
+    for (c=0; c<d->channels; c++) {
+      d->history[c][d->pos]=(float) buffer[c][i];
+      d->history[c][d->pos+AUDIO_CODEC_TAPS_PER_PHASE]=(float) buffer[c][i];
+    }
+    for (phase=0; phase<d->interpolation; phase++) {
+      float y[2];
+      if (frames >= max_frames) break;
+      for (c=0; c<d->channels; c++) {
+        const float *x=&d->history[c][d->pos+AUDIO_CODEC_TAPS_PER_PHASE];
+        float sum=0.0f;
+        int j;
+        for (j=0; j<AUDIO_CODEC_TAPS_PER_PHASE; j++) sum+=d->filter[phase+j*d->interpolation] * x[-j];
+        y[c]=sum * (float) d->interpolation;
+      }
+      out[2*frames]=clip(y[0]);
+      out[2*frames+1]=clip(y[d->channels-1]);
+      frames++;
+    }
+  }
+  return frames;
+}
@@ -0,0 +1,91 @@
+/*
+ * File audio_codec.h
+ *
+ * Low bit rate formats for the remote audio stream of the client/server mode.
+ *
+ * The receiver audio (48 kHz stereo, 16 bit) can be
+ *
+ * - downmixed to mono
+ * - decimated to 16 or 8 kHz (enough for SSB and CW)
+ * - coded as 16-bit PCM, G.711 mu-law (8 bit) or IMA-ADPCM (4 bit)
+ *
+ * At 8 kHz mono, IMA-ADPCM needs 32 kbit/s instead of 1.5 Mbit/s.
+ * Each ADPCM block carries the coder state, so a block that is dropped
+ * on the way does not disturb the following ones.
+ *
+ */
+
+#ifndef _AUDIO_CODEC_H
+#define _AUDIO_CODEC_H
+
+enum {
+  AUDIO_CODEC_PCM,
+  AUDIO_CODEC_ULAW,
+  AUDIO_CODEC_ADPCM,
+  AUDIO_CODECS
+};
+
+#define AUDIO_CODEC_INPUT_RATE 48000
+#define AUDIO_CODEC_MAX_DECIMATION 6
+#define AUDIO_CODEC_TAPS_PER_PHASE 16
+#define AUDIO_CODEC_MAX_TAPS (AUDIO_CODEC_TAPS_PER_PHASE*AUDIO_CODEC_MAX_DECIMATION)
+
+//
+// Max. size of an encoded block of "frames" input frames
+//
+#define AUDIO_CODEC_MAX_BYTES(frames) ((frames)*4+8)
+
+typedef struct _adpcm_state {
+  int predictor;
+  int index;
+} ADPCM_STATE;
+
+typedef struct _audio_encoder {
+  int codec;
+  int rate;
+  int channels;
+  int decimation;
+  int taps;
+  int phase;
+  int pos;
+  float filter[AUDIO_CODEC_MAX_TAPS];
+  float history[2][2*AUDIO_CODEC_MAX_TAPS];
+  ADPCM_STATE adpcm[2];
+} AUDIO_ENCODER;
+
+typedef struct _audio_decoder {
+  int codec;
+  int rate;
+  int channels;
+  int interpolation;
+  int taps;
+  int pos;
+  float filter[AUDIO_CODEC_MAX_TAPS];
+  float history[2][2*AUDIO_CODEC_TAPS_PER_PHASE];
+} AUDIO_DECODER;
+
+extern const char *audio_codec_name(int codec);
+
+//
+// rate must be 48000 divided by 1...AUDIO_CODEC_MAX_DECIMATION, channels 1 or 2.
+// Returns -1 if the format is not supported.
+//
+extern int audio_encoder_init(AUDIO_ENCODER *encoder, int codec, int rate, int channels);
+extern int audio_decoder_init(AUDIO_DECODER *decoder, int codec, int rate, int channels);
+
+//
+// Encode "frames" stereo 48 kHz frames (interleaved). Returns the number
+// of bytes written to out, *samples is the number of samples per channel
+// in the encoded block (after decimation).
+//
+extern int audio_encode(AUDIO_ENCODER *encoder, const short *in, int frames, unsigned char *out, int *samples);
+
+//
+// Decode a block of "samples" samples per channel into at most max_frames
+// stereo 48 kHz frames (interleaved). Returns the number of frames, or -1
+// if the block is invalid.
+//
+extern int audio_decode(AUDIO_DECODER *decoder, const unsigned char *in, int length, int samples,
+                        short *out, int max_frames);
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * File bench_stubs.c
+ *
+ * The benchmarks are linked with all objects of piHPSDR except main.o.
+ * This provides what main.c provides for the other modules, and the
+ * clocks of the benchmarks (see bench_stubs.h).
+ *
+ */
+
+#include <gtk/gtk.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+
+#include "main.h"
+#include "bench_stubs.h"
+
+//
+// What main.c provides for the other modules
+//
+struct utsname unameData;
+gint display_width=1024;
+gint display_height=600;
+gint full_screen=0;
+GtkWidget *top_window=NULL;
+GtkWidget *grid=NULL;
+
+void status_text(char *text) {
+  g_print("%s\n",text);
+}
+
+gboolean keypress_cb(GtkWidget *widget, GdkEventKey *event, gpointer data) {
+  return FALSE;
+}
+
+//
+// Wall clock and CPU time of the process, in seconds
+//
+double bench_now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + 1E-9 * (double) ts.tv_nsec;
+}
+
+double bench_cpu_time() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (double) usage.ru_utime.tv_sec + 1E-6 * (double) usage.ru_utime.tv_usec +
+         (double) usage.ru_stime.tv_sec + 1E-6 * (double) usage.ru_stime.tv_usec;
+}
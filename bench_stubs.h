@@ -0,0 +1,15 @@
+/*
+ * File bench_stubs.h
+ *
+ * What the benchmarks (protocol_bench, slice_bench) share: the stubs for
+ * main.c, which they are linked without, and their clocks.
+ *
+ */
+
+#ifndef _BENCH_STUBS_H
+#define _BENCH_STUBS_H
+
+extern double bench_now(void);
+extern double bench_cpu_time(void);
+
+#endif
@@ -0,0 +1,646 @@
+/*
+ * File capture.c
+ *
+ * Recording and replaying the datagrams received from the radio,
+ * see capture.h
+ *
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#ifdef __APPLE__
+#include "MacOS.h"  // emulate clock_gettime on old MacOS systems
+#endif
+
+#include "discovered.h"
+#include "radio.h"
+#include "capture.h"
+
+#define CAPTURE_SLOTS 4096              // datagrams in the ring buffer, power of two
+#define CAPTURE_MAX_PACKET 1500         // longer datagrams are truncated
+#define CAPTURE_INTERVAL 10000          // usec between two writes
+#define CAPTURE_WINDOW (16*1024*1024)   // bytes of the file mapped at once
+#define CAPTURE_SENDERS 16              // addresses counted to find the radio in a capture
+#define CAPTURE_INFO_MAGIC "piHPSDR capture"
+
+#define PCAP_MAGIC_NSEC 0xa1b23c4d
+#define PCAP_MAGIC_USEC 0xa1b2c3d4
+#define PCAP_LINKTYPE_RAW 101
+#define PCAP_RECORD_HEADER 16
+#define IP_UDP_HEADER 28
+
+//
+// The first packet of a recording describes the radio
+//
+typedef struct _capture_info {
+  char magic[16];
+  gint32 protocol;
+  gint32 device;
+  gint32 software_version;
+  gint32 supported_receivers;
+  gint32 adcs;
+  char name[64];
+} CAPTURE_INFO;
+
+typedef struct _capture_slot {
+  gint64 time;
+  guint32 address;
+  guint16 port;
+  guint16 length;
+  unsigned char data[CAPTURE_MAX_PACKET];
+} CAPTURE_SLOT;
+
+volatile gint capture_recording=0;
+volatile gint capture_replaying=0;
+
+static char *capture_file=NULL;
+static char *replay_file=NULL;
+static double replay_speed=1.0;        // 0: as fast as possible
+
+//
+// Recording: the receive thread is the only producer and
+// capture_thread the only consumer of the ring buffer
+//
+static CAPTURE_SLOT *ring=NULL;
+static volatile gint ring_head=0;      // next slot to fill
+static volatile gint ring_tail=0;      // next slot to write to the file
+static volatile gint capture_drops=0;  // datagrams not recorded because the ring was full
+static GThread *capture_thread_id=NULL;
+
+static int capture_fd=-1;
+static unsigned char *window=NULL;     // mapped part of the file
+static off_t window_start=0;
+static off_t file_offset=0;            // bytes written
+static long pagesize;
+
+//
+// Replay
+//
+static CAPTURE_PACKET *replay_packets=NULL;
+static int replay_count=0;
+static int replay_next=0;
+static int replay_device=-1;           // index in discovered[]
+static gint64 replay_start=0;          // CLOCK_MONOTONIC nsec when the replay started
+static gint64 replay_offset=0;         // capture nsec to add for the current loop
+static long replay_loops=0;
+
+static gint64 monotonic_nsec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec*1000000000LL+(gint64)ts.tv_nsec;
+}
+
+void capture_init() {
+  const char *env;
+  char *comma;
+
+  env=getenv("PIHPSDR_CAPTURE");
+  if(env!=NULL && *env!='\0') {
+    capture_file=g_strdup(env);
+    g_print("%s: datagrams will be recorded to %s\n",__FUNCTION__,capture_file);
+  }
+  env=getenv("PIHPSDR_REPLAY");
+  if(env!=NULL && *env!='\0') {
+    replay_file=g_strdup(env);
+    comma=strrchr(replay_file, ',');
+    if(comma!=NULL) {
+      *comma='\0';
+      replay_speed=strcmp(comma+1, "max")==0 ? 0.0 : atof(comma+1);
+      if(replay_speed<0.0) replay_speed=0.0;
+    }
+    g_print("%s: replay of %s, speed %g\n",__FUNCTION__,replay_file,replay_speed);
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+/* Recording                                                               */
+/* ---------------------------------------------------------------------- */
+
+//
+// Hot path: one copy into the ring buffer, no system call except
+// clock_gettime (which is a vDSO call), no lock
+//
+void capture_packet(const unsigned char *data, int length, const struct sockaddr_in *from) {
+  gint head=g_atomic_int_get(&ring_head);
+  CAPTURE_SLOT *slot;
+  struct timespec ts;
+
+  if((guint)head-(guint)g_atomic_int_get(&ring_tail) >= CAPTURE_SLOTS) {
+    g_atomic_int_inc(&capture_drops);
+    return;
+  }
+  slot=&ring[head & (CAPTURE_SLOTS-1)];
+  clock_gettime(CLOCK_REALTIME, &ts);
+  if(length>CAPTURE_MAX_PACKET) length=CAPTURE_MAX_PACKET;
+  slot->time=(gint64)ts.tv_sec*1000000000LL+(gint64)ts.tv_nsec;
+  slot->address=from->sin_addr.s_addr;
+  slot->port=ntohs(from->sin_port);
+  slot->length=length;
+  memcpy(slot->data, data, length);
+  g_atomic_int_set(&ring_head, (gint)((guint)head+1));
+}
+
+//
+// Returns a pointer to the next "size" bytes of the file, moving
+// the mapped window if necessary. The file has been extended to the
+// end of the window before.
+//
+static unsigned char *capture_space(int size) {
+  unsigned char *p;
+
+  if(window==NULL || file_offset+size > window_start+CAPTURE_WINDOW) {
+    if(window!=NULL) munmap(window, CAPTURE_WINDOW);
+    window_start=file_offset & ~(off_t)(pagesize-1);
+    if(ftruncate(capture_fd, window_start+CAPTURE_WINDOW)<0) {
+      perror("capture: ftruncate");
+      window=NULL;
+      return NULL;
+    }
+    window=mmap(NULL, CAPTURE_WINDOW, PROT_READ|PROT_WRITE, MAP_SHARED, capture_fd, window_start);
+    if(window==MAP_FAILED) {
+      perror("capture: mmap");
+      window=NULL;
+      return NULL;
+    }
+  }
+  p=window+(file_offset-window_start);
+  file_offset+=size;
+  return p;
+}
+
+static void put16(unsigned char *p, int value) {
+  p[0]=(value>>8)&0xFF;
+  p[1]=value&0xFF;
+}
+
+//
+// Write one datagram as a pcap record with IPv4 and UDP header
+//
+static int capture_write(gint64 time, guint32 address, int port, const unsigned char *data, int length) {
+  unsigned char *p=capture_space(PCAP_RECORD_HEADER+IP_UDP_HEADER+length);
+  guint32 record[4];
+  guint32 sum=0;
+  int i;
+
+  if(p==NULL) return -1;
+  record[0]=(guint32)(time/1000000000LL);
+  record[1]=(guint32)(time%1000000000LL);
+  record[2]=IP_UDP_HEADER+length;
+  record[3]=IP_UDP_HEADER+length;
+  memcpy(p, record, sizeof(record));
+  p+=PCAP_RECORD_HEADER;
+
+  memset(p, 0, IP_UDP_HEADER);
+  p[0]=0x45;                            // IPv4, 20 bytes header
+  put16(p+2, IP_UDP_HEADER+length);
+  p[6]=0x40;                            // don't fragment
+  p[8]=64;                              // TTL
+  p[9]=17;                              // UDP
+  memcpy(p+12, &address, 4);            // source, the destination is not known
+  for(i=0;i<20;i+=2) sum+=(p[i]<<8)|p[i+1];
+  while(sum>>16) sum=(sum&0xFFFF)+(sum>>16);
+  put16(p+10, ~sum & 0xFFFF);
+  put16(p+20, port);
+  put16(p+24, 8+length);
+  memcpy(p+IP_UDP_HEADER, data, length);
+  return 0;
+}
+
+//
+// Write everything in the ring buffer to the file. The file is then
+// truncated to what has been written, so it is a valid capture between
+// two writes.
+//
+static void capture_flush() {
+  gint head=g_atomic_int_get(&ring_head);
+  gint tail=g_atomic_int_get(&ring_tail);
+  CAPTURE_SLOT *slot;
+
+  if(head==tail) return;
+  if(window!=NULL && ftruncate(capture_fd, window_start+CAPTURE_WINDOW)<0) {
+    perror("capture: ftruncate");
+  }
+  while(tail!=head) {
+    slot=&ring[tail & (CAPTURE_SLOTS-1)];
+    if(capture_write(slot->time, slot->address, slot->port, slot->data, slot->length)<0) {
+      g_print("%s: recording stopped after %ld bytes\n",__FUNCTION__,(long)file_offset);
+      g_atomic_int_set(&capture_recording, 0);
+      break;
+    }
+    tail++;
+    g_atomic_int_set(&ring_tail, tail);
+  }
+  if(ftruncate(capture_fd, file_offset)<0) {
+    perror("capture: ftruncate");
+  }
+}
+
+static gpointer capture_thread(gpointer arg) {
+  gint drops, reported=0;
+
+  g_print("%s: recording to %s\n",__FUNCTION__,capture_file);
+  while(g_atomic_int_get(&capture_recording)) {
+    g_usleep(CAPTURE_INTERVAL);
+    capture_flush();
+    drops=g_atomic_int_get(&capture_drops);
+    if(drops!=reported) {
+      g_print("%s: %d datagrams not recorded (ring buffer full)\n",__FUNCTION__,drops);
+      reported=drops;
+    }
+  }
+  return NULL;
+}
+
+static int capture_open() {
+  guint32 header[6];
+  CAPTURE_INFO info;
+  unsigned char *p;
+
+  pagesize=sysconf(_SC_PAGESIZE);
+  capture_fd=open(capture_file, O_RDWR|O_CREAT|O_TRUNC, 0644);
+  if(capture_fd<0) {
+    perror(capture_file);
+    return -1;
+  }
+  file_offset=0;
+  window=NULL;
+
+  // pcap file header, in host byte order
+  header[0]=PCAP_MAGIC_NSEC;
+  header[1]=2 | (4<<16);                // version 2.4
+  header[2]=0;                          // time zone
+  header[3]=0;                          // accuracy
+  header[4]=65535;                      // max. length of a packet
+  header[5]=PCAP_LINKTYPE_RAW;
+  p=capture_space(sizeof(header));
+  if(p==NULL) return -1;
+  memcpy(p, header, sizeof(header));
+
+  memset(&info, 0, sizeof(info));
+  strcpy(info.magic, CAPTURE_INFO_MAGIC);
+  info.protocol=radio->protocol;
+  info.device=radio->device;
+  info.software_version=radio->software_version;
+  info.supported_receivers=radio->supported_receivers;
+  info.adcs=radio->adcs;
+  g_strlcpy(info.name, radio->name, sizeof(info.name));
+  if(capture_write(g_get_real_time()*1000LL, radio->info.network.address.sin_addr.s_addr, 0,
+                   (unsigned char *)&info, sizeof(info))<0) {
+    return -1;
+  }
+  if(ftruncate(capture_fd, file_offset)<0) {
+    perror("capture: ftruncate");
+  }
+  return 0;
+}
+
+//
+// Called when the radio is started, before the protocol
+//
+void capture_start() {
+  if(replay_device>=0 && radio==&discovered[replay_device]) {
+    replay_next=0;
+    replay_start=0;
+    replay_offset=0;
+    replay_loops=0;
+    g_atomic_int_set(&capture_replaying, 1);
+    g_print("%s: replaying %d datagrams of %s\n",__FUNCTION__,replay_count,replay_file);
+    return;
+  }
+  if(capture_file==NULL || capture_thread_id!=NULL) return;
+  if(capture_open()<0) {
+    g_print("%s: cannot record to %s\n",__FUNCTION__,capture_file);
+    capture_stop();
+    return;
+  }
+  if(ring==NULL) {
+    ring=g_new(CAPTURE_SLOT, CAPTURE_SLOTS);
+    memset(ring, 0, CAPTURE_SLOTS*sizeof(CAPTURE_SLOT));   // page faults now, not in the receive thread
+  }
+  g_atomic_int_set(&capture_drops, 0);
+  g_atomic_int_set(&capture_recording, 1);
+  capture_thread_id=g_thread_new("capture", capture_thread, NULL);
+}
+
+//
+// Called when the radio is stopped or piHPSDR exits, after the protocol.
+// The ring is kept (and used again by the next capture_start), since a
+// receive thread that is not joined by the protocol may still be in
+// capture_packet.
+//
+void capture_stop() {
+  if(capture_thread_id!=NULL) {
+    g_atomic_int_set(&capture_recording, 0);
+    g_thread_join(capture_thread_id);
+    capture_thread_id=NULL;
+    capture_flush();
+    g_print("%s: %ld bytes recorded to %s, %d datagrams not recorded\n",__FUNCTION__,
+            (long)file_offset,capture_file,g_atomic_int_get(&capture_drops));
+  }
+  if(window!=NULL) {
+    munmap(window, CAPTURE_WINDOW);
+    window=NULL;
+  }
+  if(capture_fd>=0) {
+    if(ftruncate(capture_fd, file_offset)<0) {
+      perror("capture: ftruncate");
+    }
+    close(capture_fd);
+    capture_fd=-1;
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+/* Reading and replaying                                                   */
+/* ---------------------------------------------------------------------- */
+
+static unsigned int get16(const unsigned char *p) {
+  return (p[0]<<8) | p[1];
+}
+
+static guint32 get32(const unsigned char *p, int swap) {
+  guint32 value;
+  memcpy(&value, p, 4);
+  return swap ? GUINT32_SWAP_LE_BE(value) : value;
+}
+
+//
+// A capture made with tcpdump also holds what the computer sent to the
+// radio, and its ports are those of the radio. The radio is the address
+// that sent the most datagrams (the IQ streams); datagrams from other
+// addresses are dropped. Returns the number of datagrams kept.
+//
+static int capture_radio_only(CAPTURE_PACKET *packets, int n) {
+  guint32 sender[CAPTURE_SENDERS];
+  int sent[CAPTURE_SENDERS];
+  int senders=0;
+  guint32 radio=0;
+  int best=0;
+  int i, j, kept=0;
+
+  for(i=0;i<n;i++) {
+    for(j=0;j<senders && sender[j]!=packets[i].address;j++);
+    if(j==senders) {
+      if(senders==CAPTURE_SENDERS) continue;
+      sender[senders]=packets[i].address;
+      sent[senders++]=0;
+    }
+    if(++sent[j]>best) {
+      best=sent[j];
+      radio=sender[j];
+    }
+  }
+
+  for(i=0;i<n;i++) {
+    if(packets[i].address==radio) packets[kept++]=packets[i];
+  }
+  if(kept<n) {
+    g_print("%s: %d datagrams not from the radio dropped\n",__FUNCTION__,n-kept);
+  }
+  return kept;
+}
+
+CAPTURE_PACKET *capture_read(const char *filename, int *count) {
+  int fd;
+  struct stat st;
+  const unsigned char *file, *end, *p, *ip, *udp;
+  guint32 magic, linktype, length;
+  int swap, nsec, offset, ethertype;
+  CAPTURE_PACKET *packets=NULL;
+  int n=0;
+
+  *count=0;
+  fd=open(filename, O_RDONLY);
+  if(fd<0) {
+    perror(filename);
+    return NULL;
+  }
+  if(fstat(fd, &st)<0 || st.st_size<24) {
+    g_print("%s: %s is not a capture\n",__FUNCTION__,filename);
+    close(fd);
+    return NULL;
+  }
+  file=mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(file==MAP_FAILED) {
+    perror(filename);
+    return NULL;
+  }
+  end=file+st.st_size;
+
+  magic=get32(file, 0);
+  swap=(magic==GUINT32_SWAP_LE_BE(PCAP_MAGIC_NSEC) || magic==GUINT32_SWAP_LE_BE(PCAP_MAGIC_USEC));
+  if(swap) magic=GUINT32_SWAP_LE_BE(magic);
+  if(magic!=PCAP_MAGIC_NSEC && magic!=PCAP_MAGIC_USEC) {
+    g_print("%s: %s is not a pcap file\n",__FUNCTION__,filename);
+    munmap((void *)file, st.st_size);
+    return NULL;
+  }
+  nsec=(magic==PCAP_MAGIC_NSEC);
+  linktype=get32(file+20, swap);
+
+  p=file+24;
+  while(p+PCAP_RECORD_HEADER<=end) {
+    gint64 time=(gint64)get32(p, swap)*1000000000LL+(gint64)get32(p+4, swap)*(nsec?1:1000);
+    length=get32(p+8, swap);
+    p+=PCAP_RECORD_HEADER;
+    if(p+length>end) break;
+    //
+    // link layer header
+    //
+    switch(linktype) {
+      case 0:    // BSD loopback
+        offset=4; ethertype=0x0800; break;
+      case 1:    // Ethernet
+        offset=14; ethertype=length>=14 ? get16(p+12) : 0;
+        if(ethertype==0x8100 && length>=18) {
+          offset=18; ethertype=get16(p+16);
+        }
+        break;
+      case 12:   // raw IP
+      case PCAP_LINKTYPE_RAW:
+        offset=0; ethertype=0x0800; break;
+      case 113:  // Linux "cooked"
+        offset=16; ethertype=length>=16 ? get16(p+14) : 0; break;
+      case 276:  // Linux "cooked" v2
+        offset=20; ethertype=length>=20 ? get16(p) : 0; break;
+      default:
+        g_print("%s: %s: link type %d not supported\n",__FUNCTION__,filename,linktype);
+        munmap((void *)file, st.st_size);
+        g_free(packets);
+        return NULL;
+    }
+    ip=p+offset;
+    p+=length;
+    if(ethertype!=0x0800 || (int)length<offset+IP_UDP_HEADER) continue;
+    if((ip[0]>>4)!=4 || ip[9]!=17) continue;             // IPv4, UDP
+    if((get16(ip+6) & 0x3FFF)!=0) continue;              // fragment
+    udp=ip+(ip[0]&0x0F)*4;
+    if(udp+8>p || udp+get16(udp+4)>p || get16(udp+4)<8) continue;
+
+    if((n&1023)==0) packets=g_renew(CAPTURE_PACKET, packets, n+1024);
+    packets[n].data=udp+8;
+    packets[n].length=get16(udp+4)-8;
+    memcpy(&packets[n].address, ip+12, 4);
+    packets[n].port=get16(udp);
+    packets[n].time=time;
+    n++;
+  }
+  n=capture_radio_only(packets, n);
+  *count=n;
+  return packets;
+}
+
+//
+// Offer the capture of PIHPSDR_REPLAY as a radio
+//
+void capture_discovery() {
+  DISCOVERED *d;
+  CAPTURE_INFO info;
+  int i;
+
+  replay_device=-1;
+  if(replay_file==NULL) return;
+  if(replay_packets==NULL) {
+    replay_packets=capture_read(replay_file, &replay_count);
+    if(replay_packets==NULL) {
+      g_free(replay_file);
+      replay_file=NULL;
+      return;
+    }
+  }
+  for(i=0;i<replay_count;i++) {
+    if(replay_packets[i].port!=0) break;
+  }
+  if(i==replay_count) {
+    g_print("%s: no datagrams in %s\n",__FUNCTION__,replay_file);
+    return;
+  }
+  if(devices>=MAX_DEVICES) return;
+
+  d=&discovered[devices];
+  memset(d, 0, sizeof(DISCOVERED));
+  //
+  // A capture not written by piHPSDR (e.g. by tcpdump) does not tell
+  // which radio it is from
+  //
+  d->protocol=NEW_PROTOCOL;
+  for(i=0;i<replay_count;i++) {
+    if(replay_packets[i].port==1024 && replay_packets[i].length==1032 &&
+       replay_packets[i].data[0]==0xEF && replay_packets[i].data[1]==0xFE) {
+      d->protocol=ORIGINAL_PROTOCOL;
+      break;
+    }
+  }
+  d->device=d->protocol==ORIGINAL_PROTOCOL ? DEVICE_HERMES : NEW_DEVICE_ORION2;
+  d->software_version=0;
+  d->supported_receivers=2;
+  d->adcs=1;
+  strcpy(info.name, "capture");
+  for(i=0;i<replay_count;i++) {
+    if(replay_packets[i].port==0 && replay_packets[i].length>=(int)sizeof(info) &&
+       memcmp(replay_packets[i].data, CAPTURE_INFO_MAGIC, sizeof(CAPTURE_INFO_MAGIC))==0) {
+      memcpy(&info, replay_packets[i].data, sizeof(info));
+      info.name[sizeof(info.name)-1]='\0';
+      d->protocol=info.protocol;
+      d->device=info.device;
+      d->software_version=info.software_version;
+      d->supported_receivers=info.supported_receivers;
+      d->adcs=info.adcs;
+      break;
+    }
+  }
+  snprintf(d->name, sizeof(d->name), "Replay %s", info.name);
+  d->frequency_min=0.0;
+  d->frequency_max=61440000.0;
+  d->status=STATE_AVAILABLE;
+  d->use_tcp=0;
+  d->use_routing=1;   // no check of the subnet
+  //
+  // Whatever piHPSDR sends to the "radio" goes to an unused port
+  // of the loopback interface. The MAC address is zero, so the
+  // replay has its own props file.
+  //
+  d->info.network.address.sin_family=AF_INET;
+  d->info.network.address.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+  d->info.network.address.sin_port=htons(1024);
+  d->info.network.address_length=sizeof(struct sockaddr_in);
+  d->info.network.interface_address.sin_family=AF_INET;
+  d->info.network.interface_address.sin_addr.s_addr=htonl(INADDR_ANY);
+  d->info.network.interface_length=sizeof(struct sockaddr_in);
+  d->info.network.interface_netmask.sin_family=AF_INET;
+  strcpy(d->info.network.interface_name, "capture");
+  g_print("%s: %s (protocol %d device %d) with %d datagrams\n",__FUNCTION__,d->name,d->protocol,d->device,replay_count);
+  replay_device=devices++;
+}
+
+//
+// Hand out the next datagrams of the capture, once they are due.
+// Without pacing (speed 0), up to "max" datagrams are returned at once.
+//
+int capture_replay_recv(unsigned char **bufs, int bufsize, int max,
+                        int *lengths, struct sockaddr_in *addrs) {
+  CAPTURE_PACKET *packet;
+  gint64 due, now;
+  struct timespec ts;
+  int n=0;
+
+  if(replay_count==0) {
+    g_usleep(100000);
+    errno=EAGAIN;
+    return -1;
+  }
+  if(replay_start==0) replay_start=monotonic_nsec();
+
+  while(n<max) {
+    packet=&replay_packets[replay_next];
+    if(packet->port!=0 && replay_speed>0.0) {
+      due=replay_start+(gint64)((double)(packet->time-replay_packets[0].time+replay_offset)/replay_speed);
+      now=monotonic_nsec();
+      if(due>now) {
+        if(n>0) break;
+        if(due-now>1000000000LL) {
+          // a long gap in the capture is shortened to one second
+          replay_start-=due-now-1000000000LL;
+          due=now+1000000000LL;
+        }
+        ts.tv_sec=due/1000000000LL;
+        ts.tv_nsec=due%1000000000LL;
+#ifdef __APPLE__
+        usleep((due-now)/1000);
+#else
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)==EINTR);
+#endif
+      }
+    }
+    if(packet->port!=0) {
+      lengths[n]=packet->length<bufsize ? packet->length : bufsize;
+      memcpy(bufs[n], packet->data, lengths[n]);
+      if(addrs!=NULL) {
+        memset(&addrs[n], 0, sizeof(struct sockaddr_in));
+        addrs[n].sin_family=AF_INET;
+        addrs[n].sin_addr.s_addr=packet->address;
+        addrs[n].sin_port=htons(packet->port);
+      }
+      n++;
+    }
+    replay_next++;
+    if(replay_next>=replay_count) {
+      // next loop, continued 1 msec after the last datagram
+      replay_offset+=replay_packets[replay_count-1].time-replay_packets[0].time+1000000LL;
+      replay_next=0;
+      replay_loops++;
+      g_print("%s: loop %ld\n",__FUNCTION__,replay_loops);
+    }
+  }
+  return n;
+}
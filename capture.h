@@ -0,0 +1,74 @@
+/*
+ * File capture.h
+ *
+ * Recording of the datagrams received from the radio, and replaying
+ * them later into the same receive path without a radio.
+ *
+ * Recording: if the environment variable PIHPSDR_CAPTURE names a file
+ * when the radio is started, the datagrams read by the receive thread of
+ * the old protocol (EP6 frames) or the new protocol (DDC, high priority,
+ * mic, ...) are copied into a ring buffer. A background thread writes
+ * them with their time of arrival to the file, which is memory-mapped.
+ * The receive thread never waits: if the ring is full, the datagram is
+ * not recorded (and counted).
+ *
+ * The file is a pcap file (raw IPv4, nsec time stamps), so it can be
+ * read with Wireshark and used by protocol_bench. The first packet
+ * (UDP port 0) describes the radio. The file is valid after each write,
+ * so nothing but the last few msec is lost if piHPSDR is not left
+ * orderly. capture_stop(), called when the radio is stopped or piHPSDR
+ * exits, writes what is left in the ring and closes the file.
+ *
+ * Replay: if PIHPSDR_REPLAY names a capture ("file" or "file,speed"),
+ * discovery offers it as a radio. If it is started, the receive thread
+ * reads the datagrams from the capture instead of the socket, paced by
+ * their time stamps: speed 1 is real time, 4 is four times as fast,
+ * 0 (or "max") is as fast as the receive path takes them. The capture
+ * is replayed in a loop. A capture made with tcpdump may be replayed,
+ * too: only the datagrams of the radio (the address that sent the
+ * most) are used.
+ *
+ */
+
+#ifndef _CAPTURE_H
+#define _CAPTURE_H
+
+#include <netinet/in.h>
+
+//
+// A UDP datagram of a capture
+//
+typedef struct _capture_packet {
+  const unsigned char *data;   // UDP payload
+  int length;
+  guint32 address;             // source address, network byte order
+  int port;                    // source port
+  gint64 time;                 // nsec since the epoch
+} CAPTURE_PACKET;
+
+extern volatile gint capture_recording;
+extern volatile gint capture_replaying;
+
+extern void capture_init(void);
+extern void capture_discovery(void);
+extern void capture_start(void);
+extern void capture_stop(void);
+
+//
+// Called by the receive thread for each datagram, if capture_recording is set
+//
+extern void capture_packet(const unsigned char *data, int length, const struct sockaddr_in *from);
+
+//
+// Used instead of net_rx_recv() by the receive thread if capture_replaying is set
+//
+extern int capture_replay_recv(unsigned char **bufs, int bufsize, int max,
+                               int *lengths, struct sockaddr_in *addrs);
+
+//
+// Read the UDP/IPv4 datagrams of a pcap file. The file stays mapped,
+// data points into it. Returns NULL if the file cannot be read.
+//
+extern CAPTURE_PACKET *capture_read(const char *filename, int *count);
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * File cat_bench.c
+ *
+ * Replay a CAT trace through the command table of rigctl.c (the lookup
+ * of rigctl_cat.h with the command list of rigctl_commands.h) and report
+ * commands per second. The handlers are replaced by a function that only
+ * counts, so this measures the dispatch, not the radio.
+ * For comparison, the same trace is looked up by a linear search over the
+ * mnemonics.
+ *
+ * usage: cat_bench [-r repeats] [trace]
+ *
+ * The trace is a CAT stream ("FA;IF;ZZFA00014074000;...", white space
+ * is ignored) or a log written with RIGCTL debug on (the commands are
+ * taken from the "RIGCTL: command=" lines). Without a trace, the polling
+ * of a digimode program, a logger and a panadapter is used.
+ *
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "rigctl_cat.h"
+
+static long handled=0;
+
+static gboolean bench_handler(CLIENT *client,char *command) {
+  handled++;
+  return TRUE;
+}
+
+#define CAT_HANDLER(name) bench_handler
+
+static const CAT_COMMAND cat_commands[CAT_KEYS]={
+#include "rigctl_commands.h"
+};
+
+static const char *default_trace[]={
+  "FA;", "IF;", "MD;", "FR;", "FT;", "FB;", "SM0;", "TX;", "RX;",
+  "ZZFA;", "ZZFB;", "ZZMD;", "ZZSM0;", "ZZTX;", "ZZSP;", "ZZFI;", "ZZRT;",
+  "FA00014074000;", "ZZFA00014074000;", "MD2;", "ZZMD00;", "ID;", "PS;", "AI0;",
+  "XX;", "ZZZZ;"
+};
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + 1E-9 * (double) ts.tv_nsec;
+}
+
+static char **add(char **trace, int *count, const char *command, int length) {
+  trace=realloc(trace, (*count+1)*sizeof(char *));
+  trace[*count]=malloc(length+1);
+  memcpy(trace[*count], command, length);
+  trace[*count][length]='\0';
+  (*count)++;
+  return trace;
+}
+
+static char **read_trace(const char *filename, int *count) {
+  FILE *f=fopen(filename, "r");
+  char **trace=NULL;
+  char command[256];
+  char line[1024];
+  int length=0;
+  char *p;
+
+  if (f == NULL) {
+    perror(filename);
+    exit(1);
+  }
+  *count=0;
+  while (fgets(line, sizeof(line), f)) {
+    p=strstr(line, "RIGCTL: command=");
+    if (p != NULL) {
+      p+=strlen("RIGCTL: command=");
+    } else if (strstr(line, "RIGCTL") != NULL) {
+      continue;   // other debug output
+    } else {
+      p=line;
+    }
+    for (; *p; p++) {
+      if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') continue;
+      if (length < (int) sizeof(command)-1) command[length++]=*p;
+      if (*p == ';') {
+        trace=add(trace, count, command, length);
+        length=0;
+      }
+    }
+  }
+  fclose(f);
+  return trace;
+}
+
+//
+// What a lookup without the table costs: compare with every mnemonic
+//
+static const char **mnemonics=NULL;
+static int mnemonic_count=0;
+
+static void collect_mnemonics() {
+  int i;
+  mnemonics=malloc(CAT_KEYS*sizeof(char *));
+  for (i=0; i<CAT_KEYS; i++) {
+    char *m;
+    if (cat_commands[i].query == NULL && cat_commands[i].set == NULL) continue;
+    m=malloc(5);
+    if (i < 26*26) {
+      sprintf(m, "%c%c", 'A'+i/26, 'A'+i%26);
+    } else {
+      sprintf(m, "ZZ%c%c", 'A'+(i-26*26)/26, 'A'+(i-26*26)%26);
+    }
+    mnemonics[mnemonic_count++]=m;
+  }
+}
+
+static int linear_lookup(const char *command) {
+  int i;
+  for (i=0; i<mnemonic_count; i++) {
+    if (strncmp(command, mnemonics[i], strlen(mnemonics[i])) == 0) return i;
+  }
+  return -1;
+}
+
+int main(int argc, char **argv) {
+  int repeats=100000;
+  int count=0;
+  int c, i, r;
+  char **trace=NULL;
+  long unknown=0;
+  long found=0;
+  double t, t_table, t_linear;
+
+  while ((c=getopt(argc, argv, "r:")) != -1) {
+    switch (c) {
+      case 'r': repeats=atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-r repeats] [trace]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind < argc) {
+    trace=read_trace(argv[optind], &count);
+  } else {
+    for (i=0; i<(int)(sizeof(default_trace)/sizeof(default_trace[0])); i++) {
+      trace=add(trace, &count, default_trace[i], strlen(default_trace[i]));
+    }
+  }
+  if (count == 0) {
+    fprintf(stderr, "no commands in the trace\n");
+    return 1;
+  }
+  collect_mnemonics();
+
+  t=now();
+  for (r=0; r<repeats; r++) {
+    for (i=0; i<count; i++) {
+      CAT_FUNCTION function=cat_lookup(cat_commands, trace[i]);
+      if (function == NULL || !function(NULL, trace[i])) unknown++;
+    }
+  }
+  t_table=now()-t;
+
+  t=now();
+  for (r=0; r<repeats; r++) {
+    for (i=0; i<count; i++) {
+      if (linear_lookup(trace[i]) >= 0) found++;
+    }
+  }
+  t_linear=now()-t;
+
+  printf("%d commands in the trace, %d repeats, %d mnemonics in the table\n", count, repeats, mnemonic_count);
+  printf("table : %10.0f commands/sec %8.1f nsec/command (%ld handled, %ld answered with ?;)\n",
+         (double) count*repeats/t_table, 1E9*t_table/((double) count*repeats), handled, unknown);
+  printf("linear: %10.0f commands/sec %8.1f nsec/command (%ld found)\n",
+         (double) count*repeats/t_linear, 1E9*t_linear/((double) count*repeats), found);
+  return 0;
+}
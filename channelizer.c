@@ -0,0 +1,268 @@
+/*
+ * File channelizer.c
+ *
+ * Polyphase FFT channelizer (see channelizer.h)
+ *
+ * With M sub-channels and the prototype filter h of length P*M, output
+ * sample n of sub-channel k is
+ *
+ *   y[k][n] = exp(-2 pi i k N/M) * sum(m) v[m] exp(2 pi i k m/M)
+ *   v[m]    = sum(p) h[p*M+m] x[N-p*M-m]
+ *
+ * where N=n*M/2 is the newest input sample. The sum over m is an inverse
+ * FFT, and since N advances by M/2, the factor in front is (-1)^(k*n).
+ *
+ * The input history is kept newest sample first, so v is the product of
+ * h and the history, folded into M sums. These loops run over contiguous
+ * arrays without dependencies and are vectorized by the compiler (this
+ * file is compiled with -O3).
+ *
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "channelizer.h"
+
+//
+// The history moves back to the end of its buffer after this
+// many output samples
+//
+#define CHANNELIZER_HISTORY 64
+
+//
+// Kaiser window beta for about 90 dB stop band attenuation
+//
+#define CHANNELIZER_BETA 9.0
+
+static double bessel_i0(double x) {
+  double sum=1.0;
+  double term=1.0;
+  int k;
+
+  for(k=1;k<50;k++) {
+    term*=(x/(2.0*k))*(x/(2.0*k));
+    sum+=term;
+    if(term<1.0E-12*sum) break;
+  }
+  return sum;
+}
+
+//
+// Number of sub-channels for an input rate, 0 if the rate cannot be split
+//
+int channelizer_channels(int input_rate) {
+  int channels;
+
+  if(input_rate<CHANNELIZER_RATE || input_rate%CHANNELIZER_SPACING!=0) return 0;
+  channels=input_rate/CHANNELIZER_SPACING;
+  if((channels&(channels-1))!=0) return 0;
+  return channels;
+}
+
+//
+// Windowed sinc, cut off half way between the sub-channels: flat to
+// 15 kHz, and 90 dB down from 33 kHz, which would alias into 15 kHz
+// at the output rate of 48 kHz
+//
+static void design_filter(CHANNELIZER *c) {
+  double centre=(double)(c->length-1)/2.0;
+  double cutoff=(double)CHANNELIZER_SPACING/(double)c->input_rate;
+  double sum=0.0;
+  double t, r;
+  int i;
+
+  for(i=0;i<c->length;i++) {
+    t=(double)i-centre;
+    c->filter[i]=(t==0.0) ? 2.0*cutoff : sin(2.0*M_PI*cutoff*t)/(M_PI*t);
+    r=2.0*t/(double)(c->length-1);
+    c->filter[i]*=bessel_i0(CHANNELIZER_BETA*sqrt(1.0-r*r))/bessel_i0(CHANNELIZER_BETA);
+    sum+=c->filter[i];
+  }
+  for(i=0;i<c->length;i++) {
+    c->filter[i]/=sum;
+  }
+}
+
+CHANNELIZER *create_channelizer(int input_rate) {
+  CHANNELIZER *c;
+  int channels=channelizer_channels(input_rate);
+  int bits, i, j, r;
+
+  if(channels==0) {
+    g_print("%s: cannot split %d Hz into %d Hz channels\n",__FUNCTION__,input_rate,CHANNELIZER_SPACING);
+    return NULL;
+  }
+
+  c=g_new0(CHANNELIZER,1);
+  c->input_rate=input_rate;
+  c->channels=channels;
+  c->decimation=channels/2;
+  c->length=CHANNELIZER_TAPS*channels;
+  c->filter=g_new(double,c->length);
+  design_filter(c);
+
+  c->history_size=c->length+CHANNELIZER_HISTORY*c->decimation;
+  c->history_re=g_new0(double,c->history_size);
+  c->history_im=g_new0(double,c->history_size);
+  c->position=c->history_size-c->length;
+
+  c->fft_re=g_new(double,channels);
+  c->fft_im=g_new(double,channels);
+  c->twiddle_re=g_new(double,channels/2+1);
+  c->twiddle_im=g_new(double,channels/2+1);
+  for(i=0;i<=channels/2;i++) {
+    // positive sign: inverse FFT
+    c->twiddle_re[i]=cos(2.0*M_PI*(double)i/(double)channels);
+    c->twiddle_im[i]=sin(2.0*M_PI*(double)i/(double)channels);
+  }
+  bits=0;
+  while((1<<bits)<channels) bits++;
+  c->bit_reverse=g_new(int,channels);
+  for(i=0;i<channels;i++) {
+    r=0;
+    for(j=0;j<bits;j++) {
+      if(i&(1<<j)) r|=1<<(bits-1-j);
+    }
+    c->bit_reverse[i]=r;
+  }
+
+  g_print("%s: input_rate=%d channels=%d decimation=%d filter=%d\n",
+          __FUNCTION__,c->input_rate,c->channels,c->decimation,c->length);
+  return c;
+}
+
+void destroy_channelizer(CHANNELIZER *c) {
+  if(c==NULL) return;
+  g_free(c->filter);
+  g_free(c->history_re);
+  g_free(c->history_im);
+  g_free(c->fft_re);
+  g_free(c->fft_im);
+  g_free(c->twiddle_re);
+  g_free(c->twiddle_im);
+  g_free(c->bit_reverse);
+  g_free(c);
+}
+
+//
+// The sub-channel nearest to an offset from the centre of the input.
+// The outermost sub-channel (at half the input rate) is not used, it
+// is in the transition band of the DDC.
+//
+gboolean channelizer_bin(CHANNELIZER *c, long long offset, int *bin) {
+  long long b;
+
+  if(offset>=0) {
+    b=(offset+CHANNELIZER_SPACING/2)/CHANNELIZER_SPACING;
+  } else {
+    b=-((-offset+CHANNELIZER_SPACING/2)/CHANNELIZER_SPACING);
+  }
+  if(b<=-c->channels/2 || b>=c->channels/2) return FALSE;
+  *bin=(int)b;
+  return TRUE;
+}
+
+//
+// In-place radix-2 inverse FFT of fft_re/fft_im, already in bit reversed order
+//
+static void inverse_fft(CHANNELIZER *c) {
+  double *re=c->fft_re;
+  double *im=c->fft_im;
+  int size, half, step, i, j, k;
+  double wr, wi, tr, ti;
+
+  for(size=2;size<=c->channels;size*=2) {
+    half=size/2;
+    step=c->channels/size;
+    for(i=0;i<c->channels;i+=size) {
+      for(j=0;j<half;j++) {
+        k=i+j;
+        wr=c->twiddle_re[j*step];
+        wi=c->twiddle_im[j*step];
+        tr=wr*re[k+half]-wi*im[k+half];
+        ti=wr*im[k+half]+wi*re[k+half];
+        re[k+half]=re[k]-tr;
+        im[k+half]=im[k]-ti;
+        re[k]+=tr;
+        im[k]+=ti;
+      }
+    }
+  }
+}
+
+//
+// v[m]=sum(p) h[p*M+m]*history[p*M+m], for the real and imaginary part
+//
+static void polyphase(const double * restrict filter, const double * restrict history,
+                      double * restrict v, int channels, int length) {
+  int m, p;
+
+  for(m=0;m<channels;m++) {
+    v[m]=filter[m]*history[m];
+  }
+  for(p=channels;p<length;p+=channels) {
+    for(m=0;m<channels;m++) {
+      v[m]+=filter[p+m]*history[p+m];
+    }
+  }
+}
+
+static void channelizer_output(CHANNELIZER *c, const int *bins, int nbins, double **out, int sample) {
+  double v_re[c->channels];
+  double v_im[c->channels];
+  int b, k, m;
+
+  polyphase(c->filter, c->history_re+c->position, v_re, c->channels, c->length);
+  polyphase(c->filter, c->history_im+c->position, v_im, c->channels, c->length);
+  for(m=0;m<c->channels;m++) {
+    c->fft_re[c->bit_reverse[m]]=v_re[m];
+    c->fft_im[c->bit_reverse[m]]=v_im[m];
+  }
+  inverse_fft(c);
+
+  for(b=0;b<nbins;b++) {
+    k=bins[b];
+    if(k<0) k+=c->channels;
+    if(c->odd && (k&1)) {
+      out[b][2*sample]=-c->fft_re[k];
+      out[b][2*sample+1]=-c->fft_im[k];
+    } else {
+      out[b][2*sample]=c->fft_re[k];
+      out[b][2*sample+1]=c->fft_im[k];
+    }
+  }
+  c->odd=!c->odd;
+}
+
+//
+// Split n interleaved IQ samples. The output samples of the sub-channels
+// bins[0..nbins-1] (relative to the centre, see channelizer_bin) are
+// written to out[0..nbins-1], which must have room for n/decimation+1
+// IQ samples. Returns the number of output samples.
+//
+int channelizer_process(CHANNELIZER *c, const double *iq, int n, const int *bins, int nbins, double **out) {
+  int samples=0;
+  int i;
+
+  for(i=0;i<n;i++) {
+    if(c->position==0) {
+      memmove(c->history_re+c->history_size-c->length, c->history_re, c->length*sizeof(double));
+      memmove(c->history_im+c->history_size-c->length, c->history_im, c->length*sizeof(double));
+      c->position=c->history_size-c->length;
+    }
+    c->position--;
+    c->history_re[c->position]=iq[2*i];
+    c->history_im[c->position]=iq[2*i+1];
+    c->pending++;
+    if(c->pending==c->decimation) {
+      c->pending=0;
+      channelizer_output(c, bins, nbins, out, samples);
+      samples++;
+    }
+  }
+  return samples;
+}
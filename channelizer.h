@@ -0,0 +1,59 @@
+/*
+ * File channelizer.h
+ *
+ * Polyphase FFT channelizer: splits a wide IQ stream (e.g. 768 or
+ * 1536 kHz) into narrow sub-channels at 48 kHz.
+ *
+ * The sub-channels are CHANNELIZER_SPACING apart, the first one is
+ * centred on the input. There are input_rate/CHANNELIZER_SPACING of
+ * them, which must be a power of two, and they are oversampled by two:
+ * each one is 48 kHz wide, so a signal up to 12 kHz off the centre of
+ * the nearest sub-channel, plus a filter of 3 kHz, is passed without
+ * aliasing.
+ *
+ * For every input_rate/48000 input samples, the prototype low pass
+ * filter is applied once by the polyphase branches and one inverse
+ * FFT gives the next output sample of all sub-channels. This replaces
+ * the filtering and decimation that WDSP does in each channel when
+ * every channel is fed with the wide input.
+ *
+ */
+
+#ifndef _CHANNELIZER_H
+#define _CHANNELIZER_H
+
+#define CHANNELIZER_SPACING 24000   // Hz
+#define CHANNELIZER_RATE 48000      // output rate of the sub-channels
+#define CHANNELIZER_TAPS 8          // filter taps per polyphase branch
+
+typedef struct _channelizer {
+  int input_rate;
+  int channels;          // sub-channels = FFT size
+  int decimation;        // input samples per output sample (channels/2)
+  int length;            // filter length (CHANNELIZER_TAPS*channels)
+  double *filter;
+
+  //
+  // Input history, newest sample first, at history_re+position
+  //
+  double *history_re;
+  double *history_im;
+  int history_size;
+  int position;
+  int pending;           // input samples since the last output
+  int odd;               // output sample number is odd
+
+  double *fft_re;
+  double *fft_im;
+  double *twiddle_re;
+  double *twiddle_im;
+  int *bit_reverse;
+} CHANNELIZER;
+
+extern int channelizer_channels(int input_rate);
+extern CHANNELIZER *create_channelizer(int input_rate);
+extern void destroy_channelizer(CHANNELIZER *c);
+extern gboolean channelizer_bin(CHANNELIZER *c, long long offset, int *bin);
+extern int channelizer_process(CHANNELIZER *c, const double *iq, int n, const int *bins, int nbins, double **out);
+
+#endif
@@ -30,6 +30,9 @@
 #include <netdb.h>
 #include <string.h>
 #include <strings.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/uio.h>
 #ifndef __APPLE__
 #include <endian.h>
 #endif
@@ -86,8 +89,19 @@ static char reply[64];
 static gboolean running;
 static gint listen_socket;
 
-static int audio_buffer_index=0;
+//
+// Receiver audio is collected per receiver and then sent to each
+// client in the format it has asked for.
+//
+static int audio_buffer_index[8];
+static short audio_buffer[8][AUDIO_DATA_SIZE*2];
 AUDIO_DATA audio_data;
+static unsigned char audio_codec_buffer[sizeof(AUDIO_CODEC_DATA)+AUDIO_CODEC_MAX_BYTES(AUDIO_DATA_SIZE)];
+
+int remote_audio_codec=AUDIO_CODEC_PCM;
+int remote_audio_rate=AUDIO_CODEC_INPUT_RATE;
+int remote_audio_channels=2;
+static long long server_version=0LL;
 
 
 GMutex accumulated_mutex;
@@ -107,12 +121,13 @@ g_print("add_client: clients=%p\n",clients);
   return client;
 }
 
+static void client_stop_sender(REMOTE_CLIENT *client);
+
 void delete_client(REMOTE_CLIENT *client) {
 g_print("delete_client: %p\n",client);
   g_mutex_lock(&client_mutex);
   if(clients==client) {
     clients=client->next;
-    g_free(client);
   } else {
     REMOTE_CLIENT* c=clients;
     REMOTE_CLIENT* last_c=NULL;
@@ -122,11 +137,21 @@ g_print("delete_client: %p\n",client);
     }
     if(c!=NULL) {
       last_c->next=c->next;
-      g_free(c);
     }
   }
 g_print("delete_client: clients=%p\n",clients);
   g_mutex_unlock(&client_mutex);
+  // now nobody else can queue data for this client
+  client_stop_sender(client);
+  for(int i=0;i<8;i++) {
+    if(client->receiver[i].spectrum_codec!=NULL) {
+      g_free(client->receiver[i].spectrum_codec);
+    }
+    if(client->receiver[i].audio_encoder!=NULL) {
+      g_free(client->receiver[i].audio_encoder);
+    }
+  }
+  g_free(client);
 }
 
 static int recv_bytes(int s,char *buffer,int bytes) {
@@ -145,10 +170,266 @@ static int recv_bytes(int s,char *buffer,int bytes) {
   return bytes_read;
 }
 
+//
+// Server side: outbound queue of a client.
+//
+// All data sent to a client is put into its queue, and a sender
+// thread (one per client) writes it to the socket. Writing is
+// non-blocking and gathers as many queued messages as possible
+// into one sendmsg() call.
+// The queue is bounded. If a client falls behind, spectrum frames are
+// dropped first: a new spectrum frame replaces an unsent older frame
+// of the same receiver, and if the queue is full the oldest spectrum
+// frames are discarded. Audio is only dropped if the queue overflows
+// with no spectrum frame left to discard. Other messages (radio/vfo
+// data, command responses) are never dropped.
+//
+#define SEND_QUEUE_MAX_BYTES (256*1024)
+#define SEND_IOV_MAX 32
+
+enum {
+  MSG_CONTROL,
+  MSG_SPECTRUM,
+  MSG_AUDIO,
+};
+
+typedef struct _remote_msg {
+  gint type;
+  gint rx;
+  gint busy;      // being written by the sender thread, must not be dropped
+  gint length;
+  gint offset;    // bytes already sent
+  char data[];
+} REMOTE_MSG;
+
+//
+// Remove the oldest message of the given type which is not being sent and
+// of which nothing has been sent yet (a partially sent message cannot be
+// taken out of the stream).
+// Must be called with send_mutex held. Returns TRUE if a message was dropped.
+//
+static gboolean client_drop_oldest(REMOTE_CLIENT *client,int type,int rx) {
+  GList *l;
+  for(l=client->send_queue->head;l!=NULL;l=l->next) {
+    REMOTE_MSG *m=(REMOTE_MSG *)l->data;
+    if(m->type==type && !m->busy && m->offset==0 && (rx<0 || m->rx==rx)) {
+      if(type==MSG_SPECTRUM) {
+        // a compressed frame is lost: the next one must be a key frame
+        client->receiver[m->rx].spectrum_resync=TRUE;
+        client->spectrum_dropped++;
+      } else if(type==MSG_AUDIO) {
+        client->audio_dropped++;
+      }
+      client->send_queue_bytes-=m->length;
+      g_queue_delete_link(client->send_queue,l);
+      g_free(m);
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static int client_enqueue(REMOTE_CLIENT *client,int type,int rx,const void *data,int length) {
+  REMOTE_MSG *m;
+
+  g_mutex_lock(&client->send_mutex);
+  if(!client->running) {
+    g_mutex_unlock(&client->send_mutex);
+    return -1;
+  }
+  if(type==MSG_SPECTRUM) {
+    // an unsent older frame of this receiver is stale
+    client_drop_oldest(client,MSG_SPECTRUM,rx);
+  }
+  while(client->send_queue_bytes+length>SEND_QUEUE_MAX_BYTES) {
+    if(client_drop_oldest(client,MSG_SPECTRUM,-1)) continue;
+    if(type==MSG_SPECTRUM) {
+      client->receiver[rx].spectrum_resync=TRUE;
+      client->spectrum_dropped++;
+      g_mutex_unlock(&client->send_mutex);
+      return 0;
+    }
+    if(client_drop_oldest(client,MSG_AUDIO,-1)) continue;
+    break;  // only control messages left: queue anyway
+  }
+  m=g_malloc(sizeof(REMOTE_MSG)+length);
+  m->type=type;
+  m->rx=rx;
+  m->busy=0;
+  m->length=length;
+  m->offset=0;
+  memcpy(m->data,data,length);
+  g_queue_push_tail(client->send_queue,m);
+  client->send_queue_bytes+=length;
+  g_cond_signal(&client->send_cond);
+  g_mutex_unlock(&client->send_mutex);
+  return length;
+}
+
+//
+// Compressed spectrum frames are deltas to the previous frame, so an unsent
+// frame must not be replaced by a newer one. Returns TRUE if a frame of this
+// receiver is still waiting in the queue (then the caller skips this update).
+// *resync tells whether a frame has been dropped since the last call.
+//
+static gboolean client_spectrum_pending(REMOTE_CLIENT *client,int rx,gboolean *resync) {
+  GList *l;
+  gboolean pending=FALSE;
+  g_mutex_lock(&client->send_mutex);
+  for(l=client->send_queue->head;l!=NULL;l=l->next) {
+    REMOTE_MSG *m=(REMOTE_MSG *)l->data;
+    if(m->type==MSG_SPECTRUM && m->rx==rx && m->offset==0) {
+      pending=TRUE;
+      break;
+    }
+  }
+  if(!pending) {
+    *resync=client->receiver[rx].spectrum_resync;
+    client->receiver[rx].spectrum_resync=FALSE;
+  }
+  g_mutex_unlock(&client->send_mutex);
+  return pending;
+}
+
+static gpointer client_sender_thread(gpointer arg) {
+  REMOTE_CLIENT *client=(REMOTE_CLIENT *)arg;
+  struct iovec iov[SEND_IOV_MAX];
+  struct msghdr msg;
+  struct pollfd pfd;
+  GList *l;
+  REMOTE_MSG *m;
+  int n,rc;
+  int flags=MSG_DONTWAIT;
+#ifdef MSG_NOSIGNAL
+  flags|=MSG_NOSIGNAL;
+#endif
+
+g_print("client_sender_thread: started\n");
+  while(1) {
+    g_mutex_lock(&client->send_mutex);
+    while(client->running && g_queue_is_empty(client->send_queue)) {
+      g_cond_wait(&client->send_cond,&client->send_mutex);
+    }
+    if(!client->running) {
+      g_mutex_unlock(&client->send_mutex);
+      break;
+    }
+    n=0;
+    for(l=client->send_queue->head;l!=NULL && n<SEND_IOV_MAX;l=l->next) {
+      m=(REMOTE_MSG *)l->data;
+      m->busy=1;
+      iov[n].iov_base=m->data+m->offset;
+      iov[n].iov_len=m->length-m->offset;
+      n++;
+    }
+    g_mutex_unlock(&client->send_mutex);
+
+    //
+    // The socket itself stays blocking since the server_client_thread
+    // reads from it, so use a per-call non-blocking send.
+    //
+    memset(&msg,0,sizeof(msg));
+    msg.msg_iov=iov;
+    msg.msg_iovlen=n;
+    rc=sendmsg(client->socket,&msg,flags);
+    if(rc<0) {
+      if(errno==EAGAIN || errno==EWOULDBLOCK || errno==EINTR) {
+        rc=0;
+      } else {
+        perror("client_sender_thread");
+        g_mutex_lock(&client->send_mutex);
+        client->running=FALSE;
+        g_mutex_unlock(&client->send_mutex);
+        // wake up server_client_thread
+        shutdown(client->socket,SHUT_RDWR);
+        break;
+      }
+    }
+
+    g_mutex_lock(&client->send_mutex);
+    while(!g_queue_is_empty(client->send_queue)) {
+      m=(REMOTE_MSG *)g_queue_peek_head(client->send_queue);
+      if(!m->busy) break;
+      if(rc>=m->length-m->offset) {
+        rc-=m->length-m->offset;
+        client->send_queue_bytes-=m->length;
+        g_queue_pop_head(client->send_queue);
+        g_free(m);
+      } else {
+        m->offset+=rc;
+        break;
+      }
+    }
+    for(l=client->send_queue->head;l!=NULL;l=l->next) {
+      ((REMOTE_MSG *)l->data)->busy=0;
+    }
+    gboolean pending=!g_queue_is_empty(client->send_queue);
+    g_mutex_unlock(&client->send_mutex);
+
+    if(pending) {
+      // socket buffer full: wait until it can take more data
+      pfd.fd=client->socket;
+      pfd.events=POLLOUT;
+      pfd.revents=0;
+      poll(&pfd,1,100);
+    }
+  }
+g_print("client_sender_thread: terminated: spectrum dropped=%d audio dropped=%d\n",client->spectrum_dropped,client->audio_dropped);
+  return NULL;
+}
+
+static void client_start_sender(REMOTE_CLIENT *client) {
+  g_mutex_init(&client->send_mutex);
+  g_cond_init(&client->send_cond);
+  client->send_queue=g_queue_new();
+  client->send_queue_bytes=0;
+  client->spectrum_dropped=0;
+  client->audio_dropped=0;
+  client->sender_thread_id=g_thread_new("SSDR_sender",client_sender_thread,client);
+}
+
+static void client_stop_sender(REMOTE_CLIENT *client) {
+  REMOTE_MSG *m;
+  g_mutex_lock(&client->send_mutex);
+  client->running=FALSE;
+  g_cond_signal(&client->send_cond);
+  g_mutex_unlock(&client->send_mutex);
+  g_thread_join(client->sender_thread_id);
+  while((m=(REMOTE_MSG *)g_queue_pop_head(client->send_queue))!=NULL) {
+    g_free(m);
+  }
+  g_queue_free(client->send_queue);
+  g_cond_clear(&client->send_cond);
+  g_mutex_clear(&client->send_mutex);
+}
+
+//
+// If the socket belongs to a client of our server, the data goes
+// through the client's queue. Returns -2 if this is not the case.
+//
+static int client_send_bytes(int s,char *buffer,int bytes) {
+  REMOTE_CLIENT *c;
+  int rc=-2;
+  g_mutex_lock(&client_mutex);
+  c=clients;
+  while(c!=NULL && c->socket!=s) {
+    c=c->next;
+  }
+  if(c!=NULL) {
+    rc=client_enqueue(c,MSG_CONTROL,-1,buffer,bytes);
+  }
+  g_mutex_unlock(&client_mutex);
+  return rc;
+}
+
 static int send_bytes(int s,char *buffer,int bytes) {
   int bytes_sent=0;
   int rc;
   if(s<0) return -1;
+  if(hpsdr_server) {
+    rc=client_send_bytes(s,buffer,bytes);
+    if(rc!=-2) return rc;
+  }
   while(bytes_sent!=bytes) {
     rc=send(s,&buffer[bytes_sent],bytes-bytes_sent,0);
     if(rc<0) {
@@ -163,31 +444,124 @@ static int send_bytes(int s,char *buffer,int bytes) {
 }
 
 void remote_audio(RECEIVER *rx,short left_sample,short right_sample) {
-  int i=audio_buffer_index*2;
-  audio_data.sample[i]=htons(left_sample);
-  audio_data.sample[i+1]=htons(right_sample);
-  audio_buffer_index++;
-  if(audio_buffer_index>=AUDIO_DATA_SIZE) {
+  int r=rx->id;
+  int i=audio_buffer_index[r]*2;
+  audio_buffer[r][i]=left_sample;
+  audio_buffer[r][i+1]=right_sample;
+  audio_buffer_index[r]++;
+  if(audio_buffer_index[r]>=AUDIO_DATA_SIZE) {
+    gboolean pcm_ready=FALSE;
     g_mutex_lock(&client_mutex);
     REMOTE_CLIENT *c=clients;
     while(c!=NULL && c->socket!=-1) {
-      audio_data.header.sync=REMOTE_SYNC;
-      audio_data.header.data_type=htons(INFO_AUDIO);
-      audio_data.header.version=htonll(CLIENT_SERVER_VERSION);
-      audio_data.rx=rx->id;
-      audio_data.samples=ntohs(audio_buffer_index);
-      int bytes_sent=send_bytes(c->socket,(char *)&audio_data,sizeof(audio_data));
-      if(bytes_sent<0) {
-        perror("remote_audio");
-        if(c->socket!=-1) {
-          close(c->socket);
-        }
+      AUDIO_ENCODER *encoder=c->receiver[r].audio_encoder;
+      if(encoder==NULL) {
+        if(!pcm_ready) {
+          audio_data.header.sync=REMOTE_SYNC;
+          audio_data.header.data_type=htons(INFO_AUDIO);
+          audio_data.header.version=htonll(CLIENT_SERVER_VERSION);
+          audio_data.rx=r;
+          audio_data.samples=ntohs(audio_buffer_index[r]);
+          for(i=0;i<AUDIO_DATA_SIZE*2;i++) {
+            audio_data.sample[i]=htons(audio_buffer[r][i]);
+          }
+          pcm_ready=TRUE;
+        }
+        client_enqueue(c,MSG_AUDIO,r,&audio_data,sizeof(audio_data));
+      } else {
+        // the encoder keeps state, so it sees every block even if the queue drops it
+        AUDIO_CODEC_DATA *codec_data=(AUDIO_CODEC_DATA *)audio_codec_buffer;
+        int samples;
+        int bytes=audio_encode(encoder,audio_buffer[r],AUDIO_DATA_SIZE,&audio_codec_buffer[sizeof(AUDIO_CODEC_DATA)],&samples);
+        codec_data->header.sync=REMOTE_SYNC;
+        codec_data->header.data_type=htons(INFO_AUDIO_CODEC);
+        codec_data->header.version=htonll(CLIENT_SERVER_VERSION);
+        codec_data->rx=r;
+        codec_data->codec=encoder->codec;
+        codec_data->channels=encoder->channels;
+        codec_data->rate=htons(encoder->rate);
+        codec_data->samples=htons(samples);
+        codec_data->length=htons(bytes);
+        client_enqueue(c,MSG_AUDIO,r,audio_codec_buffer,sizeof(AUDIO_CODEC_DATA)+bytes);
       }
       c=c->next;
     }
     g_mutex_unlock(&client_mutex);
-    audio_buffer_index=0;
+    audio_buffer_index[r]=0;
+  }
+}
+
+//
+// Send one compressed spectrum frame (INFO_SPECTRUM_COMPRESSED).
+// The VFO values are only included if they have changed (or with a key frame).
+// Must be called with rx->display_mutex held.
+//
+static int send_spectrum_compressed(REMOTE_CLIENT *client,int r,RECEIVER *rx) {
+  REMOTE_RX *remote=&client->receiver[r];
+  unsigned char buffer[sizeof(SPECTRUM_COMPRESSED_DATA)+6*sizeof(uint64_t)+2*sizeof(int16_t)+SPECTRUM_CODEC_MAX_BYTES];
+  unsigned char payload[SPECTRUM_CODEC_MAX_BYTES];
+  SPECTRUM_COMPRESSED_DATA *spectrum_data=(SPECTRUM_COMPRESSED_DATA *)buffer;
+  unsigned char *p=buffer+sizeof(SPECTRUM_COMPRESSED_DATA);
+  long long vfo_values[6];
+  gboolean resync=FALSE;
+  gboolean vfo_changed=FALSE;
+  int width,low,high;
+  int keyframe,k,bytes,i;
+  uint64_t v;
+  int16_t range;
+
+  if(client_spectrum_pending(client,r,&resync)) {
+    return 0;
+  }
+
+  width=rx->width;
+  if(width>SPECTRUM_CODEC_MAX_SAMPLES) width=SPECTRUM_CODEC_MAX_SAMPLES;
+  // the client uses the same samples for the panadapter and the waterfall
+  low=rx->panadapter_low<rx->waterfall_low?rx->panadapter_low:rx->waterfall_low;
+  high=rx->panadapter_high>rx->waterfall_high?rx->panadapter_high:rx->waterfall_high;
+  bytes=spectrum_encode(remote->spectrum_codec,&rx->pixel_samples[rx->pan],width,low,high,resync,payload,&keyframe,&k);
+
+  vfo_values[0]=vfo[VFO_A].frequency;
+  vfo_values[1]=vfo[VFO_B].frequency;
+  vfo_values[2]=vfo[VFO_A].ctun_frequency;
+  vfo_values[3]=vfo[VFO_B].ctun_frequency;
+  vfo_values[4]=vfo[VFO_A].offset;
+  vfo_values[5]=vfo[VFO_B].offset;
+  for(i=0;i<6;i++) {
+    if(vfo_values[i]!=remote->last_vfo[i]) vfo_changed=TRUE;
   }
+
+  spectrum_data->header.sync=REMOTE_SYNC;
+  spectrum_data->header.data_type=htons(INFO_SPECTRUM_COMPRESSED);
+  spectrum_data->header.version=htonll(CLIENT_SERVER_VERSION);
+  spectrum_data->rx=r;
+  spectrum_data->flags=0;
+  spectrum_data->k=k;
+  spectrum_data->meter=htond(rx->meter);
+  spectrum_data->samples=htons(width);
+  if(keyframe || vfo_changed) {
+    spectrum_data->flags|=SPECTRUM_FLAG_VFO;
+    for(i=0;i<6;i++) {
+      v=htonll(vfo_values[i]);
+      memcpy(p,&v,sizeof(v));
+      p+=sizeof(v);
+      remote->last_vfo[i]=vfo_values[i];
+    }
+  }
+  if(keyframe) {
+    // a changed range always forces a key frame
+    spectrum_data->flags|=SPECTRUM_FLAG_KEYFRAME|SPECTRUM_FLAG_RANGE;
+    range=htons((int16_t)low);
+    memcpy(p,&range,sizeof(range));
+    p+=sizeof(range);
+    range=htons((int16_t)high);
+    memcpy(p,&range,sizeof(range));
+    p+=sizeof(range);
+  }
+  memcpy(p,payload,bytes);
+  p+=bytes;
+  spectrum_data->length=htons((uint16_t)(p-buffer-sizeof(SPECTRUM_COMPRESSED_DATA)));
+  return client_enqueue(client,MSG_SPECTRUM,r,buffer,p-buffer);
 }
 
 static gint send_spectrum(void *arg) {
@@ -210,6 +584,13 @@ g_print("send_spectrum: no more receivers\n");
     if(client->receiver[r].send_spectrum) {
       if(rx->displaying && (rx->pixels>0) && (rx->pixel_samples!=NULL)) {
         g_mutex_lock(&rx->display_mutex);
+        if(client->receiver[r].spectrum_compressed) {
+          if(send_spectrum_compressed(client,r,rx)<0) {
+            result=FALSE;
+          }
+          g_mutex_unlock(&rx->display_mutex);
+          continue;
+        }
         spectrum_data.header.sync=REMOTE_SYNC;
         spectrum_data.header.data_type=htons(INFO_SPECTRUM);
         spectrum_data.header.version=htonll(CLIENT_SERVER_VERSION);
@@ -227,8 +608,8 @@ g_print("send_spectrum: no more receivers\n");
           s=(short)samples[i+rx->pan];
           spectrum_data.sample[i]=htons(s);
         }
-        // send the buffer
-        int bytes_sent=send_bytes(client->socket,(char *)&spectrum_data,sizeof(spectrum_data));
+        // queue the buffer
+        int bytes_sent=client_enqueue(client,MSG_SPECTRUM,r,&spectrum_data,sizeof(spectrum_data));
         if(bytes_sent<0) {
           result=FALSE;
         }
@@ -243,7 +624,7 @@ void send_radio_data(REMOTE_CLIENT *client) {
   RADIO_DATA radio_data;
   radio_data.header.sync=REMOTE_SYNC;
   radio_data.header.data_type=htons(INFO_RADIO);
-  radio_data.header.version=htonl(CLIENT_SERVER_VERSION);
+  radio_data.header.version=htonll(CLIENT_SERVER_VERSION);
   strcpy(radio_data.name,radio->name);
   radio_data.protocol=htons(radio->protocol);
   radio_data.device=htons(radio->device);
@@ -449,9 +830,20 @@ g_print("server_client_thread: received header: type=%d\n",ntohs(header.data_typ
 
          int rx=spectrum_command.id;
          int state=spectrum_command.start_stop;
-g_print("server_client_thread: CMD_RESP_SPECTRUM rx=%d state=%d timer_id=%d\n",rx,state,client->spectrum_update_timer_id);
+         long long version=ntohll(header.version);
+g_print("server_client_thread: CMD_RESP_SPECTRUM rx=%d state=%d timer_id=%d version=%lld\n",rx,state,client->spectrum_update_timer_id,version);
          if(state) {
            client->receiver[rx].receiver=rx;
+           if(version>=CLIENT_SERVER_VERSION_SPECTRUM_COMPRESSED) {
+             if(client->receiver[rx].spectrum_codec==NULL) {
+               client->receiver[rx].spectrum_codec=g_new(SPECTRUM_CODEC,1);
+               spectrum_codec_reset(client->receiver[rx].spectrum_codec);
+             }
+             client->receiver[rx].spectrum_resync=TRUE;
+             client->receiver[rx].spectrum_compressed=TRUE;
+           } else {
+             client->receiver[rx].spectrum_compressed=FALSE;
+           }
            client->receiver[rx].spectrum_fps=receiver[rx]->fps;
            client->receiver[rx].spectrum_port=0;
            client->receiver[rx].send_spectrum=TRUE;
@@ -467,6 +859,45 @@ g_print("send_spectrum thread already running\n");
          }
          }
          break;
+       case CMD_RESP_AUDIO:
+         {
+         AUDIO_COMMAND audio_command;
+         AUDIO_ENCODER *encoder=NULL;
+         AUDIO_ENCODER *old_encoder;
+         bytes_read=recv_bytes(client->socket,(char *)&audio_command.id,sizeof(AUDIO_COMMAND)-sizeof(header));
+         if(bytes_read<0) {
+           g_print("server_client_thread: read %d bytes for AUDIO_COMMAND\n",bytes_read);
+           perror("server_client_thread");
+           // dialog box?
+           return NULL;
+         }
+         int rx=audio_command.id;
+         int codec=audio_command.codec;
+         int rate=ntohs(audio_command.rate);
+         int channels=audio_command.channels;
+g_print("server_client_thread: CMD_RESP_AUDIO rx=%d codec=%s rate=%d channels=%d\n",rx,audio_codec_name(codec),rate,channels);
+         if(rx<0 || rx>=8) break;
+         if(codec!=AUDIO_CODEC_PCM || rate!=AUDIO_CODEC_INPUT_RATE || channels!=2) {
+           encoder=g_new(AUDIO_ENCODER,1);
+           if(audio_encoder_init(encoder,codec,rate,channels)<0) {
+             g_print("server_client_thread: audio format not supported\n");
+             g_free(encoder);
+             encoder=NULL;
+           }
+         }
+         // remote_audio uses the encoder with client_mutex held
+         g_mutex_lock(&client_mutex);
+         old_encoder=client->receiver[rx].audio_encoder;
+         client->receiver[rx].audio_encoder=encoder;
+         client->receiver[rx].audio_format=encoder?codec:AUDIO_CODEC_PCM;
+         client->receiver[rx].audio_rate=encoder?rate:AUDIO_CODEC_INPUT_RATE;
+         client->receiver[rx].audio_channels=encoder?channels:2;
+         g_mutex_unlock(&client_mutex);
+         if(old_encoder!=NULL) {
+           g_free(old_encoder);
+         }
+         }
+         break;
        case CMD_RESP_RX_FREQ:
 g_print("server_client_thread: CMD_RESP_RX_FREQ\n");
          {
@@ -1102,7 +1533,7 @@ void send_start_spectrum(int s,int rx) {
   SPECTRUM_COMMAND command;
   command.header.sync=REMOTE_SYNC;
   command.header.data_type=htons(CMD_RESP_SPECTRUM);
-  command.header.version=htonl(CLIENT_SERVER_VERSION);
+  command.header.version=htonll(CLIENT_SERVER_VERSION);
   command.id=rx;
   command.start_stop=1;
   int bytes_sent=send_bytes(s,(char *)&command,sizeof(command));
@@ -1113,6 +1544,21 @@ void send_start_spectrum(int s,int rx) {
   }
 }
 
+void send_audio_format(int s,int rx) {
+  AUDIO_COMMAND command;
+  command.header.sync=REMOTE_SYNC;
+  command.header.data_type=htons(CMD_RESP_AUDIO);
+  command.header.version=htonll(CLIENT_SERVER_VERSION);
+  command.id=rx;
+  command.codec=remote_audio_codec;
+  command.channels=remote_audio_channels;
+  command.rate=htons(remote_audio_rate);
+  int bytes_sent=send_bytes(s,(char *)&command,sizeof(command));
+  if(bytes_sent<0) {
+    perror("send_command");
+  }
+}
+
 void send_vfo_frequency(int s,int rx,long long hz) {
   FREQ_COMMAND command;
 
@@ -1768,7 +2214,7 @@ g_print("hpsdr_server: listening on port %d\n",listen_port);
       g_print("listen_thread: listen failed\n");
       break;
     }
-    REMOTE_CLIENT* client=g_new(REMOTE_CLIENT,1);
+    REMOTE_CLIENT* client=g_new0(REMOTE_CLIENT,1);
     client->spectrum_update_timer_id=-1;
     client->address_length=sizeof(client->address);
     client->running=TRUE;
@@ -1781,8 +2227,10 @@ g_print("hpsdr_server: accept\n");
  char s[128];
  inet_ntop(AF_INET, &(((struct sockaddr_in *)&client->address)->sin_addr),s,128);
 g_print("Client_connected from %s\n",s);
-    client->thread_id=g_thread_new("SSDR_client",server_client_thread,client);
+    // the send queue must exist before other threads can see the client
+    client_start_sender(client);
     add_client(client);
+    client->thread_id=g_thread_new("SSDR_client",server_client_thread,client);
     close(listen_socket);
     gpointer thread_result=g_thread_join(client->thread_id);
   }
@@ -1840,6 +2288,9 @@ g_print("start_spectrum: delay %d\n",delay);
     return TRUE;
   }
   send_start_spectrum(client_socket,rx->id);
+  if(server_version>=CLIENT_SERVER_VERSION_AUDIO_CODEC) {
+    send_audio_format(client_socket,rx->id);
+  }
   return FALSE;
 }
 
@@ -1849,6 +2300,27 @@ void start_vfo_timer() {
 g_print("check_vfo_timer_id %d\n",check_vfo_timer_id);
 }
 
+//
+// The spectrum buffer of a remote receiver grows with the number of
+// samples the server sends (its width or zoom may change). The old
+// buffer is freed in the GTK thread, after it has been drawn.
+//
+static int remote_pixel_samples[8];   // size of receiver[r]->pixel_samples
+
+static gboolean remote_free_pixel_samples(gpointer data) {
+  g_free(data);
+  return FALSE;
+}
+
+static void remote_pixel_samples_alloc(int r,int samples) {
+  float *old=receiver[r]->pixel_samples;
+
+  if(old!=NULL && samples<=remote_pixel_samples[r]) return;
+  receiver[r]->pixel_samples=g_new0(float,samples);
+  remote_pixel_samples[r]=samples;
+  if(old!=NULL) g_idle_add(remote_free_pixel_samples,old);
+}
+
 static void *client_thread(void* arg) {
   gint bytes_read;
   HEADER header;
@@ -1878,6 +2350,8 @@ static void *client_thread(void* arg) {
         }
 
 g_print("INFO_RADIO: %d\n",bytes_read);
+        // servers before version 2 send 0 here
+        server_version=ntohll(header.version);
         // build a radio (discovered) structure
         radio=g_new(DISCOVERED,1);
         strcpy(radio->name,radio_data.name);
@@ -2083,9 +2557,7 @@ g_print("g_idle_add: ext_vfo_update\n");
         long long offset_b=ntohll(spectrum_data.vfo_b_offset);
         receiver[r]->meter=ntohd(spectrum_data.meter);
         short samples=ntohs(spectrum_data.samples);
-        if(receiver[r]->pixel_samples==NULL) {
-          receiver[r]->pixel_samples=g_new(float,(int)samples);
-        }
+        remote_pixel_samples_alloc(r,(int)samples);
 
         short sample;
         for(int i=0;i<samples;i++) {
@@ -2104,6 +2576,112 @@ g_print("g_idle_add: ext_vfo_update\n");
         g_idle_add(ext_receiver_remote_update_display,receiver[r]);
         }
         break;
+      case INFO_SPECTRUM_COMPRESSED:
+        {
+        SPECTRUM_COMPRESSED_DATA spectrum_data;
+        static SPECTRUM_CODEC spectrum_codec[8];
+        static unsigned char buffer[6*sizeof(uint64_t)+2*sizeof(int16_t)+SPECTRUM_CODEC_MAX_BYTES];
+        static int spectrum_low[8];
+        static int spectrum_high[8];
+        unsigned char *p=buffer;
+        int length;
+        bytes_read=recv_bytes(client_socket,(char *)&spectrum_data.rx,sizeof(spectrum_data)-sizeof(header));
+        if(bytes_read<0) {
+          g_print("client_thread: read %d bytes for SPECTRUM_COMPRESSED_DATA\n",bytes_read);
+          perror("client_thread");
+          // dialog box?
+          return NULL;
+        }
+        length=ntohs(spectrum_data.length);
+        if(length>(int)sizeof(buffer) || spectrum_data.rx>=8) {
+          g_print("client_thread: bad SPECTRUM_COMPRESSED_DATA rx=%d length=%d\n",spectrum_data.rx,length);
+          return NULL;
+        }
+        bytes_read=recv_bytes(client_socket,(char *)buffer,length);
+        if(bytes_read<0) {
+          g_print("client_thread: read %d bytes for SPECTRUM_COMPRESSED_DATA\n",bytes_read);
+          perror("client_thread");
+          return NULL;
+        }
+        int r=spectrum_data.rx;
+        receiver[r]->meter=ntohd(spectrum_data.meter);
+        int samples=ntohs(spectrum_data.samples);
+        if(spectrum_data.flags&SPECTRUM_FLAG_VFO) {
+          long long vfo_values[6];
+          uint64_t v;
+          for(int i=0;i<6;i++) {
+            memcpy(&v,p,sizeof(v));
+            p+=sizeof(v);
+            vfo_values[i]=ntohll(v);
+          }
+          if(vfo[VFO_A].frequency!=vfo_values[0] || vfo[VFO_B].frequency!=vfo_values[1] || vfo[VFO_A].ctun_frequency!=vfo_values[2] || vfo[VFO_B].ctun_frequency!=vfo_values[3] || vfo[VFO_A].offset!=vfo_values[4] || vfo[VFO_B].offset!=vfo_values[5]) {
+            vfo[VFO_A].frequency=vfo_values[0];
+            vfo[VFO_B].frequency=vfo_values[1];
+            vfo[VFO_A].ctun_frequency=vfo_values[2];
+            vfo[VFO_B].ctun_frequency=vfo_values[3];
+            vfo[VFO_A].offset=vfo_values[4];
+            vfo[VFO_B].offset=vfo_values[5];
+            g_idle_add(ext_vfo_update,(gpointer)NULL);
+          }
+        }
+        if(spectrum_data.flags&SPECTRUM_FLAG_RANGE) {
+          int16_t range;
+          memcpy(&range,p,sizeof(range));
+          p+=sizeof(range);
+          spectrum_low[r]=(int16_t)ntohs(range);
+          memcpy(&range,p,sizeof(range));
+          p+=sizeof(range);
+          spectrum_high[r]=(int16_t)ntohs(range);
+        }
+        remote_pixel_samples_alloc(r,samples);
+        if(spectrum_decode(&spectrum_codec[r],p,length-(p-buffer),samples,spectrum_low[r],spectrum_high[r],
+                           spectrum_data.flags&SPECTRUM_FLAG_KEYFRAME,spectrum_data.k,receiver[r]->pixel_samples)==0) {
+          g_idle_add(ext_receiver_remote_update_display,receiver[r]);
+        }
+        }
+        break;
+      case INFO_AUDIO_CODEC:
+        {
+        AUDIO_CODEC_DATA audio_data;
+        static AUDIO_DECODER audio_decoder[8];
+        static gboolean audio_decoder_valid[8];
+        static unsigned char buffer[AUDIO_CODEC_MAX_BYTES(AUDIO_DATA_SIZE)];
+        static short output[2*(AUDIO_DATA_SIZE+AUDIO_CODEC_MAX_DECIMATION)];
+        bytes_read=recv_bytes(client_socket,(char *)&audio_data.rx,sizeof(audio_data)-sizeof(header));
+        if(bytes_read<0) {
+          g_print("client_thread: read %d bytes for AUDIO_CODEC_DATA\n",bytes_read);
+          perror("client_thread");
+          // dialog box?
+          return NULL;
+        }
+        int length=ntohs(audio_data.length);
+        if(length>(int)sizeof(buffer) || audio_data.rx>=8) {
+          g_print("client_thread: bad AUDIO_CODEC_DATA rx=%d length=%d\n",audio_data.rx,length);
+          return NULL;
+        }
+        bytes_read=recv_bytes(client_socket,(char *)buffer,length);
+        if(bytes_read<0) {
+          g_print("client_thread: read %d bytes for AUDIO_CODEC_DATA\n",bytes_read);
+          perror("client_thread");
+          return NULL;
+        }
+        int r=audio_data.rx;
+        int rate=ntohs(audio_data.rate);
+        AUDIO_DECODER *decoder=&audio_decoder[r];
+        if(!audio_decoder_valid[r] || decoder->codec!=audio_data.codec || decoder->rate!=rate || decoder->channels!=audio_data.channels) {
+          audio_decoder_valid[r]=audio_decoder_init(decoder,audio_data.codec,rate,audio_data.channels)==0;
+g_print("INFO_AUDIO_CODEC: rx=%d codec=%s rate=%d channels=%d valid=%d\n",r,audio_codec_name(audio_data.codec),rate,audio_data.channels,audio_decoder_valid[r]);
+        }
+        if(!audio_decoder_valid[r]) break;
+        int frames=audio_decode(decoder,buffer,length,ntohs(audio_data.samples),output,AUDIO_DATA_SIZE+AUDIO_CODEC_MAX_DECIMATION);
+        RECEIVER *rx=receiver[r];
+        if(rx->local_audio) {
+          for(int i=0;i<frames;i++) {
+            audio_write(rx,(float)output[i*2]/32767.0,(float)output[(i*2)+1]/32767.0);
+          }
+        }
+        }
+        break;
       case INFO_AUDIO:
         {
         AUDIO_DATA audio_data;
@@ -20,6 +20,9 @@
 #ifndef HPSDR_SERVER_H
 #define HPSDR_SERVER_H
 
+#include "spectrum_codec.h"
+#include "audio_codec.h"
+
 #ifndef __APPLE__
 #define htonll htobe64
 #define ntohll be64toh
@@ -85,6 +88,8 @@ enum {
   CMD_RESP_SWAP_IQ,
   CMD_RESP_REGION,
   CMD_RESP_MUTE_RX,
+  INFO_SPECTRUM_COMPRESSED,
+  INFO_AUDIO_CODEC,
 };
 
 enum {
@@ -93,7 +98,14 @@ enum {
   VFO_A_SWAP_B,
 };
 
-#define CLIENT_SERVER_VERSION 0LL
+//
+// Version 1: the client can decode INFO_SPECTRUM_COMPRESSED
+// Version 2: the server accepts CMD_RESP_AUDIO to select the audio format
+//            and sends INFO_AUDIO_CODEC
+//
+#define CLIENT_SERVER_VERSION 2LL
+#define CLIENT_SERVER_VERSION_SPECTRUM_COMPRESSED 1LL
+#define CLIENT_SERVER_VERSION_AUDIO_CODEC 2LL
 
 #define SPECTRUM_DATA_SIZE 800
 #define AUDIO_DATA_SIZE 1024
@@ -104,12 +116,25 @@ typedef struct _remote_rx {
   gint receiver;
   gboolean send_audio;
   gint audio_format;
+  gint audio_rate;
+  gint audio_channels;
+  AUDIO_ENCODER *audio_encoder;     // NULL: stereo 48 kHz INFO_AUDIO
   gint audio_port;
   struct sockaddr_in audio_address;
   gboolean send_spectrum;
   gint spectrum_fps;
   gint spectrum_port;
   struct sockaddr_in spectrum_address;
+  //
+  // State of the compressed spectrum stream. The header fields
+  // are only sent when they differ from the last ones sent.
+  //
+  gboolean spectrum_compressed;
+  gboolean spectrum_resync;
+  SPECTRUM_CODEC *spectrum_codec;
+  long long last_vfo[6];
+  gint last_low;
+  gint last_high;
 } REMOTE_RX;
 
 typedef struct _remote_client {
@@ -122,6 +147,18 @@ typedef struct _remote_client {
   gint receivers;
   gint spectrum_update_timer_id;
   REMOTE_RX receiver[8];
+  //
+  // Outbound data is queued here and written to the socket
+  // by a sender thread, so slow clients do not block the
+  // DSP or GTK threads.
+  //
+  GMutex send_mutex;
+  GCond send_cond;
+  GQueue *send_queue;
+  gint send_queue_bytes;
+  GThread *sender_thread_id;
+  gint spectrum_dropped;
+  gint audio_dropped;
   void *next;
 } REMOTE_CLIENT;
 
@@ -240,6 +277,25 @@ typedef struct __attribute__((__packed__)) _spectrum_data {
   uint16_t sample[SPECTRUM_DATA_SIZE];
 } SPECTRUM_DATA;
 
+//
+// A compressed spectrum frame is followed by "length" bytes:
+// six uint64 VFO values (if SPECTRUM_FLAG_VFO), the int16 range low/high
+// (if SPECTRUM_FLAG_RANGE), then the encoded samples (see spectrum_codec.h).
+//
+#define SPECTRUM_FLAG_KEYFRAME 0x01
+#define SPECTRUM_FLAG_VFO      0x02
+#define SPECTRUM_FLAG_RANGE    0x04
+
+typedef struct __attribute__((__packed__)) _spectrum_compressed_data {
+  HEADER header;
+  uint8_t rx;
+  uint8_t flags;
+  uint8_t k;
+  uint16_t meter;
+  uint16_t samples;
+  uint16_t length;
+} SPECTRUM_COMPRESSED_DATA;
+
 typedef struct __attribute__((__packed__)) _audio_data {
   HEADER header;
   uint8_t rx;
@@ -247,6 +303,27 @@ typedef struct __attribute__((__packed__)) _audio_data {
   uint16_t sample[AUDIO_DATA_SIZE*2];
 } AUDIO_DATA;
 
+//
+// An encoded audio block (see audio_codec.h) follows, with "length" bytes
+//
+typedef struct __attribute__((__packed__)) _audio_codec_data {
+  HEADER header;
+  uint8_t rx;
+  uint8_t codec;
+  uint8_t channels;
+  uint16_t rate;
+  uint16_t samples;
+  uint16_t length;
+} AUDIO_CODEC_DATA;
+
+typedef struct __attribute__((__packed__)) _audio_command {
+  HEADER header;
+  uint8_t id;
+  uint8_t codec;
+  uint8_t channels;
+  uint16_t rate;
+} AUDIO_COMMAND;
+
 typedef struct __attribute__((__packed__)) _spectrum_command {
   HEADER header;
   int8_t id;
@@ -474,6 +551,13 @@ extern gint start_spectrum(void *data);
 extern void start_vfo_timer(void);
 extern gboolean remote_started;
 
+//
+// audio format requested by the client (stored in remote.props)
+//
+extern int remote_audio_codec;
+extern int remote_audio_rate;
+extern int remote_audio_channels;
+
 
 extern REMOTE_CLIENT *clients;
 
@@ -490,6 +574,7 @@ extern void send_receiver_data(REMOTE_CLIENT *client,int rx);
 extern void send_vfo_data(REMOTE_CLIENT *client,int v);
 
 extern void send_start_spectrum(int s,int rx);
+extern void send_audio_format(int s,int rx);
 extern void send_vfo_frequency(int s,int rx,long long hz);
 extern void send_vfo_move_to(int s,int rx,long long hz);
 extern void send_vfo_move(int s,int rx,long long hz,int round);
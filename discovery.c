@@ -53,6 +53,7 @@
 #include "client_server.h"
 #endif
 #include "property.h"
+#include "capture.h"
 
 static GtkWidget *discovery_dialog;
 static DISCOVERED *d;
@@ -74,9 +75,14 @@ static char host_addr_buffer[128]="g0orx.ddns.net";
 char *host_addr = &host_addr_buffer[0];
 GtkWidget *host_port_spinner;
 gint host_port=50000;  // default listening port
+static GtkWidget *audio_codec_combo;
+static GtkWidget *audio_rate_combo;
+static GtkWidget *audio_mono_b;
+static const int audio_rates[]={48000,16000,8000};
 #endif
 
 static gboolean delete_event_cb(GtkWidget *widget, GdkEvent *event, gpointer data) {
+  flushProperties();
   _exit(0);
 }
 
@@ -138,6 +144,7 @@ static gboolean discover_cb (GtkWidget *widget, GdkEventButton *event, gpointer
 
 static gboolean exit_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
   gtk_widget_destroy(discovery_dialog);
+  flushProperties();
   _exit(0);
   return TRUE;
 }
@@ -175,6 +182,15 @@ g_print("connect_cb: %s:%d\n",host_addr,host_port);
   char temp[16];
   sprintf(temp,"%d",host_port);
   setProperty("port",temp);
+  remote_audio_codec=gtk_combo_box_get_active(GTK_COMBO_BOX(audio_codec_combo));
+  remote_audio_rate=audio_rates[gtk_combo_box_get_active(GTK_COMBO_BOX(audio_rate_combo))];
+  remote_audio_channels=gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(audio_mono_b))?1:2;
+  sprintf(temp,"%d",remote_audio_codec);
+  setProperty("audio_codec",temp);
+  sprintf(temp,"%d",remote_audio_rate);
+  setProperty("audio_rate",temp);
+  sprintf(temp,"%d",remote_audio_channels);
+  setProperty("audio_channels",temp);
   saveProperties("remote.props");
   if(radio_connect_remote(host_addr,host_port)==0) {
     gtk_widget_destroy(discovery_dialog);
@@ -274,6 +290,8 @@ void discovery() {
   }
 #endif
 
+  capture_discovery();
+
   // subsequent discoveries check all protocols enabled.
   discover_only_stemlab=0;
 
@@ -462,6 +480,12 @@ fprintf(stderr,"%p Protocol=%d name=%s\n",d,d->protocol,d->name);
     if(value!=NULL) strcpy(host_addr_buffer,value);
     value=getProperty("port");
     if(value!=NULL) host_port=atoi(value);
+    value=getProperty("audio_codec");
+    if(value!=NULL) remote_audio_codec=atoi(value);
+    value=getProperty("audio_rate");
+    if(value!=NULL) remote_audio_rate=atoi(value);
+    value=getProperty("audio_channels");
+    if(value!=NULL) remote_audio_channels=atoi(value);
 
     GtkWidget *connect_b=gtk_button_new_with_label("Connect to Server");
     g_signal_connect (connect_b, "button-press-event", G_CALLBACK(connect_cb), NULL);
@@ -483,6 +507,35 @@ fprintf(stderr,"%p Protocol=%d name=%s\n",d,d->protocol,d->name);
     gtk_grid_attach(GTK_GRID(grid),host_port_spinner,3,row,1,1);
 
     row++;
+
+    GtkWidget *audio_label =gtk_label_new(NULL);
+    gtk_label_set_markup(GTK_LABEL(audio_label), "<b>Remote Audio</b>");
+    gtk_widget_show(audio_label);
+    gtk_grid_attach(GTK_GRID(grid),audio_label,0,row,1,1);
+
+    audio_codec_combo=gtk_combo_box_text_new();
+    for (int i=0; i<AUDIO_CODECS; i++) {
+      gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(audio_codec_combo),NULL,audio_codec_name(i));
+    }
+    if (remote_audio_codec < 0 || remote_audio_codec >= AUDIO_CODECS) remote_audio_codec=AUDIO_CODEC_PCM;
+    gtk_combo_box_set_active(GTK_COMBO_BOX(audio_codec_combo),remote_audio_codec);
+    gtk_grid_attach(GTK_GRID(grid),audio_codec_combo,1,row,1,1);
+
+    audio_rate_combo=gtk_combo_box_text_new();
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(audio_rate_combo),NULL,"48 kHz");
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(audio_rate_combo),NULL,"16 kHz");
+    gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(audio_rate_combo),NULL,"8 kHz");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(audio_rate_combo),0);
+    for (int i=0; i<3; i++) {
+      if (audio_rates[i] == remote_audio_rate) gtk_combo_box_set_active(GTK_COMBO_BOX(audio_rate_combo),i);
+    }
+    gtk_grid_attach(GTK_GRID(grid),audio_rate_combo,2,row,1,1);
+
+    audio_mono_b=gtk_check_button_new_with_label("Mono");
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(audio_mono_b), remote_audio_channels == 1);
+    gtk_grid_attach(GTK_GRID(grid),audio_mono_b,3,row,1,1);
+
+    row++;
 #endif
 
 #ifdef GPIO
@@ -113,6 +113,10 @@ static void waterfall_automatic_cb(GtkWidget *widget, gpointer data) {
   active_receiver->waterfall_automatic=active_receiver->waterfall_automatic==1?0:1;
 }
 
+static void waterfall_palette_cb(GtkWidget *widget, gpointer data) {
+  active_receiver->waterfall_palette=gtk_combo_box_get_active(GTK_COMBO_BOX(widget));
+}
+
 static void display_panadapter_cb(GtkWidget *widget, gpointer data) {
   active_receiver->display_panadapter=active_receiver->display_panadapter==1?0:1;
   reconfigure_radio();
@@ -319,6 +323,23 @@ void display_menu(GtkWidget *parent) {
   gtk_grid_attach(GTK_GRID(grid),waterfall_low_r,col,row,1,1);
   g_signal_connect(waterfall_low_r,"value_changed",G_CALLBACK(waterfall_low_value_changed_cb),NULL);
 
+  col=2;
+
+  GtkWidget *waterfall_palette_label=gtk_label_new(NULL);
+  gtk_label_set_markup(GTK_LABEL(waterfall_palette_label), "<b>Waterfall Colours: </b>");
+  gtk_widget_show(waterfall_palette_label);
+  gtk_grid_attach(GTK_GRID(grid),waterfall_palette_label,col,row,1,1);
+
+  col++;
+
+  GtkWidget *waterfall_palette_b=gtk_combo_box_text_new();
+  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(waterfall_palette_b),NULL,"Colour");
+  gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(waterfall_palette_b),NULL,"Grayscale");
+  gtk_combo_box_set_active(GTK_COMBO_BOX(waterfall_palette_b),active_receiver->waterfall_palette);
+  gtk_widget_show(waterfall_palette_b);
+  gtk_grid_attach(GTK_GRID(grid),waterfall_palette_b,col,row,1,1);
+  g_signal_connect(waterfall_palette_b,"changed",G_CALLBACK(waterfall_palette_cb),NULL);
+
   col=2;
   row=1;
 
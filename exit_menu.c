@@ -33,6 +33,8 @@
 #include "soapy_protocol.h"
 #endif
 #include "actions.h"
+#include "capture.h"
+#include "property.h"
 #ifdef GPIO
 #include "gpio.h"
 #endif
@@ -112,7 +114,10 @@ g_print("exit_cb\n");
 #ifdef CLIENT_SERVER
   }
 #endif
+  capture_stop();
   radioSaveState();
+  flushProperties();
+  action_queue_report();
 
   _exit(0);
 }
@@ -134,7 +139,9 @@ static gboolean reboot_cb (GtkWidget *widget, GdkEventButton *event, gpointer da
       break;
 #endif
   }
+  capture_stop();
   radioSaveState();
+  flushProperties();
   int rc=system("reboot");
   _exit(0);
 }
@@ -156,7 +163,9 @@ static gboolean shutdown_cb (GtkWidget *widget, GdkEventButton *event, gpointer
       break;
 #endif
   }
+  capture_stop();
   radioSaveState();
+  flushProperties();
   int rc=system("shutdown -h -P now");
   _exit(0);
 }
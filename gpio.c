@@ -63,6 +63,7 @@
 #include "sliders.h"
 #include "new_protocol.h"
 #include "zoompan.h"
+#include "trace.h"
 #ifdef LOCALCW
 #include "iambic.h"
 
@@ -341,8 +342,6 @@ SWITCH *switches=switches_controller1[0];
 
 static int running=0;
 
-static GThread *rotary_encoder_thread_id;
-
 static uint64_t epochMilli;
 
 #ifdef GPIO
@@ -362,49 +361,6 @@ static unsigned int millis () {
 }
 #endif
 
-static gpointer rotary_encoder_thread(gpointer data) {
-  int i;
-  enum ACTION action;
-  enum ACTION_MODE mode;
-  gint val;
-
-  usleep(250000);
-  g_print("%s\n",__FUNCTION__);
-  while(TRUE) {
-    g_mutex_lock(&encoder_mutex);
-    for(i=0;i<MAX_ENCODERS;i++) {
-      if(encoders[i].bottom_encoder_enabled && encoders[i].bottom_encoder_pos!=0) {
-        //g_print("%s: BOTTOM encoder %d pos=%d\n",__FUNCTION__,i,encoders[i].bottom_encoder_pos);
-        action=encoders[i].bottom_encoder_function;
-        mode=RELATIVE;
-	if(action==VFO && vfo_encoder_divisor>1) {
-          val=encoders[i].bottom_encoder_pos/vfo_encoder_divisor;
-          encoders[i].bottom_encoder_pos=encoders[i].bottom_encoder_pos-(val*vfo_encoder_divisor);
-        } else {
-          val=encoders[i].bottom_encoder_pos;
-          encoders[i].bottom_encoder_pos=0;
-	}
-	if(val!=0) schedule_action(action, mode, val);
-      }
-      if(encoders[i].top_encoder_enabled && encoders[i].top_encoder_pos!=0) {
-        //g_print("%s: TOP encoder %d pos=%d\n",__FUNCTION__,i,encoders[i].top_encoder_pos);
-        action=encoders[i].top_encoder_function;
-        mode=RELATIVE;
-	if(action==VFO && vfo_encoder_divisor>1) {
-          val=encoders[i].top_encoder_pos/vfo_encoder_divisor;
-          encoders[i].top_encoder_pos=encoders[i].top_encoder_pos-(val*vfo_encoder_divisor);
-        } else {
-          val=encoders[i].top_encoder_pos;
-          encoders[i].top_encoder_pos=0;
-	}
-	if(val!=0) schedule_action(action, mode, val);
-      }
-    }
-    g_mutex_unlock(&encoder_mutex);
-    usleep(100000); // sleep for 100ms
-  }
-}
-
 int process_function_switch(void *data) {
   function++;
   if(function>=MAX_FUNCTIONS) {
@@ -417,8 +373,85 @@ int process_function_switch(void *data) {
 
 #ifdef GPIO
 
-static void process_encoder(int e,int l,int addr,int val) {
+//
+// Called from the gpiod monitor thread (with encoder_mutex held) for
+// every detent of an encoder, with the kernel time stamp of the edge.
+//
+// The time between detents gives the speed of the knob. Above
+// ENCODER_ACCEL_SPEED steps/sec, each detent counts as more than one step
+// (up to encoder_acceleration steps). The steps are handed to the action
+// queue at once, which merges them if they arrive faster than they
+// can be processed.
+//
+// The speed starts again from zero after a pause of more than
+// ENCODER_ACCEL_PAUSE, and when the knob is turned the other way, so
+// that a slow or reversed detent is never multiplied.
+//
+#define ENCODER_ACCEL_SPEED 20.0
+#define ENCODER_ACCEL_PAUSE 200000000LL   // nsec
+
+static void encoder_moved(int e,int l,int dir,const struct timespec *ts) {
+  gint *pos;
+  gint64 *last;
+  double *speed;
+  gint *last_dir;
+  gint function;
+  gint64 t=(gint64)ts->tv_sec*1000000000LL+ts->tv_nsec;
+  int divisor=1;
+  int factor=1;
+  gint val;
+  struct timespec now;
+
+  if(l==BOTTOM_ENCODER) {
+    pos=&encoders[e].bottom_encoder_pos;
+    last=&encoders[e].bottom_encoder_time;
+    speed=&encoders[e].bottom_encoder_speed;
+    last_dir=&encoders[e].bottom_encoder_dir;
+    function=encoders[e].bottom_encoder_function;
+  } else {
+    pos=&encoders[e].top_encoder_pos;
+    last=&encoders[e].top_encoder_time;
+    speed=&encoders[e].top_encoder_speed;
+    last_dir=&encoders[e].top_encoder_dir;
+    function=encoders[e].top_encoder_function;
+  }
+  if(function==VFO && vfo_encoder_divisor>1) {
+    divisor=vfo_encoder_divisor;
+  }
+
+  //
+  // speed in steps/sec, smoothed over the last few detents
+  //
+  if(*last!=0 && t>*last && t-*last<=ENCODER_ACCEL_PAUSE && dir==*last_dir) {
+    *speed=0.7*(*speed)+0.3*(1E9/(double)(t-*last)/(double)divisor);
+  } else {
+    *speed=0.0;
+  }
+  *last=t;
+  *last_dir=dir;
+  if(encoder_acceleration>1 && *speed>ENCODER_ACCEL_SPEED) {
+    factor=(int)(*speed/ENCODER_ACCEL_SPEED);
+    if(factor>encoder_acceleration) factor=encoder_acceleration;
+  }
+
+  *pos+=dir*factor;
+  val=*pos/divisor;
+  *pos-=val*divisor;
+  if(val!=0) {
+    schedule_action(SOURCE_GPIO, function, RELATIVE, val);
+    //
+    // delay from the edge to the action queue, if the kernel time stamps
+    // are CLOCK_MONOTONIC (Linux 5.7 and later)
+    //
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    TRACE_EVENT(TRACE_GPIO_ENCODER, (e<<8) | l, val);
+    TRACE_EVENT(TRACE_GPIO_LATENCY, e, (int)(((gint64)now.tv_sec*1000000000LL+now.tv_nsec-t)/1000));
+  }
+}
+
+static void process_encoder(int e,int l,int addr,int val,const struct timespec *ts) {
   guchar pinstate;
+  int dir=0;
   //g_print("%s: encoder=%d level=%d addr=0x%02X val=%d\n",__FUNCTION__,e,l,addr,val);
   g_mutex_lock(&encoder_mutex);
   switch(l) {
@@ -433,10 +466,10 @@ static void process_encoder(int e,int l,int addr,int val) {
             case DIR_NONE:
               break;
             case DIR_CW:
-              encoders[e].bottom_encoder_pos++;
+              dir=1;
               break;
             case DIR_CCW:
-              encoders[e].bottom_encoder_pos--;
+              dir=-1;
               break;
             default:
               break;
@@ -453,10 +486,10 @@ static void process_encoder(int e,int l,int addr,int val) {
             case DIR_NONE:
               break;
             case DIR_CW:
-              encoders[e].bottom_encoder_pos++;
+              dir=1;
               break;
             case DIR_CCW:
-              encoders[e].bottom_encoder_pos--;
+              dir=-1;
               break;
             default:
               break;
@@ -478,10 +511,10 @@ static void process_encoder(int e,int l,int addr,int val) {
             case DIR_NONE:
               break;
             case DIR_CW:
-              encoders[e].top_encoder_pos++;
+              dir=1;
               break;
             case DIR_CCW:
-              encoders[e].top_encoder_pos--;
+              dir=-1;
               break;
             default:
               break;
@@ -497,10 +530,10 @@ static void process_encoder(int e,int l,int addr,int val) {
             case DIR_NONE:
               break;
             case DIR_CW:
-              encoders[e].top_encoder_pos++;
+              dir=1;
               break;
             case DIR_CCW:
-              encoders[e].top_encoder_pos--;
+              dir=-1;
               break;
             default:
               break;
@@ -511,15 +544,19 @@ static void process_encoder(int e,int l,int addr,int val) {
       }
       break;
   }
+  if(dir!=0) {
+    encoder_moved(e,l,dir,ts);
+  }
   g_mutex_unlock(&encoder_mutex);
 }
 
-static void process_edge(int offset,int value) {
+static void process_edge(int offset,int value,const struct timespec *ts) {
   gint i;
   unsigned int t;
   gboolean found;
 
   //g_print("%s: offset=%d value=%d\n",__FUNCTION__,offset,value);
+  TRACE_EVENT(TRACE_GPIO_EDGE, offset, value);
   found=FALSE;
 #ifdef LOCALCW
   if(ENABLE_CW_BUTTONS) {
@@ -537,22 +574,22 @@ static void process_edge(int offset,int value) {
   for(i=0;i<MAX_ENCODERS;i++) {
     if(encoders[i].bottom_encoder_enabled && encoders[i].bottom_encoder_address_a==offset) {
       //g_print("%s: found %d encoder %d bottom A\n",__FUNCTION__,offset,i);
-      process_encoder(i,BOTTOM_ENCODER,A,value==PRESSED?1:0);
+      process_encoder(i,BOTTOM_ENCODER,A,value==PRESSED?1:0,ts);
       found=TRUE;
       break;
     } else if(encoders[i].bottom_encoder_enabled && encoders[i].bottom_encoder_address_b==offset) {
       //g_print("%s: found %d encoder %d bottom B\n",__FUNCTION__,offset,i);
-      process_encoder(i,BOTTOM_ENCODER,B,value==PRESSED?1:0);
+      process_encoder(i,BOTTOM_ENCODER,B,value==PRESSED?1:0,ts);
       found=TRUE;
       break;
     } else if(encoders[i].top_encoder_enabled && encoders[i].top_encoder_address_a==offset) {
       //g_print("%s: found %d encoder %d top A\n",__FUNCTION__,offset,i);
-      process_encoder(i,TOP_ENCODER,A,value==PRESSED?1:0);
+      process_encoder(i,TOP_ENCODER,A,value==PRESSED?1:0,ts);
       found=TRUE;
       break;
     } else if(encoders[i].top_encoder_enabled && encoders[i].top_encoder_address_b==offset) {
       //g_print("%s: found %d encoder %d top B\n",__FUNCTION__,offset,i);
-      process_encoder(i,TOP_ENCODER,B,value==PRESSED?1:0);
+      process_encoder(i,TOP_ENCODER,B,value==PRESSED?1:0,ts);
       found=TRUE;
       break;
     } else if(encoders[i].switch_enabled && encoders[i].switch_address==offset) {
@@ -563,7 +600,8 @@ static void process_edge(int offset,int value) {
         return;
       }
       encoders[i].switch_debounce=t+settle_time;
-      schedule_action(encoders[i].switch_function, value, 0);
+      TRACE_EVENT(TRACE_GPIO_SWITCH, encoders[i].switch_function, value);
+      schedule_action(SOURCE_GPIO, encoders[i].switch_function, value, 0);
       found=TRUE;
       break;
     }
@@ -589,7 +627,8 @@ static void process_edge(int offset,int value) {
         }
 //g_print("%s: switches=%p function=%d (%s)\n",__FUNCTION__,switches,switches[i].switch_function,sw_string[switches[i].switch_function]);
         switches[i].switch_debounce=t+settle_time;
-        schedule_action(switches[i].switch_function, value, 0);
+        TRACE_EVENT(TRACE_GPIO_SWITCH, switches[i].switch_function, value);
+        schedule_action(SOURCE_GPIO, switches[i].switch_function, value, 0);
         break;
       }
     }
@@ -601,7 +640,10 @@ static void process_edge(int offset,int value) {
   }
 }
 
-static int interrupt_cb(int event_type, unsigned int line, const struct timespec *timeout, void* data) {
+//
+// The third argument is the (kernel) time stamp of the event
+//
+static int interrupt_cb(int event_type, unsigned int line, const struct timespec *ts, void* data) {
   //g_print("%s: event=%d line=%d\n",__FUNCTION__,event_type,line);
   switch(event_type) {
     case GPIOD_CTXLESS_EVENT_CB_TIMEOUT:
@@ -610,11 +652,11 @@ static int interrupt_cb(int event_type, unsigned int line, const struct timespec
       break;
     case GPIOD_CTXLESS_EVENT_CB_RISING_EDGE:
       //g_print("%s: Ignore RISING EDGE\n",__FUNCTION__);
-      process_edge(line,RELEASED);
+      process_edge(line,RELEASED,ts);
       break;
     case GPIOD_CTXLESS_EVENT_CB_FALLING_EDGE:
       //g_print("%s: Process FALLING EDGE\n",__FUNCTION__);
-      process_edge(line,PRESSED);
+      process_edge(line,PRESSED,ts);
       break;
   }
   return GPIOD_CTXLESS_EVENT_CB_RET_OK;
@@ -1069,14 +1111,6 @@ int gpio_init() {
       g_print("%s: g_thread_new failed for monitor_thread\n",__FUNCTION__);
     }
 
-    if(controller!=NO_CONTROLLER) {
-      rotary_encoder_thread_id = g_thread_new( "encoders", rotary_encoder_thread, NULL);
-      if(!rotary_encoder_thread_id ) {
-        g_print("%s: g_thread_new failed on rotary_encoder_thread\n",__FUNCTION__);
-        exit( -1 );
-      }
-      g_print("%s: rotary_encoder_thread: id=%p\n",__FUNCTION__,rotary_encoder_thread_id);
-    }
   }
 
 #endif
@@ -48,6 +48,12 @@ typedef struct _encoder {
   gint switch_address;
   gint switch_function;
   gulong switch_debounce;
+  gint64 bottom_encoder_time;     // time stamp (nsec) of the last detent
+  double bottom_encoder_speed;    // steps/sec
+  gint bottom_encoder_dir;        // direction of the last detent
+  gint64 top_encoder_time;
+  double top_encoder_speed;
+  gint top_encoder_dir;
 } ENCODER;
 
 extern ENCODER *encoders;
@@ -62,6 +62,7 @@
 #include <sys/time.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #ifdef __APPLE__
@@ -182,6 +183,8 @@ static int active_thread = 0;
 
 static void process_ep2(uint8_t *frame);
 static void *handler_ep6(void *arg);
+static void *handler_ep6_load(void *arg);
+static void ep6_control(uint8_t *pointer);
 
 
 static double  last_i_sample=0.0;
@@ -235,6 +238,7 @@ int main(int argc, char *argv[])
 
 	// seed value for random number generator
 	seed = ((uintptr_t) &seed) & 0xffffff;
+        impair_seed=1;
         diversity=0;
         noiseblank=0;
         nb_pulse=0;
@@ -257,6 +261,16 @@ int main(int argc, char *argv[])
             if (!strncmp(argv[i],"-diversity",   10))  {diversity=1;}
             if (!strncmp(argv[i],"-P1",           3))  {oldnew=1;}
             if (!strncmp(argv[i],"-P2",           3))  {oldnew=2;}
+            if (!strncmp(argv[i],"-load",         5))  {loadgen=1;}
+            if (!strncmp(argv[i],"-receivers",   10) && i < argc-1)  {loadgen=1; load_receivers=atoi(argv[++i]);}
+            if (!strncmp(argv[i],"-rate",         5) && i < argc-1)  {loadgen=1; load_rate=atoi(argv[++i]);}
+            if (!strncmp(argv[i],"-duration",     9) && i < argc-1)  {loadgen=1; load_duration=atoi(argv[++i]);}
+            if (!strncmp(argv[i],"-loss",         5) && i < argc-1)  {impair_loss=0.01*atof(argv[++i]);}
+            if (!strncmp(argv[i],"-burst",        6) && i < argc-2)  {impair_burst=0.01*atof(argv[++i]); impair_burstlen=atoi(argv[++i]);}
+            if (!strncmp(argv[i],"-reorder",      8) && i < argc-2)  {impair_reorder=0.01*atof(argv[++i]); impair_reorder_depth=atoi(argv[++i]);}
+            if (!strncmp(argv[i],"-dup",          4) && i < argc-1)  {impair_dup=0.01*atof(argv[++i]);}
+            if (!strncmp(argv[i],"-jitter",       7) && i < argc-1)  {impair_jitter=(int) (1000.0*atof(argv[++i]));}
+            if (!strncmp(argv[i],"-seed",         5) && i < argc-1)  {impair_seed=strtoul(argv[++i], NULL, 0);}
             if (!strncmp(argv[i],"-nb",           3))  {
 		noiseblank=1;
                 if (i < argc-1) sscanf(argv[++i],"%d",&nb_pulse);
@@ -266,6 +280,28 @@ int main(int argc, char *argv[])
             }
         }
 
+        if (loadgen) {
+            if (load_rate != 0 && load_rate != 48 && load_rate != 96 && load_rate != 192 && load_rate != 384 &&
+                load_rate != 768 && load_rate != 1536) {
+                fprintf(stderr,"Invalid rate %d (48, 96, 192, 384 kHz, for P2 also 768 and 1536 kHz)\n", load_rate);
+                return EXIT_FAILURE;
+            }
+            if (load_receivers < 0 || load_receivers > 8) {
+                fprintf(stderr,"Invalid number of receivers %d (1-8 for P1, 1-4 for P2)\n", load_receivers);
+                return EXIT_FAILURE;
+            }
+            fprintf(stderr,"LOAD GENERATOR mode: receivers=%d rate=%d duration=%d (0: as requested)\n",
+                    load_receivers, load_rate, load_duration);
+        }
+
+        if (impair_active()) {
+            if (impair_burstlen < 1) impair_burstlen=1;
+            if (impair_reorder_depth < 1) impair_reorder_depth=1;
+            fprintf(stderr,"NETWORK IMPAIRMENTS: loss=%g%% burst=%g%% (length %d) reorder=%g%% (depth %d) dup=%g%% jitter=%d usec seed=%u\n",
+                    100.0*impair_loss, 100.0*impair_burst, impair_burstlen, 100.0*impair_reorder, impair_reorder_depth,
+                    100.0*impair_dup, impair_jitter, impair_seed);
+        }
+
         switch (OLDDEVICE) {
             case   DEVICE_METIS:        fprintf(stderr,"DEVICE is ATLAS/METIS\n");   c1=3.3; c2=0.090; break;
             case   DEVICE_HERMES:       fprintf(stderr,"DEVICE is HERMES\n");        c1=3.3; c2=0.095; break;
@@ -1241,23 +1277,79 @@ void process_ep2(uint8_t *frame)
 	}
 }
 
+static uint8_t ep6_header[40] =
+{
+//                     C0  C1  C2  C3  C4
+	127, 127, 127,  0,  0, 33, 18, 21,
+	127, 127, 127,  8,  0,  0,  0,  0,
+	127, 127, 127, 16,  0,  0,  0,  0,
+	127, 127, 127, 24,  0,  0,  0,  0,
+	127, 127, 127, 32, 66, 66, 66, 66
+};
+static int ep6_header_offset;
+
+//
+// Put the SYNC and C&C bytes of the next 512-byte block, cycling
+// through the five C&C addresses
+//
+static void ep6_control(uint8_t *pointer)
+{
+	int j;
+
+	memcpy(pointer, ep6_header + ep6_header_offset, 8);
+
+	switch (ep6_header_offset) {
+	    case 0:
+		if (OLDDEVICE == DEVICE_HERMES_LITE2) {
+		  *(pointer+4) = 0;
+		  // C2/C3 is TX FIFO count
+		  *(pointer+5) = 0;
+		  *(pointer+6) = 0;
+		}
+		ep6_header_offset=8;
+		break;
+	    case 8:
+		if (OLDDEVICE == DEVICE_HERMES_LITE2) {
+		  // HL2: temperature
+		  *(pointer+4) =  3;
+		  *(pointer+5) =112;  // 3*256 + 112 = 880 ==> 20.0 degrees centigrade
+		} else {
+		  // AIN5: Exciter power
+		  *(pointer+4)=0;		// about 500 mW
+		  *(pointer+5)=txdrive;
+		}
+		// AIN1: Forward Power
+		j=(int) ((4095.0/c1)*sqrt(100.0*txlevel*c2));
+		*(pointer+6)=(j >> 8) & 0xFF;
+		*(pointer+7)=(j     ) & 0xFF;
+		ep6_header_offset=16;
+		break;
+	    case 16:
+		// AIN2: Reverse power; stays at zero
+		// AIN3: stays at zero (PA current for HL2)
+		ep6_header_offset=24;
+		break;
+	    case 24:
+		// AIN4:
+		// AIN5: supply voltage
+		*(pointer+6) = 0;
+		*(pointer+7) = 63;
+		ep6_header_offset=32;
+		break;
+	    case 32:
+		ep6_header_offset=0;
+		break;
+	}
+}
+
 void *handler_ep6(void *arg)
 {
 	int i, j, k, n, size;
-	int data_offset, header_offset;
+	int data_offset;
 	uint32_t counter;
 	uint8_t buffer[1032];
 	uint8_t *pointer;
 	uint8_t id[4] = { 0xef, 0xfe, 1, 6 };
-	uint8_t header[40] =
-	{
-//                             C0  C1  C2  C3  C4
-		127, 127, 127,  0,  0, 33, 18, 21,
-		127, 127, 127,  8,  0,  0,  0,  0,
-		127, 127, 127, 16,  0,  0,  0,  0,
-		127, 127, 127, 24,  0,  0,  0,  0,
-		127, 127, 127, 32, 66, 66, 66, 66
-	};
         int32_t adc1isample,adc1qsample;
         int32_t adc2isample,adc2qsample;
         int32_t dacisample,dacqsample;
@@ -1272,12 +1364,18 @@ void *handler_ep6(void *arg)
         int decimation;  // for converting 1536 kHz samples to 48, 192, 384, ....
         unsigned int seed;
         unsigned int tx_fifo_count;
+        IMPAIR_STREAM *imp;
+
+	if (loadgen) return handler_ep6_load(arg);
+
+	// no impairments for TCP
+	imp = sock_TCP_Client > -1 ? NULL : impair_stream_new("EP6", 0);
 
 	seed=((uintptr_t) &seed) & 0xffffff;
 
 	memcpy(buffer, id, 4);
 
-	header_offset = 0;
+	ep6_header_offset = 0;
 	counter = 0;
 
 	noiseIQpt=0;
@@ -1318,51 +1416,8 @@ void *handler_ep6(void *arg)
 		for (i = 0; i < 2; ++i)
 		{
 		    pointer = buffer + i * 516 - i % 2 * 4 + 8;
-		    memcpy(pointer, header + header_offset, 8);
-
-		    switch (header_offset) {
-			case 0:
-                            if (OLDDEVICE == DEVICE_HERMES_LITE2) {
-			      *(pointer+4) = 0;
-			      // C2/C3 is TX FIFO count
-			      *(pointer+5) = 0;
-			      *(pointer+6) = 0;
-                            }
-			    header_offset=8;
-			    break;
-			case 8:
-                            if (OLDDEVICE == DEVICE_HERMES_LITE2) {
-			      // HL2: temperature
-			      *(pointer+4) =  3;
-			      *(pointer+5) =112;  // 3*256 + 112 = 880 ==> 20.0 degrees centigrade
-                            } else {
-			      // AIN5: Exciter power
-			      *(pointer+4)=0;		// about 500 mW
-			      *(pointer+5)=txdrive;
-                            }
-			    // AIN1: Forward Power
-			    j=(int) ((4095.0/c1)*sqrt(100.0*txlevel*c2));
-			    *(pointer+6)=(j >> 8) & 0xFF;
-			    *(pointer+7)=(j     ) & 0xFF;
-			    header_offset=16;
-			    break;
-			case 16:
-			    // AIN2: Reverse power; stays at zero
-			    // AIN3: stays at zero (PA current for HL2)
-			    header_offset=24;
-			    break;
-			case 24:
-			    // AIN4:
-			    // AIN5: supply voltage
-			    *(pointer+6) = 0;
-			    *(pointer+7) = 63;	
-			    header_offset=32;
-			    break;
-			case 32:
-			    header_offset=0;
-			    break;
-		    }
-			    
+		    ep6_control(pointer);
+
 		    pointer += 8;
 		    memset(pointer, 0, 504);
 		    fac1=rxatt_dbl[0]*0.0002239;	// Amplitude of 800-Hz-signal to ADC1
@@ -1483,10 +1538,126 @@ void *handler_ep6(void *arg)
 		}
 		else
 		{
-			sendto(sock_udp, buffer, 1032, 0, (struct sockaddr *)&addr_old, sizeof(addr_old));
+			impair_sendto(imp, sock_udp, buffer, 1032, &addr_old);
 		}
 
 	}
+	impair_stream_free(imp);
+	active_thread = 0;
+	return NULL;
+}
+
+//
+// handler_ep6 of the load generator: the samples are taken from a
+// template and the packets are sent in batches (see loadgen.c).
+// Each packet is made of five pieces: the METIS header with the
+// sequence number, and SYNC/C&C plus 504 sample bytes for each of
+// the two blocks.
+//
+static void *handler_ep6_load(void *arg)
+{
+	LOAD_TEMPLATE tmpl;
+	LOAD_CLOCK clk;
+	LOAD_STREAM stream;
+	struct iovec iov[LOAD_BATCH*5];
+	uint8_t header[LOAD_BATCH][8];
+	uint8_t control[LOAD_BATCH][16];
+	uint8_t id[4] = { 0xef, 0xfe, 1, 6 };
+	uint32_t counter;
+	int block, myrate, myreceivers, r, k, i, n, due;
+	long long now;
+	IMPAIR_STREAM *imp;
+
+	memset(&tmpl, 0, sizeof(tmpl));
+	memset(&stream, 0, sizeof(stream));
+	ep6_header_offset = 0;
+	counter = 0;
+	block = 0;
+	myrate = -1;
+	myreceivers = -1;
+	load_clock_start(&clk);
+	now = clk.start;
+	// no impairments for TCP
+	imp = sock_TCP_Client > -1 ? NULL : impair_stream_new("EP6", 0);
+
+	while (enable_thread)
+	{
+		r = load_receivers > 0 ? load_receivers : receivers;
+		if (r < 1) r = 1;
+		if (load_rate > 0 && load_rate <= 384) {
+		    k = load_rate;
+		} else if (rate > 0) {
+		    k = 48 << rate;
+		} else {
+		    k = 48;
+		}
+		if (k != myrate || r != myreceivers) {
+		    if (r != receivers || rate < 0 || (48 << rate) != k) {
+			fprintf(stderr,"LOAD: sending %d receivers at %d kHz, the SDR program requested %d at %d kHz\n",
+				r, k, receivers, rate < 0 ? 0 : 48 << rate);
+		    }
+		    if (load_template(&tmpl, k, r, 504 / (6*r+2), 2, 504) < 0) {
+			fprintf(stderr,"LOAD: cannot make template\n");
+			break;
+		    }
+		    myrate = k;
+		    myreceivers = r;
+		    block = 0;
+		    // do not count the time for making the template as lateness
+		    load_clock_start(&clk);
+		    now = clk.start;
+		    load_stream_start(&stream, now, myrate, 2*tmpl.slots);
+		}
+
+		now = load_tick(&clk);
+		impair_flush(imp, 0);
+		due = load_due(&stream, now);
+		while (due > 0)
+		{
+		    n = due > LOAD_BATCH ? LOAD_BATCH : due;
+		    for (i = 0; i < n; i++)
+		    {
+			memcpy(header[i], id, 4);
+			*(uint32_t *)(header[i] + 4) = htonl(counter);
+			counter++;
+			ep6_control(control[i]);
+			ep6_control(control[i] + 8);
+			iov[5*i  ].iov_base = header[i];
+			iov[5*i  ].iov_len  = 8;
+			iov[5*i+1].iov_base = control[i];
+			iov[5*i+1].iov_len  = 8;
+			iov[5*i+2].iov_base = tmpl.data + block*504;
+			iov[5*i+2].iov_len  = 504;
+			if (++block >= tmpl.blocks) block = 0;
+			iov[5*i+3].iov_base = control[i] + 8;
+			iov[5*i+3].iov_len  = 8;
+			iov[5*i+4].iov_base = tmpl.data + block*504;
+			iov[5*i+4].iov_len  = 504;
+			if (++block >= tmpl.blocks) block = 0;
+		    }
+		    if (sock_TCP_Client > -1)
+		    {
+			load_send(&stream, NULL, sock_TCP_Client, NULL, iov, 5, n);
+		    }
+		    else
+		    {
+			load_send(&stream, imp, sock_udp, &addr_old, iov, 5, n);
+		    }
+		    due -= n;
+		}
+
+		if (load_expired(&clk, now))
+		{
+		    load_report("EP6", &stream, now);
+		    load_clock_report(&clk, now);
+		    impair_stream_free(imp);
+		    exit(EXIT_SUCCESS);
+		}
+	}
+	load_report("EP6", &stream, now);
+	load_clock_report(&clk, now);
+	impair_stream_free(imp);
+	load_template_free(&tmpl);
 	active_thread = 0;
 	return NULL;
 }
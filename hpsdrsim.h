@@ -120,3 +120,112 @@ extern int clock_nanosleep(clockid_t __clock_id, int __flags,
 #define IM3a  0.60
 #define IM3b  0.20
 
+
+//
+// Load generator (see loadgen.c). Any of -receivers, -rate and -duration
+// implies -load. -receivers and -rate override what the SDR program
+// requests, so it must be set up the same way.
+//
+#define LOAD_BATCH 64          // max. packets per sendmmsg
+
+EXTERN int loadgen;            // load generator mode
+EXTERN int load_receivers;     // if > 0: number of receivers (P1) or DDCs (P2)
+EXTERN int load_rate;          // if > 0: sample rate in kHz
+EXTERN int load_duration;      // if > 0: report and exit after this many seconds
+
+//
+// A loop of packed RX sample blocks for one sample rate and layout.
+// Each block has "slots" samples of "channels" receivers (6 bytes
+// each) followed by "pad" bytes, and is "blocksize" bytes long.
+//
+typedef struct _load_template {
+  int rate;
+  int channels;
+  int slots;
+  int pad;
+  int blocksize;
+  int blocks;
+  unsigned char *data;
+} LOAD_TEMPLATE;
+
+//
+// Pacing of the sending thread, and counters of one stream of packets
+//
+typedef struct _load_clock {
+  struct timespec next;
+  struct timespec cpu;
+  long long start;
+  long ticks;
+  long late;
+  long long maxlate;
+} LOAD_CLOCK;
+
+typedef struct _load_stream {
+  long long start;
+  int rate;                    // kHz
+  int samples;                 // samples per packet
+  long long packets;
+  long long skipped;
+  long long bytes;
+  long long calls;
+  long long errors;
+} LOAD_STREAM;
+
+//
+// Network impairments (see netimpair.c), a stream is NULL if there are none
+//
+#define IMPAIR_HELD   1024     // max. packets held back per stream
+#define IMPAIR_MAXLEN 1444     // max. length of a packet that can be held back
+
+EXTERN double       impair_loss;           // probability that a packet is lost
+EXTERN double       impair_burst;          // probability that a burst loss starts
+EXTERN int          impair_burstlen;       // mean length of a burst loss, in packets
+EXTERN double       impair_reorder;        // probability that a packet is held back ...
+EXTERN int          impair_reorder_depth;  // ... behind this many packets
+EXTERN double       impair_dup;            // probability that a packet is sent twice
+EXTERN int          impair_jitter;         // max. delay of a packet, in usec
+EXTERN unsigned int impair_seed;
+
+typedef struct _impair_packet {
+  unsigned char data[IMPAIR_MAXLEN];
+  int len;
+  int sock;
+  int to_valid;
+  struct sockaddr_in to;
+  long long due_packet;                    // send before this packet of the stream ...
+  long long due_usec;                      // ... and not before this time
+} IMPAIR_PACKET;
+
+typedef struct _impair_stream {
+  char name[16];
+  uint64_t rng;
+  int burst;
+  long long packets;
+  long long dropped;
+  long long burst_dropped;
+  long long bursts;
+  long long duplicated;
+  long long reordered;
+  long long delayed;
+  long long errors;
+  int held;
+  IMPAIR_PACKET queue[IMPAIR_HELD];
+} IMPAIR_STREAM;
+
+int            impair_active(void);
+IMPAIR_STREAM *impair_stream_new(const char *name, int id);
+void           impair_stream_free(IMPAIR_STREAM *s);
+int            impair_sendto(IMPAIR_STREAM *s, int sock, const unsigned char *data, int len, struct sockaddr_in *to);
+void           impair_flush(IMPAIR_STREAM *s, int all);
+void           impair_report(IMPAIR_STREAM *s);
+
+int       load_template(LOAD_TEMPLATE *t, int rate, int channels, int slots, int pad, int blocksize);
+void      load_template_free(LOAD_TEMPLATE *t);
+void      load_clock_start(LOAD_CLOCK *c);
+long long load_tick(LOAD_CLOCK *c);
+int       load_expired(LOAD_CLOCK *c, long long now);
+void      load_stream_start(LOAD_STREAM *s, long long now, int rate, int samples);
+int       load_due(LOAD_STREAM *s, long long now);
+int       load_send(LOAD_STREAM *s, IMPAIR_STREAM *imp, int sock, struct sockaddr_in *to, struct iovec *iov, int iovlen, int n);
+void      load_report(const char *name, LOAD_STREAM *s, long long now);
+void      load_clock_report(LOAD_CLOCK *c, long long now);
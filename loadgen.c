@@ -0,0 +1,328 @@
+/*
+ * Load generator for the HPSDR simulator (hpsdrsim -load)
+ *
+ * In the normal mode, the simulator computes each RX sample when it
+ * sends it, with branches for PTT, diversity etc. and with the device
+ * specific routing of the ADCs. This is fine for testing the SDR program
+ * but too slow to drive it at the highest sample rates with many
+ * receivers.
+ *
+ * In the load generator mode, the samples (ADC noise plus the 800 Hz
+ * tone, attenuator, PTT and diversity are ignored) are computed once
+ * for a given sample rate and receiver layout and stored in "templates":
+ * a loop of packed blocks, exactly in the format they have in the
+ * packets (24-bit big endian I/Q, receivers interleaved). Sending a
+ * packet is then only pointing an iovec to the next block, with a small
+ * header in front, and the packets that are due are sent in batches with
+ * sendmmsg every millisecond.
+ *
+ * The noise is made by hashing the sample number, and the tone is taken
+ * from a table of one period, so both loops run on plain arrays and are
+ * vectorized by the compiler (this file is compiled with -O3). The
+ * number of blocks in a template is chosen such that the tone continues
+ * seamlessly when the template starts over.
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE    // for sendmmsg
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#ifdef __APPLE__
+#include "MacOS.h"  // emulate clock_gettime on old MacOS systems
+#endif
+
+#define EXTERN extern
+#include "hpsdrsim.h"
+
+#define LOAD_CHUNK   4096      // samples synthesized at a time
+#define LOAD_MINLOOP 2         // a template lasts at least 1/2 second
+#define LOAD_TICK    1000000L  // nsec between two batches
+#define LOAD_MAXLAG  100000    // usec a stream may fall behind before it is re-started
+
+#define NOISE_AMP 0.00003f     // same as noiseItab
+#define TONE_AMP  0.0002239f   // -73 dBm, same as the normal mode
+
+static int gcd(int a, int b) {
+  int t;
+  while (b) {
+    t=a % b;
+    a=b;
+    b=t;
+  }
+  return a;
+}
+
+//
+// n noise samples, uniformly distributed in [-NOISE_AMP, NOISE_AMP],
+// plus the tone. The noise of sample s of channel key is a hash of
+// (s, key), the tone of sample s is tone[s % period].
+//
+static void synth(float *out, const float *tone, int period, uint32_t key, long first, int n) {
+  int k, j, m, len;
+  uint32_t x;
+
+  for (k=0; k<n; k++) {
+    x=((uint32_t) (first+k)) * 0x9E3779B1u ^ key;
+    x ^= x >> 15;
+    x *= 0x2C1B3C6Du;
+    x ^= x >> 12;
+    x *= 0x297A2D39u;
+    x ^= x >> 15;
+    out[k]=(float) (int32_t) x * (NOISE_AMP / 2147483648.0f);
+  }
+  j=first % period;
+  k=0;
+  while (k < n) {
+    len=period-j;
+    if (len > n-k) len=n-k;
+    for (m=0; m<len; m++) {
+      out[k+m] += tone[j+m];
+    }
+    k += len;
+    j=0;
+  }
+}
+
+static void to_int(int32_t *out, const float *in, int n) {
+  int k;
+  for (k=0; k<n; k++) {
+    out[k]=(int32_t) (in[k] * 8388607.0f);
+  }
+}
+
+int load_template(LOAD_TEMPLATE *t, int rate, int channels, int slots, int pad, int blocksize) {
+  float *tonei, *toneq, *fi, *fq;
+  int32_t *vi, *vq;
+  int period, decimation, base, loops;
+  long total, first, s;
+  int c, k, n;
+  unsigned char *p;
+
+  load_template_free(t);
+  if (rate < 48 || rate > 1536 || 1536 % rate != 0 || channels < 1 || slots < 1) return -1;
+  if (slots*(6*channels+pad) > blocksize) return -1;
+
+  //
+  // one period of the tone at this rate, and enough blocks for an
+  // integer number of periods lasting at least 1/LOAD_MINLOOP seconds
+  //
+  decimation=1536 / rate;
+  period=LENTONE / decimation;
+  base=period / gcd(period, slots);
+  loops=(rate*1000/LOAD_MINLOOP + base*slots - 1) / (base*slots);
+
+  t->rate=rate;
+  t->channels=channels;
+  t->slots=slots;
+  t->pad=pad;
+  t->blocksize=blocksize;
+  t->blocks=base*loops;
+  t->data=calloc((size_t) t->blocks, (size_t) blocksize);
+  if (t->data == NULL) {
+    t->blocks=0;
+    return -1;
+  }
+
+  tonei=malloc(period*sizeof(float));
+  toneq=malloc(period*sizeof(float));
+  fi=malloc(LOAD_CHUNK*sizeof(float));
+  fq=malloc(LOAD_CHUNK*sizeof(float));
+  vi=malloc(LOAD_CHUNK*sizeof(int32_t));
+  vq=malloc(LOAD_CHUNK*sizeof(int32_t));
+  for (k=0; k<period; k++) {
+    tonei[k]=(float) toneItab[k*decimation] * TONE_AMP;
+    toneq[k]=(float) toneQtab[k*decimation] * TONE_AMP;
+  }
+
+  total=(long) t->blocks * slots;
+  for (c=0; c<channels; c++) {
+    for (first=0; first < total; first += LOAD_CHUNK) {
+      n=total-first < LOAD_CHUNK ? total-first : LOAD_CHUNK;
+      synth(fi, tonei, period, 2*c+1, first, n);
+      synth(fq, toneq, period, 2*c+2, first, n);
+      to_int(vi, fi, n);
+      to_int(vq, fq, n);
+      for (k=0; k<n; k++) {
+        s=first+k;
+        p=t->data + (s / slots)*blocksize + (s % slots)*(6*channels+pad) + 6*c;
+        p[0]=(vi[k] >> 16) & 0xFF;
+        p[1]=(vi[k] >>  8) & 0xFF;
+        p[2]=(vi[k] >>  0) & 0xFF;
+        p[3]=(vq[k] >> 16) & 0xFF;
+        p[4]=(vq[k] >>  8) & 0xFF;
+        p[5]=(vq[k] >>  0) & 0xFF;
+      }
+    }
+  }
+  free(tonei);
+  free(toneq);
+  free(fi);
+  free(fq);
+  free(vi);
+  free(vq);
+  fprintf(stderr,"LOAD: template for %d kHz, %d channel(s): %d blocks of %d samples (%ld kB)\n",
+          rate, channels, t->blocks, slots, ((long) t->blocks*blocksize) >> 10);
+  return 0;
+}
+
+void load_template_free(LOAD_TEMPLATE *t) {
+  if (t->data != NULL) free(t->data);
+  memset(t, 0, sizeof(LOAD_TEMPLATE));
+}
+
+static long long now_usec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long) ts.tv_sec*1000000LL + ts.tv_nsec/1000;
+}
+
+void load_clock_start(LOAD_CLOCK *c) {
+  memset(c, 0, sizeof(LOAD_CLOCK));
+  clock_gettime(CLOCK_MONOTONIC, &c->next);
+  c->start=now_usec();
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &c->cpu);
+#endif
+}
+
+//
+// Sleep until the next tick, and return the time in usec
+//
+long long load_tick(LOAD_CLOCK *c) {
+  long long now, late;
+
+  c->next.tv_nsec += LOAD_TICK;
+  while (c->next.tv_nsec >= 1000000000) {
+    c->next.tv_nsec -= 1000000000;
+    c->next.tv_sec++;
+  }
+  clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &c->next, NULL);
+  now=now_usec();
+  late=now - ((long long) c->next.tv_sec*1000000LL + c->next.tv_nsec/1000);
+  c->ticks++;
+  if (late > 1000) c->late++;
+  if (late > c->maxlate) c->maxlate=late;
+  if (late > LOAD_MAXLAG) {
+    // we have been stopped: do not try to catch up the ticks
+    clock_gettime(CLOCK_MONOTONIC, &c->next);
+  }
+  return now;
+}
+
+int load_expired(LOAD_CLOCK *c, long long now) {
+  return load_duration > 0 && now - c->start >= (long long) load_duration*1000000LL;
+}
+
+void load_stream_start(LOAD_STREAM *s, long long now, int rate, int samples) {
+  memset(s, 0, sizeof(LOAD_STREAM));
+  s->start=now;
+  s->rate=rate;
+  s->samples=samples;
+}
+
+//
+// Number of packets that are due now. If the stream has fallen behind
+// by more than LOAD_MAXLAG, the missing packets are counted and skipped.
+//
+int load_due(LOAD_STREAM *s, long long now) {
+  long long due, lag;
+
+  due=((now - s->start) * s->rate / 1000) / s->samples - s->packets - s->skipped;
+  lag=due * s->samples * 1000 / s->rate;
+  if (lag > LOAD_MAXLAG) {
+    s->skipped += due;
+    due=0;
+  }
+  return (int) due;
+}
+
+//
+// Send n messages, each consisting of iovlen consecutive entries of iov.
+// If to is NULL (TCP), the socket is connected.
+// With network impairments, each message is copied into one buffer and
+// sent through impair_sendto.
+//
+int load_send(LOAD_STREAM *s, IMPAIR_STREAM *imp, int sock, struct sockaddr_in *to, struct iovec *iov, int iovlen, int n) {
+  struct mmsghdr msgs[LOAD_BATCH];
+  unsigned char packet[IMPAIR_MAXLEN];
+  int i, j, rc, sent, len;
+  long bytes;
+
+  if (n > LOAD_BATCH) n=LOAD_BATCH;
+  if (imp != NULL) {
+    for (i=0; i<n; i++) {
+      len=0;
+      for (j=0; j<iovlen; j++) {
+        if (len+iov[i*iovlen+j].iov_len > IMPAIR_MAXLEN) break;
+        memcpy(packet+len, iov[i*iovlen+j].iov_base, iov[i*iovlen+j].iov_len);
+        len += iov[i*iovlen+j].iov_len;
+      }
+      impair_sendto(imp, sock, packet, len, to);
+      s->bytes += len;
+    }
+    s->packets += n;
+    s->calls++;
+    return n;
+  }
+  memset(msgs, 0, n*sizeof(struct mmsghdr));
+  for (i=0; i<n; i++) {
+    msgs[i].msg_hdr.msg_name=to;
+    msgs[i].msg_hdr.msg_namelen=to ? sizeof(struct sockaddr_in) : 0;
+    msgs[i].msg_hdr.msg_iov=iov+i*iovlen;
+    msgs[i].msg_hdr.msg_iovlen=iovlen;
+  }
+#ifdef __APPLE__
+  // no sendmmsg on MacOS
+  for (sent=0; sent<n; sent++) {
+    rc=sendmsg(sock, &msgs[sent].msg_hdr, 0);
+    if (rc < 0) break;
+    msgs[sent].msg_len=rc;
+  }
+#else
+  sent=0;
+  while (sent < n) {
+    rc=sendmmsg(sock, msgs+sent, n-sent, 0);
+    if (rc <= 0) break;
+    sent += rc;
+  }
+#endif
+  bytes=0;
+  for (i=0; i<sent; i++) {
+    for (j=0; j<iovlen; j++) bytes += iov[i*iovlen+j].iov_len;
+  }
+  s->packets += sent;
+  s->bytes += bytes;
+  s->calls++;
+  s->errors += n-sent;
+  // packets that could not be sent are not repeated
+  s->skipped += n-sent;
+  return sent;
+}
+
+void load_report(const char *name, LOAD_STREAM *s, long long now) {
+  double secs=(now - s->start)*1E-6;
+  if (secs <= 0.0 || s->samples == 0) return;
+  fprintf(stderr,"LOAD: %-6s %8lld packets (%.0f/s, %.1f per sendmmsg), %.1f of %d ksps, %.1f Mbit/s, %lld skipped, %lld errors\n",
+          name, s->packets, s->packets/secs, s->calls ? (double) s->packets/s->calls : 0.0,
+          s->packets*s->samples/secs*1E-3, s->rate, s->bytes*8.0/secs*1E-6, s->skipped, s->errors);
+}
+
+void load_clock_report(LOAD_CLOCK *c, long long now) {
+  double secs=(now - c->start)*1E-6;
+  double cpu=0.0;
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  cpu=(ts.tv_sec - c->cpu.tv_sec) + 1E-9*(ts.tv_nsec - c->cpu.tv_nsec);
+#endif
+  if (secs <= 0.0) return;
+  fprintf(stderr,"LOAD: %.1f sec, CPU %.1f%% of one core, %ld ticks, %ld late, max. %lld usec late\n",
+          secs, 100.0*cpu/secs, c->ticks, c->late, c->maxlate);
+}
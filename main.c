@@ -57,12 +57,16 @@
 #include "discovery.h"
 #include "new_protocol.h"
 #include "old_protocol.h"
+#include "property.h"
 #ifdef SOAPYSDR
 #include "soapy_protocol.h"
 #endif
 #include "ext.h"
 #include "vfo.h"
 #include "css.h"
+#include "trace.h"
+#include "capture.h"
+#include "stream_stats.h"
 
 struct utsname unameData;
 
@@ -169,7 +173,9 @@ gboolean main_delete (GtkWidget *widget) {
 #ifdef CLIENT_SERVER
     }
 #endif
+    capture_stop();
     radioSaveState();
+    flushProperties();
   }
   _exit(0);
 }
@@ -352,6 +358,10 @@ int main(int argc,char **argv) {
   MacOSstartup(argv[0]);
 #endif
 
+  trace_init();
+  capture_init();
+  stream_stats_init();
+
   sprintf(name,"org.g0orx.pihpsdr.pid%d",getpid());
 
 //fprintf(stderr,"gtk_application_new: %s\n",name);
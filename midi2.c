@@ -27,6 +27,7 @@
 #include "actions.h"
 #include "midi.h"
 #include "alsa_midi.h"
+#include "trace.h"
 
 struct desc *MidiCommandsTable[129];
 
@@ -37,13 +38,8 @@ void NewMidiEvent(enum MIDIevent event, int channel, int note, int val) {
     static int last_wheel_action=NO_ACTION ;
     static struct timespec tp, last_wheel_tp={0,0};
     long delta;
-    struct timespec ts;  // used in debug code
-    double now;          // used in debug code
 
-//Un-comment next three lines to get a log of incoming MIDI messages
-clock_gettime(CLOCK_MONOTONIC, &ts);
-now=ts.tv_sec + 1E-9*ts.tv_nsec;
-g_print("%s:%12.3f:EVENT=%d CHAN=%d NOTE=%d VAL=%d\n",__FUNCTION__,now,event,channel,note,val);
+    TRACE_EVENT(TRACE_MIDI_EVENT, (event<<8) | channel, (note<<8) | val);
 
     if (event == MIDI_PITCH) {
 	desc=MidiCommandsTable[128];
@@ -21,13 +21,13 @@ void DoTheMidi(int action, enum ACTIONtype type, int val) {
 
     switch(type) {
       case MIDI_KEY:
-        schedule_action(action, val?PRESSED:RELEASED, 0);
+        schedule_action(SOURCE_MIDI, action, val?PRESSED:RELEASED, 0);
 	break;
       case MIDI_KNOB:
-        schedule_action(action, ABSOLUTE, val);
+        schedule_action(SOURCE_MIDI, action, ABSOLUTE, val);
         break;
       case MIDI_WHEEL:
-        schedule_action(action, RELATIVE, val);
+        schedule_action(SOURCE_MIDI, action, RELATIVE, val);
         break;
       default:
         // other types cannot happen for MIDI
@@ -0,0 +1,158 @@
+/*
+ * File net_rx.c
+ *
+ * Batched reception of UDP datagrams from the radio.
+ *
+ * At high sample rates and with many DDCs, the radio sends tens of
+ * thousands of datagrams per second, and reading them one at a time
+ * with recvfrom() costs one system call each. On Linux, recvmmsg()
+ * can fetch all datagrams that are already queued in the socket with
+ * a single system call. On other systems (MacOS) we fall back to
+ * recvfrom().
+ *
+ * The statistics (system calls per second, packets per system call,
+ * CPU time of the receive thread per packet) can be written to the log
+ * to compare the batched and the one-packet-at-a-time mode.
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE    // for recvmmsg
+#endif
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "net_rx.h"
+
+int net_rx_batch=1;
+int net_rx_sockbuf=0;
+int net_rx_report=0;
+
+//
+// Report interval for the statistics in seconds
+//
+#define NET_RX_REPORT_INTERVAL 10.0
+
+static double ts_diff(struct timespec *a, struct timespec *b) {
+  return (double)(a->tv_sec - b->tv_sec) + 1E-9*(double)(a->tv_nsec - b->tv_nsec);
+}
+
+void net_rx_stats_init(NET_RX_STATS *stats, const char *name) {
+  memset(stats, 0, sizeof(NET_RX_STATS));
+  stats->name=name;
+  clock_gettime(CLOCK_MONOTONIC, &stats->last_wall);
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &stats->last_cpu);
+}
+
+//
+// Must be called from the receiving thread, since the CPU time
+// is that of the calling thread.
+//
+void net_rx_stats_report(NET_RX_STATS *stats) {
+  struct timespec wall, cpu;
+  double dt, dcpu;
+  long calls, pkts;
+
+  clock_gettime(CLOCK_MONOTONIC, &wall);
+  dt=ts_diff(&wall, &stats->last_wall);
+  if (dt < NET_RX_REPORT_INTERVAL) return;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+  dcpu=ts_diff(&cpu, &stats->last_cpu);
+  calls=stats->syscalls - stats->last_syscalls;
+  pkts =stats->packets  - stats->last_packets;
+  if (pkts > 0) {
+    g_print("%s: batch=%d %0.0f syscalls/sec, %0.2f packets/syscall, %0.2f usec CPU/packet, %0.1f%% CPU\n",
+            stats->name, net_rx_get_batch(), (double) calls / dt, (double) pkts / (double) calls,
+            1E6 * dcpu / (double) pkts, 100.0 * dcpu / dt);
+  }
+  stats->last_syscalls=stats->syscalls;
+  stats->last_packets=stats->packets;
+  stats->last_wall=wall;
+  stats->last_cpu=cpu;
+}
+
+//
+// Size the receive buffer of the socket if requested.
+// The kernel may silently limit the size (net.core.rmem_max),
+// so read it back and report the actual value.
+//
+void net_rx_set_rcvbuf(int sock, const char *name) {
+  int optval;
+  socklen_t optlen=sizeof(optval);
+
+  if (net_rx_sockbuf <= 0) return;
+  optval=net_rx_sockbuf;
+  if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &optval, sizeof(optval)) < 0) {
+    perror("net_rx: SO_RCVBUF");
+    return;
+  }
+  if (getsockopt(sock, SOL_SOCKET, SO_RCVBUF, &optval, &optlen) == 0) {
+    g_print("%s: SO_RCVBUF requested %d, got %d\n", name, net_rx_sockbuf, optval);
+  }
+}
+
+int net_rx_get_batch() {
+  int batch=net_rx_batch;
+  if (batch < 1) batch=1;
+  if (batch > NET_RX_MAX_BATCH) batch=NET_RX_MAX_BATCH;
+#ifdef __APPLE__
+  batch=1;  // no recvmmsg
+#endif
+  return batch;
+}
+
+int net_rx_recv(int sock, unsigned char **bufs, int bufsize, int max,
+                int *lengths, struct sockaddr_in *addrs, NET_RX_STATS *stats) {
+  int i, n;
+  long bytes=0;
+
+  if (max > NET_RX_MAX_BATCH) max=NET_RX_MAX_BATCH;
+#ifndef __APPLE__
+  if (max > 1) {
+    struct mmsghdr msgs[NET_RX_MAX_BATCH];
+    struct iovec iovecs[NET_RX_MAX_BATCH];
+
+    memset(msgs, 0, max*sizeof(struct mmsghdr));
+    for (i=0; i<max; i++) {
+      iovecs[i].iov_base=bufs[i];
+      iovecs[i].iov_len=bufsize;
+      msgs[i].msg_hdr.msg_iov=&iovecs[i];
+      msgs[i].msg_hdr.msg_iovlen=1;
+      if (addrs) {
+        msgs[i].msg_hdr.msg_name=&addrs[i];
+        msgs[i].msg_hdr.msg_namelen=sizeof(struct sockaddr_in);
+      }
+    }
+    //
+    // MSG_WAITFORONE: block for the first datagram, then take
+    // only what is already there
+    //
+    n=recvmmsg(sock, msgs, max, MSG_WAITFORONE, NULL);
+    stats->syscalls++;
+    if (n < 0) return n;
+    for (i=0; i<n; i++) {
+      lengths[i]=msgs[i].msg_len;
+      bytes+=msgs[i].msg_len;
+    }
+  } else
+#endif
+  {
+    socklen_t length=sizeof(struct sockaddr_in);
+    n=recvfrom(sock, bufs[0], bufsize, 0, (struct sockaddr *)addrs, addrs ? &length : NULL);
+    stats->syscalls++;
+    if (n < 0) return n;
+    lengths[0]=n;
+    bytes=n;
+    n=1;
+  }
+  stats->packets+=n;
+  stats->bytes+=bytes;
+  if (net_rx_report) net_rx_stats_report(stats);
+  return n;
+}
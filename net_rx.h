@@ -0,0 +1,61 @@
+/*
+ * File net_rx.h
+ *
+ * Batched reception of UDP datagrams from the radio, shared by
+ * old_protocol.c and new_protocol.c, together with some statistics
+ * (number of system calls and CPU time per received packet).
+ *
+ */
+
+#ifndef _NET_RX_H
+#define _NET_RX_H
+
+#include <time.h>
+#include <netinet/in.h>
+
+//
+// Max. number of datagrams to read with a single recvmmsg() call
+//
+#define NET_RX_MAX_BATCH 32
+
+//
+// These are radio properties:
+//
+// net_rx_batch   : number of datagrams per system call, 1 means "plain recvfrom()"
+// net_rx_sockbuf : if > 0, size of the socket receive buffer (SO_RCVBUF) in bytes
+// net_rx_report  : if set, report the statistics in the log every 10 seconds
+//
+extern int net_rx_batch;
+extern int net_rx_sockbuf;
+extern int net_rx_report;
+
+typedef struct _net_rx_stats {
+  const char *name;
+  long syscalls;
+  long packets;
+  long bytes;
+  //
+  // values at the time of the last report
+  //
+  long last_syscalls;
+  long last_packets;
+  struct timespec last_wall;
+  struct timespec last_cpu;
+} NET_RX_STATS;
+
+extern void net_rx_stats_init(NET_RX_STATS *stats, const char *name);
+extern void net_rx_stats_report(NET_RX_STATS *stats);
+extern void net_rx_set_rcvbuf(int sock, const char *name);
+extern int net_rx_get_batch(void);
+
+//
+// Read up to "max" datagrams into bufs[0..max-1], each of size bufsize.
+// Blocks until at least one datagram is available (or the socket times out).
+// Returns the number of datagrams read, or -1 (errno set) on error.
+// lengths[i] and addrs[i] receive the size and the source of datagram i.
+// addrs may be NULL.
+//
+extern int net_rx_recv(int sock, unsigned char **bufs, int bufsize, int max,
+                       int *lengths, struct sockaddr_in *addrs, NET_RX_STATS *stats);
+
+#endif
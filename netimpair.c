@@ -0,0 +1,189 @@
+/*
+ * Network impairments for the HPSDR simulator
+ *
+ * With -loss, -burst, -reorder, -dup or -jitter, the packets of the RX
+ * streams (EP6 of the old protocol, the DDC and high priority packets
+ * of the new protocol) are dropped, duplicated, held back or delayed
+ * before they are sent, as it happens on Wi-Fi and VPN links. The SDR
+ * program can then be tested against packet loss and reordering
+ * without a real network.
+ *
+ * Each stream has its own random number generator, seeded from -seed
+ * and the stream number, so the same packets of a stream are affected
+ * in each run. With -jitter, the time at which a delayed packet is sent
+ * depends on when the next packets of the stream are sent, so it is
+ * only as repeatable as the timing of the stream.
+ *
+ * Burst loss follows the Gilbert model: a packet starts a burst with
+ * the -burst probability, and all packets of the burst are lost. A
+ * burst ends after each packet with the probability 1/length.
+ *
+ * When a stream ends, the numbers of packets that have been lost,
+ * duplicated, reordered and delayed are printed, to be compared with
+ * what the SDR program reports.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#ifdef __APPLE__
+#include "MacOS.h"  // emulate clock_gettime on old MacOS systems
+#endif
+
+#define EXTERN extern
+#include "hpsdrsim.h"
+
+//
+// xorshift64*, one state per stream
+//
+static double impair_random(IMPAIR_STREAM *s) {
+  s->rng ^= s->rng >> 12;
+  s->rng ^= s->rng << 25;
+  s->rng ^= s->rng >> 27;
+  return (double) ((s->rng * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static long long now_usec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long) ts.tv_sec*1000000LL + ts.tv_nsec/1000;
+}
+
+int impair_active(void) {
+  return impair_loss > 0.0 || impair_burst > 0.0 || impair_reorder > 0.0 || impair_dup > 0.0 || impair_jitter > 0;
+}
+
+IMPAIR_STREAM *impair_stream_new(const char *name, int id) {
+  IMPAIR_STREAM *s;
+
+  if (!impair_active()) return NULL;
+  s=calloc(1, sizeof(IMPAIR_STREAM));
+  if (s == NULL) return NULL;
+  snprintf(s->name, sizeof(s->name), "%s", name);
+  s->rng=((uint64_t) impair_seed << 16) ^ (uint64_t) (id+1) * 0x9E3779B97F4A7C15ULL;
+  if (s->rng == 0) s->rng=1;
+  return s;
+}
+
+static void send_packet(IMPAIR_STREAM *s, int sock, const unsigned char *data, int len, struct sockaddr_in *to) {
+  if (sendto(sock, data, len, 0, (struct sockaddr *)to, to ? sizeof(struct sockaddr_in) : 0) < 0) {
+    s->errors++;
+  }
+}
+
+//
+// Send the held packets that are due, the oldest first
+//
+void impair_flush(IMPAIR_STREAM *s, int all) {
+  int i, j;
+  long long now;
+
+  if (s == NULL || s->held == 0) return;
+  now=now_usec();
+  j=0;
+  for (i=0; i<s->held; i++) {
+    IMPAIR_PACKET *p=&s->queue[i];
+    if (all || (p->due_packet <= s->packets && p->due_usec <= now)) {
+      send_packet(s, p->sock, p->data, p->len, p->to_valid ? &p->to : NULL);
+    } else {
+      if (i != j) s->queue[j]=*p;
+      j++;
+    }
+  }
+  s->held=j;
+}
+
+static void hold_packet(IMPAIR_STREAM *s, int sock, const unsigned char *data, int len, struct sockaddr_in *to,
+                        long long due_packet, long long due_usec) {
+  IMPAIR_PACKET *p;
+
+  if (s->held >= IMPAIR_HELD || len > IMPAIR_MAXLEN) {
+    // queue full: the packet goes out now
+    send_packet(s, sock, data, len, to);
+    return;
+  }
+  p=&s->queue[s->held++];
+  memcpy(p->data, data, len);
+  p->len=len;
+  p->sock=sock;
+  p->to_valid=to != NULL;
+  if (to) p->to=*to;
+  p->due_packet=due_packet;
+  p->due_usec=due_usec;
+}
+
+//
+// Replaces sendto() for the packets of a stream. With s == NULL
+// (no impairments), this is a plain sendto().
+//
+int impair_sendto(IMPAIR_STREAM *s, int sock, const unsigned char *data, int len, struct sockaddr_in *to) {
+  long long due_packet, due_usec;
+  int copies, i;
+
+  if (s == NULL) {
+    return sendto(sock, data, len, 0, (struct sockaddr *)to, to ? sizeof(struct sockaddr_in) : 0);
+  }
+  s->packets++;
+  impair_flush(s, 0);
+
+  if (s->burst) {
+    s->dropped++;
+    s->burst_dropped++;
+    if (impair_random(s) * impair_burstlen < 1.0) s->burst=0;
+    return len;
+  }
+  if (impair_burst > 0.0 && impair_random(s) < impair_burst) {
+    s->bursts++;
+    s->dropped++;
+    s->burst_dropped++;
+    s->burst=impair_burstlen > 1 && impair_random(s) * impair_burstlen >= 1.0;
+    return len;
+  }
+  if (impair_loss > 0.0 && impair_random(s) < impair_loss) {
+    s->dropped++;
+    return len;
+  }
+
+  copies=1;
+  if (impair_dup > 0.0 && impair_random(s) < impair_dup) {
+    s->duplicated++;
+    copies=2;
+  }
+  for (i=0; i<copies; i++) {
+    due_packet=0;
+    due_usec=0;
+    if (impair_reorder > 0.0 && impair_random(s) < impair_reorder) {
+      s->reordered++;
+      due_packet=s->packets + impair_reorder_depth + 1;   // behind the next depth packets
+    }
+    if (impair_jitter > 0) {
+      due_usec=now_usec() + (long long) (impair_random(s) * impair_jitter);
+      s->delayed++;
+    }
+    if (due_packet || due_usec) {
+      hold_packet(s, sock, data, len, to, due_packet, due_usec);
+    } else {
+      send_packet(s, sock, data, len, to);
+    }
+  }
+  return len;
+}
+
+void impair_report(IMPAIR_STREAM *s) {
+  if (s == NULL || s->packets == 0) return;
+  fprintf(stderr,"IMPAIR: %-6s %lld packets: %lld lost (%lld in %lld bursts), %lld duplicated, %lld reordered, %lld delayed, %lld errors\n",
+          s->name, s->packets, s->dropped, s->burst_dropped, s->bursts, s->duplicated, s->reordered, s->delayed, s->errors);
+}
+
+//
+// Send what is still held, print the report and free the stream
+//
+void impair_stream_free(IMPAIR_STREAM *s) {
+  if (s == NULL) return;
+  impair_flush(s, 1);
+  impair_report(s);
+  free(s);
+}
@@ -0,0 +1,172 @@
+/*
+ * File netstats_menu.c
+ *
+ * Shows the counters of the packet streams received from the radio
+ * (see stream_stats.h), updated twice a second, and resets them.
+ *
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "new_menu.h"
+#include "netstats_menu.h"
+#include "radio.h"
+#include "stream_stats.h"
+
+static GtkWidget *parent_window=NULL;
+static GtkWidget *dialog=NULL;
+static guint timer=0;
+
+enum {
+  COL_RECEIVED=0,
+  COL_LOST,
+  COL_GAPS,
+  COL_LONGEST,
+  COL_REORDERED,
+  COL_DUPLICATED,
+  COL_LATE,
+  COL_P50,
+  COL_P99,
+  COL_MAX,
+  COLUMNS
+};
+
+static const char *column_title[COLUMNS]={
+  "Received", "Lost", "Gaps", "Longest", "Reordered", "Duplicated", "Late",
+  "p50 (us)", "p99 (us)", "Max (us)"
+};
+
+static GtkWidget *value[STREAMS][COLUMNS];
+
+static void cleanup() {
+  if(timer!=0) {
+    g_source_remove(timer);
+    timer=0;
+  }
+  if(dialog!=NULL) {
+    gtk_widget_destroy(dialog);
+    dialog=NULL;
+    sub_menu=NULL;
+  }
+}
+
+static gboolean close_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  cleanup();
+  return TRUE;
+}
+
+static gboolean delete_event(GtkWidget *widget, GdkEvent *event, gpointer user_data) {
+  cleanup();
+  return FALSE;
+}
+
+static void set_value(GtkWidget *label, int v) {
+  char text[32];
+  if(label==NULL) return;
+  if(v<0) {
+    strcpy(text,"-");
+  } else {
+    sprintf(text,"%d",v);
+  }
+  gtk_label_set_text(GTK_LABEL(label),text);
+}
+
+static gboolean update_cb(gpointer data) {
+  STREAM_STATS s;
+  int i, p50;
+
+  for(i=0;i<STREAMS;i++) {
+    if(value[i][0]==NULL) continue;
+    stream_stats_get(i,&s);
+    set_value(value[i][COL_RECEIVED],s.received);
+    set_value(value[i][COL_LOST],s.lost);
+    set_value(value[i][COL_GAPS],s.gaps);
+    set_value(value[i][COL_LONGEST],s.longest);
+    set_value(value[i][COL_REORDERED],s.reordered);
+    set_value(value[i][COL_DUPLICATED],s.duplicated);
+    set_value(value[i][COL_LATE],s.late);
+    // no intervals yet: p50 is -1
+    p50=stream_stats_percentile(&s,50);
+    set_value(value[i][COL_P50],p50);
+    set_value(value[i][COL_P99],stream_stats_percentile(&s,99));
+    set_value(value[i][COL_MAX],p50<0?-1:s.maximum);
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean reset_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  stream_stats_reset();
+  update_cb(NULL);
+  return TRUE;
+}
+
+void netstats_menu(GtkWidget *parent) {
+  int i, j, row;
+  GtkWidget *label;
+
+  parent_window=parent;
+
+  dialog=gtk_dialog_new();
+  gtk_window_set_transient_for(GTK_WINDOW(dialog),GTK_WINDOW(parent_window));
+  //gtk_window_set_decorated(GTK_WINDOW(dialog),FALSE);
+  gtk_window_set_title(GTK_WINDOW(dialog),"piHPSDR - Network Statistics");
+  g_signal_connect (dialog, "delete_event", G_CALLBACK (delete_event), NULL);
+
+  GdkRGBA color;
+  color.red = 1.0;
+  color.green = 1.0;
+  color.blue = 1.0;
+  color.alpha = 1.0;
+  gtk_widget_override_background_color(dialog,GTK_STATE_FLAG_NORMAL,&color);
+
+  GtkWidget *content=gtk_dialog_get_content_area(GTK_DIALOG(dialog));
+
+  GtkWidget *grid=gtk_grid_new();
+
+  gtk_grid_set_column_homogeneous(GTK_GRID(grid),TRUE);
+  gtk_grid_set_column_spacing (GTK_GRID(grid),10);
+  gtk_grid_set_row_spacing (GTK_GRID(grid),5);
+
+  GtkWidget *close_b=gtk_button_new_with_label("Close");
+  g_signal_connect (close_b, "pressed", G_CALLBACK(close_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid),close_b,0,0,1,1);
+
+  GtkWidget *reset_b=gtk_button_new_with_label("Reset");
+  g_signal_connect (reset_b, "pressed", G_CALLBACK(reset_cb), NULL);
+  gtk_grid_attach(GTK_GRID(grid),reset_b,1,0,1,1);
+
+  for(j=0;j<COLUMNS;j++) {
+    label=gtk_label_new(column_title[j]);
+    gtk_grid_attach(GTK_GRID(grid),label,j+1,1,1,1);
+  }
+
+  //
+  // The old protocol only has EP6, the new protocol all the others
+  //
+  memset(value,0,sizeof(value));
+  row=2;
+  for(i=0;i<STREAMS;i++) {
+    if((protocol==ORIGINAL_PROTOCOL) != (i==STREAM_EP6)) continue;
+    label=gtk_label_new(stream_stats_name(i));
+    gtk_widget_set_halign(label,GTK_ALIGN_START);
+    gtk_grid_attach(GTK_GRID(grid),label,0,row,1,1);
+    for(j=0;j<COLUMNS;j++) {
+      value[i][j]=gtk_label_new("-");
+      gtk_widget_set_halign(value[i][j],GTK_ALIGN_END);
+      gtk_grid_attach(GTK_GRID(grid),value[i][j],j+1,row,1,1);
+    }
+    row++;
+  }
+
+  gtk_container_add(GTK_CONTAINER(content),grid);
+
+  sub_menu=dialog;
+
+  update_cb(NULL);
+  timer=g_timeout_add(500, update_cb, NULL);
+
+  gtk_widget_show_all(dialog);
+
+}
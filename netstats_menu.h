@@ -0,0 +1,9 @@
+/*
+ * File netstats_menu.h
+ *
+ * Network statistics: the counters of the packet streams received
+ * from the radio
+ *
+ */
+
+extern void netstats_menu(GtkWidget *parent);
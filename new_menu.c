@@ -48,6 +48,7 @@
 #include "noise_menu.h"
 #include "agc_menu.h"
 #include "test_menu.h"
+#include "netstats_menu.h"
 #include "vox_menu.h"
 #include "diversity_menu.h"
 #include "tx_menu.h"
@@ -134,6 +135,12 @@ static gboolean restart_cb (GtkWidget *widget, GdkEventButton *event, gpointer d
   return TRUE;
 }
 
+static gboolean netstats_b_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
+  cleanup();
+  netstats_menu(top_window);
+  return TRUE;
+}
+
 static gboolean about_b_cb (GtkWidget *widget, GdkEventButton *event, gpointer data) {
   cleanup();
   about_menu(top_window);
@@ -675,6 +682,11 @@ void new_menu()
     i++;
 #endif
 
+    GtkWidget *netstats_b=gtk_button_new_with_label("Network");
+    g_signal_connect (netstats_b, "button-press-event", G_CALLBACK(netstats_b_cb), NULL);
+    gtk_grid_attach(GTK_GRID(grid),netstats_b,(i%5),i/5,1,1);
+    i++;
+
     GtkWidget *about_b=gtk_button_new_with_label("About");
     g_signal_connect (about_b, "button-press-event", G_CALLBACK(about_b_cb), NULL);
     gtk_grid_attach(GTK_GRID(grid),about_b,(i%5),i/5,1,1);
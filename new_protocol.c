@@ -60,6 +60,11 @@
 #include "vox.h"
 #include "ext.h"
 #include "iambic.h"
+#include "net_rx.h"
+#include "trace.h"
+#include "capture.h"
+#include "stream_stats.h"
+#include "slice.h"
 
 #define min(x,y) (x<y?x:y)
 
@@ -74,6 +79,7 @@
 #define RXACTION_NORMAL 1    // deliver 238 samples to a receiver
 #define RXACTION_PS     2    // deliver 2*119 samples to PS engine
 #define RXACTION_DIV    3    // take 2*119 samples, mix them, deliver to a receiver
+#define RXACTION_SLICE  4    // deliver 238 samples to a slice
 
 static int rxcase[7/*MAX_DDC*/];
 static int rxid  [7/*MAX_DDC*/];
@@ -175,10 +181,8 @@ static sem_t mic_line_sem_buffer;
 #endif
 static GThread *mic_line_thread_id;
 #ifdef __APPLE__
-static sem_t *iq_sem_ready[7/*MAX_DDC*/];
 static sem_t *iq_sem_buffer[7/*MAX_DDC*/];
 #else
-static sem_t iq_sem_ready[7/*MAX_DDC*/];
 static sem_t iq_sem_buffer[7/*MAX_DDC*/];
 #endif
 static GThread *iq_thread_id[7/*MAX_DDC*/];
@@ -203,51 +207,98 @@ static socklen_t length=sizeof(addr);
 
 //
 // Instead of allocating and free-ing (malloc/free) the network buffers
-// at a very high rate, we do it the "pedestrian" way, which may
-// alleviate the system load a little.
+// at a very high rate, we allocate a pool of network buffers *once*
+// in new_protocol_init(). Its size depends on the number of DDCs, the
+// depth of the IQ rings and the sample rate, and it never grows.
 //
-// Therefore we allocate a pool of network buffers *once*, make 
-// them a linked list, and simply maintain a "free" flag.
+// Free buffers are kept on a lock-free stack (LIFO, so recently used
+// and thus cache-hot buffers are re-used first). Buffers are taken
+// from the pool by new_protocol_thread() and returned by the thread
+// that has processed them, so acquire and release are O(1) and need
+// no mutex.
 //
-// This ONLY applies to the network buffers filled with data in
-// new_protocol_thread(), so this need not be thread-safe.
+// The head of the stack is an index (plus one, zero means "empty")
+// in the lower 16 bits and a tag in the upper 16 bits. The tag is
+// incremented with each change and thus protects against the ABA
+// problem.
 //
+// If the pool is exhausted, the packet is received into a scratch
+// buffer and dropped, and this is counted.
+//
+#define BUFFER_POOL_MAX 2048
+#define BUFFER_POOL_DDCS 7      // the hard limit on MAX_DDC, see new_protocol_init
 
 //
-// One buffer. The fences can be used to detect over-writing them
-// 
+// One buffer. The fences can be used to detect over-writing them.
+// Buffers are aligned to cache lines so that two threads working on
+// adjacent buffers do not share a cache line.
 //
 
 struct mybuffer_ {
-   struct mybuffer_ *next;
-   int             free;
+   int             index;   // position in pool
+   volatile gint   free;    // to detect double release
+   gint64          rxtime;  // time of reception (see stream_stats_now)
    long            lowfence;
    unsigned char   buffer[NET_BUFFER_SIZE];
    long            highfence;
-} mybuffer_;
+} __attribute__((aligned(64)));
 
 typedef struct mybuffer_ mybuffer;
 
+static mybuffer *pool=NULL;
+static gint *pool_next=NULL;          // free-list links (index+1)
+static volatile gint pool_head=0;     // tag << 16 | (index+1)
+static int pool_size=0;
+static volatile gint pool_in_use=0;
+static volatile gint pool_high_water=0;
+static volatile gint pool_failures=0;
+static mybuffer *pool_scratch=NULL;   // receives packets if pool exhausted
+
 //
-// number of buffers allocated (for statistics)
+// IQ packets are handed from new_protocol_thread to the iq_thread of
+// each DDC through a bounded ring of buffer pointers, such that the
+// receive thread never has to wait for a (slow) DDC thread. If the
+// ring is full, the packet is dropped and counted.
 //
-static int num_buf = 0; 
-
+// The ring follows the "sequenced slot" scheme: each slot carries a
+// sequence number which tells whether it is ready to be written
+// (seq == position) or ready to be read (seq == position+1). The
+// write position is claimed with compare-and-exchange, so more than
+// one producer may safely enqueue. iq_sem_buffer[ddc] counts the
+// packets in the ring and is used by iq_thread to sleep.
 //
-// head of buffer list
+// The ring depth is iq_queue_depth (rounded up to a power of two),
+// it is read once in new_protocol_init().
 //
-static mybuffer *buflist = NULL;
+int iq_queue_depth=16;
+
+typedef struct _iq_slot {
+  volatile gint seq;
+  mybuffer *buf;
+} IQ_SLOT;
+
+typedef struct _iq_queue {
+  IQ_SLOT *slot;
+  gint mask;
+  volatile gint head;       // next position to write
+  volatile gint tail;       // next position to read
+  volatile gint high_water; // max. number of packets queued
+  volatile gint drops;      // packets dropped because ring was full
+} IQ_QUEUE;
+
+static IQ_QUEUE iq_queue[7/*MAX_DDC*/];
 
 //
 // The buffers used by new_protocol_thread
 //
-static mybuffer *iq_buffer[7/*MAX_DDC*/];
 static mybuffer *command_response_buffer;
 static mybuffer *high_priority_buffer;
 static mybuffer *mic_line_buffer;
 
 static int mic_bytes_read;
 
+static NET_RX_STATS rx_stats;
+
 static unsigned char general_buffer[60];
 static unsigned char high_priority_buffer_to_radio[1444];
 static unsigned char transmit_specific_buffer[60];
@@ -283,43 +334,206 @@ static gpointer iq_thread(gpointer data);
 static void  process_iq_data(unsigned char *buffer, RECEIVER *rx);
 static void  process_ps_iq_data(unsigned char *buffer);
 static void process_div_iq_data(unsigned char *buffer);
+static void process_slice_iq_data(unsigned char *buffer, SLICE *s);
 static void  process_command_response();
 static void  process_high_priority();
 static void  process_mic_data(int bytes);
 
 //
-// obtain free buffer, if nothing is left allocate
-// 5 new ones. Note these buffer "live" as long as the
-// program lives. They are never free()d.
+// Allocate the buffer pool. For each DDC, we need as many buffers
+// as there are slots in its IQ ring plus the one being processed.
+// In addition, there are the buffers of one receive batch and those
+// for the command response, high priority and mic line threads.
+//
+// The pool is kept when the protocol is restarted, so it is sized for
+// the highest sample rate, where a DDC may fill its whole ring, and for
+// the largest number of DDCs (BUFFER_POOL_DDCS) rather than the current
+// MAX_DDC: a restart with more DDCs (more receivers or slices) or a
+// higher sample rate never needs a larger pool.
+//
+static void buffer_pool_init() {
+  int i;
+  int n;
+  int per_ddc;
+  void *mem;
+
+  per_ddc=2;                  // the ring depth, see iq_queue_init
+  while (per_ddc < iq_queue_depth && per_ddc < 1024) per_ddc=per_ddc<<1;
+  n=BUFFER_POOL_DDCS*(per_ddc+1) + NET_RX_MAX_BATCH + 6;
+  if (n > BUFFER_POOL_MAX) n=BUFFER_POOL_MAX;
+
+  if (pool != NULL) {
+    //
+    // Only a deeper IQ ring (iq_queue_depth) needs a larger pool. It is
+    // rebuilt if no buffer is in use, that is, the protocol has been
+    // stopped.
+    //
+    if (n <= pool_size || g_atomic_int_get(&pool_in_use) != 0) return;
+    free(pool);
+    g_free(pool_next);
+  }
+
+  if (posix_memalign(&mem, 64, (n+1)*sizeof(mybuffer)) != 0) {
+    g_print("NewProtocol: cannot allocate buffer pool\n");
+    exit(-1);
+  }
+  pool=(mybuffer *) mem;
+  pool_next=g_new(gint, n);
+  pool_size=n;
+  for (i=0; i<n; i++) {
+    pool[i].index=i;
+    pool[i].free=1;
+    pool_next[i]=(i < n-1) ? i+2 : 0;
+  }
+  pool_head=1;
+  pool_scratch=&pool[n];
+  pool_scratch->index=-1;
+  pool_scratch->free=0;
+  g_print("NewProtocol: buffer pool with %d buffers (%d per DDC)\n", n, per_ddc);
+}
+
+//
+// Obtain a free buffer from the pool. If nothing is left, count
+// the failure and return the scratch buffer.
 //
 static mybuffer *get_my_buffer() {
+  gint old, new, idx, used;
+
+  for (;;) {
+    old=g_atomic_int_get(&pool_head);
+    idx=old & 0xFFFF;
+    if (idx == 0) {
+      if (g_atomic_int_add(&pool_failures, 1) == 0) {
+        g_print("NewProtocol: buffer pool (%d) exhausted, dropping packets\n", pool_size);
+      }
+      return pool_scratch;
+    }
+    new=((old + 0x10000) & 0xFFFF0000) | g_atomic_int_get(&pool_next[idx-1]);
+    if (g_atomic_int_compare_and_exchange(&pool_head, old, new)) break;
+  }
+  pool[idx-1].free=0;
+  used=g_atomic_int_add(&pool_in_use, 1) + 1;
+  if (used > g_atomic_int_get(&pool_high_water)) g_atomic_int_set(&pool_high_water, used);
+  return &pool[idx-1];
+}
+
+//
+// Return buffer to the pool. May be called from any thread.
+//
+static void release_my_buffer(mybuffer *bp) {
+  gint old, new;
+
+  if (bp == pool_scratch) return;
+  if (!g_atomic_int_compare_and_exchange(&bp->free, 0, 1)) {
+    g_print("NewProtocol: buffer %d released twice\n", bp->index);
+    return;
+  }
+  for (;;) {
+    old=g_atomic_int_get(&pool_head);
+    g_atomic_int_set(&pool_next[bp->index], old & 0xFFFF);
+    new=((old + 0x10000) & 0xFFFF0000) | (bp->index+1);
+    if (g_atomic_int_compare_and_exchange(&pool_head, old, new)) break;
+  }
+  g_atomic_int_add(&pool_in_use, -1);
+}
+
+//
+// Statistics of the buffer pool, for display purposes
+//
+void new_protocol_buffer_stats(int *size, int *in_use, int *high_water, int *failures) {
+  *size=pool_size;
+  *in_use=g_atomic_int_get(&pool_in_use);
+  *high_water=g_atomic_int_get(&pool_high_water);
+  *failures=g_atomic_int_get(&pool_failures);
+}
+
+
+static void iq_queue_init(IQ_QUEUE *q, int depth) {
   int i;
-  mybuffer *bp=buflist;
-  while (bp) {
-    if (bp->free) {
-      // found free buffer. Mark as used and return that one.
-      bp->free=0;
-      return bp;
-    }
-    bp=bp->next;
+  int n=2;
+  while (n < depth && n < 1024) n=n<<1;
+  q->slot=g_new(IQ_SLOT, n);
+  for (i=0; i<n; i++) {
+    q->slot[i].seq=i;
+    q->slot[i].buf=NULL;
   }
-  //
-  // no free buffer found, allocate some extra ones
-  // and add to the head of the list
-  //
-  for (i=0; i<5; i++) {
-    bp = malloc(sizeof(mybuffer));
-    bp->free=1;
-    bp->next = buflist;
-    buflist=bp;
-    num_buf++;
+  q->mask=n-1;
+  q->head=0;
+  q->tail=0;
+  q->high_water=0;
+  q->drops=0;
+}
+
+//
+// Returns 1 if the buffer has been queued, 0 if the ring is full.
+// Positions are compared using unsigned wrap-around arithmetic.
+//
+static int iq_queue_put(IQ_QUEUE *q, mybuffer *buf) {
+  IQ_SLOT *slot;
+  gint pos, diff, fill;
+
+  pos=g_atomic_int_get(&q->head);
+  for (;;) {
+    slot=&q->slot[pos & q->mask];
+    diff=(gint)((guint)g_atomic_int_get(&slot->seq) - (guint)pos);
+    if (diff == 0) {
+      if (g_atomic_int_compare_and_exchange(&q->head, pos, (gint)((guint)pos+1))) break;
+      pos=g_atomic_int_get(&q->head);
+    } else if (diff < 0) {
+      g_atomic_int_inc(&q->drops);
+      return 0;
+    } else {
+      pos=g_atomic_int_get(&q->head);
+    }
   }
-  g_print("NewProtocol: number of buffer increased to %d\n", num_buf);
-  // Mark the first buffer in list as used and return that one.
-  buflist->free=0;
-  return buflist;
+  slot->buf=buf;
+  g_atomic_int_set(&slot->seq, (gint)((guint)pos+1));
+  fill=(gint)((guint)pos+1 - (guint)g_atomic_int_get(&q->tail));
+  if (fill > g_atomic_int_get(&q->high_water)) g_atomic_int_set(&q->high_water, fill);
+  return 1;
 }
 
+//
+// Only called from the (single) iq_thread of the DDC, after
+// iq_sem_buffer has signalled that a packet is available.
+//
+// With more than one producer, the packet counted by the semaphore
+// may be in a later slot than the one at the tail, which a producer
+// has claimed but not yet filled. The consumer then waits for that
+// producer (a few instructions), since giving up would lose the count
+// and leave the packet at the tail in the ring for ever.
+//
+static mybuffer *iq_queue_get(IQ_QUEUE *q) {
+  IQ_SLOT *slot;
+  mybuffer *buf;
+  gint pos=q->tail;
+
+  if (g_atomic_int_get(&q->head) == pos) return NULL;   // nothing claimed
+  slot=&q->slot[pos & q->mask];
+  while ((gint)((guint)g_atomic_int_get(&slot->seq) - ((guint)pos+1)) != 0) {
+    g_thread_yield();
+  }
+  buf=slot->buf;
+  slot->buf=NULL;
+  g_atomic_int_set(&slot->seq, (gint)((guint)pos+q->mask+1));
+  g_atomic_int_set(&q->tail, (gint)((guint)pos+1));
+  return buf;
+}
+
+//
+// Statistics for the IQ ring of a DDC, for display purposes
+//
+void new_protocol_iq_queue_stats(int ddc, int *depth, int *high_water, int *drops) {
+  if (ddc < 0 || ddc >= MAX_DDC || iq_queue[ddc].slot == NULL) {
+    *depth=0;
+    *high_water=0;
+    *drops=0;
+    return;
+  }
+  *depth=iq_queue[ddc].mask+1;
+  *high_water=g_atomic_int_get(&iq_queue[ddc].high_water);
+  *drops=g_atomic_int_get(&iq_queue[ddc].drops);
+}
 
 #ifdef INCLUDED
 static void new_protocol_calc_buffers() {
@@ -382,6 +596,7 @@ void update_action_table() {
   // determine the actions to be taken when a DDC packet arrives
   //
 
+  int i;
   int flag=0;
   int xmit=isTransmitting();  // store such that it cannot change while building the flag
   int newdev=(device==NEW_DEVICE_ANGELIA || device==NEW_DEVICE_ORION || device == NEW_DEVICE_ORION2);
@@ -413,10 +628,9 @@ void update_action_table() {
   // Set up rxcase and rxid for each of the 12 cases
   // note that rxid[i] can be left unspecified if rxcase[i] == RXACTION_SKIP
   //
-  rxcase[0] = RXACTION_SKIP;
-  rxcase[1] = RXACTION_SKIP;
-  rxcase[2] = RXACTION_SKIP;
-  rxcase[3] = RXACTION_SKIP;
+  for (i=0; i<7; i++) {
+    rxcase[i] = RXACTION_SKIP;
+  }
   switch (flag) {
     case       0:							// HERMES, RX, no DIVERSITY
     case   10100:							// HERMES, TX, no PURESIGNAL, DUPLEX
@@ -457,6 +671,16 @@ void update_action_table() {
 	g_print("ACTION TABLE: case not handled: %d\n", flag);
 	break;
   }
+  //
+  // The slices have DDCs of their own, after those of the receivers.
+  // They receive whenever the receivers do.
+  //
+  if (!xmit || duplex) {
+    for (i=0; i<slice_ddcs() && slice_first_ddc()+i<MAX_DDC; i++) {
+      rxid[slice_first_ddc()+i]=i;
+      rxcase[slice_first_ddc()+i] = RXACTION_SLICE;
+    }
+  }
 }
 
 void new_protocol_init(int pixels) {
@@ -467,7 +691,7 @@ void new_protocol_init(int pixels) {
     //
     // This is the hard (compile-time) limit on the number of DDCs
     //
-    if (MAX_DDC > 7) {
+    if (MAX_DDC > BUFFER_POOL_DDCS) {
       g_print("%s: MAX_DDC exceeds allowed range\n", __FUNCTION__);
       exit(-1);
     }
@@ -476,6 +700,7 @@ void new_protocol_init(int pixels) {
     memset(rxcase      , 0, sizeof(rxcase));
     memset(rxid        , 0, sizeof(rxid));
     memset(ddc_sequence, 0, sizeof(ddc_sequence));
+    stream_stats_reset();
     update_action_table();
 
 #ifdef INCLUDED
@@ -556,21 +781,17 @@ void new_protocol_init(int pixels) {
     }
     g_print( "mic_line_thread: id=%p\n",mic_line_thread_id);
 
+    buffer_pool_init();
+
 //
 //  Spawn off one IQ reading thread for each DDC to be used
 //  Note that IQ reading threads are associated with DDCs and
 //  not with RECEIVERs.
 //
     for(i=0;i<MAX_DDC;i++) {
+      iq_queue_init(&iq_queue[i], iq_queue_depth);
 #ifdef __APPLE__
       char sname[12];
-      sprintf(sname,"IQREADY%03d", i);
-      sem_unlink(sname);
-      iq_sem_ready[i]=sem_open(sname, O_CREAT | O_EXCL, 0700, 0);
-      if (iq_sem_ready[i] == SEM_FAILED) {
-        g_print("SEM=%s, ",sname);
-        perror("IQreadySemaphore");
-      }
       sprintf(sname,"IQBUF%03d", i);
       sem_unlink(sname);
       iq_sem_buffer[i]=sem_open(sname, O_CREAT| O_EXCL, 0700, 0);
@@ -579,7 +800,6 @@ void new_protocol_init(int pixels) {
         perror("IQbufferSemaphore");
       }
 #else
-      rc=sem_init(&iq_sem_ready[i], 0, 0); // check return value!
       rc=sem_init(&iq_sem_buffer[i], 0, 0); // check return value!
 #endif
       iq_thread_id[i] = g_thread_new( "iq thread", iq_thread, GINT_TO_POINTER(i));
@@ -594,6 +814,7 @@ void new_protocol_init(int pixels) {
     int optval = 1;
     setsockopt(data_socket, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
     setsockopt(data_socket, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval));
+    net_rx_set_rcvbuf(data_socket, "NewProtocol");
 #ifdef __APPLE__
     //optval = 0x10;  // IPTOS_LOWDELAY
     optval = 0xb8;  // DSCP EF
@@ -821,6 +1042,19 @@ static void new_protocol_high_priority() {
         }
     }
 
+//
+//  Set DDC frequencies of the slices
+//
+    for(i=0;i<slice_ddcs() && slice_first_ddc()+i<MAX_DDC;i++) {
+      ddc=slice_first_ddc()+i;
+      rxFrequency=slice_ddc_frequency(&slice[i])+calibration;
+      phase=(long)((4294967296.0*(double)rxFrequency)/122880000.0);
+      high_priority_buffer_to_radio[9+(ddc*4)]=phase>>24;
+      high_priority_buffer_to_radio[10+(ddc*4)]=phase>>16;
+      high_priority_buffer_to_radio[11+(ddc*4)]=phase>>8;
+      high_priority_buffer_to_radio[12+(ddc*4)]=phase;
+    }
+
 //
 //  Set DUC frequency
 //
@@ -1399,6 +1633,20 @@ static void new_protocol_receive_specific() {
       receive_specific_buffer[7]=1; 						// enable  DDC0 but disable all others
     }
 
+    //
+    // The DDCs of the slices run at 48 kHz, from the ADC of the first receiver
+    //
+    if (!isTransmitting() || duplex) {
+      for(i=0;i<slice_ddcs() && slice_first_ddc()+i<MAX_DDC;i++) {
+        ddc=slice_first_ddc()+i;
+        receive_specific_buffer[7]|=(1<<ddc); // DDC enable
+        receive_specific_buffer[17+(ddc*6)]=receiver[0]->adc;
+        receive_specific_buffer[18+(ddc*6)]=0;
+        receive_specific_buffer[19+(ddc*6)]=48;
+        receive_specific_buffer[22+(ddc*6)]=24;
+      }
+    }
+
 //g_print("new_protocol_receive_specific: %s:%d enable=%02X\n",inet_ntoa(receiver_addr.sin_addr),ntohs(receiver_addr.sin_port),receive_specific_buffer[7]);
 
     if((rc=sendto(data_socket,receive_specific_buffer,sizeof(receive_specific_buffer),0,(struct sockaddr*)&receiver_addr,receiver_addr_length))<0) {
@@ -1433,6 +1681,7 @@ void new_protocol_stop() {
     new_protocol_high_priority();
     usleep(100000); // 100 ms
     close (data_socket);
+    stream_stats_report();
 }
 
 //
@@ -1482,6 +1731,8 @@ void new_protocol_restart() {
   memset(rxcase      , 0, sizeof(rxcase));
   memset(rxid        , 0, sizeof(rxid));
   memset(ddc_sequence, 0, sizeof(ddc_sequence));
+  stream_stats_report();
+  stream_stats_reset();
   update_action_table();
   // running is set to 1 at the top of new_protocol_thread,
   // but this may lead to race conditions. So out of paranoia,
@@ -1496,45 +1747,14 @@ void new_protocol_restart() {
   new_protocol_high_priority();
 }
 
-static gpointer new_protocol_thread(gpointer data) {
-
+//
+// Hand over one received packet to the thread responsible
+// for its source port
+//
+static void new_protocol_dispatch(mybuffer *mybuf, int bytesread, short sourceport) {
     int ddc;
-    short sourceport;
-    unsigned char *buffer;
-    int bytesread;
-    mybuffer *mybuf;
 
-g_print("new_protocol_thread\n");
-
-    iqindex=4;
-
-    audioindex=4; // leave space for sequence
-    audiosequence=0L;
-
-    running=1;
-
-    while(running) {
-
-        mybuf=get_my_buffer();
-        buffer=mybuf->buffer;
-        bytesread=recvfrom(data_socket,buffer,NET_BUFFER_SIZE,0,(struct sockaddr*)&addr,&length);
-
-        if (!running) {
-          //
-          // When leaving piHPSDR, it may happen that the protocol has been stopped while
-	  // we were doing "recvfrom". In this case, we want to let the main
-	  // thread terminate gracefully, including writing the props files.
-	  //
-	  mybuf->free=1;
-	  break;
-	}
-
-        if(bytesread<0) {
-            g_print("recvfrom socket failed for new_protocol_thread");
-            exit(-1);
-        }
-
-        sourceport=ntohs(addr.sin_port);
+    if (mybuf == pool_scratch) return;    // buffer pool was exhausted: drop packet
 
 //g_print("new_protocol_thread: recvd %d bytes on port %d\n",bytesread,sourceport);
 
@@ -1551,18 +1771,16 @@ g_print("new_protocol_thread\n");
 //g_print("iq packet from port=%d ddc=%d\n",sourceport,ddc);
               if(ddc>=MAX_DDC)  {
                 g_print("unexpected iq data from ddc %d\n",ddc);
-              } else {
-#ifdef __APPLE__
-                sem_wait(iq_sem_ready[ddc]);
-#else
-                sem_wait(&iq_sem_ready[ddc]);
-#endif
-                iq_buffer[ddc]=mybuf;
+                release_my_buffer(mybuf);
+              } else if (iq_queue_put(&iq_queue[ddc], mybuf)) {
 #ifdef __APPLE__
                 sem_post(iq_sem_buffer[ddc]);
 #else
                 sem_post(&iq_sem_buffer[ddc]);
 #endif
+              } else {
+                // ring full: drop packet, the sequence check will report the gap
+                release_my_buffer(mybuf);
               }
               break;
             case COMMAND_RESPONCE_TO_HOST_PORT:
@@ -1609,9 +1827,78 @@ g_print("new_protocol_thread\n");
               break;
             default:
 g_print("new_protocol_thread: Unknown port %d\n",sourceport);
-              mybuf->free=1;
+              release_my_buffer(mybuf);
               break;
         }
+}
+
+static gpointer new_protocol_thread(gpointer data) {
+
+    int i, n, batch;
+    gint64 rxtime;
+    mybuffer *mybuf[NET_RX_MAX_BATCH];
+    unsigned char *bufs[NET_RX_MAX_BATCH];
+    int lengths[NET_RX_MAX_BATCH];
+    struct sockaddr_in addrs[NET_RX_MAX_BATCH];
+
+g_print("new_protocol_thread\n");
+
+    iqindex=4;
+
+    audioindex=4; // leave space for sequence
+    audiosequence=0L;
+
+    batch=net_rx_get_batch();
+    g_print("new_protocol_thread: receiving up to %d packets per system call\n",batch);
+    net_rx_stats_init(&rx_stats, "NewProtocol RX");
+    for (i=0; i<batch; i++) mybuf[i]=NULL;
+
+    running=1;
+
+    while(running) {
+
+        //
+        // Buffers that have been handed over in the last round
+        // are replaced, the others are re-used.
+        //
+        for (i=0; i<batch; i++) {
+          if (mybuf[i] == NULL) mybuf[i]=get_my_buffer();
+          bufs[i]=mybuf[i]->buffer;
+        }
+        if (capture_replaying) {
+          n=capture_replay_recv(bufs,NET_BUFFER_SIZE,batch,lengths,addrs);
+          if (n < 0) continue;    // nothing to replay
+        } else {
+          n=net_rx_recv(data_socket,bufs,NET_BUFFER_SIZE,batch,lengths,addrs,&rx_stats);
+        }
+
+        if (!running) {
+          //
+          // When leaving piHPSDR, it may happen that the protocol has been stopped while
+	  // we were doing "recvfrom". In this case, we want to let the main
+	  // thread terminate gracefully, including writing the props files.
+	  //
+	  break;
+	}
+
+        if(n<0) {
+            g_print("recvfrom socket failed for new_protocol_thread");
+            exit(-1);
+        }
+
+        rxtime=stream_stats_now();
+        if (capture_recording) {
+          for (i=0; i<n; i++) capture_packet(bufs[i], lengths[i], &addrs[i]);
+        }
+        for (i=0; i<n; i++) {
+          mybuf[i]->rxtime=rxtime;
+          new_protocol_dispatch(mybuf[i], lengths[i], ntohs(addrs[i].sin_port));
+          mybuf[i]=NULL;
+        }
+    }
+
+    for (i=0; i<batch; i++) {
+      if (mybuf[i] != NULL) release_my_buffer(mybuf[i]);
     }
 
     return NULL;
@@ -1628,7 +1915,7 @@ static gpointer command_response_thread(gpointer data) {
     sem_wait(&command_response_sem_buffer);
 #endif
     process_command_response();
-    command_response_buffer->free=1;
+    release_my_buffer(command_response_buffer);
   }
 }
 
@@ -1643,7 +1930,7 @@ g_print("high_priority_thread\n");
     sem_wait(&high_priority_sem_buffer);
 #endif
     process_high_priority();
-    high_priority_buffer->free=1;
+    release_my_buffer(high_priority_buffer);
   }
 }
 
@@ -1662,7 +1949,7 @@ g_print("mic_line_thread\n");
 //  since this is our pace-maker
 //
     process_mic_data(mic_bytes_read);
-    mic_line_buffer->free=1;
+    release_my_buffer(mic_line_buffer);
   }
 }
 
@@ -1670,23 +1957,27 @@ static gpointer iq_thread(gpointer data) {
   int ddc=GPOINTER_TO_INT(data);
   long sequence;
   unsigned char *buffer;
+  mybuffer *mybuf;
   g_print("iq_thread: ddc=%d\n",ddc);
   while(1) {
 #ifdef __APPLE__
-    sem_post(iq_sem_ready[ddc]);
     sem_wait(iq_sem_buffer[ddc]);
 #else
-    sem_post(&iq_sem_ready[ddc]);
     sem_wait(&iq_sem_buffer[ddc]);
 #endif
-    if (iq_buffer[ddc] == NULL) continue;
-    buffer=iq_buffer[ddc]->buffer;
+    mybuf=iq_queue_get(&iq_queue[ddc]);
+    if (mybuf == NULL) continue;
+    buffer=mybuf->buffer;
 //
 //  Perform sequence check HERE for all cases
 //
     sequence=((buffer[0]&0xFF)<<24)+((buffer[1]&0xFF)<<16)+((buffer[2]&0xFF)<<8)+(buffer[3]&0xFF);
+    TRACE_EVENT(TRACE_DDC_PACKET, ddc, sequence);
+    stream_stats_packet(STREAM_DDC0+ddc, sequence, mybuf->rxtime);
+    // the PURESIGNAL feedback is also counted as the TX IQ echo
+    if (rxcase[ddc] == RXACTION_PS) stream_stats_packet(STREAM_TXECHO, sequence, mybuf->rxtime);
     if(ddc_sequence[ddc] !=sequence) {
-      g_print("DDC %d sequence error: expected %ld got %ld\n",ddc,ddc_sequence[ddc],sequence);
+      TRACE_EVENT(TRACE_DDC_SEQ_ERROR, ddc, sequence);
       ddc_sequence[ddc]=sequence;
       sequence_errors++;
     }
@@ -1708,8 +1999,11 @@ static gpointer iq_thread(gpointer data) {
 	case RXACTION_DIV:
 	  process_div_iq_data(buffer);
 	  break;
+	case RXACTION_SLICE:
+	  process_slice_iq_data(buffer,&slice[rxid[ddc]]);
+	  break;
     }
-    iq_buffer[ddc]->free=1;
+    release_my_buffer(mybuf);
   }
 }
 
@@ -1754,6 +2048,42 @@ static void process_iq_data(unsigned char *buffer, RECEIVER *rx) {
   }
 }
 
+//
+// The slices take blocks of samples: the packet is converted
+// as a whole and then handed over
+//
+static void process_slice_iq_data(unsigned char *buffer, SLICE *s) {
+  int samplesperframe;
+  int b;
+  int i;
+  int sample;
+  double iq[2*238];
+
+  samplesperframe=((buffer[14]&0xFF)<<8)+(buffer[15]&0xFF);
+  if (samplesperframe > 238) samplesperframe=238;
+
+  b=16;
+  for(i=0;i<2*samplesperframe;i++) {
+    sample  = (int)((signed char) buffer[b++])<<16;
+    sample |= (int)((((unsigned char)buffer[b++])<<8)&0xFF00);
+    sample |= (int)((unsigned char)buffer[b++]&0xFF);
+    iq[i]=(double)sample/8388608.0; // for 24 bits
+  }
+  slice_add_iq_samples_block(s, iq, samplesperframe);
+}
+
+//
+// Process a DDC packet that has not been received from the radio
+// but read from a capture (protocol_bench)
+//
+void new_protocol_replay_iq(unsigned char *buffer, int length, RECEIVER *rx) {
+  int samplesperframe;
+  if (length < 16) return;
+  samplesperframe=((buffer[14]&0xFF)<<8)+(buffer[15]&0xFF);
+  if (length < 16+6*samplesperframe) return;
+  process_iq_data(buffer, rx);
+}
+
 //
 // This is the same as process_ps_iq_data except that add_div_iq_samples is called
 // at the end
@@ -1879,7 +2209,7 @@ static void process_command_response() {
     unsigned char *buffer = command_response_buffer->buffer;
     sequence=((buffer[0]&0xFF)<<24)+((buffer[1]&0xFF)<<16)+((buffer[2]&0xFF)<<8)+(buffer[3]&0xFF);
     if (sequence != response_sequence) {
-	g_print("CommRes SeqErr: expected=%ld seen=%ld\n", response_sequence, sequence);
+	TRACE_EVENT(TRACE_CMDRES_SEQ_ERROR, response_sequence, sequence);
 	response_sequence=sequence;
     }
     response_sequence++;
@@ -1900,8 +2230,9 @@ static void process_high_priority() {
     unsigned char *buffer=high_priority_buffer->buffer;
 
     sequence=((buffer[0]&0xFF)<<24)+((buffer[1]&0xFF)<<16)+((buffer[2]&0xFF)<<8)+(buffer[3]&0xFF);
+    stream_stats_packet(STREAM_HIGHPRIO, sequence, high_priority_buffer->rxtime);
     if (sequence != highprio_rcvd_sequence) {
-	g_print("HighPrio SeqErr Expected=%ld Seen=%ld\n", highprio_rcvd_sequence, sequence);
+	TRACE_EVENT(TRACE_HIGHPRIO_SEQ_ERROR, highprio_rcvd_sequence, sequence);
 	highprio_rcvd_sequence=sequence;
     }
     highprio_rcvd_sequence++;
@@ -1957,8 +2288,9 @@ static void process_mic_data(int bytes) {
   unsigned char *buffer=mic_line_buffer->buffer;
 
   sequence=((buffer[0]&0xFF)<<24)+((buffer[1]&0xFF)<<16)+((buffer[2]&0xFF)<<8)+(buffer[3]&0xFF);
+  stream_stats_packet(STREAM_MIC, sequence, mic_line_buffer->rxtime);
   if (sequence != micsamples_sequence) {
-    g_print("MicSample SeqErr Expected=%ld Seen=%ld\n", micsamples_sequence, sequence);
+    TRACE_EVENT(TRACE_MIC_SEQ_ERROR, micsamples_sequence, sequence);
     micsamples_sequence=sequence;
   }
   micsamples_sequence++;
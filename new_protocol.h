@@ -73,6 +73,9 @@ extern int send_high_priority;
 extern int send_general;
 */
 
+// depth of the per-DDC IQ packet ring (see new_protocol.c)
+extern int iq_queue_depth;
+
 extern void schedule_high_priority(void);
 extern void schedule_general(void);
 extern void schedule_receive_specific(void);
@@ -96,4 +99,7 @@ extern void new_protocol_flush_iq_samples(void);
 extern void new_protocol_cw_audio_samples(short l, short r);
 
 extern void new_protocol_restart(void);
+extern void new_protocol_iq_queue_stats(int ddc, int *depth, int *high_water, int *drops);
+extern void new_protocol_buffer_stats(int *size, int *in_use, int *high_water, int *failures);
+extern void new_protocol_replay_iq(unsigned char *buffer, int length, RECEIVER *rx);
 #endif
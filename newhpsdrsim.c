@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <pthread.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <string.h>
 #include <netinet/in.h>
@@ -117,6 +118,7 @@ void   *duc_specific_thread(void*);
 void   *highprio_thread(void*);
 void   *send_highprio_thread(void*);
 void   *rx_thread(void *);
+void   *rx_load_thread(void *);
 void   *tx_thread(void *);
 void   *mic_thread(void *);
 void   *audio_thread(void *);
@@ -607,10 +609,17 @@ void *highprio_thread(void *data) {
           if (pthread_create(&duc_specific_thread_id, NULL, duc_specific_thread, NULL) < 0) {
             perror("***** ERROR: Create DUC specific thread");
           }
-          for (i=0; i< NUMRECEIVERS; i++) {
-            if (pthread_create(&rx_thread_id[i], NULL, rx_thread, (void *) (uintptr_t) i) < 0) {
-              perror("***** ERROR: Create RX thread");
+          if (loadgen) {
+            // a single thread sends the data of all DDCs
+            if (pthread_create(&rx_thread_id[0], NULL, rx_load_thread, NULL) < 0) {
+              perror("***** ERROR: Create RX load thread");
             }
+          } else {
+            for (i=0; i< NUMRECEIVERS; i++) {
+              if (pthread_create(&rx_thread_id[i], NULL, rx_thread, (void *) (uintptr_t) i) < 0) {
+                perror("***** ERROR: Create RX thread");
+              }
+	    }
 	  }
           if (pthread_create(&tx_thread_id, NULL, tx_thread, NULL) < 0) {
             perror("***** ERROR: Create TX thread");
@@ -627,7 +636,7 @@ void *highprio_thread(void *data) {
 	} else {
           pthread_join(ddc_specific_thread_id, NULL);
           pthread_join(duc_specific_thread_id, NULL);
-          for (i=0; i<NUMRECEIVERS; i++) {
+          for (i=0; i<(loadgen ? 1 : NUMRECEIVERS); i++) {
             pthread_join(rx_thread_id[i], NULL);
           }
           pthread_join(send_highprio_thread_id, NULL);
@@ -775,6 +784,8 @@ void *rx_thread(void *data) {
   int divptr;
   int decimation;
   unsigned int seed;
+  IMPAIR_STREAM *imp;
+  char name[8];
   
   struct timespec delay;
 
@@ -805,6 +816,8 @@ void *rx_thread(void *data) {
   }
 
   tonept=noisept=0;
+  sprintf(name, "DDC%d", myddc);
+  imp=impair_stream_new(name, 1+myddc);
   clock_gettime(CLOCK_MONOTONIC, &delay);
   fprintf(stderr,"RX thread %d, enabled=%d\n", myddc, ddcenable[myddc]);
   rxptr=txptr-4096;  
@@ -947,15 +960,155 @@ void *rx_thread(void *data) {
           delay.tv_sec++;
 	}
         clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &delay, NULL);
-        if (sendto(sock, buffer, 1444, 0, (struct sockaddr*)&addr_new, sizeof(addr_new)) < 0) {
+        if (impair_sendto(imp, sock, buffer, 1444, &addr_new) < 0) {
           perror("***** ERROR: RX thread sendto");
           break;
 	}
   }
+  impair_stream_free(imp);
   close(sock);
   return NULL;
 }
 
+//
+// RX thread of the load generator: one thread serves all DDCs.
+// The samples are taken from a template for each sample rate
+// (one with sample pairs for synchronized DDCs), and each packet is
+// the 16-byte header followed by a 1428-byte block of the template.
+// The packets that are due are sent in batches every millisecond
+// (see loadgen.c).
+//
+void *rx_load_thread(void *data) {
+  int sock[NUMRECEIVERS];
+  struct sockaddr_in addr;
+  LOAD_TEMPLATE tmpl[6][2];
+  LOAD_TEMPLATE *t;
+  LOAD_CLOCK clk;
+  LOAD_STREAM stream[NUMRECEIVERS];
+  IMPAIR_STREAM *imp[NUMRECEIVERS];
+  int active[NUMRECEIVERS];
+  int block[NUMRECEIVERS];
+  int mysync[NUMRECEIVERS];
+  unsigned long seqnum[NUMRECEIVERS];
+  struct iovec iov[LOAD_BATCH*2];
+  unsigned char header[LOAD_BATCH][16];
+  char name[8];
+  int yes = 1;
+  int ddc, myrate, sync, r, i, n, due;
+  long long now;
+  unsigned char *p;
+
+  memset(tmpl, 0, sizeof(tmpl));
+  memset(stream, 0, sizeof(stream));
+  for (ddc=0; ddc<NUMRECEIVERS; ddc++) {
+    active[ddc]=0;
+    block[ddc]=0;
+    seqnum[ddc]=0;
+    sprintf(name, "DDC%d", ddc);
+    imp[ddc]=impair_stream_new(name, 1+ddc);
+    sock[ddc]=socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock[ddc] < 0) {
+      perror("***** ERROR: RX load thread: socket");
+      continue;
+    }
+    setsockopt(sock[ddc], SOL_SOCKET, SO_REUSEADDR, (void *)&yes, sizeof(yes));
+    setsockopt(sock[ddc], SOL_SOCKET, SO_REUSEPORT, (void *)&yes, sizeof(yes));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(ddc0_port+ddc);
+    if (bind(sock[ddc], (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+      perror("***** ERROR: RX load thread: bind");
+      close(sock[ddc]);
+      sock[ddc]=-1;
+    }
+  }
+
+  load_clock_start(&clk);
+  now=clk.start;
+  while (run) {
+    now=load_tick(&clk);
+    for (ddc=0; ddc<NUMRECEIVERS; ddc++) {
+      if (sock[ddc] < 0) continue;
+      impair_flush(imp[ddc], 0);
+      if (load_receivers > 0) {
+        myrate=ddc < load_receivers ? (load_rate > 0 ? load_rate : rxrate[ddc]) : 0;
+      } else {
+        myrate=(ddcenable[ddc] > 0 && rxfreq[ddc] != 0) ? (load_rate > 0 ? load_rate : rxrate[ddc]) : 0;
+      }
+      // only a single synchronized DDC, as in rx_thread
+      sync=syncddc[ddc] > 0;
+      r=0;
+      while (r < 6 && (48 << r) != myrate) r++;
+      if (r == 6) {
+        if (active[ddc]) {
+          sprintf(name, "DDC%d", ddc);
+          load_report(name, &stream[ddc], now);
+        }
+        active[ddc]=0;
+        continue;
+      }
+      t=&tmpl[r][sync];
+      if (t->data == NULL) {
+        if (load_template(t, myrate, sync ? 2 : 1, sync ? 119 : 238, 0, 1428) < 0) {
+          fprintf(stderr,"LOAD: cannot make template\n");
+          continue;
+        }
+      }
+      if (!active[ddc] || stream[ddc].rate != myrate || mysync[ddc] != sync) {
+        if (active[ddc]) {
+          sprintf(name, "DDC%d", ddc);
+          load_report(name, &stream[ddc], now);
+        }
+        active[ddc]=1;
+        mysync[ddc]=sync;
+        // the DDCs start at different places of the template
+        block[ddc]=(ddc*t->blocks) / NUMRECEIVERS;
+        load_stream_start(&stream[ddc], now, myrate, t->slots);
+      }
+      due=load_due(&stream[ddc], now);
+      while (due > 0) {
+        n=due > LOAD_BATCH ? LOAD_BATCH : due;
+        for (i=0; i<n; i++) {
+          p=header[i];
+          memset(p, 0, 16);
+          *p++ =(seqnum[ddc] >> 24) & 0xFF;
+          *p++ =(seqnum[ddc] >> 16) & 0xFF;
+          *p++ =(seqnum[ddc] >>  8) & 0xFF;
+          *p++ =(seqnum[ddc] >>  0) & 0xFF;
+          seqnum[ddc]++;
+          // no time stamps, 24 bits per sample, 238 samples
+          header[i][13]=24;
+          header[i][15]=238;
+          iov[2*i  ].iov_base=header[i];
+          iov[2*i  ].iov_len =16;
+          iov[2*i+1].iov_base=t->data + block[ddc]*1428;
+          iov[2*i+1].iov_len =1428;
+          if (++block[ddc] >= t->blocks) block[ddc]=0;
+        }
+        load_send(&stream[ddc], imp[ddc], sock[ddc], &addr_new, iov, 2, n);
+        due -= n;
+      }
+    }
+    if (load_expired(&clk, now)) break;
+  }
+  for (ddc=0; ddc<NUMRECEIVERS; ddc++) {
+    if (active[ddc]) {
+      sprintf(name, "DDC%d", ddc);
+      load_report(name, &stream[ddc], now);
+    }
+    impair_stream_free(imp[ddc]);
+    if (sock[ddc] >= 0) close(sock[ddc]);
+  }
+  load_clock_report(&clk, now);
+  for (r=0; r<6; r++) {
+    load_template_free(&tmpl[r][0]);
+    load_template_free(&tmpl[r][1]);
+  }
+  if (load_expired(&clk, now)) exit(EXIT_SUCCESS);
+  return NULL;
+}
+
 //
 // This thread receives data (TX samples) from the PC
 //
@@ -1060,6 +1213,7 @@ void *send_highprio_thread(void *data) {
   int rc;
   int i;
   unsigned char *p;
+  IMPAIR_STREAM *imp;
 
 
   seqnum=0;
@@ -1085,6 +1239,8 @@ void *send_highprio_thread(void *data) {
   }
 
   seqnum=0;
+  // with jitter, the packets are delayed by multiples of 50 msec
+  imp=impair_stream_new("HP", 8);
   while (1) {
     if (!run) {
 	close(sock);
@@ -1110,13 +1266,14 @@ void *send_highprio_thread(void *data) {
 
     buffer[49]=63;   // about 13 volts supply 
 
-    if (sendto(sock, buffer, 60, 0, (struct sockaddr*)&addr_new, sizeof(addr_new)) < 0) {
+    if (impair_sendto(imp, sock, buffer, 60, &addr_new) < 0) {
        perror("***** ERROR: HP send thread sendto");
        break;
     }
     seqnum++;
     usleep(50000); // wait 50 msec then send again
   }
+  impair_stream_free(imp);
   close(sock);
   return NULL;
 }
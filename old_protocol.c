@@ -52,6 +52,11 @@
 #include "ext.h"
 #include "iambic.h"
 #include "error_handler.h"
+#include "net_rx.h"
+#include "trace.h"
+#include "capture.h"
+#include "stream_stats.h"
+#include "slice.h"
 
 #define min(x,y) (x<y?x:y)
 
@@ -97,27 +102,19 @@
 #define LT2208_RANDOM_OFF         0x00
 #define LT2208_RANDOM_ON          0x10
 
-// state machine buffer processing
-enum {
-  SYNC_0=0,
-  SYNC_1,
-  SYNC_2,
-  CONTROL_0,
-  CONTROL_1,
-  CONTROL_2,
-  CONTROL_3,
-  CONTROL_4,
-  LEFT_SAMPLE_HI,
-  LEFT_SAMPLE_MID,
-  LEFT_SAMPLE_LOW,
-  RIGHT_SAMPLE_HI,
-  RIGHT_SAMPLE_MID,
-  RIGHT_SAMPLE_LOW,
-  MIC_SAMPLE_HI,
-  MIC_SAMPLE_LOW,
-  SKIP
-};
-static int state=SYNC_0;
+//
+// Maximum number of HPSDR receivers that can be packed into a 512-byte
+// USB frame. Up to 5 are used here (PURESIGNAL on ANGELIA and beyond).
+//
+#define MAX_HPSDR_RECEIVERS 8
+
+//
+// A 512-byte USB frame consists of 3 sync bytes, 5 C&C bytes, and
+// (512-8)/(num_hpsdr_receivers*6+2) rows each containing 24-bit I and Q
+// samples for each receiver followed by a 16-bit mic sample.
+// At most 63 rows (one receiver) fit into a frame.
+//
+#define MAX_FRAME_ROWS 63
 
 static int display_width;
 
@@ -165,6 +162,13 @@ static int output_buffer_index=8;
 static int command=1;
 
 static GThread *receive_thread_id;
+
+//
+// Receive buffers for (batched) UDP reception
+//
+#define RX_BUFFER_SIZE 2048
+static unsigned char rx_buffer[NET_RX_MAX_BATCH][RX_BUFFER_SIZE];
+static NET_RX_STATS rx_stats;
 static gpointer receive_thread(gpointer arg);
 static void process_ozy_input_buffer(unsigned char  *buffer);
 static void process_bandscope_buffer(char  *buffer);
@@ -296,6 +300,7 @@ void old_protocol_stop() {
   }
 #endif
   pthread_mutex_unlock(&send_ozy_mutex);
+  stream_stats_report();
 }
 
 void old_protocol_run() {
@@ -312,6 +317,7 @@ void old_protocol_set_mic_sample_rate(int rate) {
 void old_protocol_init(int rx,int pixels,int rate) {
   int i;
   g_print("old_protocol_init: num_hpsdr_receivers=%d\n",how_many_receivers());
+  stream_stats_reset();
   pthread_mutex_lock(&send_ozy_mutex);
 
   old_protocol_set_mic_sample_rate(rate);
@@ -460,6 +466,7 @@ static void open_udp_socket() {
     if (setsockopt(tmp, SOL_SOCKET, SO_RCVBUF, &optval, sizeof(optval))<0) {
       perror("data_socket: SO_RCVBUF");
     }
+    net_rx_set_rcvbuf(tmp, "old_protocol");
 #ifdef __APPLE__
     //optval = 0x10;  // IPTOS_LOWDELAY
     optval = 0xb8;  // DSCP EF
@@ -541,19 +548,98 @@ static void open_tcp_socket() {
     g_print("TCP socket established: %d\n", tcp_socket);
 }
 
+//
+// Process one METIS frame (1032 bytes) received via UDP or TCP
+// at the given time (see stream_stats_now)
+//
+static void process_metis_packet(unsigned char *buffer, int bytes_read, gint64 rxtime) {
+  int ep;
+  uint32_t sequence;
+
+  if(buffer[0]==0xEF && buffer[1]==0xFE) {
+    switch(buffer[2]) {
+      case 1:
+        // get the end point
+        ep=buffer[3]&0xFF;
+
+        // get the sequence number
+        sequence=((buffer[4]&0xFF)<<24)+((buffer[5]&0xFF)<<16)+((buffer[6]&0xFF)<<8)+(buffer[7]&0xFF);
+
+        // A sequence error with a seqnum of zero usually indicates a METIS restart
+        // and is no error condition
+        if (sequence != 0 && sequence != last_seq_num+1) {
+          TRACE_EVENT(TRACE_OLD_SEQ_ERROR, last_seq_num, sequence);
+          sequence_errors++;
+        }
+        last_seq_num=sequence;
+        switch(ep) {
+          case 6: // EP6
+            stream_stats_packet(STREAM_EP6, sequence, rxtime);
+            // process the data
+            process_ozy_input_buffer(&buffer[8]);
+            process_ozy_input_buffer(&buffer[520]);
+            break;
+          case 4: // EP4
+/*
+            ep4_sequence++;
+            if(sequence!=ep4_sequence) {
+              ep4_sequence=sequence;
+            } else {
+              int seq=(int)(sequence%32L);
+              if((sequence%32L)==0L) {
+                reset_bandscope_buffer_index();
+              }
+              process_bandscope_buffer(&buffer[8]);
+              process_bandscope_buffer(&buffer[520]);
+            }
+*/
+            break;
+          default:
+            g_print("unexpected EP %d length=%d\n",ep,bytes_read);
+            break;
+        }
+        break;
+      case 2:  // response to a discovery packet
+        g_print("unexepected discovery response when not in discovery mode\n");
+        break;
+      default:
+        g_print("unexpected packet type: 0x%02X\n",buffer[2]);
+        break;
+    }
+  } else {
+    g_print("received bad header bytes on data port %02X,%02X\n",buffer[0],buffer[1]);
+  }
+}
+
+//
+// Process a METIS frame that has not been received from the radio
+// but read from a capture (protocol_bench)
+//
+void old_protocol_replay_packet(unsigned char *buffer, int length) {
+  if (length == 1032) process_metis_packet(buffer, length, stream_stats_now());
+}
+
 static gpointer receive_thread(gpointer arg) {
-  struct sockaddr_in addr;
-  socklen_t length;
-  unsigned char buffer[2048];
+  struct sockaddr_in addr[NET_RX_MAX_BATCH];
+  unsigned char *bufs[NET_RX_MAX_BATCH];
+  int lengths[NET_RX_MAX_BATCH];
+  unsigned char *buffer;
   int bytes_read;
   int ret,left;
-  int ep;
-  uint32_t sequence;
+  int i,n,batch;
+  gint64 rxtime;
 
   g_print( "old_protocol: receive_thread\n");
   running=1;
 
-  length=sizeof(addr);
+  batch=net_rx_get_batch();
+  g_print("old_protocol: receiving up to %d UDP packets per system call\n",batch);
+  net_rx_stats_init(&rx_stats, "OldProtocol RX");
+  for (i=0; i<batch; i++) {
+    bufs[i]=rx_buffer[i];
+  }
+  buffer=rx_buffer[0];
+
   while(running) {
 
     switch(device) {
@@ -564,8 +650,12 @@ static gpointer receive_thread(gpointer arg) {
 #endif
 
       default:
+        n=1;
 	for (;;) {
-          if (tcp_socket >= 0) {
+          if (capture_replaying) {
+            n=capture_replay_recv(bufs,RX_BUFFER_SIZE,batch,lengths,addr);
+            bytes_read=(n > 0) ? lengths[0] : n;
+          } else if (tcp_socket >= 0) {
 	    // TCP messages may be split, so collect exactly 1032 bytes.
 	    // Remember, this is a STREAMING protocol.
             bytes_read=0;
@@ -581,9 +671,12 @@ static gpointer receive_thread(gpointer arg) {
 	      bytes_read=ret;                          // error case: discard whole packet
               //perror("old_protocol recvfrom TCP:");
 	    }
+            lengths[0]=bytes_read;
+            n=1;
 	  } else if (data_socket >= 0) {
-            bytes_read=recvfrom(data_socket,buffer,sizeof(buffer),0,(struct sockaddr*)&addr,&length);
-            if(bytes_read < 0 && errno != EAGAIN) perror("old_protocol recvfrom UDP:");
+            n=net_rx_recv(data_socket,bufs,RX_BUFFER_SIZE,batch,lengths,addr,&rx_stats);
+            bytes_read=(n > 0) ? lengths[0] : n;
+            if(n < 0 && errno != EAGAIN) perror("old_protocol recvfrom UDP:");
 	    //g_print("%s: bytes_read=%d\n",__FUNCTION__,bytes_read);
           } else {
 	    // This could happen in METIS start/stop sequences
@@ -595,62 +688,16 @@ static gpointer receive_thread(gpointer arg) {
         if(bytes_read <= 0) {
           continue;
         }
+        rxtime=stream_stats_now();
 
-        if(buffer[0]==0xEF && buffer[1]==0xFE) {
-          switch(buffer[2]) {
-            case 1:
-              // get the end point
-              ep=buffer[3]&0xFF;
-
-              // get the sequence number
-              sequence=((buffer[4]&0xFF)<<24)+((buffer[5]&0xFF)<<16)+((buffer[6]&0xFF)<<8)+(buffer[7]&0xFF);
-
-	      // A sequence error with a seqnum of zero usually indicates a METIS restart
-	      // and is no error condition
-              if (sequence != 0 && sequence != last_seq_num+1) {
-		struct timespec ts;
-		double now;
-		clock_gettime(CLOCK_MONOTONIC, &ts);
-		now=ts.tv_sec + 1E-9*ts.tv_nsec;
-		g_print("SEQ ERROR: T=%0.3f last %ld, recvd %ld\n", now, (long) last_seq_num, (long) sequence);
-                sequence_errors++;
-	      }
-	      last_seq_num=sequence;
-              switch(ep) {
-                case 6: // EP6
-                  // process the data
-                  process_ozy_input_buffer(&buffer[8]);
-                  process_ozy_input_buffer(&buffer[520]);
-                  break;
-                case 4: // EP4
-/*
-                  ep4_sequence++;
-                  if(sequence!=ep4_sequence) {
-                    ep4_sequence=sequence;
-                  } else {
-                    int seq=(int)(sequence%32L);
-                    if((sequence%32L)==0L) {
-                      reset_bandscope_buffer_index();
-                    }
-                    process_bandscope_buffer(&buffer[8]);
-                    process_bandscope_buffer(&buffer[520]);
-                  }
-*/
-                  break;
-                default:
-                  g_print("unexpected EP %d length=%d\n",ep,bytes_read);
-                  break;
-              }
-              break;
-            case 2:  // response to a discovery packet
-              g_print("unexepected discovery response when not in discovery mode\n");
-              break;
-            default:
-              g_print("unexpected packet type: 0x%02X\n",buffer[2]);
-              break;
+        if (capture_recording) {
+          for (i=0; i<n; i++) {
+            // TCP frames come from the data port of the radio
+            if (lengths[i] > 0) capture_packet(rx_buffer[i], lengths[i], tcp_socket >= 0 ? &data_addr : &addr[i]);
           }
-        } else {
-          g_print("received bad header bytes on data port %02X,%02X\n",buffer[0],buffer[1]);
+        }
+        for (i=0; i<n; i++) {
+          if (lengths[i] > 0) process_metis_packet(rx_buffer[i], lengths[i], rxtime);
         }
         break;
     }
@@ -741,6 +788,18 @@ static int second_receiver_channel() {
   return 1;
 }
 
+//
+// The slices use the HPSDR receivers after RX1 and RX2. They are
+// switched off while DIVERSITY or PURESIGNAL need these receivers.
+//
+static int active_slices() {
+  if (diversity_enabled) return 0;
+#ifdef PURESIGNAL
+  if (transmitter != NULL && transmitter->puresignal) return 0;
+#endif
+  return slice_ddcs();
+}
+
 static long long channel_freq(int chan) {
   //
   // Return the frequency associated with the current HPSDR
@@ -759,6 +818,10 @@ static long long channel_freq(int chan) {
   int vfonum;
   long long freq;
 
+  if (chan >= 2 && chan < 2+active_slices()) {
+    return slice_ddc_frequency(&slice[chan-2])+calibration;
+  }
+
   // RX1 and RX2 are normally used for the first and second receiver.
   // all other channels are used for PURESIGNAL and get the TX frequency
   switch (chan) {
@@ -827,6 +890,7 @@ static int how_many_receivers() {
   //
   int ret = receivers;   	// 1 or 2
   if (diversity_enabled) ret=2; // need both RX channels, even if there is only one RX
+  if (active_slices() > 0) ret=2+active_slices();
 
 #ifdef USBOZY
   //
@@ -846,7 +910,7 @@ static int how_many_receivers() {
     // we need at least 2, and up to 5 for Orion2 boards. This is so because
     // the TX DAC is hard-wired to RX4 for HERMES,STEMLAB and to RX5 for ANGELIA
     // and beyond.
-  if (transmitter->puresignal) {
+  if (transmitter != NULL && transmitter->puresignal) {
     switch (device) {
       case DEVICE_METIS:
       case DEVICE_HERMES_LITE:
@@ -874,23 +938,11 @@ static int how_many_receivers() {
     return ret;
 }
 
-static int nreceiver;
-static int left_sample;
-static int right_sample;
-static short mic_sample;
-static double left_sample_double;
-static double right_sample_double;
-double left_sample_double_rx;
-double right_sample_double_rx;
-double left_sample_double_tx;
-double right_sample_double_tx;
-double left_sample_double_main;
-double right_sample_double_main;
-double left_sample_double_aux;
-double right_sample_double_aux;
-
-static int nsamples;
-static int iq_samples;
+//
+// IQ samples of one USB frame, converted to doubles and
+// sorted by HPSDR receiver (interleaved I/Q as in the WDSP buffers)
+//
+static double frame_iq[MAX_HPSDR_RECEIVERS][2*MAX_FRAME_ROWS];
 
 static void process_control_bytes() {
   int previous_ptt;
@@ -1044,173 +1096,115 @@ static int txfdbk;
 static int rx1channel;
 static int rx2channel;
 
-static void process_ozy_byte(int b) {
-  float fsample;
-  switch(state) {
-    case SYNC_0:
-      if(b==SYNC) {
-        state++;
-      }
-      break;
-    case SYNC_1:
-      if(b==SYNC) {
-        state++;
-      }
-      break;
-    case SYNC_2:
-      if(b==SYNC) {
-        state++;
-      }
-      break;
-    case CONTROL_0:
-      control_in[0]=b;
-      state++;
-      break;
-    case CONTROL_1:
-      control_in[1]=b;
-      state++;
-      break;
-    case CONTROL_2:
-      control_in[2]=b;
-      state++;
-      break;
-    case CONTROL_3:
-      control_in[3]=b;
-      state++;
-      break;
-    case CONTROL_4:
-      control_in[4]=b;
-      process_control_bytes();
-      nreceiver=0;
-      iq_samples=(512-8)/((num_hpsdr_receivers*6)+2);
-      nsamples=0;
-      state++;
-      break;
-    case LEFT_SAMPLE_HI:
-      left_sample=(int)((signed char)b<<16);
-      state++;
-      break;
-    case LEFT_SAMPLE_MID:
-      left_sample|=(int)((((unsigned char)b)<<8)&0xFF00);
-      state++;
-      break;
-    case LEFT_SAMPLE_LOW:
-      left_sample|=(int)((unsigned char)b&0xFF);
-      left_sample_double=(double)left_sample/8388607.0; // 24 bit sample 2^23-1
-      state++;
-      break;
-    case RIGHT_SAMPLE_HI:
-      right_sample=(int)((signed char)b<<16);
-      state++;
-      break;
-    case RIGHT_SAMPLE_MID:
-      right_sample|=(int)((((unsigned char)b)<<8)&0xFF00);
-      state++;
-      break;
-    case RIGHT_SAMPLE_LOW:
-      right_sample|=(int)((unsigned char)b&0xFF);
-      right_sample_double=(double)right_sample/8388607.0; // 24 bit sample 2^23-1
-
-      if (isTransmitting() && transmitter->puresignal) {
-        //
-        // transmitting with PURESIGNAL. Get sample pairs and feed to pscc
-        //
-        if (nreceiver == rxfdbk) {
-          left_sample_double_rx=left_sample_double;
-          right_sample_double_rx=right_sample_double;
-        } else if (nreceiver == txfdbk) {
-          left_sample_double_tx=left_sample_double;
-          right_sample_double_tx=right_sample_double;
-        }
-        // this is pure paranoia, it allows for txfdbk < rxfdbk
-        if (nreceiver+1 == num_hpsdr_receivers) {
-          add_ps_iq_samples(transmitter, left_sample_double_tx,right_sample_double_tx,left_sample_double_rx,right_sample_double_rx);
-        }
-      }
-
-      if (!isTransmitting() && diversity_enabled) {
-        //
-        // receiving with DIVERSITY. Get sample pairs and feed to diversity mixer
-        //
-        if (nreceiver == rx1channel) {
-          left_sample_double_main=left_sample_double;
-          right_sample_double_main=right_sample_double;
-        } else if (nreceiver == rx2channel) {
-          left_sample_double_aux=left_sample_double;
-          right_sample_double_aux=right_sample_double;
-        }
-        // this is pure paranoia, it allows for rx2channel < rx1channel
-        if (nreceiver+1 == num_hpsdr_receivers) {
-          add_div_iq_samples(receiver[0], left_sample_double_main,right_sample_double_main,left_sample_double_aux,right_sample_double_aux);
-          // if we have a second receiver, display "auxiliary" receiver as well
-          if (receivers >1) add_iq_samples(receiver[1], left_sample_double_aux,right_sample_double_aux);
-        }
-      }
-
-      if ((!isTransmitting() || duplex) && !diversity_enabled) {
-        //
-        // RX without DIVERSITY. Feed samples to RX1 and RX2
-        //
-        if (nreceiver == rx1channel) {
-           add_iq_samples(receiver[0], left_sample_double,right_sample_double);
-        } else if (nreceiver == rx2channel && receivers > 1) {
-           add_iq_samples(receiver[1], left_sample_double,right_sample_double);
-        }
-      }
-      nreceiver++;
-      if(nreceiver==num_hpsdr_receivers) {
-        state++;
-      } else {
-        state=LEFT_SAMPLE_HI;
-      }
-      break;
-    case MIC_SAMPLE_HI:
-      mic_sample=(short)(b<<8);
-      state++;
-      break;
-    case MIC_SAMPLE_LOW:
-      mic_sample|=(short)(b&0xFF);
-      mic_samples++;
-      if(mic_samples>=mic_sample_divisor) { // reduce to 48000
-        //
-        // if local_ptt is set, this usually means the PTT at the microphone connected
-        // to the SDR is pressed. In this case, we take audio from BOTH sources
-        // then we can use a "voice keyer" on some loop-back interface but at the same
-        // time use our microphone.
-        // In most situations only one source will be active so we just add.
-        //
-        if (local_ptt) {
-          fsample = (float) mic_sample * 0.00003051;
-          if (transmitter->local_microphone) fsample += audio_get_next_mic_sample();
-        } else {
-          fsample = transmitter->local_microphone ? audio_get_next_mic_sample() : (float) mic_sample * 0.00003051;
-        }
-        add_mic_sample(transmitter,fsample);
-        // micsamplecount is the "heart beat" for sending data from the 
-        // ring buffer to the radio
-        micsamplecount++;
-        mic_samples=0;
-      }
-      nsamples++;
-      if(nsamples==iq_samples) {
-        state=SYNC_0;
-      } else {
-        nreceiver=0;
-        state=LEFT_SAMPLE_HI;
-      }
-      break;
+//
+// Convert all 24-bit big-endian I/Q samples of a USB frame to doubles.
+// The frame has a fixed stride of num_hpsdr_receivers*6+2 bytes per row,
+// so this is a simple loop without any per-byte state that the compiler
+// can unroll and vectorize.
+//
+static void decode_ozy_iq(const unsigned char *buffer, int rows, int stride) {
+  const double scale=1.0/8388607.0; // 24 bit sample 2^23-1
+  for (int r=0; r<rows; r++) {
+    const unsigned char *p=buffer+8+r*stride;
+    for (int n=0; n<num_hpsdr_receivers; n++) {
+      int i_sample=((int)(signed char)p[0]<<16) | (p[1]<<8) | p[2];
+      int q_sample=((int)(signed char)p[3]<<16) | (p[4]<<8) | p[5];
+      frame_iq[n][2*r]  =(double)i_sample*scale;
+      frame_iq[n][2*r+1]=(double)q_sample*scale;
+      p+=6;
+    }
   }
 }
 
 static void process_ozy_input_buffer(unsigned char  *buffer) {
-  int i;
+  int rows,stride;
+  short mic_sample;
+  float fsample;
+
+  if (buffer[SYNC0] != SYNC || buffer[SYNC1] != SYNC || buffer[SYNC2] != SYNC) {
+    g_print("%s: SYNC error: %02X %02X %02X\n",__FUNCTION__,buffer[SYNC0],buffer[SYNC1],buffer[SYNC2]);
+    return;
+  }
+
+  //
+  // The receiver routing is evaluated once per frame
+  //
   num_hpsdr_receivers=how_many_receivers();
   rxfdbk = rx_feedback_channel();
   txfdbk = tx_feedback_channel();
   rx1channel = first_receiver_channel();
   rx2channel = second_receiver_channel();
-  for(i=0;i<512;i++) {
-    process_ozy_byte(buffer[i]&0xFF);
+
+  memcpy(control_in, &buffer[C0], 5);
+  process_control_bytes();
+
+  stride=num_hpsdr_receivers*6+2;
+  rows=(512-8)/stride;
+  decode_ozy_iq(buffer, rows, stride);
+
+  if (isTransmitting() && transmitter->puresignal) {
+    //
+    // transmitting with PURESIGNAL. Get sample pairs and feed to pscc
+    //
+    for (int r=0; r<rows; r++) {
+      add_ps_iq_samples(transmitter, frame_iq[txfdbk][2*r],frame_iq[txfdbk][2*r+1],
+                                     frame_iq[rxfdbk][2*r],frame_iq[rxfdbk][2*r+1]);
+    }
+  }
+
+  if (!isTransmitting() && diversity_enabled) {
+    //
+    // receiving with DIVERSITY. Get sample pairs and feed to diversity mixer
+    //
+    for (int r=0; r<rows; r++) {
+      add_div_iq_samples(receiver[0], frame_iq[rx1channel][2*r],frame_iq[rx1channel][2*r+1],
+                                      frame_iq[rx2channel][2*r],frame_iq[rx2channel][2*r+1]);
+    }
+    // if we have a second receiver, display "auxiliary" receiver as well
+    if (receivers >1) add_iq_samples_block(receiver[1], frame_iq[rx2channel], rows);
+  }
+
+  if ((!isTransmitting() || duplex) && !diversity_enabled) {
+    //
+    // RX without DIVERSITY. Feed samples to RX1 and RX2
+    //
+    add_iq_samples_block(receiver[0], frame_iq[rx1channel], rows);
+    if (receivers > 1) add_iq_samples_block(receiver[1], frame_iq[rx2channel], rows);
+    for (int n=2; n<num_hpsdr_receivers && n<2+active_slices(); n++) {
+      slice_add_iq_samples_block(&slice[n-2], frame_iq[n], rows);
+    }
+  }
+
+  //
+  // Without a transmitter (protocol_bench) there is nothing to do
+  // with the microphone samples
+  //
+  if (transmitter == NULL) return;
+
+  for (int r=0; r<rows; r++) {
+    const unsigned char *mic=buffer+8+r*stride+num_hpsdr_receivers*6;
+    mic_sample=(short)((mic[0]<<8) | mic[1]);
+    mic_samples++;
+    if(mic_samples>=mic_sample_divisor) { // reduce to 48000
+      //
+      // if local_ptt is set, this usually means the PTT at the microphone connected
+      // to the SDR is pressed. In this case, we take audio from BOTH sources
+      // then we can use a "voice keyer" on some loop-back interface but at the same
+      // time use our microphone.
+      // In most situations only one source will be active so we just add.
+      //
+      if (local_ptt) {
+        fsample = (float) mic_sample * 0.00003051;
+        if (transmitter->local_microphone) fsample += audio_get_next_mic_sample();
+      } else {
+        fsample = transmitter->local_microphone ? audio_get_next_mic_sample() : (float) mic_sample * 0.00003051;
+      }
+      add_mic_sample(transmitter,fsample);
+      // micsamplecount is the "heart beat" for sending data from the 
+      // ring buffer to the radio
+      micsamplecount++;
+      mic_samples=0;
+    }
     //
     // The first time data is available, micsamplecount will be
     // MUCH larger than 126. It is reset to zero once the first
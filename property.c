@@ -22,23 +22,293 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 #include "property.h"
 
 PROPERTY* properties=NULL;
+static PROPERTY* last_property=NULL;
 
 static double version=0.0;
 
+/*
+ * Entries of older generations have been deleted by clearProperties().
+ * property_file is the file the entries with in_file set came from
+ * (or have been written to).
+ */
+static unsigned int generation=1;
+static char property_file[256]="";
+
+/*
+ * Background writer: saveProperties() queues the file contents,
+ * the writer thread writes them to a temporary file and renames it.
+ */
+typedef struct _property_write {
+    char* filename;
+    GString* contents;
+} PROPERTY_WRITE;
+
+static GMutex writer_mutex;
+static GCond writer_cond;
+static GCond writer_idle_cond;
+static GQueue* writer_queue=NULL;
+static int writer_busy=0;
+static GThread* writer_thread_id=NULL;
+
+/*
+ * Hash index: open addressing with linear probing. The table size is a
+ * power of two and is doubled when it is more than 70% full.
+ */
+#define PROPERTY_TABLE_MIN 1024
+
+static PROPERTY** table=NULL;
+static unsigned int table_size=0;
+static unsigned int table_used=0;
+
+/*
+ * Arena for the PROPERTY structures and the name/value strings,
+ * so that loading a file does not need three mallocs per line.
+ */
+#define ARENA_BLOCK_SIZE 65536
+
+typedef struct _arena_block ARENA_BLOCK;
+struct _arena_block {
+    ARENA_BLOCK* next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+static ARENA_BLOCK* arena=NULL;
+
+static void* arena_alloc(size_t size) {
+    ARENA_BLOCK* block;
+    void* p;
+
+    size=(size+7)&~(size_t)7;
+    if(arena==NULL || arena->used+size>arena->size) {
+        size_t block_size=size>ARENA_BLOCK_SIZE?size:ARENA_BLOCK_SIZE;
+        block=malloc(sizeof(ARENA_BLOCK)+block_size);
+        if(block==NULL) {
+            fprintf(stderr,"property: out of memory\n");
+            exit(-1);
+        }
+        block->next=arena;
+        block->used=0;
+        block->size=block_size;
+        arena=block;
+    }
+    p=&arena->data[arena->used];
+    arena->used+=size;
+    return p;
+}
+
+static char* arena_strdup(const char* s,int* size) {
+    int length=strlen(s)+1;
+    char* p=arena_alloc(length);
+    memcpy(p,s,length);
+    if(size!=NULL) *size=(length+7)&~7;
+    return p;
+}
+
+// FNV-1a
+static unsigned int hash_name(const char* name) {
+    unsigned int h=2166136261u;
+    while(*name) {
+        h^=(unsigned char)*name++;
+        h*=16777619u;
+    }
+    return h;
+}
+
+static void table_insert(PROPERTY* property) {
+    unsigned int i=property->hash&(table_size-1);
+    while(table[i]!=NULL) {
+        i=(i+1)&(table_size-1);
+    }
+    table[i]=property;
+    table_used++;
+}
+
+static void table_resize(unsigned int size) {
+    PROPERTY* property;
+
+    free(table);
+    table=calloc(size,sizeof(PROPERTY*));
+    if(table==NULL) {
+        fprintf(stderr,"property: out of memory\n");
+        exit(-1);
+    }
+    table_size=size;
+    table_used=0;
+    for(property=properties;property!=NULL;property=property->next_property) {
+        table_insert(property);
+    }
+}
+
+static PROPERTY* find_property(const char* name,unsigned int hash) {
+    unsigned int i;
+    PROPERTY* property;
+
+    if(table==NULL) return NULL;
+    i=hash&(table_size-1);
+    while((property=table[i])!=NULL) {
+        if(property->hash==hash && strcmp(name,property->name)==0) {
+            return property;
+        }
+        i=(i+1)&(table_size-1);
+    }
+    return NULL;
+}
+
+static PROPERTY* add_property(const char* name,unsigned int hash,const char* value) {
+    PROPERTY* property;
+
+    if(table==NULL) {
+        table_resize(PROPERTY_TABLE_MIN);
+    } else if((table_used+1)*10>table_size*7) {
+        table_resize(table_size*2);
+    }
+    property=arena_alloc(sizeof(PROPERTY));
+    property->name=arena_strdup(name,NULL);
+    property->value=arena_strdup(value,&property->value_size);
+    property->hash=hash;
+    property->generation=generation;
+    property->dirty=1;
+    property->in_file=0;
+    // keep the order of the file
+    property->next_property=NULL;
+    if(last_property!=NULL) {
+        last_property->next_property=property;
+    } else {
+        properties=property;
+    }
+    last_property=property;
+    table_insert(property);
+    return property;
+}
+
 void clearProperties() {
 g_print("clearProperties\n");
-  if(properties!=NULL) {
-    // free all the properties
-    PROPERTY *next;
-    while(properties!=NULL) {
-      next=properties->next_property;
-      free(properties);
-      properties=next;
-    }
+  // the entries are kept (and revived by setProperty) to detect changes
+  generation++;
+}
+
+static void resetProperties() {
+  // free all the properties
+  while(arena!=NULL) {
+    ARENA_BLOCK* next=arena->next;
+    free(arena);
+    arena=next;
+  }
+  properties=NULL;
+  last_property=NULL;
+  if(table!=NULL) {
+    memset(table,0,table_size*sizeof(PROPERTY*));
   }
+  table_used=0;
+  property_file[0]='\0';
+}
+
+static void write_file(const char* filename,GString* contents) {
+    char tmp[512];
+    int fd;
+    gsize written=0;
+    ssize_t rc;
+
+    snprintf(tmp,sizeof(tmp),"%s.tmp",filename);
+    fd=open(tmp,O_WRONLY|O_CREAT|O_TRUNC,0644);
+    if(fd<0) {
+        fprintf(stderr,"can't open %s: %s\n",tmp,strerror(errno));
+        return;
+    }
+    while(written<contents->len) {
+        rc=write(fd,contents->str+written,contents->len-written);
+        if(rc<0) {
+            if(errno==EINTR) continue;
+            fprintf(stderr,"can't write %s: %s\n",tmp,strerror(errno));
+            close(fd);
+            unlink(tmp);
+            return;
+        }
+        written+=rc;
+    }
+    // the data must be on disk before the rename replaces the old file
+    if(fsync(fd)<0 || close(fd)<0) {
+        fprintf(stderr,"can't sync %s: %s\n",tmp,strerror(errno));
+        unlink(tmp);
+        return;
+    }
+    if(rename(tmp,filename)<0) {
+        fprintf(stderr,"can't rename %s: %s\n",tmp,strerror(errno));
+        unlink(tmp);
+    }
+}
+
+static gpointer property_writer_thread(gpointer data) {
+    PROPERTY_WRITE* job;
+
+    g_mutex_lock(&writer_mutex);
+    for(;;) {
+        while(g_queue_is_empty(writer_queue)) {
+            g_cond_wait(&writer_cond,&writer_mutex);
+        }
+        job=g_queue_pop_head(writer_queue);
+        writer_busy=1;
+        g_mutex_unlock(&writer_mutex);
+
+        write_file(job->filename,job->contents);
+        g_free(job->filename);
+        g_string_free(job->contents,TRUE);
+        g_free(job);
+
+        g_mutex_lock(&writer_mutex);
+        writer_busy=0;
+        if(g_queue_is_empty(writer_queue)) {
+            g_cond_broadcast(&writer_idle_cond);
+        }
+    }
+    return NULL;
+}
+
+static void queue_write(const char* filename,GString* contents) {
+    GList* l;
+    PROPERTY_WRITE* job;
+
+    g_mutex_lock(&writer_mutex);
+    if(writer_thread_id==NULL) {
+        writer_queue=g_queue_new();
+        writer_thread_id=g_thread_new("properties",property_writer_thread,NULL);
+    }
+    // a write of the same file that has not started yet is out of date
+    for(l=writer_queue->head;l!=NULL;l=l->next) {
+        job=(PROPERTY_WRITE*)l->data;
+        if(strcmp(job->filename,filename)==0) {
+            g_string_free(job->contents,TRUE);
+            job->contents=contents;
+            g_mutex_unlock(&writer_mutex);
+            return;
+        }
+    }
+    job=g_new(PROPERTY_WRITE,1);
+    job->filename=g_strdup(filename);
+    job->contents=contents;
+    g_queue_push_tail(writer_queue,job);
+    g_cond_signal(&writer_cond);
+    g_mutex_unlock(&writer_mutex);
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+* @brief Wait until all queued property files have been written
+*/
+void flushProperties() {
+    g_mutex_lock(&writer_mutex);
+    while(writer_queue!=NULL && (writer_busy || !g_queue_is_empty(writer_queue))) {
+        g_cond_wait(&writer_idle_cond,&writer_mutex);
+    }
+    g_mutex_unlock(&writer_mutex);
 }
 
 /* --------------------------------------------------------------------------*/
@@ -51,11 +321,16 @@ void loadProperties(char* filename) {
     char string[256];
     char* name;
     char* value;
-    FILE* f=fopen(filename,"r");
+    FILE* f;
     PROPERTY* property;
+    unsigned int hash;
+
+    // the file may still be in the writer queue
+    flushProperties();
+    f=fopen(filename,"r");
 
     fprintf(stderr,"loadProperties: %s\n",filename);
-    clearProperties();
+    resetProperties();
     if(f) {
         while(fgets(string,sizeof(string),f)) {
             if(string[0]!='#') {
@@ -63,13 +338,16 @@ void loadProperties(char* filename) {
                 value=strtok(NULL,"\n");
 		// Beware of "illegal" lines in corrupted files
 		if (name != NULL && value != NULL) {
-                  property=malloc(sizeof(PROPERTY));
-                  property->name=malloc(strlen(name)+1);
-                  strcpy(property->name,name);
-                  property->value=malloc(strlen(value)+1);
-                  strcpy(property->value,value);
-                  property->next_property=properties;
-                  properties=property;
+                  // if a name appears twice, the last one wins
+                  hash=hash_name(name);
+                  property=find_property(name,hash);
+                  if(property==NULL) {
+                    property=add_property(name,hash,value);
+                  } else {
+                    property->value=arena_strdup(value,&property->value_size);
+                  }
+                  property->dirty=0;
+                  property->in_file=1;
                   if(strcmp(name,"property_version")==0) {
                     version=atof(value);
                   }
@@ -77,10 +355,11 @@ void loadProperties(char* filename) {
             }
         }
         fclose(f);
+        strncpy(property_file,filename,sizeof(property_file)-1);
     }
 
     if(version!=PROPERTY_VERSION) {
-      properties=NULL;
+      resetProperties();
       fprintf(stderr,"loadProperties: version=%f expected version=%f ignoring\n",version,PROPERTY_VERSION);
     }
 }
@@ -89,29 +368,53 @@ void loadProperties(char* filename) {
 /**
 * @brief Save Properties
 *
+* Nothing is written if the file would not change. Otherwise the contents
+* are queued for the writer thread, so the caller does not wait for the disk.
+*
 * @param filename
 */
 void saveProperties(char* filename) {
     PROPERTY* property;
-    FILE* f=fopen(filename,"w+");
     char line[512];
+    int changes=0;
+    int live;
+    GString* contents;
 
-    fprintf(stderr,"saveProperties: %s\n",filename);
+    sprintf(line,"%0.2f",PROPERTY_VERSION);
+    setProperty("property_version",line);
 
-    if(!f) {
-        fprintf(stderr,"can't open %s\n",filename);
+    if(strcmp(filename,property_file)!=0) {
+        changes++;
+    }
+    for(property=properties;property!=NULL;property=property->next_property) {
+        live=property->generation==generation;
+        if(live && (property->dirty || !property->in_file)) {
+            changes++;
+        } else if(!live && property->in_file) {
+            changes++;
+        }
+    }
+    if(changes==0) {
+        fprintf(stderr,"saveProperties: %s: unchanged\n",filename);
         return;
     }
 
-    sprintf(line,"%0.2f",PROPERTY_VERSION);
-    setProperty("property_version",line);
-    property=properties;
-    while(property) {
-        sprintf(line,"%s=%s\n",property->name,property->value);
-        fwrite(line,1,strlen(line),f);
-        property=property->next_property;
+    contents=g_string_sized_new(65536);
+    for(property=properties;property!=NULL;property=property->next_property) {
+        live=property->generation==generation;
+        if(live) {
+            g_string_append(contents,property->name);
+            g_string_append_c(contents,'=');
+            g_string_append(contents,property->value);
+            g_string_append_c(contents,'\n');
+        }
+        property->in_file=live;
+        property->dirty=0;
     }
-    fclose(f);
+    strncpy(property_file,filename,sizeof(property_file)-1);
+    property_file[sizeof(property_file)-1]='\0';
+    fprintf(stderr,"saveProperties: %s: %d changes, %d bytes\n",filename,changes,(int)contents->len);
+    queue_write(filename,contents);
 }
 
 /* --------------------------------------------------------------------------*/
@@ -123,16 +426,11 @@ void saveProperties(char* filename) {
 * @return
 */
 char* getProperty(char* name) {
-    char* value=NULL;
-    PROPERTY* property=properties;
-    while(property) {
-        if(strcmp(name,property->name)==0) {
-            value=property->value;
-            break;
-        }
-        property=property->next_property;
+    PROPERTY* property=find_property(name,hash_name(name));
+    if(property==NULL || property->generation!=generation) {
+        return NULL;
     }
-    return value;
+    return property->value;
 }
 
 /* --------------------------------------------------------------------------*/
@@ -143,27 +441,23 @@ char* getProperty(char* name) {
 * @param value
 */
 void setProperty(char* name,char* value) {
-    PROPERTY* property=properties;
-    while(property) {
-        if(strcmp(name,property->name)==0) {
-            break;
-        }
-        property=property->next_property;
-    }
+    unsigned int hash=hash_name(name);
+    PROPERTY* property=find_property(name,hash);
     if(property) {
-        // just update
-        free(property->value);
-        property->value=malloc(strlen(value)+1);
-        strcpy(property->value,value);
+        // revive an entry deleted by clearProperties
+        property->generation=generation;
+        if(strcmp(property->value,value)!=0) {
+            // update, in place if the new value fits
+            int length=strlen(value)+1;
+            if(length<=property->value_size) {
+                memcpy(property->value,value,length);
+            } else {
+                property->value=arena_strdup(value,&property->value_size);
+            }
+            property->dirty=1;
+        }
     } else {
         // new property
-        property=malloc(sizeof(PROPERTY));
-        property->name=malloc(strlen(name)+1);
-        strcpy(property->name,name);
-        property->value=malloc(strlen(value)+1);
-        strcpy(property->value,value);
-        property->next_property=properties;
-        properties=property;
+        add_property(name,hash,value);
     }
 }
-
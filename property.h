@@ -27,10 +27,27 @@ typedef struct _PROPERTY PROPERTY;
 /* --------------------------------------------------------------------------*/
 /**
 * @brief Property structure
+*
+* Properties are kept in a list (in the order of the file) for saving,
+* and indexed by an open-addressing hash table on the name for lookups.
+* Names and values are allocated from an arena that is released as a
+* whole by loadProperties().
+*
+* clearProperties() only marks the entries as deleted (they no longer
+* belong to the current generation), so that rebuilding all properties
+* with unchanged values before a save does not count as a change.
+* saveProperties() does nothing if the file would not change, otherwise
+* the file is written by a background thread into a temporary file that
+* is then renamed.
 */
 struct _PROPERTY {
     char* name;
     char* value;
+    int value_size;           // bytes available at value
+    unsigned int hash;
+    unsigned int generation;  // current generation: not deleted
+    int dirty;                // value changed since the file was read/written
+    int in_file;              // contained in the file read/written last
     PROPERTY* next_property;
 };
 
@@ -39,5 +56,6 @@ extern void loadProperties(char* filename);
 extern char* getProperty(char* name);
 extern void setProperty(char* name,char* value);
 extern void saveProperties(char* filename);
+extern void flushProperties(void);
 
 #endif
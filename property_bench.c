@@ -0,0 +1,181 @@
+/*
+ * File property_bench.c
+ *
+ * Time loadProperties, a restore pass (getProperty for every name),
+ * a save pass (setProperty for every name) and saveProperties on a
+ * large props file, and compare the lookups with the linear list scan
+ * that property.c used before the hash index.
+ *
+ * usage: property_bench [-n properties] [-r repeats] [file]
+ *
+ * Without a file, a props file with n entries named like the ones
+ * of radio.c, band.c and receiver.c is generated.
+ *
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "property.h"
+
+#define BENCH_FILE "property_bench.props"
+
+typedef struct _list_property LIST_PROPERTY;
+struct _list_property {
+  char *name;
+  char *value;
+  LIST_PROPERTY *next;
+};
+
+static LIST_PROPERTY *list=NULL;
+
+static char *list_get(const char *name) {
+  LIST_PROPERTY *p;
+  for (p=list; p!=NULL; p=p->next) {
+    if (strcmp(name, p->name) == 0) return p->value;
+  }
+  return NULL;
+}
+
+static void list_set(const char *name, const char *value) {
+  LIST_PROPERTY *p;
+  for (p=list; p!=NULL; p=p->next) {
+    if (strcmp(name, p->name) == 0) break;
+  }
+  if (p != NULL) {
+    free(p->value);
+    p->value=strdup(value);
+  } else {
+    p=malloc(sizeof(LIST_PROPERTY));
+    p->name=strdup(name);
+    p->value=strdup(value);
+    p->next=list;
+    list=p;
+  }
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + 1E-9 * (double) ts.tv_nsec;
+}
+
+static void generate(const char *filename, int n) {
+  FILE *f=fopen(filename, "w");
+  int i;
+  if (f == NULL) {
+    perror(filename);
+    exit(1);
+  }
+  fprintf(f, "property_version=%0.2f\n", PROPERTY_VERSION);
+  for (i=1; i<n; i++) {
+    switch (i % 4) {
+      case 0: fprintf(f, "band.%d.stack.%d.a=%d\n", i/64, (i/4)%16, 14000000+i); break;
+      case 1: fprintf(f, "receiver.%d.filter.%d=%d\n", i%8, i, i%10); break;
+      case 2: fprintf(f, "transmitter.%d.mic_gain.%d=%0.2f\n", i%2, i, (double) i / 100.0); break;
+      case 3: fprintf(f, "gpio.encoder.%d.function.%d=%d\n", i%5, i, i%32); break;
+    }
+  }
+  fclose(f);
+}
+
+int main(int argc, char **argv) {
+  int n=5000;
+  int repeats=5;
+  int c, i, r, count=0;
+  const char *filename=BENCH_FILE;
+  char **names;
+  char **values;
+  char line[256];
+  FILE *f;
+  double t, t_load=0.0, t_restore=0.0, t_set=0.0, t_save=0.0;
+  double t_list_restore=0.0, t_list_set=0.0;
+  volatile long sink=0;
+
+  while ((c=getopt(argc, argv, "n:r:")) != -1) {
+    switch (c) {
+      case 'n': n=atoi(optarg); break;
+      case 'r': repeats=atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-n properties] [-r repeats] [file]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind < argc) {
+    filename=argv[optind];
+  } else {
+    generate(filename, n);
+  }
+
+  //
+  // the names and values the restore/save passes use
+  //
+  f=fopen(filename, "r");
+  if (f == NULL) {
+    perror(filename);
+    return 1;
+  }
+  names=malloc(sizeof(char *));
+  values=malloc(sizeof(char *));
+  while (fgets(line, sizeof(line), f)) {
+    char *name, *value;
+    if (line[0] == '#') continue;
+    name=strtok(line, "=");
+    value=strtok(NULL, "\n");
+    if (name == NULL || value == NULL) continue;
+    names=realloc(names, (count+1)*sizeof(char *));
+    values=realloc(values, (count+1)*sizeof(char *));
+    names[count]=strdup(name);
+    values[count]=strdup(value);
+    count++;
+  }
+  fclose(f);
+
+  for (r=0; r<repeats; r++) {
+    t=now();
+    loadProperties((char *) filename);
+    t_load+=now()-t;
+
+    t=now();
+    for (i=0; i<count; i++) {
+      char *v=getProperty(names[i]);
+      if (v) sink+=v[0];
+    }
+    t_restore+=now()-t;
+
+    t=now();
+    for (i=0; i<count; i++) setProperty(names[i], values[i]);
+    t_set+=now()-t;
+
+    t=now();
+    saveProperties(BENCH_FILE ".out");
+    t_save+=now()-t;
+
+    //
+    // the old linear list
+    //
+    for (i=0; i<count; i++) list_set(names[i], values[i]);
+    t=now();
+    for (i=0; i<count; i++) {
+      char *v=list_get(names[i]);
+      if (v) sink+=v[0];
+    }
+    t_list_restore+=now()-t;
+    t=now();
+    for (i=0; i<count; i++) list_set(names[i], values[i]);
+    t_list_set+=now()-t;
+  }
+  unlink(BENCH_FILE ".out");
+  if (optind >= argc) unlink(BENCH_FILE);
+
+  printf("%s: %d properties, %d repeats, times per pass in msec\n", filename, count, repeats);
+  printf("hash index : load %8.3f restore %8.3f set %8.3f save %8.3f\n",
+         1E3*t_load/repeats, 1E3*t_restore/repeats, 1E3*t_set/repeats, 1E3*t_save/repeats);
+  printf("linear list:               restore %8.3f set %8.3f\n",
+         1E3*t_list_restore/repeats, 1E3*t_list_set/repeats);
+  return 0;
+}
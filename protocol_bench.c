@@ -0,0 +1,306 @@
+/*
+ * File protocol_bench.c
+ *
+ * Headless throughput benchmark of the receive path: datagrams read from
+ * a capture are decoded by the real old_protocol.c/new_protocol.c code
+ * and fed into the receivers of receiver.c, whose DSP threads run the
+ * noise blankers, fexchange0 and the spectrum as in piHPSDR. There is no
+ * radio, no network and no display: the receivers are created without
+ * panadapter and waterfall, and the GTK main loop is never started.
+ *
+ * The capture is replayed as fast as possible. The protocol thread only
+ * waits if the DSP ring of a receiver is about to overflow, so no IQ
+ * block is dropped and the DSP threads run at full speed.
+ *
+ * usage: protocol_bench [-r receivers] [-s sample_rate] [-b buffer_size]
+ *                       [-f fft_size] [-l loops] [-n] [-N] [-d] [capture]
+ *
+ *   -n   noise blanker on        -N   noise blanker 2 on
+ *   -d   no spectrum (receiver not displaying)
+ *
+ * The capture is a pcap file of the UDP traffic from the radio, recorded
+ * by piHPSDR (PIHPSDR_CAPTURE, see capture.h) or by tcpdump/Wireshark.
+ * For the old protocol, the EP6 frames from port 1024 are used, and the
+ * number of receivers and the sample rate must be given as they were
+ * when the capture was taken. For the new protocol, the DDC packets are
+ * used and DDC n is fed into receiver n (-r limits the number of
+ * receivers, packets of other DDCs are skipped).
+ * Without a capture, ten seconds of old protocol frames with a test
+ * signal are made up.
+ *
+ * Results: packets per second, IQ samples per second (and per CPU second,
+ * which is the rate one core can sustain), and the time per stage:
+ * decode (protocol thread, including the copy into the DSP ring),
+ * NB, fexchange, spectrum and audio (DSP threads).
+ *
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <math.h>
+#include <sys/utsname.h>
+
+#include <wdsp.h>
+
+#include "discovered.h"
+#include "receiver.h"
+#include "transmitter.h"
+#include "radio.h"
+#include "main.h"
+#include "old_protocol.h"
+#include "new_protocol.h"
+#include "vfo.h"
+#include "capture.h"
+#include "bench_stubs.h"
+
+#define BENCH_PIXELS 1024
+#define METIS_PORT 1024
+#define BENCH_DDCS 7
+
+typedef struct _bench_packet {
+  unsigned char *data;
+  int length;
+  int ddc;        // -1 for a METIS frame
+} BENCH_PACKET;
+
+static BENCH_PACKET *packets=NULL;
+static int packet_count=0;
+static int packet_samples=0;   // IQ samples per receiver and packet, at most
+
+static void add_packet(unsigned char *data, int length, int ddc) {
+  if ((packet_count & 1023) == 0) {
+    packets=realloc(packets, (packet_count+1024)*sizeof(BENCH_PACKET));
+  }
+  packets[packet_count].data=data;
+  packets[packet_count].length=length;
+  packets[packet_count].ddc=ddc;
+  packet_count++;
+}
+
+//
+// Keep the datagrams that piHPSDR receives from the radio (see capture.c)
+//
+static int read_capture(const char *filename, int *ddcs) {
+  CAPTURE_PACKET *capture;
+  int count, i, ddc;
+  int old_frames=0;
+
+  capture=capture_read(filename, &count);
+  if (capture == NULL) exit(1);
+  *ddcs=0;
+  for (i=0; i<count; i++) {
+    unsigned char *data=(unsigned char *) capture[i].data;
+    int length=capture[i].length;
+    if (capture[i].port == METIS_PORT && length == 1032 && data[0] == 0xEF && data[1] == 0xFE
+        && data[2] == 0x01 && data[3] == 0x06) {
+      add_packet(data, length, -1);
+      old_frames++;
+    } else if (capture[i].port >= RX_IQ_TO_HOST_PORT_0 && capture[i].port < RX_IQ_TO_HOST_PORT_0+BENCH_DDCS) {
+      ddc=capture[i].port-RX_IQ_TO_HOST_PORT_0;
+      add_packet(data, length, ddc);
+      if (ddc+1 > *ddcs) *ddcs=ddc+1;
+    }
+  }
+  if (old_frames != 0 && old_frames != packet_count) {
+    fprintf(stderr, "%s: the capture contains packets of both protocols\n", filename);
+    exit(1);
+  }
+  return old_frames != 0 ? ORIGINAL_PROTOCOL : NEW_PROTOCOL;
+}
+
+//
+// Ten seconds of METIS frames (two USB frames each) with a test signal:
+// a carrier 3 kHz above the centre, noise and a pulse every 10 msec
+// for the noise blankers.
+//
+static void make_capture(int rx, int rate) {
+  int stride=rx*6+2;
+  int rows=(512-8)/stride;
+  int frames=rate*10/(2*rows);
+  unsigned char *data=calloc(frames, 1032);
+  unsigned int seed=1;
+  long n=0;
+  int i, f, r, k, sample;
+  double phase=0.0;
+  double level;
+
+  for (f=0; f<frames; f++) {
+    unsigned char *p=data+1032*f;
+    p[0]=0xEF; p[1]=0xFE; p[2]=0x01; p[3]=0x06;
+    p[4]=(f>>24)&0xFF; p[5]=(f>>16)&0xFF; p[6]=(f>>8)&0xFF; p[7]=f&0xFF;
+    for (k=0; k<2; k++) {
+      unsigned char *b=p+8+512*k;
+      b[0]=b[1]=b[2]=0x7F;   // SYNC, C0..C4 are zero
+      for (r=0; r<rows; r++, n++) {
+        unsigned char *s=b+8+r*stride;
+        level=(n % (rate/100)) < 4 ? 0.5 : 0.001;
+        for (i=0; i<rx; i++) {
+          seed=seed*1103515245+12345;
+          sample=(int)(8388607.0*(level*cos(phase)+0.0001*((double)(seed>>16)/32768.0-1.0)));
+          s[0]=(sample>>16)&0xFF; s[1]=(sample>>8)&0xFF; s[2]=sample&0xFF;
+          sample=(int)(8388607.0*(level*sin(phase)));
+          s[3]=(sample>>16)&0xFF; s[4]=(sample>>8)&0xFF; s[5]=sample&0xFF;
+          s+=6;
+        }
+        phase+=2.0*M_PI*3000.0/(double)rate;
+        if (phase > 2.0*M_PI) phase-=2.0*M_PI;
+      }
+    }
+    add_packet(p, 1032, -1);
+  }
+}
+
+//
+// Wait until a packet can be fed into receiver rx without
+// the DSP ring overflowing
+//
+static void wait_for_ring(RECEIVER *rx, int blocks) {
+  int fill;
+  for (;;) {
+    fill=g_atomic_int_get(&rx->iq_ring_inptr)-g_atomic_int_get(&rx->iq_ring_outptr);
+    if (fill < 0) fill+=rx->dsp_ring_depth;
+    if (rx->dsp_ring_depth-1-fill > blocks) return;
+    sched_yield();
+  }
+}
+
+static void wait_for_dsp(RECEIVER *rx) {
+  while (g_atomic_int_get(&rx->iq_ring_inptr) != g_atomic_int_get(&rx->iq_ring_outptr)) {
+    sched_yield();
+  }
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [-r receivers] [-s sample_rate] [-b buffer_size] [-f fft_size]"
+                  " [-l loops] [-n] [-N] [-d] [capture]\n", name);
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  const char *filename=NULL;
+  int rate=48000;
+  int loops=1;
+  int nb=0, nb2=0, spectrum=1;
+  int c, i, l, n, blocks;
+  long replayed=0;
+  gint64 dsp_blocks=0, nb_time=0, fexchange_time=0, spectrum_time=0, audio_time=0;
+  int overruns=0, errors=0;
+  double t, t0, decode=0.0, elapsed, cpu;
+  double samples;
+  DISCOVERED bench_radio;
+
+  receivers=1;
+  while ((c=getopt(argc, argv, "r:s:b:f:l:nNd")) != -1) {
+    switch (c) {
+      case 'r': receivers=atoi(optarg); break;
+      case 's': rate=atoi(optarg); break;
+      case 'b': buffer_size=atoi(optarg); break;
+      case 'f': fft_size=atoi(optarg); break;
+      case 'l': loops=atoi(optarg); break;
+      case 'n': nb=1; break;
+      case 'N': nb2=1; break;
+      case 'd': spectrum=0; break;
+      default: usage(argv[0]);
+    }
+  }
+  if (optind < argc) filename=argv[optind];
+  if (rate < 48000 || rate % 48000 != 0 || buffer_size < 64 || loops < 1) usage(argv[0]);
+
+  uname(&unameData);
+  memset(&bench_radio, 0, sizeof(bench_radio));
+  radio=&bench_radio;
+
+  if (filename != NULL) {
+    int ddcs;
+    protocol=read_capture(filename, &ddcs);
+    if (protocol == NEW_PROTOCOL && ddcs < receivers) receivers=ddcs;
+  } else {
+    protocol=ORIGINAL_PROTOCOL;
+    make_capture(receivers, rate);
+  }
+  if (packet_count == 0 || receivers < 1 || receivers > MAX_VFOS) {
+    fprintf(stderr, "nothing to replay (%d packets, %d receivers, at most %d)\n", packet_count, receivers, MAX_VFOS);
+    return 1;
+  }
+  if (protocol == ORIGINAL_PROTOCOL) {
+    device=DEVICE_HERMES;
+    packet_samples=2*((512-8)/(receivers*6+2));
+  } else {
+    device=NEW_DEVICE_ORION2;
+    packet_samples=238;
+  }
+  radio->protocol=protocol;
+  radio->device=device;
+
+  receiver_blocking_dsp=1;
+  receiver_stage_timing=1;
+  for (i=0; i<receivers; i++) {
+    receiver[i]=create_receiver(i, buffer_size, fft_size, BENCH_PIXELS, updates_per_second, BENCH_PIXELS, 0);
+    if (rate != receiver[i]->sample_rate) receiver_change_sample_rate(receiver[i], rate);
+    receiver[i]->nb=nb;
+    receiver[i]->nb2=nb2;
+    SetEXTANBRun(i, nb);
+    SetEXTNOBRun(i, nb2);
+    receiver[i]->displaying=spectrum;
+  }
+  blocks=packet_samples/buffer_size+1;
+
+  t0=bench_now();
+  cpu=bench_cpu_time();
+  for (l=0; l<loops; l++) {
+    for (n=0; n<packet_count; n++) {
+      BENCH_PACKET *packet=&packets[n];
+      if (packet->ddc >= receivers) continue;
+      if (packet->ddc < 0) {
+        for (i=0; i<receivers; i++) wait_for_ring(receiver[i], blocks);
+        t=bench_now();
+        old_protocol_replay_packet(packet->data, packet->length);
+      } else {
+        wait_for_ring(receiver[packet->ddc], blocks);
+        t=bench_now();
+        new_protocol_replay_iq(packet->data, packet->length, receiver[packet->ddc]);
+      }
+      decode+=bench_now()-t;
+      replayed++;
+    }
+  }
+  for (i=0; i<receivers; i++) wait_for_dsp(receiver[i]);
+  elapsed=bench_now()-t0;
+  cpu=bench_cpu_time()-cpu;
+
+  for (i=0; i<receivers; i++) {
+    RECEIVER *rx=receiver[i];
+    g_mutex_lock(&rx->mutex);
+    dsp_blocks+=rx->dsp_blocks;
+    nb_time+=rx->nb_time;
+    fexchange_time+=rx->fexchange_time;
+    spectrum_time+=rx->spectrum_time;
+    audio_time+=rx->audio_time;
+    overruns+=rx->dsp_ring_overruns;
+    errors+=rx->fexchange_errors;
+    g_mutex_unlock(&rx->mutex);
+  }
+  samples=(double) dsp_blocks*buffer_size;
+  if (dsp_blocks == 0) dsp_blocks=1;
+
+  printf("\n%s: %s protocol, %d packets, %d loops\n",
+         filename != NULL ? filename : "test signal", protocol == ORIGINAL_PROTOCOL ? "old" : "new",
+         packet_count, loops);
+  printf("%d receivers at %d Hz, buffer %d, fft %d, nb %s, nb2 %s, spectrum %s, %ld online cores\n",
+         receivers, rate, buffer_size, fft_size, nb ? "on" : "off", nb2 ? "on" : "off",
+         spectrum ? "on" : "off", sysconf(_SC_NPROCESSORS_ONLN));
+  printf("replayed %ld packets in %0.3f sec: %0.0f packets/sec\n", replayed, elapsed, replayed/elapsed);
+  printf("IQ samples: %0.0f/sec (%0.1f x real time per receiver), %0.0f/sec per core (%0.3f CPU sec)\n",
+         samples/elapsed, samples/elapsed/receivers/rate, samples/cpu, cpu);
+  printf("decode    %8.2f usec/packet\n", 1E6*decode/(replayed ? replayed : 1));
+  printf("nb        %8.2f usec/block\n", 1E-3*nb_time/dsp_blocks);
+  printf("fexchange %8.2f usec/block\n", 1E-3*fexchange_time/dsp_blocks);
+  printf("spectrum  %8.2f usec/block\n", 1E-3*spectrum_time/dsp_blocks);
+  printf("audio     %8.2f usec/block\n", 1E-3*audio_time/dsp_blocks);
+  printf("DSP ring overruns %d, fexchange errors %d, sequence errors %d\n", overruns, errors, sequence_errors);
+  return overruns != 0;
+}
@@ -50,6 +50,9 @@
 #include "new_menu.h"
 #include "new_protocol.h"
 #include "old_protocol.h"
+#include "net_rx.h"
+#include "capture.h"
+#include "slice.h"
 #include "store.h"
 #ifdef SOAPYSDR
 #include "soapy_protocol.h"
@@ -251,6 +254,7 @@ int cw_breakin=1; // 0=disabled 1=enabled
 int cw_is_on_vfo_freq=1;   // 1= signal on VFO freq, 0= signal offset by side tone
 
 int vfo_encoder_divisor=15;
+int encoder_acceleration=1;  // max. steps per detent when turned fast, 1=off
 
 int protocol;
 int device;
@@ -363,6 +367,11 @@ gint sequence_errors=0;
 gint rx_height;
 
 void radio_stop() {
+  //
+  // the DSP threads must not run into the channels being closed
+  //
+  receiver_stop_dsp(receiver[0]);
+  receiver_stop_dsp(receiver[1]);
   if(can_transmit) {
 g_print("radio_stop: TX: CloseChannel: %d\n",transmitter->id);
     CloseChannel(transmitter->id);
@@ -373,6 +382,9 @@ g_print("radio_stop: RX0: CloseChannel: %d\n",receiver[0]->id);
   set_displaying(receiver[1],0);
 g_print("radio_stop: RX1: CloseChannel: %d\n",receiver[1]->id);
   CloseChannel(receiver[1]->id);
+  slices_destroy();
+  capture_stop();
+  action_queue_report();
 }
 
 void reconfigure_radio() {
@@ -623,6 +635,18 @@ if(!radio_is_remote) {
 #ifdef CLIENT_SERVER
   if(!radio_is_remote) {
 #endif
+  capture_start();
+  //
+  // The slices must be ready before the first IQ samples arrive
+  //
+  switch(protocol) {
+    case ORIGINAL_PROTOCOL:
+      slices_create(receiver[0]->sample_rate,buffer_size);
+      break;
+    case NEW_PROTOCOL:
+      slices_create(slice_channelizer ? receiver[0]->sample_rate : 48000,buffer_size);
+      break;
+  }
   switch(protocol) {
     case ORIGINAL_PROTOCOL:
       old_protocol_init(0,display_width,receiver[0]->sample_rate);
@@ -1303,6 +1327,14 @@ void start_radio() {
    if (RECEIVERS < 2 || n_adc < 2) {
      diversity_enabled=0;
    }
+//
+// Sanity Check #3: no more slices than free DDCs, and in the new
+// protocol, the DDCs of the slices are part of the stream
+//
+  if (slices > slices_max()) slices=slices_max();
+  if (protocol == NEW_PROTOCOL && slice_ddcs() > 0) {
+    MAX_DDC=max(MAX_DDC,slice_first_ddc()+slice_ddcs());
+  }
 
   radio_change_region(region);
 
@@ -1467,6 +1499,7 @@ void radio_change_sample_rate(int rate) {
 #ifdef PURESIGNAL
         receiver_change_sample_rate(receiver[PS_RX_FEEDBACK],rate);
 #endif
+        slices_change_sample_rate(rate);
         old_protocol_set_mic_sample_rate(rate);
         old_protocol_run();
         tx_set_ps_sample_rate(transmitter,rate);
@@ -2085,6 +2118,14 @@ g_print("radioRestoreState: %s\n",property_path);
     if(value) buffer_size=atoi(value);
     value=getProperty("fft_size");
     if(value) fft_size=atoi(value);
+    value=getProperty("iq_queue_depth");
+    if(value) iq_queue_depth=atoi(value);
+    value=getProperty("net_rx_batch");
+    if(value) net_rx_batch=atoi(value);
+    value=getProperty("net_rx_sockbuf");
+    if(value) net_rx_sockbuf=atoi(value);
+    value=getProperty("net_rx_report");
+    if(value) net_rx_report=atoi(value);
     value=getProperty("atlas_penelope");
     if(value) atlas_penelope=atoi(value);
     value=getProperty("atlas_clock_source_10mhz");
@@ -2172,6 +2213,8 @@ g_print("radioRestoreState: %s\n",property_path);
     if(value) cw_breakin=atoi(value);
     value=getProperty("vfo_encoder_divisor");
     if(value) vfo_encoder_divisor=atoi(value);
+    value=getProperty("encoder_acceleration");
+    if(value) encoder_acceleration=atoi(value);
     value=getProperty("OCtune");
     if(value) OCtune=atoi(value);
     value=getProperty("OCfull_tune_time");
@@ -2268,6 +2311,10 @@ g_print("radioRestoreState: %s\n",property_path);
     if(value) rigctl_enable=atoi(value);
     value=getProperty("rigctl_port_base");
     if(value) rigctl_port_base=atoi(value);
+    value=getProperty("rigctl_max_clients");
+    if(value) rigctl_max_clients=atoi(value);
+    if(rigctl_max_clients<1) rigctl_max_clients=1;
+    if(rigctl_max_clients>MAX_CLIENTS) rigctl_max_clients=MAX_CLIENTS;
     value=getProperty("rigctl_serial_enable");
     if (value) serial_enable=atoi(value);
     value=getProperty("rigctl_serial_baud_rate");
@@ -2374,6 +2421,8 @@ g_print("radioRestoreState: %s\n",property_path);
     midi_restore_state();
 #endif
 
+    slices_restore_state();
+
     value=getProperty("radio.display_sequence_errors");
     if(value!=NULL) display_sequence_errors=atoi(value);
 
@@ -2430,6 +2479,8 @@ g_print("radioSaveState: %s\n",property_path);
     transmitter_save_state(transmitter);
   }
 
+  slices_save_state();
+
 #ifdef CLIENT_SERVER
   if(!radio_is_remote) {
 #endif
@@ -2453,6 +2504,14 @@ g_print("radioSaveState: %s\n",property_path);
     setProperty("buffer_size",value);
     sprintf(value,"%d",fft_size);
     setProperty("fft_size",value);
+    sprintf(value,"%d",iq_queue_depth);
+    setProperty("iq_queue_depth",value);
+    sprintf(value,"%d",net_rx_batch);
+    setProperty("net_rx_batch",value);
+    sprintf(value,"%d",net_rx_sockbuf);
+    setProperty("net_rx_sockbuf",value);
+    sprintf(value,"%d",net_rx_report);
+    setProperty("net_rx_report",value);
     sprintf(value,"%d",atlas_penelope);
     setProperty("atlas_penelope",value);
     sprintf(value,"%d",atlas_clock_source_10mhz);
@@ -2539,6 +2598,8 @@ g_print("radioSaveState: %s\n",property_path);
     setProperty("cw_breakin",value);
     sprintf(value,"%d",vfo_encoder_divisor);
     setProperty("vfo_encoder_divisor",value);
+    sprintf(value,"%d",encoder_acceleration);
+    setProperty("encoder_acceleration",value);
     sprintf(value,"%d",OCtune);
     setProperty("OCtune",value);
     sprintf(value,"%d",OCfull_tune_time);
@@ -2728,6 +2789,8 @@ g_print("radioSaveState: %s\n",property_path);
     setProperty("rigctl_enable",value);
     sprintf(value,"%d",rigctl_port_base);
     setProperty("rigctl_port_base",value);
+    sprintf(value,"%d",rigctl_max_clients);
+    setProperty("rigctl_max_clients",value);
     sprintf(value,"%d",serial_enable);
     setProperty("rigctl_serial_enable",value);
     sprintf(value,"%d",serial_baud_rate);
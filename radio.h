@@ -221,6 +221,7 @@ extern int cw_breakin;
 extern int cw_is_on_vfo_freq;
 
 extern int vfo_encoder_divisor;
+extern int encoder_acceleration;
 
 extern int protocol;
 extern int device;
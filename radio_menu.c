@@ -178,6 +178,10 @@ static void vfo_divisor_value_changed_cb(GtkWidget *widget, gpointer data) {
   vfo_encoder_divisor=gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(widget));
 }
 
+static void encoder_acceleration_value_changed_cb(GtkWidget *widget, gpointer data) {
+  encoder_acceleration=gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(widget));
+}
+
 #ifdef GPIO
 static void gpio_settle_value_changed_cb(GtkWidget *widget, gpointer data) {
   settle_time=gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(widget));
@@ -683,6 +687,17 @@ void radio_menu(GtkWidget *parent) {
   gtk_grid_attach(GTK_GRID(grid),vfo_divisor,col,row,1,1);
   g_signal_connect(vfo_divisor,"value_changed",G_CALLBACK(vfo_divisor_value_changed_cb),NULL);
   row++;
+
+  GtkWidget *acceleration_label=gtk_label_new(NULL);
+  gtk_label_set_markup(GTK_LABEL(acceleration_label), "<b>Encoder Acceleration:</b>");
+  gtk_grid_attach(GTK_GRID(grid),acceleration_label,col,row,1,1);
+  row++;
+
+  GtkWidget *acceleration=gtk_spin_button_new_with_range(1.0,10.0,1.0);
+  gtk_spin_button_set_value(GTK_SPIN_BUTTON(acceleration),(double)encoder_acceleration);
+  gtk_grid_attach(GTK_GRID(grid),acceleration,col,row,1,1);
+  g_signal_connect(acceleration,"value_changed",G_CALLBACK(encoder_acceleration_value_changed_cb),NULL);
+  row++;
 #endif
    
   if(row>temp_row) temp_row=row;
@@ -21,6 +21,13 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <time.h>
+#ifdef __APPLE__
+#include "MacOS.h"  // emulate clock_gettime on old MacOS systems
+#endif
 
 #include <wdsp.h>
 
@@ -43,6 +50,7 @@
 #include "rx_panadapter.h"
 #include "zoompan.h"
 #include "sliders.h"
+#include "slice.h"
 #include "waterfall.h"
 #include "new_protocol.h"
 #include "old_protocol.h"
@@ -51,6 +59,7 @@
 #endif
 #include "ext.h"
 #include "new_menu.h"
+#include "trace.h"
 #ifdef CLIENT_SERVER
 #include "client_server.h"
 #endif
@@ -59,6 +68,11 @@
 #define min(x,y) (x<y?x:y)
 #define max(x,y) (x<y?y:x)
 
+#define DSP_RING_DEPTH_MAX 64   // blocks, upper limit for receiver.N.dsp_ring_depth
+
+int receiver_stage_timing=0;
+int receiver_blocking_dsp=0;
+
 static gint last_x;
 static gboolean has_moved=FALSE;
 static gboolean pressed=FALSE;
@@ -67,6 +81,8 @@ static gboolean making_active=FALSE;
 static int waterfall_samples=0;
 static int waterfall_resample=6;
 
+static gpointer dsp_thread(gpointer data);
+
 void receiver_weak_notify(gpointer data,GObject  *obj) {
   RECEIVER *rx=(RECEIVER *)data;
   g_print("%s: id=%d obj=%p\n",__FUNCTION__,rx->id, obj);
@@ -271,6 +287,9 @@ void receiver_save_state(RECEIVER *rx) {
     sprintf(name,"receiver.%d.waterfall_automatic",rx->id);
     sprintf(value,"%d",rx->waterfall_automatic);
     setProperty(name,value);
+    sprintf(name,"receiver.%d.waterfall_palette",rx->id);
+    sprintf(value,"%d",rx->waterfall_palette);
+    setProperty(name,value);
   
     sprintf(name,"receiver.%d.alex_attenuation",rx->id);
     sprintf(value,"%d",rx->alex_attenuation);
@@ -337,6 +356,9 @@ void receiver_save_state(RECEIVER *rx) {
     sprintf(name,"receiver.%d.low_latency",rx->id);
     sprintf(value,"%d",rx->low_latency);
     setProperty(name,value);
+    sprintf(name,"receiver.%d.dsp_ring_depth",rx->id);
+    sprintf(value,"%d",rx->dsp_ring_depth);
+    setProperty(name,value);
   
     sprintf(name,"receiver.%d.deviation",rx->id);
     sprintf(value,"%d",rx->deviation);
@@ -469,6 +491,9 @@ g_print("%s: id=%d\n",__FUNCTION__,rx->id);
     sprintf(name,"receiver.%d.waterfall_automatic",rx->id);
     value=getProperty(name);
     if(value) rx->waterfall_automatic=atoi(value);
+    sprintf(name,"receiver.%d.waterfall_palette",rx->id);
+    value=getProperty(name);
+    if(value) rx->waterfall_palette=atoi(value);
 
     sprintf(name,"receiver.%d.alex_attenuation",rx->id);
     value=getProperty(name);
@@ -535,6 +560,12 @@ g_print("%s: id=%d\n",__FUNCTION__,rx->id);
     sprintf(name,"receiver.%d.low_latency",rx->id);
     value=getProperty(name);
     if(value) rx->low_latency=atoi(value);
+    sprintf(name,"receiver.%d.dsp_ring_depth",rx->id);
+    value=getProperty(name);
+    if(value) rx->dsp_ring_depth=atoi(value);
+    // need at least one block in processing and one being filled
+    if(rx->dsp_ring_depth<2) rx->dsp_ring_depth=2;
+    if(rx->dsp_ring_depth>DSP_RING_DEPTH_MAX) rx->dsp_ring_depth=DSP_RING_DEPTH_MAX;
 
     sprintf(name,"receiver.%d.deviation",rx->id);
     value=getProperty(name);
@@ -919,7 +950,15 @@ g_print("%s: id=%d buffer_size=%d\n",__FUNCTION__,id,buffer_size);
   g_mutex_init(&rx->display_mutex);
 
   // allocate buffers
+  // (PS feedback samples are processed by the TX engine, so no DSP thread here)
   rx->iq_input_buffer=g_new(double,2*rx->buffer_size);
+  rx->iq_ring=NULL;
+  rx->dsp_thread_id=NULL;
+  rx->dsp_stop=0;
+  rx->dsp_ring_depth=0;
+  rx->dsp_ring_overruns=0;
+  rx->dsp_ring_max_fill=0;
+  rx->dsp_blocks=0;
   //rx->audio_buffer=NULL;
   rx->audio_sequence=0L;
   rx->pixel_samples=g_new(float,rx->pixels);
@@ -1071,6 +1110,7 @@ g_print("%s: id=%d sample_rate=%d\n",__FUNCTION__,rx->id, rx->sample_rate);
   rx->waterfall_high=-40;
   rx->waterfall_low=-140;
   rx->waterfall_automatic=1;
+  rx->waterfall_palette=WATERFALL_PALETTE_COLOUR;
 
   rx->volume=0.1;
 
@@ -1125,10 +1165,23 @@ g_print("%s: id=%d sample_rate=%d\n",__FUNCTION__,rx->id, rx->sample_rate);
   rx->zoom=1;
   rx->pan=0;
 
+  rx->dsp_ring_depth=8;
+  rx->dsp_blocks=0;
+  rx->nb_time=0;
+  rx->fexchange_time=0;
+  rx->spectrum_time=0;
+  rx->audio_time=0;
+
   receiver_restore_state(rx);
 
   // allocate buffers
-  rx->iq_input_buffer=g_new(double,2*rx->buffer_size);
+  // the IQ input buffer is the block of the DSP ring buffer currently being filled
+  rx->iq_ring=g_new(double,2*rx->buffer_size*rx->dsp_ring_depth);
+  rx->iq_ring_inptr=0;
+  rx->iq_ring_outptr=0;
+  rx->dsp_ring_overruns=0;
+  rx->dsp_ring_max_fill=0;
+  rx->iq_input_buffer=rx->iq_ring;
   rx->audio_buffer_size=480;
   rx->audio_sequence=0L;
   rx->pixels=pixels*rx->zoom;
@@ -1162,7 +1215,7 @@ g_print("%s: OpenChannel id=%d buffer_size=%d fft_size=%d sample_rate=%d\n",
               48000, // output rate
               0, // receive
               1, // run
-              0.010, 0.025, 0.0, 0.010, 0);
+              0.010, 0.025, 0.0, 0.010, receiver_blocking_dsp);
 
 //
 // It has been reported that the piHPSDR noise blankers do not function
@@ -1231,7 +1284,13 @@ g_print("%s: OpenChannel id=%d buffer_size=%d fft_size=%d sample_rate=%d\n",
    
   calculate_display_average(rx);
 
-  create_visual(rx);
+  if(rx->height>0) {
+    create_visual(rx);
+  } else {
+    rx->panel=NULL;
+    rx->panadapter=NULL;
+    rx->waterfall=NULL;
+  }
 
 g_print("%s: rx=%p id=%d local_audio=%d\n",__FUNCTION__,rx,rx->id,rx->local_audio);
   if(rx->local_audio) {
@@ -1245,6 +1304,26 @@ g_print("%s: rx=%p id=%d local_audio=%d\n",__FUNCTION__,rx,rx->id,rx->local_audi
 
   rx->txrxcount=0;
   rx->txrxmax=0;
+
+#ifdef __APPLE__
+  char sname[12];
+  sprintf(sname,"RXDSP%03d", rx->id);
+  sem_unlink(sname);
+  rx->dsp_sem=sem_open(sname, O_CREAT | O_EXCL, 0700, 0);
+  if (rx->dsp_sem == SEM_FAILED) {
+    g_print("SEM=%s, ",sname);
+    perror("RXDSPSemaphore");
+  }
+#else
+  sem_init(&rx->dsp_sem, 0, 0);
+#endif
+  rx->dsp_stop=0;
+  rx->dsp_thread_id=g_thread_new("rx dsp", dsp_thread, rx);
+  if( ! rx->dsp_thread_id ) {
+    g_print("g_thread_new failed on dsp_thread for rx=%d\n",rx->id);
+    exit( -1 );
+  }
+g_print("%s: id=%d dsp_thread: id=%p ring_depth=%d\n",__FUNCTION__,rx->id,rx->dsp_thread_id,rx->dsp_ring_depth);
   return rx;
 }
 
@@ -1479,35 +1558,150 @@ static void process_rx_buffer(RECEIVER *rx) {
   }
 }
 
-void full_rx_buffer(RECEIVER *rx) {
+static gint64 stage_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec*1000000000LL+(gint64)ts.tv_nsec;
+}
+
+static void full_rx_buffer(RECEIVER *rx, gdouble *iq) {
   int error;
+  gint64 t0=0, t1=0, t2=0, t3=0;
 
   //g_print("%s: rx=%p\n",__FUNCTION__,rx);
   g_mutex_lock(&rx->mutex);
 
+  if(receiver_stage_timing) t0=stage_time();
+
   // noise blanker works on original IQ samples
   if(rx->nb) {
-     xanbEXT (rx->id, rx->iq_input_buffer, rx->iq_input_buffer);
+     xanbEXT (rx->id, iq, iq);
   }
   if(rx->nb2) {
-     xnobEXT (rx->id, rx->iq_input_buffer, rx->iq_input_buffer);
+     xnobEXT (rx->id, iq, iq);
+  }
+
+  // the slices are split from the first receiver (after the noise blankers)
+  if(rx->id==0) {
+    slices_channelize(iq, rx->buffer_size, rx->sample_rate, slice_source_frequency());
   }
 
-  fexchange0(rx->id, rx->iq_input_buffer, rx->audio_output_buffer, &error);
+  if(receiver_stage_timing) t1=stage_time();
+
+  fexchange0(rx->id, iq, rx->audio_output_buffer, &error);
   if(error!=0) {
     rx->fexchange_errors++;
   }
+  TRACE_EVENT(TRACE_RX_BLOCK_END, rx->id, error);
+
+  if(receiver_stage_timing) t2=stage_time();
 
   if(rx->displaying) {
     g_mutex_lock(&rx->display_mutex);
-    Spectrum0(1, rx->id, 0, 0, rx->iq_input_buffer);
+    Spectrum0(1, rx->id, 0, 0, iq);
     g_mutex_unlock(&rx->display_mutex);
   }
 
+  if(receiver_stage_timing) t3=stage_time();
+
   process_rx_buffer(rx);
+
+  if(receiver_stage_timing) {
+    rx->nb_time+=t1-t0;
+    rx->fexchange_time+=t2-t1;
+    rx->spectrum_time+=t3-t2;
+    rx->audio_time+=stage_time()-t3;
+  }
+  rx->dsp_blocks++;
   g_mutex_unlock(&rx->mutex);
 }
 
+//
+// The DSP thread processes all blocks that the protocol thread
+// has put into the ring buffer, then waits for the next one.
+//
+static gpointer dsp_thread(gpointer data) {
+  RECEIVER *rx=(RECEIVER *)data;
+  int outptr;
+
+  g_print("%s: rx=%d\n",__FUNCTION__,rx->id);
+  while(1) {
+#ifdef __APPLE__
+    sem_wait(rx->dsp_sem);
+#else
+    sem_wait(&rx->dsp_sem);
+#endif
+    if(g_atomic_int_get(&rx->dsp_stop)) break;
+    outptr=g_atomic_int_get(&rx->iq_ring_outptr);
+    while (outptr != g_atomic_int_get(&rx->iq_ring_inptr)) {
+      TRACE_EVENT(TRACE_RX_BLOCK_START, rx->id, outptr);
+      full_rx_buffer(rx, rx->iq_ring+2*rx->buffer_size*outptr);
+      outptr++;
+      if (outptr >= rx->dsp_ring_depth) outptr=0;
+      g_atomic_int_set(&rx->iq_ring_outptr,outptr);
+    }
+  }
+  return NULL;
+}
+
+//
+// Stop and join the DSP thread, and free its ring buffer. The protocol
+// must have been stopped, no more blocks arrive. Called from radio_stop
+// before the receivers are re-created.
+//
+void receiver_stop_dsp(RECEIVER *rx) {
+  if(rx==NULL || rx->dsp_thread_id==NULL) return;
+  g_atomic_int_set(&rx->dsp_stop,1);
+#ifdef __APPLE__
+  sem_post(rx->dsp_sem);
+#else
+  sem_post(&rx->dsp_sem);
+#endif
+  g_thread_join(rx->dsp_thread_id);
+  rx->dsp_thread_id=NULL;
+#ifdef __APPLE__
+  sem_close(rx->dsp_sem);
+#else
+  sem_destroy(&rx->dsp_sem);
+#endif
+  g_mutex_lock(&rx->mutex);
+  g_free(rx->iq_ring);
+  rx->iq_ring=NULL;
+  rx->iq_input_buffer=NULL;
+  g_mutex_unlock(&rx->mutex);
+}
+
+//
+// Called from the protocol thread when the block being filled is complete.
+// It is handed over to the DSP thread and the next block of the ring is
+// used for further samples. If the ring is full, the DSP thread cannot keep
+// up: the block is dropped (that is, it will be over-written) and counted
+// as an overrun, but the protocol thread never waits.
+//
+static void queue_rx_buffer(RECEIVER *rx) {
+  int inptr=g_atomic_int_get(&rx->iq_ring_inptr);
+  int outptr=g_atomic_int_get(&rx->iq_ring_outptr);
+  int next=inptr+1;
+  int fill;
+
+  if (next >= rx->dsp_ring_depth) next=0;
+  if (next == outptr) {
+    rx->dsp_ring_overruns++;
+    TRACE_EVENT(TRACE_RX_OVERRUN, rx->id, rx->dsp_ring_overruns);
+    return;
+  }
+  fill=next-outptr;
+  if (fill < 0) fill += rx->dsp_ring_depth;
+  if (fill > rx->dsp_ring_max_fill) rx->dsp_ring_max_fill=fill;
+  rx->iq_input_buffer=rx->iq_ring+2*rx->buffer_size*next;
+  g_atomic_int_set(&rx->iq_ring_inptr,next);
+#ifdef __APPLE__
+  sem_post(rx->dsp_sem);
+#else
+  sem_post(&rx->dsp_sem);
+#endif
+}
+
 static int rx_buffer_seen=0;
 static int tx_buffer_seen=0;
 
@@ -1534,11 +1728,43 @@ void add_iq_samples(RECEIVER *rx, double i_sample,double q_sample) {
   rx->iq_input_buffer[(rx->samples*2)+1]=q_sample;
   rx->samples=rx->samples+1;
   if(rx->samples>=rx->buffer_size) {
-    full_rx_buffer(rx);
+    queue_rx_buffer(rx);
     rx->samples=0;
   }
 }
 
+//
+// Same as add_iq_samples, but for n (interleaved) IQ samples at once,
+// as obtained from a protocol decoder that converts whole frames.
+// The samples are copied in chunks into the IQ input buffer.
+//
+void add_iq_samples_block(RECEIVER *rx, const double *iq, int n) {
+  int count;
+  guint silence;
+
+  while (n > 0) {
+    count=rx->buffer_size-rx->samples;
+    if (count > n) count=n;
+    memcpy(rx->iq_input_buffer+2*rx->samples, iq, 2*count*sizeof(double));
+    if (rx->txrxcount < rx->txrxmax) {
+      //
+      // "silence" the first samples after a TX/RX transition
+      //
+      silence=rx->txrxmax-rx->txrxcount;
+      if (silence > (guint)count) silence=count;
+      memset(rx->iq_input_buffer+2*rx->samples, 0, 2*silence*sizeof(double));
+      rx->txrxcount+=silence;
+    }
+    rx->samples+=count;
+    iq+=2*count;
+    n-=count;
+    if(rx->samples>=rx->buffer_size) {
+      queue_rx_buffer(rx);
+      rx->samples=0;
+    }
+  }
+}
+
 //
 // Note that we sum the second channel onto the first one.
 //
@@ -1558,7 +1784,7 @@ void add_div_iq_samples(RECEIVER *rx, double i0, double q0, double i1, double q1
   rx->iq_input_buffer[(rx->samples*2)+1]=q_sample;
   rx->samples=rx->samples+1;
   if(rx->samples>=rx->buffer_size) {
-    full_rx_buffer(rx);
+    queue_rx_buffer(rx);
     rx->samples=0;
   }
 }
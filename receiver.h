@@ -20,6 +20,7 @@
 #define _RECEIVER_H
 
 #include <gtk/gtk.h>
+#include <semaphore.h>
 #ifdef PORTAUDIO
 #include "portaudio.h"
 #endif
@@ -114,8 +115,19 @@ typedef struct _receiver {
   gint waterfall_low;
   gint waterfall_high;
   gint waterfall_automatic;
+  gint waterfall_palette;
   cairo_surface_t *panadapter_surface;
-  GdkPixbuf *pixbuf;
+  //
+  // The waterfall image is a ring of rows: waterfall_head is the row
+  // containing the newest line, which is displayed on top.
+  // Horizontal shifts (frequency/pan changes) are not applied to the
+  // pixels: waterfall_shift accumulates them, and each row remembers
+  // the value it was drawn with in waterfall_row_shift.
+  //
+  cairo_surface_t *waterfall_surface;
+  gint waterfall_head;
+  gint waterfall_shift;
+  gint *waterfall_row_shift;
   gint local_audio;
   gint mute_when_not_active;
   gint audio_device;
@@ -174,8 +186,46 @@ typedef struct _receiver {
   //
   guint txrxcount;
   guint txrxmax;
+
+  //
+  // WDSP processing (noise blankers, fexchange0, spectrum, audio) is done
+  // in a DSP thread for each receiver. The protocol thread fills blocks
+  // of buffer_size IQ samples into a ring buffer (single producer,
+  // single consumer), such that a slow DSP cannot stall the network.
+  //
+  GThread *dsp_thread_id;
+  volatile gint dsp_stop;          // set by receiver_stop_dsp
+  gdouble *iq_ring;                // dsp_ring_depth blocks of IQ samples
+  gint dsp_ring_depth;
+  volatile gint iq_ring_inptr;     // block currently filled by the protocol thread
+  volatile gint iq_ring_outptr;    // next block to be processed by the DSP thread
+  gint dsp_ring_overruns;          // number of blocks dropped because the ring was full
+  gint dsp_ring_max_fill;          // high-water mark of blocks waiting in the ring
+  //
+  // DSP time per stage in nsec, only measured if receiver_stage_timing is set
+  //
+  gint64 dsp_blocks;
+  gint64 nb_time;
+  gint64 fexchange_time;
+  gint64 spectrum_time;
+  gint64 audio_time;
+#ifdef __APPLE__
+  sem_t *dsp_sem;
+#else
+  sem_t dsp_sem;
+#endif
 } RECEIVER;
 
+extern int receiver_stage_timing;
+//
+// If set when a receiver is created, fexchange0 waits for the output
+// of WDSP instead of returning an error if it is not yet available
+//
+extern int receiver_blocking_dsp;
+
+//
+// A receiver created with height 0 has no panel, panadapter and waterfall
+//
 extern RECEIVER *create_pure_signal_receiver(int id, int buffer_size,int sample_rate,int pixels);
 extern RECEIVER *create_receiver(int id, int buffer_size, int fft_size, int pixels, int fps, int width, int height);
 extern void receiver_change_sample_rate(RECEIVER *rx,int sample_rate);
@@ -195,6 +245,7 @@ extern void set_deviation(RECEIVER *rx);
 
 extern void add_iq_samples(RECEIVER *rx, double i_sample,double q_sample);
 extern void add_div_iq_samples(RECEIVER *rx, double i0,double q0, double i1, double q1);
+extern void add_iq_samples_block(RECEIVER *rx, const double *iq, int n);
 
 extern void reconfigure_receiver(RECEIVER *rx,int height);
 
@@ -208,6 +259,7 @@ extern gboolean receiver_scroll_event(GtkWidget *widget, GdkEventScroll *event,
 extern void set_displaying(RECEIVER *rx,int state);
 
 extern void receiver_restore_state(RECEIVER *rx);
+extern void receiver_stop_dsp(RECEIVER *rx);
 
 extern void receiver_set_active(RECEIVER *rx);
 
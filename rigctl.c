@@ -35,6 +35,7 @@
 #include "band_menu.h"
 #include "sliders.h"
 #include "rigctl.h"
+#include "rigctl_cat.h"
 #include "radio.h"
 #include "channel.h"
 #include "filter.h"
@@ -50,9 +51,12 @@
 #include <wdsp.h>
 #include "store.h"
 #include "ext.h"
+#include "trace.h"
+#include "slice.h"
 #include "rigctl_menu.h"
 #include "noise_menu.h"
 #include "new_protocol.h"
+#include "stream_stats.h"
 #ifdef LOCALCW
 #include "iambic.h"              // declare keyer_update()
 #endif
@@ -64,6 +68,7 @@
 #include <sys/socket.h>
 #include <arpa/inet.h> //inet_addr
 #include <netinet/tcp.h>
+#include <poll.h>
 
 int rigctl_port_base=19090;
 int rigctl_enable=0;
@@ -96,19 +101,29 @@ extern int enable_tx_equalizer;
 typedef struct {GMutex m; } GT_MUTEX;
 
 GT_MUTEX * mutex_a;
-GT_MUTEX * mutex_busy;
 
 FILE * out;
 int  output;
 FILTER * band_filter;
 
-#define MAX_CLIENTS 3
-static GThread *rigctl_server_thread_id = NULL;
+//
+// All TCP clients and the serial port are served by a single I/O thread
+// that waits with poll() on the listening socket, the client connections,
+// the serial port and a "wakeup" pipe. The other threads write to the
+// wakeup pipe if the I/O thread has to look at something new (replies
+// buffered for a client, serial port closed, shut down).
+//
+#define RIGCTL_OUTPUT_SIZE 4096        // replies buffered per client
+#define RIGCTL_FIFO_PAUSE 50000        // usec, see rigctl_io_thread
+#define RIGCTL_REPORT_INTERVAL 60      // sec, client statistics if rigctl_debug
+
+int rigctl_max_clients=8;
+
+static GThread *rigctl_io_thread_id = NULL;
 static GThread *rigctl_cw_thread_id = NULL;
 static int server_running;
-
-static GThread *serial_server_thread_id = NULL;
-static gboolean serial_running=FALSE;
+static int wakeup_pipe[2]={-1,-1};
+static GCond serial_closed;            // signalled when the I/O thread closed the serial port
 
 static int server_socket=-1;
 static int server_address_length;
@@ -116,17 +131,29 @@ static struct sockaddr_in server_address;
 
 static int rigctl_timer = 0;
 
-typedef struct _client {
+struct _client {
   int fd;
   int fifo;    // only needed for serial clients to
                // indicate this is a FIFO and not a
                // true serial line
-  int busy;    // only needed for serial clients over FIFOs
-  int done;    // only needed for serial clients over FIFOs
+  int busy;    // only needed for serial clients over FIFOs:
+               // commands have been read, the replies are not yet sent
+  gint64 resume_time;            // only needed for FIFOs: do not read before
+  volatile gint pending;         // commands passed to parse_cmd, not yet processed
+  volatile gint close_request;   // only needed for the serial client
   socklen_t address_length;
   struct sockaddr_in address;
-  GThread *thread_id;
-} CLIENT;
+  char input[MAXDATASIZE];       // command being assembled
+  int input_length;
+  GMutex output_mutex;           // protects fd and the output buffer
+  char output[RIGCTL_OUTPUT_SIZE];
+  int output_length;
+  int output_dropped;
+  gint64 connect_time;           // for the command rate statistics
+  int commands;
+  int report_commands;
+  gint64 report_time;
+};
 
 typedef struct _command {
   CLIENT *client;
@@ -136,36 +163,69 @@ typedef struct _command {
 static CLIENT client[MAX_CLIENTS];
 static CLIENT serial_client;       // serial lines must pass a valid CLIENT to parse_cmd
 
-static gpointer rigctl_client (gpointer data);
+//
+// Snapshot of the radio state needed to answer the frequent read queries
+// (FA;, IF;, ZZFA; ...) directly on the rigctl I/O thread, without going
+// through the GTK main loop. It is published by the GTK thread (from
+// vfo_update, after each CAT command and by a timer for the meters) and
+// protected by a sequence lock: the writer makes the sequence odd while
+// updating, readers retry if it was odd or has changed while copying.
+//
+typedef struct _rigctl_state {
+  long long frequency[2];   // ctun frequency if ctun is on
+  int mode[2];
+  int filter[2];
+  long long step;
+  long long rit;
+  int rit_enabled;
+  int xit_enabled;
+  int split;
+  int mox;
+  int transmitting;
+  int active_receiver;
+  int ctcss_enabled;
+  int ctcss;
+  double meter[2];
+} RIGCTL_STATE;
+
+#define RIGCTL_STATE_INTERVAL 50   // msec, for the meters
+
+static RIGCTL_STATE rigctl_state;
+static volatile gint rigctl_state_seq=0;    // 0: not yet published
+static guint rigctl_state_timer_id=0;
+
+static gint rigctl_fast_queries=0;
+static gint rigctl_slow_queries=0;
+
+static int ts2000_mode(int m);
+
+static void rigctl_wakeup() {
+  char c=0;
+  if(wakeup_pipe[1]>=0) {
+    // if the pipe is full, the I/O thread wakes up anyway
+    if(write(wakeup_pipe[1],&c,1)<0) return;
+  }
+}
 
 void close_rigctl_ports() {
-  int i;
-  struct linger linger = { 0 };
-  linger.l_onoff = 1;
-  linger.l_linger = 0;
-
   g_print("close_rigctl_ports: server_socket=%d\n",server_socket);
   server_running=0;
-  for(i=0;i<MAX_CLIENTS;i++) {
-      if(client[i].fd!=-1) {
-        g_print("setting SO_LINGER to 0 for client_socket: %d\n",client[i].fd);
-        if(setsockopt(client[i].fd,SOL_SOCKET,SO_LINGER,(const char *)&linger,sizeof(linger))==-1) {
-          perror("setsockopt(...,SO_LINGER,...) failed for client");
-        }
-        g_print("closing client socket: %d\n",client[i].fd);
-        close(client[i].fd);
-        client[i].fd=-1;
-      }
+  if(rigctl_state_timer_id!=0) {
+    g_source_remove(rigctl_state_timer_id);
+    rigctl_state_timer_id=0;
   }
-
-  if(server_socket>=0) {
-     g_print("setting SO_LINGER to 0 for server_socket: %d\n",server_socket);
-    if(setsockopt(server_socket,SOL_SOCKET,SO_LINGER,(const char *)&linger,sizeof(linger))==-1) {
-      perror("setsockopt(...,SO_LINGER,...) failed for server");
-    }
-    g_print("closing server_socket: %d\n",server_socket);
-    close(server_socket);
-    server_socket=-1;
+  //
+  // The I/O thread closes the client connections and the server socket
+  //
+  rigctl_wakeup();
+  if(rigctl_io_thread_id!=NULL) {
+    g_thread_join(rigctl_io_thread_id);
+    rigctl_io_thread_id=NULL;
+  }
+  if(wakeup_pipe[0]>=0) {
+    close(wakeup_pipe[0]);
+    close(wakeup_pipe[1]);
+    wakeup_pipe[0]=wakeup_pipe[1]=-1;
   }
 }
 
@@ -505,44 +565,367 @@ static gpointer rigctl_cw_thread(gpointer data)
   return NULL;
 }
 
-void send_resp (int fd,char * msg) {
+//
+// Must be called on the GTK thread
+//
+void rigctl_publish_state() {
+  RIGCTL_STATE state;
+  int v;
+
+  if(active_receiver==NULL) return;
+  for(v=0;v<2;v++) {
+    state.frequency[v]=vfo[v].ctun?vfo[v].ctun_frequency:vfo[v].frequency;
+    state.mode[v]=vfo[v].mode;
+    state.filter[v]=vfo[v].filter;
+    state.meter[v]=receiver[v]!=NULL?receiver[v]->meter:0.0;
+  }
+  state.step=step;
+  state.rit=vfo[VFO_A].rit;
+  state.rit_enabled=vfo[VFO_A].rit_enabled;
+  state.xit_enabled=transmitter==NULL?0:transmitter->xit_enabled;
+  state.split=split;
+  state.mox=mox;
+  state.transmitting=isTransmitting();
+  state.active_receiver=active_receiver->id;
+  state.ctcss_enabled=transmitter==NULL?0:transmitter->ctcss_enabled;
+  state.ctcss=transmitter==NULL?0:transmitter->ctcss;
+
+  g_atomic_int_inc(&rigctl_state_seq);       // odd: update in progress
+  __sync_synchronize();
+  rigctl_state=state;
+  __sync_synchronize();
+  g_atomic_int_inc(&rigctl_state_seq);       // even: consistent
+}
+
+static gboolean rigctl_state_timer(gpointer data) {
+  rigctl_publish_state();
+  return TRUE;
+}
+
+//
+// Copy the snapshot. Returns FALSE if nothing has been published yet.
+//
+static gboolean rigctl_read_state(RIGCTL_STATE *state) {
+  gint seq;
+  do {
+    seq=g_atomic_int_get(&rigctl_state_seq);
+    if(seq==0) return FALSE;
+    if(seq&1) {
+      g_thread_yield();
+      continue;
+    }
+    __sync_synchronize();
+    *state=rigctl_state;
+    __sync_synchronize();
+  } while(seq!=g_atomic_int_get(&rigctl_state_seq));
+  return TRUE;
+}
+
+//
+// Called by parse_cmd on the GTK thread, and on the I/O thread for the
+// queries answered there. The reply is written at once if nothing is
+// buffered for this client, what cannot be written now is sent by the
+// I/O thread. If the client does not read its replies, they are dropped.
+//
+void send_resp (CLIENT *client,char * msg) {
   if(rigctl_debug) g_print("RIGCTL: RESP=%s\n",msg);
   int length=strlen(msg);
   int rc;
-  int count=0;
+  gboolean wakeup=FALSE;
+
+  g_mutex_lock(&client->output_mutex);
+  if(client->fd>=0) {
+    if(client->output_length==0) {
+      rc=write(client->fd,msg,length);
+      if(rc>0) {
+        length -= rc;
+        msg += rc;
+      }
+    }
+    if(length>0) {
+      if(client->output_length+length<=RIGCTL_OUTPUT_SIZE) {
+        memcpy(&client->output[client->output_length],msg,length);
+        client->output_length+=length;
+        wakeup=TRUE;
+      } else {
+        client->output_dropped++;
+        TRACE_EVENT(TRACE_CAT_REPLY_DROPPED, client->fd, client->output_length);
+      }
+    }
+  }
+  g_mutex_unlock(&client->output_mutex);
+  if(wakeup) rigctl_wakeup();
+}
+
+static const char *client_name(CLIENT *c) {
+  return c==&serial_client?(c->fifo?"serial FIFO":"serial port"):"client";
+}
+
+static void set_nonblocking(int fd) {
+  int flags=fcntl(fd,F_GETFL,0);
+  if(flags<0 || fcntl(fd,F_SETFL,flags|O_NONBLOCK)<0) {
+    perror("rigctl: O_NONBLOCK");
+  }
+}
+
+static void start_client(CLIENT *c) {
+  c->busy=0;
+  c->resume_time=0;
+  c->close_request=0;
+  c->input_length=0;
+  c->output_length=0;
+  c->output_dropped=0;
+  c->connect_time=g_get_monotonic_time();
+  c->commands=0;
+  c->report_commands=0;
+  c->report_time=c->connect_time;
+
+  g_mutex_lock(&mutex_a->m);
+  cat_control++;
+  if(rigctl_debug) g_print("RIGCTL: CTLA INC cat_contro=%d\n",cat_control);
+  g_mutex_unlock(&mutex_a->m);
+  g_idle_add(ext_vfo_update,NULL);
+}
+
+//
+// Only called on the I/O thread
+//
+static void close_client(CLIENT *c,const char *reason) {
+  int fd;
+  double seconds;
+  struct linger linger = { 0 };
+  linger.l_onoff = 1;
+  linger.l_linger = 0;
+
+  g_mutex_lock(&c->output_mutex);
+  fd=c->fd;
+  c->fd=-1;
+  c->output_length=0;
+  if(c==&serial_client) g_cond_broadcast(&serial_closed);
+  g_mutex_unlock(&c->output_mutex);
+  if(fd<0) return;
+
+  seconds=1E-6*(double)(g_get_monotonic_time()-c->connect_time);
+  g_print("rigctl: %s fd=%d closed (%s): %d commands in %0.1f sec (%0.1f/sec), %d replies dropped\n",
+          client_name(c),fd,reason,c->commands,seconds,seconds>0.0?c->commands/seconds:0.0,c->output_dropped);
+  if(c!=&serial_client) {
+    if(setsockopt(fd,SOL_SOCKET,SO_LINGER,(const char *)&linger,sizeof(linger))==-1) {
+      perror("setsockopt(...,SO_LINGER,...) failed for client");
+    }
+  }
+  close(fd);
+
+  g_mutex_lock(&mutex_a->m);
+  cat_control--;
+  if(rigctl_debug) g_print("RIGCTL: CTLA DEC - cat_control=%d\n",cat_control);
+  g_mutex_unlock(&mutex_a->m);
+  g_idle_add(ext_vfo_update,NULL);
+}
 
 //
-// Possibly, the channel is already closed. In this case
-// give up (rc < 0) or at most try a few times (rc == 0)
-// since we are in the GTK idle loop
+// Answer a pure read query from the snapshot, on the I/O thread.
+// Returns FALSE if the command has to go to parse_cmd. The replies are
+// the same as there.
 //
-  while(length>0) {
-    rc=write(fd,msg,length);
-    if (rc < 0) return;
-    if (rc == 0) {
-      count++;
-      if (count > 10) return;
+static gboolean rigctl_fast_query(CLIENT *client,const char *command) {
+  RIGCTL_STATE state;
+  char reply[80];
+  int v;
+
+  reply[0]='\0';
+  if(command[0]=='Z' && command[1]=='Z') {
+    if(strcmp(command,"ZZFA;")==0 || strcmp(command,"ZZFB;")==0) {
+      if(!rigctl_read_state(&state)) return FALSE;
+      v=command[3]=='A'?VFO_A:VFO_B;
+      sprintf(reply,"ZZF%c%011lld;",command[3],state.frequency[v]);
+    } else if(strcmp(command,"ZZMD;")==0 || strcmp(command,"ZZME;")==0) {
+      if(!rigctl_read_state(&state)) return FALSE;
+      // parse_cmd answers ZZME with "ZZMD"
+      sprintf(reply,"ZZMD%02d;",state.mode[command[3]=='D'?VFO_A:VFO_B]);
+    } else if(strcmp(command,"ZZFI;")==0 || strcmp(command,"ZZFJ;")==0) {
+      if(!rigctl_read_state(&state)) return FALSE;
+      v=command[3]=='I'?VFO_A:VFO_B;
+      sprintf(reply,"ZZF%c%02d;",command[3],state.filter[v]);
+    } else if(strcmp(command,"ZZSM0;")==0 || strcmp(command,"ZZSM1;")==0) {
+      double m;
+      if(!rigctl_read_state(&state)) return FALSE;
+      v=command[4]-'0';
+      m=state.meter[v];
+      m=fmax(-140.0,m);
+      m=fmin(-10.0,m);
+      sprintf(reply,"ZZSM%d%03d;",v,(int)((m+140.0)*2));
+    } else if(strcmp(command,"ZZTX;")==0) {
+      if(!rigctl_read_state(&state)) return FALSE;
+      sprintf(reply,"ZZTX%d;",state.mox);
+    } else if(strcmp(command,"ZZSP;")==0) {
+      if(!rigctl_read_state(&state)) return FALSE;
+      sprintf(reply,"ZZSP%d;",state.split);
+    } else if(strcmp(command,"ZZRT;")==0) {
+      if(!rigctl_read_state(&state)) return FALSE;
+      sprintf(reply,"ZZRT%d;",state.rit_enabled);
+    } else {
+      return FALSE;
     }
-    length -= rc;
-    msg += rc;
+  } else if(strcmp(command,"FA;")==0 || strcmp(command,"FB;")==0) {
+    if(!rigctl_read_state(&state)) return FALSE;
+    v=command[1]=='A'?VFO_A:VFO_B;
+    sprintf(reply,"F%c%011lld;",command[1],state.frequency[v]);
+  } else if(strcmp(command,"IF;")==0) {
+    if(!rigctl_read_state(&state)) return FALSE;
+    sprintf(reply,"IF%011lld%04lld%+06lld%d%d%d%02d%d%d%d%d%d%d%02d%d;",
+            state.frequency[VFO_A],state.step,state.rit,state.rit_enabled,state.xit_enabled,
+            0,0,state.transmitting,ts2000_mode(state.mode[VFO_A]),0,0,state.split,state.ctcss_enabled?2:0,state.ctcss,0);
+  } else if(strcmp(command,"MD;")==0) {
+    if(!rigctl_read_state(&state)) return FALSE;
+    sprintf(reply,"MD%d;",ts2000_mode(state.mode[VFO_A]));
+  } else if(strcmp(command,"FR;")==0) {
+    if(!rigctl_read_state(&state)) return FALSE;
+    sprintf(reply,"FR%d;",state.active_receiver);
+  } else if(strcmp(command,"FT;")==0) {
+    if(!rigctl_read_state(&state)) return FALSE;
+    sprintf(reply,"FT%d;",state.split);
+  } else if(strcmp(command,"SM0;")==0 || strcmp(command,"SM1;")==0) {
+    if(!rigctl_read_state(&state)) return FALSE;
+    sprintf(reply,"SM%04d;",(int)state.meter[command[2]-'0']);
+  } else if(strcmp(command,"ID;")==0) {
+    strcpy(reply,"ID019;"); // TS-2000
+  } else {
+    return FALSE;
+  }
+  send_resp(client,reply);
+  return TRUE;
+}
+
+//
+// A complete command has been read from a client
+//
+static void rigctl_command(CLIENT *client,const char *command) {
+  if(rigctl_debug) g_print("RIGCTL: command=%s\n",command);
+  TRACE_EVENT(TRACE_CAT_COMMAND, client->fd, trace_mnemonic(command));
+  client->commands++;
+  if(client->fifo) client->busy=1;
+  //
+  // Read queries are answered here, unless earlier commands of
+  // this client are still waiting for parse_cmd (keep the order)
+  //
+  if(g_atomic_int_get(&client->pending)==0 && rigctl_fast_query(client,command)) {
+    TRACE_EVENT(TRACE_CAT_FAST_REPLY, client->fd, trace_mnemonic(command));
+    g_atomic_int_inc(&rigctl_fast_queries);
+    return;
   }
+  g_atomic_int_inc(&rigctl_slow_queries);
+  COMMAND *info=g_new(COMMAND,1);
+  info->client=client;
+  info->command=g_new(char,MAXDATASIZE);
+  strcpy(info->command,command);
+  g_atomic_int_inc(&client->pending);
+  g_idle_add(parse_cmd,info);
 }
 
 //
-// 2-25-17 - K5JAE - removed duplicate rigctl
+// Returns -1 if the connection is closed
 //
+static int read_client(CLIENT *client) {
+  char buffer[MAXDATASIZE];
+  int numbytes;
+  int i;
 
-static gpointer rigctl_server(gpointer data) {
-  int port=GPOINTER_TO_INT(data);
-  int on=1;
+  numbytes=read(client->fd,buffer,sizeof(buffer));
+  if(numbytes<0) {
+    return (errno==EAGAIN || errno==EWOULDBLOCK || errno==EINTR)?0:-1;
+  }
+  if(numbytes==0) return -1;
+  for(i=0;i<numbytes;i++) {
+    if(client->input_length>=MAXDATASIZE-1) {
+      // no ';' in sight, this is garbage
+      client->input_length=0;
+    }
+    client->input[client->input_length++]=buffer[i];
+    if(buffer[i]==';') {
+      client->input[client->input_length]='\0';
+      client->input_length=0;
+      rigctl_command(client,client->input);
+    }
+  }
+  return 0;
+}
+
+//
+// Send what send_resp could not write. Returns -1 on error.
+//
+static int flush_output(CLIENT *client) {
+  int rc=0;
+  g_mutex_lock(&client->output_mutex);
+  if(client->fd>=0 && client->output_length>0) {
+    rc=write(client->fd,client->output,client->output_length);
+    if(rc>0) {
+      client->output_length-=rc;
+      memmove(client->output,&client->output[rc],client->output_length);
+    } else if(rc<0 && (errno==EAGAIN || errno==EWOULDBLOCK || errno==EINTR)) {
+      rc=0;
+    }
+  }
+  g_mutex_unlock(&client->output_mutex);
+  return rc<0?-1:0;
+}
+
+//
+// A slot may only be used again when parse_cmd has processed all
+// commands of the previous connection
+//
+static int free_slot() {
   int i;
+  for(i=0;i<rigctl_max_clients && i<MAX_CLIENTS;i++) {
+    if(client[i].fd==-1 && g_atomic_int_get(&client[i].pending)==0) return i;
+  }
+  return -1;
+}
+
+static void accept_client() {
+  int spare=free_slot();
+  int fd;
+  int on=1;
+
+  if(spare<0) return;
+  client[spare].address_length=sizeof(client[spare].address);
+  fd=accept(server_socket,(struct sockaddr*)&client[spare].address,&client[spare].address_length);
+  if(fd<0) {
+    if(errno!=EAGAIN && errno!=EWOULDBLOCK && errno!=EINTR) {
+      perror("rigctl_server: client accept failed");
+    }
+    return;
+  }
+  set_nonblocking(fd);
+
+  //
+  // Setting TCP_NODELAY may (or may not) improve responsiveness
+  // by *disabling* Nagle's algorithm for clustering small packets
+  //
+#ifdef __APPLE__
+  if(setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (void *)&on, sizeof(on))<0) {
+#else
+  if(setsockopt(fd, SOL_TCP, TCP_NODELAY, (void *)&on, sizeof(on))<0) {
+#endif
+    perror("TCP_NODELAY");
+  }
+
+  start_client(&client[spare]);
+  g_mutex_lock(&client[spare].output_mutex);
+  client[spare].fd=fd;
+  g_mutex_unlock(&client[spare].output_mutex);
+  g_print("rigctl: slot= %d connected with fd=%d from %s:%d\n",spare,fd,
+          inet_ntoa(client[spare].address.sin_addr),ntohs(client[spare].address.sin_port));
+}
+
+static void open_server_socket(int port) {
+  int on=1;
 
   g_print("rigctl_server: starting server on port %d\n",port);
 
   server_socket=socket(AF_INET,SOCK_STREAM,0);
   if(server_socket<0) {
     perror("rigctl_server: listen socket failed");
-    return NULL;
+    return;
   }
 
   setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
@@ -556,135 +939,171 @@ static gpointer rigctl_server(gpointer data) {
   if(bind(server_socket,(struct sockaddr*)&server_address,sizeof(server_address))<0) {
     perror("rigctl_server: listen socket bind failed");
     close(server_socket);
-    return NULL;
+    server_socket=-1;
+    return;
   }
 
-  for(i=0;i<MAX_CLIENTS;i++) {
-    client[i].fd=-1;
-  }
-  // listen with a max queue of 3
-  if(listen(server_socket,3)<0) {
+  if(listen(server_socket,MAX_CLIENTS)<0) {
     perror("rigctl_server: listen failed");
     close(server_socket);
-    return NULL;
+    server_socket=-1;
+    return;
+  }
+  set_nonblocking(server_socket);
+}
+
+//
+// Command rates of all clients since the last report
+//
+static void rigctl_report() {
+  gint64 now=g_get_monotonic_time();
+  int i;
+  for(i=0;i<=MAX_CLIENTS;i++) {
+    CLIENT *c=i<MAX_CLIENTS?&client[i]:&serial_client;
+    double seconds;
+    if(c->fd<0) continue;
+    seconds=1E-6*(double)(now-c->report_time);
+    g_print("rigctl: %s fd=%d: %d commands, %0.1f/sec (%d replies dropped)\n",client_name(c),c->fd,
+            c->commands,seconds>0.0?(c->commands-c->report_commands)/seconds:0.0,c->output_dropped);
+    c->report_commands=c->commands;
+    c->report_time=now;
   }
-  server_running=1;
+}
+
+static gpointer rigctl_io_thread(gpointer data) {
+  int port=GPOINTER_TO_INT(data);
+  struct pollfd pfd[MAX_CLIENTS+3];
+  CLIENT *pclient[MAX_CLIENTS+3];
+  char drain[64];
+  gint64 now;
+  gint64 next_report;
+  int listener;
+  int timeout;
+  int i, n, rc;
+
+  open_server_socket(port);
 
   // must start the thread here in order NOT to inherit a lock
   if (!rigctl_cw_thread_id) rigctl_cw_thread_id = g_thread_new("RIGCTL cw", rigctl_cw_thread, NULL);
 
+  next_report=g_get_monotonic_time()+RIGCTL_REPORT_INTERVAL*1000000LL;
   while(server_running) {
-    int spare;
+    if(g_atomic_int_get(&serial_client.close_request)) {
+      g_atomic_int_set(&serial_client.close_request,0);
+      close_client(&serial_client,"disabled");
+    }
 
+    now=g_get_monotonic_time();
+    timeout=-1;
+    n=0;
+    pfd[n].fd=wakeup_pipe[0];
+    pfd[n].events=POLLIN;
+    pclient[n]=NULL;
+    n++;
     //
-    // find a spare slot
+    // If all slots are in use, new connections wait in the listen queue
     //
-    spare = -1;
-    for(i=0;i<MAX_CLIENTS;i++) {
-      if(client[i].fd == -1) {
-        spare=i;
-        break;
+    listener=-1;
+    if(server_socket>=0 && free_slot()>=0) {
+      listener=n;
+      pfd[n].fd=server_socket;
+      pfd[n].events=POLLIN;
+      pclient[n]=NULL;
+      n++;
+    }
+    for(i=0;i<=MAX_CLIENTS;i++) {
+      CLIENT *c=i<MAX_CLIENTS?&client[i]:&serial_client;
+      short events=0;
+      if(c->fd<0) continue;
+      g_mutex_lock(&c->output_mutex);
+      if(c->output_length>0) events|=POLLOUT;
+      g_mutex_unlock(&c->output_mutex);
+      if(c->fifo) {
+        //
+        // If the "serial line" is a FIFO, we must not drain it
+        // by reading our own responses (it must go to the other
+        // side). Therefore, wait until RIGCTL_FIFO_PAUSE after the
+        // last CAT command of this client has been processed and
+        // the reply has been written.
+        //
+        if(c->busy && g_atomic_int_get(&c->pending)==0 && !(events&POLLOUT)) {
+          c->busy=0;
+          c->resume_time=now+RIGCTL_FIFO_PAUSE;
+        }
+        if(!c->busy) {
+          if(now>=c->resume_time) {
+            events|=POLLIN;
+          } else {
+            int t=(int)((c->resume_time-now+999)/1000);
+            if(timeout<0 || t<timeout) timeout=t;
+          }
+        }
+      } else {
+        events|=POLLIN;
       }
+      pfd[n].fd=c->fd;
+      pfd[n].events=events;
+      pclient[n]=c;
+      n++;
     }
-    // if all slots are in use, wait and continue
-    if (spare < 0) {
-      usleep(100000L);
-      continue;
+    if(rigctl_debug) {
+      int t=now>=next_report?0:(int)((next_report-now+999)/1000);
+      if(timeout<0 || t<timeout) timeout=t;
     }
 
-    //
-    // A slot is available, try to get connection via accept()
-    //
-    g_print("rigctl: slot= %d waiting for connection\n",spare);
-    client[spare].fd=accept(server_socket,(struct sockaddr*)&client[spare].address,&client[spare].address_length);
-    if(client[spare].fd<0) {
-      perror("rigctl_server: client accept failed");
-      client[spare].fd = -1;
-      continue;
+    rc=poll(pfd,n,timeout);
+    if(rc<0) {
+      if(errno==EINTR) continue;
+      perror("rigctl: poll");
+      break;
     }
-    g_print("rigctl: slot= %d connected with fd=%d\n",spare,client[spare].fd);
 
-    //
-    // Setting TCP_NODELAY may (or may not) improve responsiveness
-    // by *disabling* Nagle's algorithm for clustering small packets
-    //
-#ifdef __APPLE__
-    if(setsockopt(client[spare].fd, IPPROTO_TCP, TCP_NODELAY, (void *)&on, sizeof(on))<0) {
-#else
-    if(setsockopt(client[spare].fd, SOL_TCP, TCP_NODELAY, (void *)&on, sizeof(on))<0) {
-#endif
-      perror("TCP_NODELAY");
+    if(pfd[0].revents&POLLIN) {
+      while(read(wakeup_pipe[0],drain,sizeof(drain))>0);
+    }
+    if(listener>=0 && (pfd[listener].revents&POLLIN)) {
+      accept_client();
+    }
+    for(i=0;i<n;i++) {
+      CLIENT *c=pclient[i];
+      if(c==NULL || c->fd!=pfd[i].fd) continue;
+      if(pfd[i].revents&POLLOUT) {
+        if(flush_output(c)<0) {
+          close_client(c,"write failed");
+          continue;
+        }
+      }
+      if(pfd[i].revents&(POLLIN|POLLHUP|POLLERR)) {
+        if(read_client(c)<0) {
+          close_client(c,"connection closed");
+        }
+      }
     }
 
-    //
-    // Spawn off a thread for handling this new connection
-    //
-    client[spare].thread_id = g_thread_new("rigctl client", rigctl_client, (gpointer)&client[spare]);
-    // note that g_thread_new() never returns from a failure.
+    if(rigctl_debug && g_get_monotonic_time()>=next_report) {
+      rigctl_report();
+      next_report+=RIGCTL_REPORT_INTERVAL*1000000LL;
+    }
   }
 
-  close(server_socket);
-  return NULL;
-}
-
-static gpointer rigctl_client (gpointer data) {
-   
-  CLIENT *client=(CLIENT *)data;
-
-  g_print("rigctl_client: starting rigctl_client: socket=%d\n",client->fd);
-
-  g_mutex_lock(&mutex_a->m);
-  cat_control++;
-  if(rigctl_debug) g_print("RIGCTL: CTLA INC cat_contro=%d\n",cat_control);
-  g_mutex_unlock(&mutex_a->m);
-  g_idle_add(ext_vfo_update,NULL);
-
-  int i;
-  int numbytes;
-  char  cmd_input[MAXDATASIZE] ;
-
-  char *command=g_new(char,MAXDATASIZE);
-  int command_index=0;
-
-   while(server_running && (numbytes=recv(client->fd , cmd_input , MAXDATASIZE-2 , 0)) > 0 ) {
-       for(i=0;i<numbytes;i++) {
-         command[command_index]=cmd_input[i];
-         command_index++;
-         if(cmd_input[i]==';') {
-           command[command_index]='\0';
-           if(rigctl_debug) g_print("RIGCTL: command=%s\n",command);
-           COMMAND *info=g_new(COMMAND,1);
-           info->client=client;
-           info->command=command;
-           g_idle_add(parse_cmd,info);
-           command=g_new(char,MAXDATASIZE);
-           command_index=0;
-         }
-       }
-     }
-  g_print("RIGCTL: Leaving rigctl_client thread\n");
-  //
-  // If rigctl is disabled via the GUI, the connections are closed by close_rigctl_ports()
-  // but even the we should decrement cat_control
-  //
-  if(client->fd!=-1) {
-    g_print("setting SO_LINGER to 0 for client_socket: %d\n",client->fd);
+  g_print("rigctl: leaving I/O thread: %d queries answered directly, %d by parse_cmd\n",
+          g_atomic_int_get(&rigctl_fast_queries),g_atomic_int_get(&rigctl_slow_queries));
+  for(i=0;i<=MAX_CLIENTS;i++) {
+    close_client(i<MAX_CLIENTS?&client[i]:&serial_client,"rigctl disabled");
+  }
+  if(server_socket>=0) {
     struct linger linger = { 0 };
     linger.l_onoff = 1;
     linger.l_linger = 0;
-    if(setsockopt(client->fd,SOL_SOCKET,SO_LINGER,(const char *)&linger,sizeof(linger))==-1) {
-      perror("setsockopt(...,SO_LINGER,...) failed for client");
+    g_print("setting SO_LINGER to 0 for server_socket: %d\n",server_socket);
+    if(setsockopt(server_socket,SOL_SOCKET,SO_LINGER,(const char *)&linger,sizeof(linger))==-1) {
+      perror("setsockopt(...,SO_LINGER,...) failed for server");
     }
-    close(client->fd);
-    client->fd=-1;
+    g_print("closing server_socket: %d\n",server_socket);
+    close(server_socket);
+    server_socket=-1;
   }
-  // Decrement CAT_CONTROL
-  g_mutex_lock(&mutex_a->m);
-  cat_control--;
-  if(rigctl_debug) g_print("RIGCTL: CTLA DEC - cat_control=%d\n",cat_control);
-  g_mutex_unlock(&mutex_a->m);
-  g_idle_add(ext_vfo_update,NULL);
-  return NULL; 
+  return NULL;
 }
 
 // 
@@ -747,3080 +1166,2684 @@ static int ts2000_mode(int m) {
 }
 
 
-gboolean parse_extended_cmd (char *command,CLIENT *client) {
-  gboolean implemented=TRUE;
+//
+// The CAT command handlers. parse_cmd looks up the handler for the
+// mnemonic and the number of arguments in cat_commands (see rigctl_cat.h)
+//
+
+// set commands that are accepted but have no effect here (e.g. PS1;
+// from hamlib), so that the client does not get "?;"
+static gboolean cat_set_ignored(CLIENT *client,char *command) {
+  return TRUE;
+}
+
+// sets or reads the Step Size
+static gboolean cat_zzac_query(CLIENT *client,char *command) {
   char reply[256];
   reply[0]='\0';
-  switch(command[2]) {
-    case 'A': //ZZAx
-      switch(command[3]) {
-        case 'A': //ZZAA
-          implemented=FALSE;
-          break;
-        case 'B': //ZZAB
-          implemented=FALSE;
-          break;
-        case 'C': //ZZAC
-          // sets or reads the Step Size
-          if(command[4]==';') {
-            // read the step size
-           sprintf(reply,"ZZAC%02d;",vfo_get_stepindex());
-           send_resp(client->fd,reply) ;
-          } else if(command[6]==';') {
-            // set the step size
-            int i=atoi(&command[4]) ;
-            vfo_set_step_from_index(i);
-            vfo_update();
-          } else {
-          }
-          break;
-        case 'D': //ZZAD
-          // move VFO A down by selected step
-          if(command[6]==';') {
-            int step_index=atoi(&command[4]);
-            long long hz = (long long) vfo_get_step_from_index(step_index);
-            vfo_id_move(VFO_A,-hz,FALSE);
-          } else {
-          }
-          break;
-        case 'E': //ZZAE
-          // move VFO A down nn tune steps
-          if(command[6]==';') {
-            int steps=atoi(&command[4]);
-            vfo_id_step(VFO_A,-steps);
-          }
-          break;
-        case 'F': //ZZAF
-          // move VFO A up nn tune steps
-          if(command[6]==';') {
-            int steps=atoi(&command[4]);
-            vfo_id_step(VFO_A,steps);
-          }
-          break;
-        case 'G': //ZZAG
-          // read/set audio gain
-          if(command[4]==';') {
-            // send reply back
-            sprintf(reply,"ZZAG%03d;",(int)(active_receiver->volume*100.0));
-            send_resp(client->fd,reply) ;
-          } else {
-            int gain=atoi(&command[4]);
-            active_receiver->volume=(double)gain/100.0;
-            update_af_gain();
-          }
-          break;
-        case 'I': //ZZAI
-          implemented=FALSE;
-          break;
-        case 'P': //ZZAP
-          implemented=FALSE;
-          break;
-        case 'R': //ZZAR
-          // read/set RX0 AGC Threshold
-          if(command[4]==';') {
-            // send reply back
-            sprintf(reply,"ZZAR%+04d;",(int)(receiver[0]->agc_gain));
-            send_resp(client->fd,reply) ;
-          } else {
-            int threshold=atoi(&command[4]);
-            set_agc_gain(VFO_A,(double)threshold);
-          }
-          break;
-        case 'S': //ZZAS
-          // read/set RX1 AGC Threshold
-          if(receivers==2) {
-            if(command[4]==';') {
-              // send reply back
-              sprintf(reply,"ZZAS%+04d;",(int)(receiver[1]->agc_gain));
-              send_resp(client->fd,reply) ;
-            } else {
-              int threshold=atoi(&command[4]);
-              set_agc_gain(VFO_B,(double)threshold);
-            }
-          }
-          break;
-        case 'T': //ZZAT
-          implemented=FALSE;
-          break;
-        case 'U': //ZZAU
-          // move VFO A up by selected step
-          if(command[6]==';') {
-            int step_index=atoi(&command[4]);
-            long long hz = (long long) vfo_get_step_from_index(step_index);
-            vfo_id_move(VFO_A, hz, FALSE);
-          } else {
-          }
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
-      break;
-    case 'B': //ZZBx
-      switch(command[3]) {
-        case 'A': //ZZBA
-          // move RX2 down one band
-          if(command[4]==';') {
-            if(receivers==2) {
-              band_minus(receiver[1]->id);
-            }
-          }
-          break;
-        case 'B': //ZZBB
-          // move RX2 up one band
-          if(command[4]==';') {
-            if(receivers==2) {
-              band_plus(receiver[1]->id);
-            }
-          }
-          break;
-        case 'D': //ZZBD
-          // move RX1 down one band
-          if(command[4]==';') {
-            band_minus(receiver[0]->id);
-          }
-          break;
-        case 'E': //ZZBE
-          // move VFO B down nn tune steps
-          if(command[6]==';') {
-            int steps=atoi(&command[4]);
-            vfo_id_step(VFO_B,-steps);
-          }
 
-          break;
-        case 'F': //ZZBF
-          // move VFO B up nn tune steps
-          if(command[6]==';') {
-            int steps=atoi(&command[4]);
-            vfo_id_step(VFO_B,+steps);
-          }
-          break;
-        case 'G': //ZZBG
-          implemented=FALSE;
-          break;
-        case 'I': //ZZBI
-          implemented=FALSE;
-          break;
-        case 'M': //ZZBM
-          // move VFO B down by selected step
-          if(command[6]==';') {
-            int step_index=atoi(&command[4]);
-            long long hz = (long long) vfo_get_step_from_index(step_index);
-            vfo_id_move(VFO_B,-hz,FALSE);
-          } else {
-          }
+  // read the step size
+ sprintf(reply,"ZZAC%02d;",vfo_get_stepindex());
+ send_resp(client,reply) ;
+  return TRUE;
+}
 
-          break;
-        case 'P': //ZZBP
-          // move VFO B up by selected step
-          if(command[6]==';') {
-            int step_index=atoi(&command[4]);
-            long long hz = (long long) vfo_get_step_from_index(step_index);
-            vfo_id_move(VFO_B,hz,FALSE);
-          } else {
-          }
-          break;
-        case 'R': //ZZBR
-          implemented=FALSE;
-          break;
-        case 'S': //ZZBS
-          // set/read RX1 band switch
-          if(command[4]==';') {
-            int b;
-            switch(vfo[VFO_A].band) {
-              case band136:
-                b=136;
-                break;
-              case band472:
-                b=472;
-                break;
-              case band160:
-                b=160;
-                break;
-              case band80:
-                b=80;
-                break;
-              case band60:
-                b=60;
-                break;
-              case band40:
-                b=40;
-                break;
-              case band30:
-                b=30;
-                break;
-              case band20:
-                b=20;
-                break;
-              case band17:
-                b=17;
-                break;
-              case band15:
-                b=15;
-                break;
-              case band12:
-                b=12;
-                break;
-              case band10:
-                b=10;
-                break;
-              case band6:
-                b=6;
-                break;
-              case bandGen:
-                b=888;
-                break;
-              case bandWWV:
-                b=999;
-                break;
-              default:
-                b=20;
-                break;
-            }
-            sprintf(reply,"ZZBS%03d;",b);
-            send_resp(client->fd,reply) ;
-          } else if(command[7]==';') {
-            int band=band20;
-            int b=atoi(&command[4]);
-            switch(b) {
-              case 136:
-                band=band136;
-                break;
-              case 472:
-                band=band472;
-                break;
-              case 160:
-                band=band160;
-                break;
-              case 80:
-                band=band80;
-                break;
-              case 60:
-                band=band60;
-                break;
-              case 40:
-                band=band40;
-                break;
-              case 30:
-                band=band30;
-                break;
-              case 20:
-                band=band20;
-                break;
-              case 17:
-                band=band17;
-                break;
-              case 15:
-                band=band15;
-                break;
-              case 12:
-                band=band12;
-                break;
-              case 10:
-                band=band10;
-                break;
-              case 6:
-                band=band6;
-                break;
-              case 888:
-                band=bandGen;
-                break;
-              case 999:
-                band=bandWWV;
-                break;
-            }
-            vfo_band_changed(VFO_A,band);
-          }
-          break;
-        case 'T': //ZZBT
-          // set/read RX2 band switch
-          break;
-        case 'U': //ZZBU
-          // move RX1 up one band
-          if(command[4]==';') {
-            band_plus(receiver[0]->id);
-          }
-          break;
-        case 'Y': //ZZBY
-          // closes console (ignored)
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+static gboolean cat_zzac_set(CLIENT *client,char *command) {
+  // set the step size
+  int i=atoi(&command[4]) ;
+  vfo_set_step_from_index(i);
+  vfo_update();
+  return TRUE;
+}
+
+// move VFO A down by selected step
+static gboolean cat_zzad_set(CLIENT *client,char *command) {
+  int step_index=atoi(&command[4]);
+  long long hz = (long long) vfo_get_step_from_index(step_index);
+  vfo_id_move(VFO_A,-hz,FALSE);
+  return TRUE;
+}
+
+// move VFO A down nn tune steps
+static gboolean cat_zzae_set(CLIENT *client,char *command) {
+  int steps=atoi(&command[4]);
+  vfo_id_step(VFO_A,-steps);
+  return TRUE;
+}
+
+// move VFO A up nn tune steps
+static gboolean cat_zzaf_set(CLIENT *client,char *command) {
+  int steps=atoi(&command[4]);
+  vfo_id_step(VFO_A,steps);
+  return TRUE;
+}
+
+// read/set audio gain
+static gboolean cat_zzag_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  // send reply back
+  sprintf(reply,"ZZAG%03d;",(int)(active_receiver->volume*100.0));
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzag_set(CLIENT *client,char *command) {
+  int gain=atoi(&command[4]);
+  active_receiver->volume=(double)gain/100.0;
+  update_af_gain();
+  return TRUE;
+}
+
+// read/set RX0 AGC Threshold
+static gboolean cat_zzar_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  // send reply back
+  sprintf(reply,"ZZAR%+04d;",(int)(receiver[0]->agc_gain));
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzar_set(CLIENT *client,char *command) {
+  int threshold=atoi(&command[4]);
+  set_agc_gain(VFO_A,(double)threshold);
+  return TRUE;
+}
+
+// read/set RX1 AGC Threshold
+static gboolean cat_zzas(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  if(receivers==2) {
+    if(command[4]==';') {
+      // send reply back
+      sprintf(reply,"ZZAS%+04d;",(int)(receiver[1]->agc_gain));
+      send_resp(client,reply) ;
+    } else {
+      int threshold=atoi(&command[4]);
+      set_agc_gain(VFO_B,(double)threshold);
+    }
+  }
+  return TRUE;
+}
+
+// move VFO A up by selected step
+static gboolean cat_zzau_set(CLIENT *client,char *command) {
+  int step_index=atoi(&command[4]);
+  long long hz = (long long) vfo_get_step_from_index(step_index);
+  vfo_id_move(VFO_A, hz, FALSE);
+  return TRUE;
+}
+
+// move RX2 down one band
+static gboolean cat_zzba_set(CLIENT *client,char *command) {
+  if(receivers==2) {
+    band_minus(receiver[1]->id);
+  }
+  return TRUE;
+}
+
+// move RX2 up one band
+static gboolean cat_zzbb_set(CLIENT *client,char *command) {
+  if(receivers==2) {
+    band_plus(receiver[1]->id);
+  }
+  return TRUE;
+}
+
+// move RX1 down one band
+static gboolean cat_zzbd_set(CLIENT *client,char *command) {
+  band_minus(receiver[0]->id);
+  return TRUE;
+}
+
+// move VFO B down nn tune steps
+static gboolean cat_zzbe_set(CLIENT *client,char *command) {
+  int steps=atoi(&command[4]);
+  vfo_id_step(VFO_B,-steps);
+  return TRUE;
+}
+
+// move VFO B up nn tune steps
+static gboolean cat_zzbf_set(CLIENT *client,char *command) {
+  int steps=atoi(&command[4]);
+  vfo_id_step(VFO_B,+steps);
+  return TRUE;
+}
+
+// move VFO B down by selected step
+static gboolean cat_zzbm_set(CLIENT *client,char *command) {
+  int step_index=atoi(&command[4]);
+  long long hz = (long long) vfo_get_step_from_index(step_index);
+  vfo_id_move(VFO_B,-hz,FALSE);
+  return TRUE;
+}
+
+// move VFO B up by selected step
+static gboolean cat_zzbp_set(CLIENT *client,char *command) {
+  int step_index=atoi(&command[4]);
+  long long hz = (long long) vfo_get_step_from_index(step_index);
+  vfo_id_move(VFO_B,hz,FALSE);
+  return TRUE;
+}
+
+// set/read RX1 band switch
+static gboolean cat_zzbs_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  int b;
+  switch(vfo[VFO_A].band) {
+    case band136:
+      b=136;
       break;
-    case 'C': //ZZCx
-      switch(command[3]) {
-        case 'B': //ZZCB: VFO A to B
-          if(!locked) {
-            if(command[4]==';') {
-	      vfo_a_to_b();
-            }
-          }
-          break;
-        case 'D': //ZZCD: VFO B to A
-          if(!locked) {
-            if(command[4]==';') {
-              vfo_b_to_a();
-            }
-          }
-          break;
-        case 'F': //ZZCF: Swap VFO A and B
-          if(!locked) {
-            if(command[4]==';') {
-              vfo_a_swap_b();
-            }
-          }
-          break;
-        case 'I': //ZZCI
-          implemented=FALSE;
-          break;
-        case 'L': //ZZCL
-          implemented=FALSE;
-          break;
-        case 'M': //ZZCM
-          implemented=FALSE;
-          break;
-        case 'N': //ZZCN
-          // set/read VFO A CTUN
-          if(command[4]==';') {
-            // return the CTUN status
-            sprintf(reply,"ZZCN%d;",vfo[VFO_A].ctun);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            int state=atoi(&command[4]);
-            ctun_update(VFO_A,state);
-            vfo_update();
-          }
-          break;
-        case 'O': //ZZCO
-          // set/read VFO B CTUN
-          if(command[4]==';') {
-            // return the CTUN status
-            sprintf(reply,"ZZCO%d;",vfo[VFO_B].ctun);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            int state=atoi(&command[4]);
-            ctun_update(VFO_B,state);
-            vfo_update();
-          }
-          break;
-        case 'P': //ZZCP
-          // set/read compander
-          if(command[4]==';') {
-            sprintf(reply,"ZZCP%d;",0);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            // ignore
-          }
-          break;
-        case 'S': //ZZCS
-          implemented=FALSE;
-          break;
-        case 'T': //ZZCT
-          implemented=FALSE;
-          break;
-        case 'U': //ZZCU
-          implemented=FALSE;
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band472:
+      b=472;
       break;
-    case 'D': //ZZDx
-      switch(command[3]) {
-        case 'A': //ZZDA
-          break;
-        case 'B': //ZZDB
-          // set/read RX Reference
-          if(command[4]==';') {
-            sprintf(reply,"ZZDB%d;",0); // currently always 0
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            // ignore
-          }
-          break;
-        case 'C': //ZZDC
-          // set/get diversity gain
-          if(command[4]==';') {
-            sprintf(reply,"ZZDC%04d;",(int)div_gain);
-            send_resp(client->fd,reply) ;
-          } else if(command[8]==';') {
-            // ignore
-          }
-          break;
-        case 'D': //ZZDD
-          // set/get diversity phase
-          if(command[4]==';') {
-            sprintf(reply,"ZZDD%04d;",(int)div_phase);
-            send_resp(client->fd,reply) ;
-          } else if(command[8]==';') {
-            // ignore
-          }
-        case 'E': //ZZDE
-          implemented=FALSE;
-          break;
-        case 'F': //ZZDF
-          implemented=FALSE;
-          break;
-        case 'M': //ZZDM
-          // set/read Display Mode
-          if(command[4]==';') {
-            int v=0;
-            if(active_receiver->display_waterfall) {
-              v=8;
-            } else {
-              v=2;
-            }
-            sprintf(reply,"ZZDM%d;",v);
-            send_resp(client->fd,reply) ;
-          } else {
-          }
-          break;
-        case 'N': //ZZDN
-          // set/read waterfall low
-          if(command[4]==';') {
-            sprintf(reply,"ZZDN%+4d;",active_receiver->waterfall_low);
-            send_resp(client->fd,reply) ;
-          } else {
-          }
-          break;
-        case 'O': //ZZDO
-          // set/read waterfall high
-          if(command[4]==';') {
-            sprintf(reply,"ZZDO%+4d;",active_receiver->waterfall_high);
-            send_resp(client->fd,reply) ;
-          } else {
-          }
-          break;
-        case 'P': //ZZDP
-          // set/read panadapter high
-          if(command[4]==';') {
-            sprintf(reply,"ZZDP%+4d;",active_receiver->panadapter_high);
-            send_resp(client->fd,reply) ;
-          } else {
-          }
-          break;
-        case 'Q': //ZZDQ
-          // set/read panadapter low
-          if(command[4]==';') {
-            sprintf(reply,"ZZDQ%+4d;",active_receiver->panadapter_low);
-            send_resp(client->fd,reply) ;
-          } else {
-          }
-          break;
-        case 'R': //ZZDR
-          // set/read panadapter step
-          if(command[4]==';') {
-            sprintf(reply,"ZZDR%2d;",active_receiver->panadapter_step);
-            send_resp(client->fd,reply) ;
-          } else {
-          }
-          break;
-        case 'U': //ZZDU
-          implemented=FALSE;
-          break;
-        case 'X': //ZZDX
-          implemented=FALSE;
-          break;
-        case 'Y': //ZZDY
-          implemented=FALSE;
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band160:
+      b=160;
       break;
-    case 'E': //ZZEx
-      switch(command[3]) {
-        case 'A': //ZZEA
-          // set/read rx equalizer values
-          if(command[4]==';') {
-            sprintf(reply,"ZZEA%03d%03d%03d%03d%03d00000000000000000000;",3,rx_equalizer[0],rx_equalizer[1],rx_equalizer[2],rx_equalizer[3]);
-            send_resp(client->fd,reply) ;
-          } else if(command[37]==';') {
-            char temp[4];
-            temp[3]='\0';
-            strncpy(temp,&command[4],3);
-            int bands=atoi(temp);
-            if(bands==3) {
-              strncpy(temp,&command[7],3);
-              rx_equalizer[0]=atoi(temp);
-              strncpy(temp,&command[10],3);
-              rx_equalizer[1]=atoi(temp);
-              strncpy(temp,&command[13],3);
-              rx_equalizer[2]=atoi(temp);
-            } else {
-            }
-          } else {
-          }
-          break;
-        case 'B': //ZZEB
-          // set/read tx equalizer values
-          if(command[4]==';') {
-            sprintf(reply,"ZZEB%03d%03d%03d%03d%03d00000000000000000000;",3,tx_equalizer[0],tx_equalizer[1],tx_equalizer[2],tx_equalizer[3]);
-            send_resp(client->fd,reply) ;
-          } else if(command[37]==';') {
-            char temp[4];
-            temp[3]='\0';
-            strncpy(temp,&command[4],3);
-            int bands=atoi(temp);
-            if(bands==3) {
-              strncpy(temp,&command[7],3);
-              tx_equalizer[0]=atoi(temp);
-              strncpy(temp,&command[10],3);
-              tx_equalizer[1]=atoi(temp);
-              strncpy(temp,&command[13],3);
-              tx_equalizer[2]=atoi(temp);
-            } else {
-            }
-          } else {
-          }
-          break;
-        case 'M': //ZZEM
-          implemented=FALSE;
-          break;
-        case 'R': //ZZER
-          // set/read rx equalizer
-          if(command[4]==';') {
-            sprintf(reply,"ZZER%d;",enable_rx_equalizer);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            enable_rx_equalizer=atoi(&command[4]);
-          } else {
-          }
-          break;
-        case 'T': //ZZET
-          // set/read tx equalizer
-          if(command[4]==';') {
-            sprintf(reply,"ZZET%d;",enable_tx_equalizer);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            enable_tx_equalizer=atoi(&command[4]);
-          } else {
-          }
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band80:
+      b=80;
       break;
-    case 'F': //ZZFx
-      switch(command[3]) {
-        case 'A': //ZZFA
-          // set/read VFO-A frequency
-          if(command[4]==';') {
-            if(vfo[VFO_A].ctun) {
-              sprintf(reply,"ZZFA%011lld;",vfo[VFO_A].ctun_frequency);
-            } else {
-              sprintf(reply,"ZZFA%011lld;",vfo[VFO_A].frequency);
-            }
-            send_resp(client->fd,reply) ;
-          } else if(command[15]==';') {
-            long long f=atoll(&command[4]);
-            vfo_set_frequency(VFO_A,f);
-            vfo_update();
-          }
-          break;
-        case 'B': //ZZFB
-          // set/read VFO-B frequency
-          if(command[4]==';') {
-            if(vfo[VFO_B].ctun) {
-              sprintf(reply,"ZZFB%011lld;",vfo[VFO_B].ctun_frequency);
-            } else {
-              sprintf(reply,"ZZFB%011lld;",vfo[VFO_B].frequency);
-            }
-            send_resp(client->fd,reply) ;
-          } else if(command[15]==';') {
-            long long f=atoll(&command[4]);
-            vfo_set_frequency(VFO_B,f);
-            vfo_update();
-          }
-          break;
-        case 'D': //ZZFD
-          // set/read deviation
-          if(command[4]==';') {
-            sprintf(reply,"ZZFD%d;",active_receiver->deviation==2500?0:1);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            int d=atoi(&command[4]);
-            if(d==0) {
-              active_receiver->deviation=2500;
-            } else if(d==1) {
-              active_receiver->deviation=5000;
-            } else {
-            }
-            vfo_update();
-          }
-          break;
-        case 'H': //ZZFH
-          // set/read RX1 filter high
-          if(command[4]==';') {
-            sprintf(reply,"ZZFH%05d;",receiver[0]->filter_high);
-            send_resp(client->fd,reply) ;
-          } else if(command[9]==';') {
-            int fh=atoi(&command[4]);
-            fh=fmin(9999,fh);
-            fh=fmax(-9999,fh);
-            // make sure filter is filterVar1
-            if(vfo[VFO_A].filter!=filterVar1) {
-              vfo_filter_changed(filterVar1);
-            }
-            FILTER *mode_filters=filters[vfo[VFO_A].mode];
-            FILTER *filter=&mode_filters[filterVar1];
-            filter->high=fh;
-            vfo_filter_changed(filterVar1);
-          }
-          break;
-        case 'I': //ZZFI
-          // set/read RX1 DSP receive filter
-          if(command[4]==';') {
-            sprintf(reply,"ZZFI%02d;",vfo[VFO_A].filter);
-            send_resp(client->fd,reply) ;
-          } else if(command[6]==';') {
-            int filter=atoi(&command[4]);
-            // update RX1 filter
-	    vfo_filter_changed(filter);
-          }
-          break;
-        case 'J': //ZZFJ
-          // set/read RX2 DSP receive filter
-          if(command[4]==';') {
-            sprintf(reply,"ZZFJ%02d;",vfo[VFO_B].filter);
-            send_resp(client->fd,reply) ;
-          } else if(command[6]==';') {
-            int filter=atoi(&command[4]);
-            // update RX2 filter
-          }
-          break;
-        case 'L': //ZZFL
-          // set/read RX1 filter low
-          if(command[4]==';') {
-            sprintf(reply,"ZZFL%05d;",receiver[0]->filter_low);
-            send_resp(client->fd,reply) ;
-          } else if(command[9]==';') {
-            int fl=atoi(&command[4]);
-            fl=fmin(9999,fl);
-            fl=fmax(-9999,fl);
-            // make sure filter is filterVar1
-            if(vfo[VFO_A].filter!=filterVar1) {
-              vfo_filter_changed(filterVar1);
-            }
-            FILTER *mode_filters=filters[vfo[VFO_A].mode];
-            FILTER *filter=&mode_filters[filterVar1];
-            filter->low=fl;
-            vfo_filter_changed(filterVar1);
-          }
-          break;
-        case 'M': //ZZFM
-          implemented=FALSE;
-          break;
-        case 'R': //ZZFR
-          implemented=FALSE;
-          break;
-        case 'S': //ZZFS
-          implemented=FALSE;
-          break;
-        case 'V': //ZZFV
-          implemented=FALSE;
-          break;
-        case 'W': //ZZFW
-          implemented=FALSE;
-          break;
-        case 'X': //ZZFX
-          implemented=FALSE;
-          break;
-        case 'Y': //ZZFY
-          implemented=FALSE;
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band60:
+      b=60;
       break;
-    case 'G': //ZZGx
-      switch(command[3]) {
-        case 'E': //ZZGE
-          implemented=FALSE;
-          break;
-        case 'L': //ZZGL
-          implemented=FALSE;
-          break;
-        case 'T': //ZZGT
-          // set/read RX1 AGC
-          if(command[4]==';') {
-            sprintf(reply,"ZZGT%d;",receiver[0]->agc);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            int agc=atoi(&command[4]);
-            // update RX1 AGC
-            receiver[0]->agc=agc;
-            vfo_update();
-          }
-          break;
-        case 'U': //ZZGU
-          // set/read RX2 AGC
-          if(command[4]==';') {
-            sprintf(reply,"ZZGU%d;",receiver[1]->agc);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            int agc=atoi(&command[4]);
-            // update RX2 AGC
-            receiver[1]->agc=agc;
-            vfo_update();
-          }
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band40:
+      b=40;
       break;
-    case 'H': //ZZHx
-      switch(command[3]) {
-        case 'A': //ZZHA
-          implemented=FALSE;
-          break;
-        case 'R': //ZZHR
-          implemented=FALSE;
-          break;
-        case 'T': //ZZHT
-          implemented=FALSE;
-          break;
-        case 'U': //ZZHU
-          implemented=FALSE;
-          break;
-        case 'V': //ZZHV
-          implemented=FALSE;
-          break;
-        case 'W': //ZZHW
-          implemented=FALSE;
-          break;
-        case 'X': //ZZHX
-          implemented=FALSE;
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band30:
+      b=30;
       break;
-    case 'I': //ZZIx
-      switch(command[3]) {
-        case 'D': //ZZID
-          strcpy(reply,"ZZID240;");
-          send_resp(client->fd,reply) ;
-          break;
-        case 'F': //ZZIF
-          implemented=FALSE;
-          break;
-        case 'O': //ZZIO
-          implemented=FALSE;
-          break;
-        case 'S': //ZZIS
-          implemented=FALSE;
-          break;
-        case 'T': //ZZIT
-          implemented=FALSE;
-          break;
-        case 'U': //ZZIU
-          implemented=FALSE;
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band20:
+      b=20;
       break;
-    case 'K': //ZZKx
-      switch(command[3]) {
-        case 'M': //ZZIM
-          implemented=FALSE;
-          break;
-        case 'O': //ZZIO
-          implemented=FALSE;
-          break;
-        case 'S': //ZZIS
-          implemented=FALSE;
-          break;
-        case 'Y': //ZZIY
-          implemented=FALSE;
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band17:
+      b=17;
       break;
-    case 'L': //ZZLx
-      switch(command[3]) {
-        case 'A': //ZZLA
-          // read/set RX0 gain
-          if(command[4]==';') {
-            // send reply back
-            sprintf(reply,"ZZLA%03d;",(int)(receiver[0]->volume*100.0));
-            send_resp(client->fd,reply) ;
-          } else {
-            int gain=atoi(&command[4]);
-            receiver[0]->volume=(double)gain/100.0;
-            update_af_gain();
-          }
-          break;
-        case 'B': //ZZLB
-          implemented=FALSE;
-          break;
-        case 'C': //ZZLC
-          // read/set RX1 gain
-          if(receivers==2) {
-            if(command[4]==';') {
-              // send reply back
-              sprintf(reply,"ZZLC%03d;",(int)(receiver[1]->volume*100.0));
-              send_resp(client->fd,reply) ;
-            } else {
-              int gain=atoi(&command[4]);
-              receiver[1]->volume=(double)gain/100.0;
-              update_af_gain();
-            }
-          }
-          break;
-        case 'D': //ZZLD
-          implemented=FALSE;
-          break;
-        case 'E': //ZZLE
-          implemented=FALSE;
-          break;
-        case 'F': //ZZLF
-          implemented=FALSE;
-          break;
-        case 'G': //ZZLG
-          implemented=FALSE;
-          break;
-        case 'H': //ZZLH
-          implemented=FALSE;
-          break;
-        case 'I': //ZZLI
-          if(transmitter!=NULL) {
-            if(command[4]==';') {
-              // send reply back
-              sprintf(reply,"ZZLI%d;",transmitter->puresignal);
-              send_resp(client->fd,reply) ;
-            } else {
-              int ps=atoi(&command[4]);
-              transmitter->puresignal=ps;
-            }
-            vfo_update();
-          }
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band15:
+      b=15;
       break;
-    case 'M': //ZZMx
-      switch(command[3]) {
-        case 'A': //ZZMA
-          implemented=FALSE;
-          break;
-        case 'B': //ZZMB
-          implemented=FALSE;
-          break;
-        case 'D': //ZZMD
-          // set/read RX1 operating mode
-          if(command[4]==';') {
-            sprintf(reply,"ZZMD%02d;",vfo[VFO_A].mode);
-            send_resp(client->fd,reply);
-          } else if(command[6]==';') {
-            vfo_mode_changed(atoi(&command[4]));
-          }
-          break;
-        case 'E': //ZZME
-          // set/read RX2 operating mode
-          if(command[4]==';') {
-            sprintf(reply,"ZZMD%02d;",vfo[VFO_B].mode);
-            send_resp(client->fd,reply);
-          } else if(command[6]==';') {
-            vfo_mode_changed(atoi(&command[4]));
-          }
-          break;
-        case 'G': //ZZMG
-          // set/read mic gain
-          if(command[4]==';') {
-            sprintf(reply,"ZZMG%03d;",(int)mic_gain);
-            send_resp(client->fd,reply);
-          } else if(command[7]==';') {
-            mic_gain=(double)atoi(&command[4]);
-          }
-          break;
-        case 'L': //ZZML
-          // read DSP modes and indexes
-          if(command[4]==';') {
-            sprintf(reply,"ZZML LSB00: USB01: DSB02: CWL03: CWU04: FMN05:  AM06:DIGU07:SPEC08:DIGL09: SAM10: DRM11;");
-            send_resp(client->fd,reply);
-          }
-          break;
-        case 'N': //ZZMN
-          // read Filter Names and indexes
-          if(command[6]==';') {
-            int mode=atoi(&command[4])-1;
-            FILTER *f=filters[mode];
-            sprintf(reply,"ZZMN");
-            char temp[32];
-            for(int i=0;i<FILTERS;i++) {
-              sprintf(temp,"%5s%5d%5d",f[i].title,f[i].high,f[i].low);
-              strcat(reply,temp);
-            }
-            strcat(reply,";");
-            send_resp(client->fd,reply);
-          }
-          break;
-        case 'O': //ZZMO
-          // set/read MON status
-          if(command[4]==';') {
-            sprintf(reply,"ZZMO%d;",0);
-            send_resp(client->fd,reply);
-          }
-          break;
-        case 'R': //ZZMR
-          // set/read RX Meter mode
-          if(command[4]==';') {
-            sprintf(reply,"ZZMR%d;",smeter+1);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            smeter=atoi(&command[4])-1;
-          }
-          break;
-        case 'S': //ZZMS
-          implemented=FALSE;
-          break;
-        case 'T': //ZZMT
-          if(command[4]==';') {
-            sprintf(reply,"ZZMT%02d;",1); // forward power
-            send_resp(client->fd,reply);
-          } else {
-          }
-          break;
-        case 'U': //ZZMU
-          implemented=FALSE;
-          break;
-        case 'V': //ZZMV
-          implemented=FALSE;
-          break;
-        case 'W': //ZZMW
-          implemented=FALSE;
-          break;
-        case 'X': //ZZMX
-          implemented=FALSE;
-          break;
-        case 'Y': //ZZMY
-          implemented=FALSE;
-          break;
-        case 'Z': //ZZMZ
-          implemented=FALSE;
-          break;
-        default:
-           implemented=FALSE;
-           break;
-
-      }
+    case band12:
+      b=12;
       break;
-    case 'N': //ZZNx
-      switch(command[3]) {
-        case 'A': //ZZNA
-          // set/read RX1 NB1
-          if(command[4]==';') {
-            sprintf(reply,"ZZNA%d;",receiver[0]->nb);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[0]->nb=atoi(&command[4]);
-            if(receiver[0]->nb) {
-              receiver[0]->nb2=0;
-            }
-            update_noise();
-          }
-          break;
-        case 'B': //ZZNB
-          // set/read RX1 NB2
-          if(command[4]==';') {
-            sprintf(reply,"ZZNB%d;",receiver[0]->nb2);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[0]->nb2=atoi(&command[4]);
-            if(receiver[0]->nb2) {
-              receiver[0]->nb=0;
-            }
-            update_noise();
-          }
-          break;
-        case 'C': //ZZNC
-          // set/read RX2 NB1
-          if(command[4]==';') {
-            sprintf(reply,"ZZNC%d;",receiver[1]->nb);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[1]->nb=atoi(&command[4]);
-            if(receiver[1]->nb) {
-              receiver[1]->nb2=0;
-            }
-            update_noise();
-          }
-          break;
-        case 'D': //ZZND
-          // set/read RX2 NB2
-          if(command[4]==';') {
-            sprintf(reply,"ZZND%d;",receiver[1]->nb2);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[1]->nb2=atoi(&command[4]);
-            if(receiver[1]->nb2) {
-              receiver[1]->nb=0;
-            }
-            update_noise();
-          }
-          break;
-        case 'L': //ZZNL
-          // set/read NB1 threshold
-          implemented=FALSE;
-          break;
-        case 'M': //ZZNM
-          // set/read NB2 threshold
-          implemented=FALSE;
-          break;
-        case 'N': //ZZNN
-          // set/read RX1 SNB status
-          if(command[4]==';') {
-            sprintf(reply,"ZZNN%d;",receiver[0]->snb);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[0]->snb=atoi(&command[4]);
-            update_noise();
-          }
-          break;
-        case 'O': //ZZNO
-          // set/read RX2 SNB status
-          if(command[4]==';') {
-            sprintf(reply,"ZZNO%d;",receiver[1]->snb);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[1]->snb=atoi(&command[4]);
-            update_noise();
-          }
-          break;
-        case 'R': //ZZNR
-          // set/read RX1 NR
-          if(command[4]==';') {
-            sprintf(reply,"ZZNR%d;",receiver[0]->nr);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[0]->nr=atoi(&command[4]);
-            if(receiver[0]->nr) {
-              receiver[0]->nr2=0;
-            }
-            update_noise();
-          }
-          break;
-        case 'S': //ZZNS
-          // set/read RX1 NR2
-          if(command[4]==';') {
-            sprintf(reply,"ZZNS%d;",receiver[0]->nr2);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[0]->nr2=atoi(&command[4]);
-            if(receiver[0]->nr2) {
-              receiver[0]->nr=0;
-            }
-            update_noise();
-          }
-          break;
-        case 'T': //ZZNT
-          // set/read RX1 ANF
-          if(command[4]==';') {
-            sprintf(reply,"ZZNT%d;",receiver[0]->anf);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[0]->anf=atoi(&command[4]);
-            update_noise();
-          }
-          break;
-        case 'U': //ZZNU
-          // set/read RX2 ANF
-          if(command[4]==';') {
-            sprintf(reply,"ZZNU%d;",receiver[1]->anf);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[1]->anf=atoi(&command[4]);
-            update_noise();
-          }
-          break;
-        case 'V': //ZZNV
-          // set/read RX2 NR
-          if(command[4]==';') {
-            sprintf(reply,"ZZNV%d;",receiver[1]->nr);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[1]->nr=atoi(&command[4]);
-            if(receiver[1]->nr) {
-              receiver[1]->nr2=0;
-            }
-            update_noise();
-          }
-          break;
-        case 'W': //ZZNW
-          // set/read RX2 NR2
-          if(command[4]==';') {
-            sprintf(reply,"ZZNW%d;",receiver[1]->nr2);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            receiver[1]->nr2=atoi(&command[4]);
-            if(receiver[1]->nr2) {
-              receiver[1]->nr=0;
-            }
-            update_noise();
-          }
-          break;
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band10:
+      b=10;
       break;
-    case 'O': //ZZOx
-      switch(command[3]) {
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case band6:
+      b=6;
       break;
-    case 'P': //ZZPx
-      switch(command[3]) {
-        case 'A': //ZZPA
-          // set/read preamp setting
-          if(command[4]==';') {
-            int a=adc[receiver[0]->adc].attenuation;
-            if(a==0) {
-              a=1;
-            } else if(a<=-30) {
-              a=4;
-            } else if(a<=-20) {
-              a=0;
-            } else if(a<=-10) {
-              a=2;
-            } else {
-              a=3;
-            }
-            sprintf(reply,"ZZPA%d;",a);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            int a=atoi(&command[4]);
-            switch(a) {
-              case 0:
-                adc[receiver[0]->adc].attenuation=-20;
-                break;
-              case 1:
-                adc[receiver[0]->adc].attenuation=0;
-                break;
-              case 2:
-                adc[receiver[0]->adc].attenuation=-10;
-                break;
-              case 3:
-                adc[receiver[0]->adc].attenuation=-20;
-                break;
-              case 4:
-                adc[receiver[0]->adc].attenuation=-30;
-                break;
-              default:
-                adc[receiver[0]->adc].attenuation=0;
-                break;
-            }
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case bandGen:
+      b=888;
       break;
-    case 'Q': //ZZQx
-      switch(command[3]) {
-        default:
-           implemented=FALSE;
-           break;
-      }
+    case bandWWV:
+      b=999;
       break;
-    case 'R': //ZZRx
-      switch(command[3]) {
-        case 'C': //ZZRC
-          // clear RIT frequency
-          if(command[4]==';') {
-            vfo[VFO_A].rit=0;
-            vfo_update();
-          }
-          break;
-        case 'D': //ZZRD
-          // decrement RIT frequency
-          if(command[4]==';') {
-            if(vfo[VFO_A].mode==modeCWL || vfo[VFO_A].mode==modeCWU) {
-              vfo[VFO_A].rit-=10;
-            } else {
-              vfo[VFO_A].rit-=rit_increment;
-            }
-            vfo_update();
-          } else if(command[9]==';') {
-            vfo[VFO_A].rit=atoi(&command[4]);
-            vfo_update();
-          }
-          break;
-        case 'F': //ZZRF
-          // set/read RIT frequency
-          if(command[4]==';') {
-            sprintf(reply,"ZZRF%+5lld;",vfo[VFO_A].rit);
-            send_resp(client->fd,reply);
-          } else if(command[9]==';') {
-            vfo[VFO_A].rit=atoi(&command[4]);
-            vfo_update();
-          }
-          break;
-        case 'M': //ZZRM
-          // read meter value
-          if(command[5]==';') {
-            int m=atoi(&command[4]);
-            sprintf(reply,"ZZRM%d%20d;",smeter,(int)receiver[0]->meter);
-            send_resp(client->fd,reply);
-          }
-          break;
-        case 'S': //ZZRS
-          // set/read RX2 enable
-          if(command[4]==';') {
-            sprintf(reply,"ZZRS%d;",receivers==2);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            int state=atoi(&command[4]);
-            if(state) {
-              radio_change_receivers(2);
-            } else {
-              radio_change_receivers(1);
-            }
-          }
-          break;
-        case 'T': //ZZRT
-          // set/read RIT enable
-          if(command[4]==';') {
-            sprintf(reply,"ZZRT%d;",vfo[VFO_A].rit_enabled);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            vfo[VFO_A].rit_enabled=atoi(&command[4]);
-            vfo_update();
-          }
-          break;
-        case 'U': //ZZRU
-          // increments RIT Frequency
-          if(command[4]==';') {
-            if(vfo[VFO_A].mode==modeCWL || vfo[VFO_A].mode==modeCWU) {
-              vfo[VFO_A].rit+=10;
-            } else {
-              vfo[VFO_A].rit+=rit_increment;
-            }
-            vfo_update();
-          } else if(command[9]==';') {
-            vfo[VFO_A].rit=atoi(&command[4]);
-            vfo_update();
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    default:
+      b=20;
       break;
-    case 'S': //ZZSx
-      switch(command[3]) {
-        case 'A': //ZZSA
-          // move VFO A down one step 
-          if(command[4]==';') {
-            vfo_step(-1);
-          }
-          break;
-        case 'B': //ZZSB
-          // move VFO A up one step 
-          if(command[4]==';') {
-            vfo_step(1);
-          }
-          break;
-        case 'D': //ZZSD
-          implemented=FALSE;
-          break;
-        case 'F': //ZZSF
-          implemented=FALSE;
-          break;
-        case 'G': //ZZSG
-          // move VFO B down 1 step
-          if(command[4]==';') {
-            vfo_id_step(VFO_B,-1);
-          }
-          break;
-        case 'H': //ZZSH
-          // move VFO B up 1 step
-          if(command[4]==';') {
-            vfo_id_step(VFO_B,1);
-          }
-          break;
-        case 'M': //ZZSM
-          // reads the S Meter (in dB)
-          if(command[5]==';') {
-            int v=atoi(&command[4]);
-            if(v==VFO_A || v==VFO_B) {
-              double m=receiver[v]->meter;
-              m=fmax(-140.0,m);
-              m=fmin(-10.0,m);
-              sprintf(reply,"ZZSM%d%03d;",v,(int)((m+140.0)*2));
-              send_resp(client->fd,reply);
-            }
-          }
-          break;
-        case 'N': //ZZSN
-          implemented=FALSE;
-          break;
-        case 'P': //ZZSP
-          // set/read split
-          if(command[4]==';') {
-            sprintf(reply,"ZZSP%d;",split);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-	    int val=atoi(&command[4]);
-            radio_set_split(val);
-          }
-          break;
-        case 'R': //ZZSR
-          implemented=FALSE;
-          break;
-        case 'S': //ZZSS
-          implemented=FALSE;
-          break;
-        case 'T': //ZZST
-          implemented=FALSE;
-          break;
-        case 'U': //ZZSU
-          implemented=FALSE;
-          break;
-        case 'V': //ZZSV
-          implemented=FALSE;
-          break;
-        case 'W': //ZZSW
-          // set/read split
-          if(command[4]==';') {
-            sprintf(reply,"ZZSW%d;",split);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            int val=atoi(&command[4]);
-            radio_set_split(val);
-          }
-          break;
-        case 'Y': //ZZSY
-          implemented=FALSE;
-          break;
-        case 'Z': //ZZSZ
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+  }
+  sprintf(reply,"ZZBS%03d;",b);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzbs_set(CLIENT *client,char *command) {
+  int band=band20;
+  int b=atoi(&command[4]);
+  switch(b) {
+    case 136:
+      band=band136;
       break;
-    case 'T': //ZZTx
-      switch(command[3]) {
-        case 'A': //ZZTA
-          implemented=FALSE;
-          break;
-        case 'B': //ZZTB
-          implemented=FALSE;
-          break;
-        case 'F': //ZZTF
-          implemented=FALSE;
-          break;
-        case 'H': //ZZTH
-          implemented=FALSE;
-          break;
-        case 'I': //ZZTI
-          implemented=FALSE;
-          break;
-        case 'L': //ZZTL
-          implemented=FALSE;
-          break;
-        case 'M': //ZZTM
-          implemented=FALSE;
-          break;
-        case 'O': //ZZTO
-          implemented=FALSE;
-          break;
-        case 'P': //ZZTP
-          implemented=FALSE;
-          break;
-        case 'S': //ZZTS
-          implemented=FALSE;
-          break;
-        case 'U': //ZZTU
-          // sets or reads TUN status
-          if(command[4]==';') {
-            sprintf(reply,"ZZTU%d;",tune);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            tune_update(atoi(&command[4]));
-          }
-          break;
-        case 'V': //ZZTV
-          implemented=FALSE;
-          break;
-        case 'X': //ZZTX
-          // sets or reads MOX status
-          if(command[4]==';') {
-            sprintf(reply,"ZZTX%d;",mox);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            mox_update(atoi(&command[4]));
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 472:
+      band=band472;
       break;
-    case 'U': //ZZUx
-      switch(command[3]) {
-        case 'A': //ZZUA
-          implemented=FALSE;
-          break;
-        case 'S': //ZZUS
-          implemented=FALSE;
-          break;
-        case 'T': //ZZUT
-          implemented=FALSE;
-          break;
-        case 'X': //ZZUX
-          implemented=FALSE;
-          break;
-        case 'Y': //ZZUY
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 160:
+      band=band160;
       break;
-    case 'V': //ZZVx
-      switch(command[3]) {
-        case 'A': //ZZVA
-          implemented=FALSE;
-          break;
-        case 'B': //ZZVB
-          implemented=FALSE;
-          break;
-        case 'C': //ZZVC
-          implemented=FALSE;
-          break;
-        case 'D': //ZZVD
-          implemented=FALSE;
-          break;
-        case 'E': //ZZVE
-          implemented=FALSE;
-          break;
-        case 'F': //ZZVF
-          implemented=FALSE;
-          break;
-        case 'H': //ZZVH
-          implemented=FALSE;
-          break;
-        case 'I': //ZZVI
-          implemented=FALSE;
-          break;
-        case 'J': //ZZVJ
-          implemented=FALSE;
-          break;
-        case 'K': //ZZVK
-          implemented=FALSE;
-          break;
-        case 'L': //ZZVL
-          // set/get VFO Lock
-          implemented=FALSE;
-          break;
-        case 'M': //ZZVM
-          implemented=FALSE;
-          break;
-        case 'N': //ZZVN
-          implemented=FALSE;
-          break;
-        case 'O': //ZZVO
-          implemented=FALSE;
-          break;
-        case 'P': //ZZVP
-          implemented=FALSE;
-          break;
-        case 'Q': //ZZVQ
-          implemented=FALSE;
-          break;
-        case 'R': //ZZVR
-          implemented=FALSE;
-          break;
-        case 'S': //ZZVS
-          implemented=FALSE;
-          break;
-        case 'T': //ZZVT
-          implemented=FALSE;
-          break;
-        case 'U': //ZZVU
-          implemented=FALSE;
-          break;
-        case 'V': //ZZVV
-          implemented=FALSE;
-          break;
-        case 'W': //ZZVW
-          implemented=FALSE;
-          break;
-        case 'X': //ZZVX
-          implemented=FALSE;
-          break;
-        case 'Y': //ZZVY
-          implemented=FALSE;
-          break;
-        case 'Z': //ZZVZ
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 80:
+      band=band80;
       break;
-    case 'W': //ZZWx
-      switch(command[3]) {
-        case 'A': //ZZWA
-          implemented=FALSE;
-          break;
-        case 'B': //ZZWB
-          implemented=FALSE;
-          break;
-        case 'C': //ZZWC
-          implemented=FALSE;
-          break;
-        case 'D': //ZZWD
-          implemented=FALSE;
-          break;
-        case 'E': //ZZWE
-          implemented=FALSE;
-          break;
-        case 'F': //ZZWF
-          implemented=FALSE;
-          break;
-        case 'G': //ZZWG
-          implemented=FALSE;
-          break;
-        case 'H': //ZZWH
-          implemented=FALSE;
-          break;
-        case 'J': //ZZWJ
-          implemented=FALSE;
-          break;
-        case 'K': //ZZWK
-          implemented=FALSE;
-          break;
-        case 'L': //ZZWL
-          implemented=FALSE;
-          break;
-        case 'M': //ZZWM
-          implemented=FALSE;
-          break;
-        case 'N': //ZZWN
-          implemented=FALSE;
-          break;
-        case 'O': //ZZWO
-          implemented=FALSE;
-          break;
-        case 'P': //ZZWP
-          implemented=FALSE;
-          break;
-        case 'Q': //ZZWQ
-          implemented=FALSE;
-          break;
-        case 'R': //ZZWR
-          implemented=FALSE;
-          break;
-        case 'S': //ZZWS
-          implemented=FALSE;
-          break;
-        case 'T': //ZZWT
-          implemented=FALSE;
-          break;
-        case 'U': //ZZWU
-          implemented=FALSE;
-          break;
-        case 'V': //ZZWV
-          implemented=FALSE;
-          break;
-        case 'W': //ZZWW
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 60:
+      band=band60;
       break;
-    case 'X': //ZZXx
-      switch(command[3]) {
-        case 'C': //ZZXC
-          // clear transmitter XIT
-          if(command[4]==';') {
-            transmitter->xit=0;
-            vfo_update();
-          }
-          break;
-        case 'F': //ZZXF
-          // set/read XIT
-          if(command[4]==';') {
-            sprintf(reply,"ZZXT%+05lld;",transmitter->xit);
-            send_resp(client->fd,reply) ;
-          } else if(command[9]==';') {
-            transmitter->xit=(long long)atoi(&command[4]);
-            vfo_update();
-          }
-          break;
-        case 'H': //ZZXH
-          implemented=FALSE;
-          break;
-        case 'N': //ZZXN
-          // read combined RX1 status
-          if(command[4]==';') {
-            int status=0;
-            status=status|((receiver[0]->agc)&0x03);
-            int a=adc[receiver[0]->adc].attenuation;
-            if(a==0) {
-              a=1;
-            } else if(a<=-30) {
-              a=4;
-            } else if(a<=-20) {
-              a=0;
-            } else if(a<=-10) {
-              a=2;
-            } else {
-              a=3;
-            }
-            status=status|((a&0x03)<<3);
-            status=status|((receiver[0]->squelch_enable&0x01)<<6);
-            status=status|((receiver[0]->nb&0x01)<<7);
-            status=status|((receiver[0]->nb2&0x01)<<8);
-            status=status|((receiver[0]->nr&0x01)<<9);
-            status=status|((receiver[0]->nr2&0x01)<<10);
-            status=status|((receiver[0]->snb&0x01)<<11);
-            status=status|((receiver[0]->anf&0x01)<<12);
-            sprintf(reply,"ZZXN%04d;",status);
-            send_resp(client->fd,reply);
-          }
-          break;
-        case 'O': //ZZXO
-          // read combined RX2 status
-          if(receivers==2) {
-            if(command[4]==';') {
-              int status=0;
-              status=status|((receiver[1]->agc)&0x03);
-              int a=adc[receiver[1]->adc].attenuation;
-              if(a==0) {
-                a=1;
-              } else if(a<=-30) {
-                a=4;
-              } else if(a<=-20) {
-                a=0;
-              } else if(a<=-10) {
-                a=2;
-              } else {
-                a=3;
-              }
-              status=status|((a&0x03)<<3);
-              status=status|((receiver[1]->squelch_enable&0x01)<<6);
-              status=status|((receiver[1]->nb&0x01)<<7);
-              status=status|((receiver[1]->nb2&0x01)<<8);
-              status=status|((receiver[1]->nr&0x01)<<9);
-              status=status|((receiver[1]->nr2&0x01)<<10);
-              status=status|((receiver[1]->snb&0x01)<<11);
-              status=status|((receiver[1]->anf&0x01)<<12);
-              sprintf(reply,"ZZXO%04d;",status);
-              send_resp(client->fd,reply);
-            }
-          }
-          break;
-        case 'S': //ZZXS
-          /// set/read XIT enable
-          if(command[4]==';') {
-            sprintf(reply,"ZZXS%d;",transmitter->xit_enabled);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            transmitter->xit_enabled=atoi(&command[4]);
-            vfo_update();
-          }
-          break;
-        case 'T': //ZZXT
-          implemented=FALSE;
-          break;
-        case 'V': //ZZXV
-          // read combined VFO status
-          if(command[4]==';') {
-            int status=0;
-            if(vfo[VFO_A].rit_enabled) {
-              status=status|0x01;
-            }
-            if(locked) {
-              status=status|0x02;
-              status=status|0x04;
-            }
-            if(split) {
-              status=status|0x08;
-            }
-            if(vfo[VFO_A].ctun) {
-              status=status|0x10;
-            }
-            if(vfo[VFO_B].ctun) {
-              status=status|0x20;
-            }
-            if(mox) {
-              status=status|0x40;
-            }
-            if(tune) {
-              status=status|0x80;
-            }
-            sprintf(reply,"ZZXV%03d;",status);
-            send_resp(client->fd,reply);
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 40:
+      band=band40;
       break;
-    case 'Y': //ZZYx
-      switch(command[3]) {
-	case 'A': //ZZYA
-          implemented=FALSE;
-          break;
-	case 'B': //ZZYB
-          implemented=FALSE;
-          break;
-	case 'C': //ZZYC
-          implemented=FALSE;
-          break;
-	case 'R': //ZZYR
-          // switch receivers
-          if(command[5]==';') {
-            int v=atoi(&command[4]);
-            if(v==0) {
-              active_receiver=receiver[0];
-            } else if(v==1) {
-              if(receivers==2) {
-                active_receiver=receiver[1];
-              }
-            }
-            vfo_update();
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 30:
+      band=band30;
+      break;
+    case 20:
+      band=band20;
+      break;
+    case 17:
+      band=band17;
+      break;
+    case 15:
+      band=band15;
+      break;
+    case 12:
+      band=band12;
+      break;
+    case 10:
+      band=band10;
+      break;
+    case 6:
+      band=band6;
+      break;
+    case 888:
+      band=bandGen;
+      break;
+    case 999:
+      band=bandWWV;
+      break;
+  }
+  vfo_band_changed(VFO_A,band);
+  return TRUE;
+}
+
+// set/read RX2 band switch
+static gboolean cat_zzbt(CLIENT *client,char *command) {
+  return TRUE;
+}
+
+// move RX1 up one band
+static gboolean cat_zzbu_set(CLIENT *client,char *command) {
+  band_plus(receiver[0]->id);
+  return TRUE;
+}
+
+// closes console (ignored)
+static gboolean cat_zzby(CLIENT *client,char *command) {
+  return TRUE;
+}
+
+// VFO A to B
+static gboolean cat_zzcb(CLIENT *client,char *command) {
+  if(!locked) {
+    if(command[4]==';') {
+      vfo_a_to_b();
+    }
+  }
+  return TRUE;
+}
+
+// VFO B to A
+static gboolean cat_zzcd(CLIENT *client,char *command) {
+  if(!locked) {
+    if(command[4]==';') {
+      vfo_b_to_a();
+    }
+  }
+  return TRUE;
+}
+
+// Swap VFO A and B
+static gboolean cat_zzcf(CLIENT *client,char *command) {
+  if(!locked) {
+    if(command[4]==';') {
+      vfo_a_swap_b();
+    }
+  }
+  return TRUE;
+}
+
+// set/read VFO A CTUN
+static gboolean cat_zzcn_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  // return the CTUN status
+  sprintf(reply,"ZZCN%d;",vfo[VFO_A].ctun);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzcn_set(CLIENT *client,char *command) {
+  int state=atoi(&command[4]);
+  ctun_update(VFO_A,state);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read VFO B CTUN
+static gboolean cat_zzco_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  // return the CTUN status
+  sprintf(reply,"ZZCO%d;",vfo[VFO_B].ctun);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzco_set(CLIENT *client,char *command) {
+  int state=atoi(&command[4]);
+  ctun_update(VFO_B,state);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read compander
+static gboolean cat_zzcp_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZCP%d;",0);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzda(CLIENT *client,char *command) {
+  return TRUE;
+}
+
+// set/read RX Reference
+static gboolean cat_zzdb_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZDB%d;",0); // currently always 0
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+// set/get diversity gain
+static gboolean cat_zzdc_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZDC%04d;",(int)div_gain);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+// set/get diversity phase
+static gboolean cat_zzdd_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZDD%04d;",(int)div_phase);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+// set/read Display Mode
+static gboolean cat_zzdm_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  int v=0;
+  if(active_receiver->display_waterfall) {
+    v=8;
+  } else {
+    v=2;
+  }
+  sprintf(reply,"ZZDM%d;",v);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+// set/read waterfall low
+static gboolean cat_zzdn_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZDN%+4d;",active_receiver->waterfall_low);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+// set/read waterfall high
+static gboolean cat_zzdo_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZDO%+4d;",active_receiver->waterfall_high);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+// set/read panadapter high
+static gboolean cat_zzdp_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZDP%+4d;",active_receiver->panadapter_high);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+// set/read panadapter low
+static gboolean cat_zzdq_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZDQ%+4d;",active_receiver->panadapter_low);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+// set/read panadapter step
+static gboolean cat_zzdr_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZDR%2d;",active_receiver->panadapter_step);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+// set/read rx equalizer values
+static gboolean cat_zzea_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZEA%03d%03d%03d%03d%03d00000000000000000000;",3,rx_equalizer[0],rx_equalizer[1],rx_equalizer[2],rx_equalizer[3]);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzea_set(CLIENT *client,char *command) {
+  char temp[4];
+  temp[3]='\0';
+  strncpy(temp,&command[4],3);
+  int bands=atoi(temp);
+  if(bands==3) {
+    strncpy(temp,&command[7],3);
+    rx_equalizer[0]=atoi(temp);
+    strncpy(temp,&command[10],3);
+    rx_equalizer[1]=atoi(temp);
+    strncpy(temp,&command[13],3);
+    rx_equalizer[2]=atoi(temp);
+  } else {
+  }
+  return TRUE;
+}
+
+// set/read tx equalizer values
+static gboolean cat_zzeb_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZEB%03d%03d%03d%03d%03d00000000000000000000;",3,tx_equalizer[0],tx_equalizer[1],tx_equalizer[2],tx_equalizer[3]);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzeb_set(CLIENT *client,char *command) {
+  char temp[4];
+  temp[3]='\0';
+  strncpy(temp,&command[4],3);
+  int bands=atoi(temp);
+  if(bands==3) {
+    strncpy(temp,&command[7],3);
+    tx_equalizer[0]=atoi(temp);
+    strncpy(temp,&command[10],3);
+    tx_equalizer[1]=atoi(temp);
+    strncpy(temp,&command[13],3);
+    tx_equalizer[2]=atoi(temp);
+  } else {
+  }
+  return TRUE;
+}
+
+// set/read rx equalizer
+static gboolean cat_zzer_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZER%d;",enable_rx_equalizer);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzer_set(CLIENT *client,char *command) {
+  enable_rx_equalizer=atoi(&command[4]);
+  return TRUE;
+}
+
+// set/read tx equalizer
+static gboolean cat_zzet_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZET%d;",enable_tx_equalizer);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzet_set(CLIENT *client,char *command) {
+  enable_tx_equalizer=atoi(&command[4]);
+  return TRUE;
+}
+
+// set/read VFO-A frequency
+static gboolean cat_zzfa_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  if(vfo[VFO_A].ctun) {
+    sprintf(reply,"ZZFA%011lld;",vfo[VFO_A].ctun_frequency);
+  } else {
+    sprintf(reply,"ZZFA%011lld;",vfo[VFO_A].frequency);
+  }
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzfa_set(CLIENT *client,char *command) {
+  long long f=atoll(&command[4]);
+  vfo_set_frequency(VFO_A,f);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read VFO-B frequency
+static gboolean cat_zzfb_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  if(vfo[VFO_B].ctun) {
+    sprintf(reply,"ZZFB%011lld;",vfo[VFO_B].ctun_frequency);
+  } else {
+    sprintf(reply,"ZZFB%011lld;",vfo[VFO_B].frequency);
+  }
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzfb_set(CLIENT *client,char *command) {
+  long long f=atoll(&command[4]);
+  vfo_set_frequency(VFO_B,f);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read deviation
+static gboolean cat_zzfd_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZFD%d;",active_receiver->deviation==2500?0:1);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzfd_set(CLIENT *client,char *command) {
+  int d=atoi(&command[4]);
+  if(d==0) {
+    active_receiver->deviation=2500;
+  } else if(d==1) {
+    active_receiver->deviation=5000;
+  } else {
+  }
+  vfo_update();
+  return TRUE;
+}
+
+// set/read RX1 filter high
+static gboolean cat_zzfh_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZFH%05d;",receiver[0]->filter_high);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzfh_set(CLIENT *client,char *command) {
+  int fh=atoi(&command[4]);
+  fh=fmin(9999,fh);
+  fh=fmax(-9999,fh);
+  // make sure filter is filterVar1
+  if(vfo[VFO_A].filter!=filterVar1) {
+    vfo_filter_changed(filterVar1);
+  }
+  FILTER *mode_filters=filters[vfo[VFO_A].mode];
+  FILTER *filter=&mode_filters[filterVar1];
+  filter->high=fh;
+  vfo_filter_changed(filterVar1);
+  return TRUE;
+}
+
+// set/read RX1 DSP receive filter
+static gboolean cat_zzfi_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZFI%02d;",vfo[VFO_A].filter);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzfi_set(CLIENT *client,char *command) {
+  int filter=atoi(&command[4]);
+  // update RX1 filter
+  vfo_filter_changed(filter);
+  return TRUE;
+}
+
+// set/read RX2 DSP receive filter
+static gboolean cat_zzfj_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZFJ%02d;",vfo[VFO_B].filter);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzfj_set(CLIENT *client,char *command) {
+  int filter=atoi(&command[4]);
+  // update RX2 filter
+  return TRUE;
+}
+
+// set/read RX1 filter low
+static gboolean cat_zzfl_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZFL%05d;",receiver[0]->filter_low);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzfl_set(CLIENT *client,char *command) {
+  int fl=atoi(&command[4]);
+  fl=fmin(9999,fl);
+  fl=fmax(-9999,fl);
+  // make sure filter is filterVar1
+  if(vfo[VFO_A].filter!=filterVar1) {
+    vfo_filter_changed(filterVar1);
+  }
+  FILTER *mode_filters=filters[vfo[VFO_A].mode];
+  FILTER *filter=&mode_filters[filterVar1];
+  filter->low=fl;
+  vfo_filter_changed(filterVar1);
+  return TRUE;
+}
+
+// set/read RX1 AGC
+static gboolean cat_zzgt_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZGT%d;",receiver[0]->agc);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzgt_set(CLIENT *client,char *command) {
+  int agc=atoi(&command[4]);
+  // update RX1 AGC
+  receiver[0]->agc=agc;
+  vfo_update();
+  return TRUE;
+}
+
+// set/read RX2 AGC
+static gboolean cat_zzgu_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZGU%d;",receiver[1]->agc);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzgu_set(CLIENT *client,char *command) {
+  int agc=atoi(&command[4]);
+  // update RX2 AGC
+  receiver[1]->agc=agc;
+  vfo_update();
+  return TRUE;
+}
+
+static gboolean cat_zzid(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  strcpy(reply,"ZZID240;");
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+// read the counters of a packet stream received from the radio
+// ZZJSnn; (nn = stream, see stream_stats.h) returns
+// ZZJSnn, received (10 digits), lost, reordered, duplicated, late,
+// and the median, 99th percentile and maximum of the intervals
+// between the packets in usec (8 digits each).
+// ZZJS99; resets the counters of all packet streams (no reply).
+#define ZZJS_RESET 99
+
+static gboolean cat_zzjs_query(CLIENT *client,char *command) {
+  char reply[256];
+  STREAM_STATS s;
+  int stream;
+
+  if(!g_ascii_isdigit(command[4]) || !g_ascii_isdigit(command[5])) return FALSE;
+  stream=atoi(&command[4]);
+  if(stream==ZZJS_RESET) {
+    stream_stats_reset();
+    return TRUE;
+  }
+  if(stream>=STREAMS) return FALSE;
+  stream_stats_get(stream,&s);
+  sprintf(reply,"ZZJS%02d%010d%08d%08d%08d%08d%08d%08d%08d;",stream,
+          s.received,MAX(s.lost,0),s.reordered,s.duplicated,s.late,
+          MAX(stream_stats_percentile(&s,50),0),MAX(stream_stats_percentile(&s,99),0),s.maximum);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// read/set RX0 gain
+static gboolean cat_zzla_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  // send reply back
+  sprintf(reply,"ZZLA%03d;",(int)(receiver[0]->volume*100.0));
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzla_set(CLIENT *client,char *command) {
+  int gain=atoi(&command[4]);
+  receiver[0]->volume=(double)gain/100.0;
+  update_af_gain();
+  return TRUE;
+}
+
+// read/set RX1 gain
+static gboolean cat_zzlc(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  if(receivers==2) {
+    if(command[4]==';') {
+      // send reply back
+      sprintf(reply,"ZZLC%03d;",(int)(receiver[1]->volume*100.0));
+      send_resp(client,reply) ;
+    } else {
+      int gain=atoi(&command[4]);
+      receiver[1]->volume=(double)gain/100.0;
+      update_af_gain();
+    }
+  }
+  return TRUE;
+}
+
+static gboolean cat_zzli(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  if(transmitter!=NULL) {
+    if(command[4]==';') {
+      // send reply back
+      sprintf(reply,"ZZLI%d;",transmitter->puresignal);
+      send_resp(client,reply) ;
+    } else {
+      int ps=atoi(&command[4]);
+      transmitter->puresignal=ps;
+    }
+    vfo_update();
+  }
+  return TRUE;
+}
+
+// set/read RX1 operating mode
+static gboolean cat_zzmd_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZMD%02d;",vfo[VFO_A].mode);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzmd_set(CLIENT *client,char *command) {
+  vfo_mode_changed(atoi(&command[4]));
+  return TRUE;
+}
+
+// set/read RX2 operating mode
+static gboolean cat_zzme_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZMD%02d;",vfo[VFO_B].mode);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzme_set(CLIENT *client,char *command) {
+  vfo_mode_changed(atoi(&command[4]));
+  return TRUE;
+}
+
+// set/read mic gain
+static gboolean cat_zzmg_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZMG%03d;",(int)mic_gain);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzmg_set(CLIENT *client,char *command) {
+  mic_gain=(double)atoi(&command[4]);
+  return TRUE;
+}
+
+// read DSP modes and indexes
+static gboolean cat_zzml_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZML LSB00: USB01: DSB02: CWL03: CWU04: FMN05:  AM06:DIGU07:SPEC08:DIGL09: SAM10: DRM11;");
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// read Filter Names and indexes
+static gboolean cat_zzmn_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  int mode=atoi(&command[4])-1;
+  FILTER *f=filters[mode];
+  sprintf(reply,"ZZMN");
+  char temp[32];
+  for(int i=0;i<FILTERS;i++) {
+    sprintf(temp,"%5s%5d%5d",f[i].title,f[i].high,f[i].low);
+    strcat(reply,temp);
+  }
+  strcat(reply,";");
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// set/read MON status
+static gboolean cat_zzmo_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZMO%d;",0);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// set/read RX Meter mode
+static gboolean cat_zzmr_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZMR%d;",smeter+1);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzmr_set(CLIENT *client,char *command) {
+  smeter=atoi(&command[4])-1;
+  return TRUE;
+}
+
+static gboolean cat_zzmt_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZMT%02d;",1); // forward power
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// set/read RX1 NB1
+static gboolean cat_zzna_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNA%d;",receiver[0]->nb);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzna_set(CLIENT *client,char *command) {
+  receiver[0]->nb=atoi(&command[4]);
+  if(receiver[0]->nb) {
+    receiver[0]->nb2=0;
+  }
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX1 NB2
+static gboolean cat_zznb_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNB%d;",receiver[0]->nb2);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zznb_set(CLIENT *client,char *command) {
+  receiver[0]->nb2=atoi(&command[4]);
+  if(receiver[0]->nb2) {
+    receiver[0]->nb=0;
+  }
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX2 NB1
+static gboolean cat_zznc_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNC%d;",receiver[1]->nb);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zznc_set(CLIENT *client,char *command) {
+  receiver[1]->nb=atoi(&command[4]);
+  if(receiver[1]->nb) {
+    receiver[1]->nb2=0;
+  }
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX2 NB2
+static gboolean cat_zznd_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZND%d;",receiver[1]->nb2);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zznd_set(CLIENT *client,char *command) {
+  receiver[1]->nb2=atoi(&command[4]);
+  if(receiver[1]->nb2) {
+    receiver[1]->nb=0;
+  }
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX1 SNB status
+static gboolean cat_zznn_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNN%d;",receiver[0]->snb);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zznn_set(CLIENT *client,char *command) {
+  receiver[0]->snb=atoi(&command[4]);
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX2 SNB status
+static gboolean cat_zzno_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNO%d;",receiver[1]->snb);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzno_set(CLIENT *client,char *command) {
+  receiver[1]->snb=atoi(&command[4]);
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX1 NR
+static gboolean cat_zznr_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNR%d;",receiver[0]->nr);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zznr_set(CLIENT *client,char *command) {
+  receiver[0]->nr=atoi(&command[4]);
+  if(receiver[0]->nr) {
+    receiver[0]->nr2=0;
+  }
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX1 NR2
+static gboolean cat_zzns_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNS%d;",receiver[0]->nr2);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzns_set(CLIENT *client,char *command) {
+  receiver[0]->nr2=atoi(&command[4]);
+  if(receiver[0]->nr2) {
+    receiver[0]->nr=0;
+  }
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX1 ANF
+static gboolean cat_zznt_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNT%d;",receiver[0]->anf);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zznt_set(CLIENT *client,char *command) {
+  receiver[0]->anf=atoi(&command[4]);
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX2 ANF
+static gboolean cat_zznu_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNU%d;",receiver[1]->anf);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zznu_set(CLIENT *client,char *command) {
+  receiver[1]->anf=atoi(&command[4]);
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX2 NR
+static gboolean cat_zznv_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNV%d;",receiver[1]->nr);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zznv_set(CLIENT *client,char *command) {
+  receiver[1]->nr=atoi(&command[4]);
+  if(receiver[1]->nr) {
+    receiver[1]->nr2=0;
+  }
+  update_noise();
+  return TRUE;
+}
+
+// set/read RX2 NR2
+static gboolean cat_zznw_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZNW%d;",receiver[1]->nr2);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zznw_set(CLIENT *client,char *command) {
+  receiver[1]->nr2=atoi(&command[4]);
+  if(receiver[1]->nr2) {
+    receiver[1]->nr=0;
+  }
+  update_noise();
+  return TRUE;
+}
+
+// set/read preamp setting
+static gboolean cat_zzpa_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  int a=adc[receiver[0]->adc].attenuation;
+  if(a==0) {
+    a=1;
+  } else if(a<=-30) {
+    a=4;
+  } else if(a<=-20) {
+    a=0;
+  } else if(a<=-10) {
+    a=2;
+  } else {
+    a=3;
+  }
+  sprintf(reply,"ZZPA%d;",a);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzpa_set(CLIENT *client,char *command) {
+  int a=atoi(&command[4]);
+  switch(a) {
+    case 0:
+      adc[receiver[0]->adc].attenuation=-20;
+      break;
+    case 1:
+      adc[receiver[0]->adc].attenuation=0;
+      break;
+    case 2:
+      adc[receiver[0]->adc].attenuation=-10;
+      break;
+    case 3:
+      adc[receiver[0]->adc].attenuation=-20;
+      break;
+    case 4:
+      adc[receiver[0]->adc].attenuation=-30;
+      break;
+    default:
+      adc[receiver[0]->adc].attenuation=0;
+      break;
+  }
+  return TRUE;
+}
+
+// clear RIT frequency
+static gboolean cat_zzrc_set(CLIENT *client,char *command) {
+  vfo[VFO_A].rit=0;
+  vfo_update();
+  return TRUE;
+}
+
+// decrement RIT frequency
+static gboolean cat_zzrd_query(CLIENT *client,char *command) {
+  if(vfo[VFO_A].mode==modeCWL || vfo[VFO_A].mode==modeCWU) {
+    vfo[VFO_A].rit-=10;
+  } else {
+    vfo[VFO_A].rit-=rit_increment;
+  }
+  vfo_update();
+  return TRUE;
+}
+
+static gboolean cat_zzrd_set(CLIENT *client,char *command) {
+  vfo[VFO_A].rit=atoi(&command[4]);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read RIT frequency
+static gboolean cat_zzrf_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZRF%+5lld;",vfo[VFO_A].rit);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzrf_set(CLIENT *client,char *command) {
+  vfo[VFO_A].rit=atoi(&command[4]);
+  vfo_update();
+  return TRUE;
+}
+
+// read meter value
+static gboolean cat_zzrm_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  int m=atoi(&command[4]);
+  sprintf(reply,"ZZRM%d%20d;",smeter,(int)receiver[0]->meter);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// set/read RX2 enable
+static gboolean cat_zzrs_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZRS%d;",receivers==2);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzrs_set(CLIENT *client,char *command) {
+  int state=atoi(&command[4]);
+  if(state) {
+    radio_change_receivers(2);
+  } else {
+    radio_change_receivers(1);
+  }
+  return TRUE;
+}
+
+// set/read RIT enable
+static gboolean cat_zzrt_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZRT%d;",vfo[VFO_A].rit_enabled);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzrt_set(CLIENT *client,char *command) {
+  vfo[VFO_A].rit_enabled=atoi(&command[4]);
+  vfo_update();
+  return TRUE;
+}
+
+// increments RIT Frequency
+static gboolean cat_zzru_query(CLIENT *client,char *command) {
+  if(vfo[VFO_A].mode==modeCWL || vfo[VFO_A].mode==modeCWU) {
+    vfo[VFO_A].rit+=10;
+  } else {
+    vfo[VFO_A].rit+=rit_increment;
+  }
+  vfo_update();
+  return TRUE;
+}
+
+static gboolean cat_zzru_set(CLIENT *client,char *command) {
+  vfo[VFO_A].rit=atoi(&command[4]);
+  vfo_update();
+  return TRUE;
+}
+
+// move VFO A down one step
+static gboolean cat_zzsa_set(CLIENT *client,char *command) {
+  vfo_step(-1);
+  return TRUE;
+}
+
+// move VFO A up one step
+static gboolean cat_zzsb_set(CLIENT *client,char *command) {
+  vfo_step(1);
+  return TRUE;
+}
+
+// move VFO B down 1 step
+static gboolean cat_zzsg_set(CLIENT *client,char *command) {
+  vfo_id_step(VFO_B,-1);
+  return TRUE;
+}
+
+// move VFO B up 1 step
+static gboolean cat_zzsh_set(CLIENT *client,char *command) {
+  vfo_id_step(VFO_B,1);
+  return TRUE;
+}
+
+// reads the frequency (11 digits) and the signal level (in dBm) of
+// slice nn (see slice.h)
+static gboolean cat_zzsl_query(CLIENT *client,char *command) {
+  char reply[256];
+  long long f;
+  double m;
+  int n;
+
+  if(!g_ascii_isdigit(command[4]) || !g_ascii_isdigit(command[5])) return FALSE;
+  n=atoi(&command[4]);
+  if(n>=slices) return FALSE;
+  g_mutex_lock(&slice[n].mutex);
+  f=slice[n].frequency;
+  m=slice[n].meter;
+  g_mutex_unlock(&slice[n].mutex);
+  m=fmax(-140.0,m);
+  m=fmin(-10.0,m);
+  sprintf(reply,"ZZSL%02d%011lld%+04d;",n,f,(int)m);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// sets the frequency of slice nn (ZZSLnnfffffffffff;)
+static gboolean cat_zzsl_set(CLIENT *client,char *command) {
+  int n;
+
+  if(!g_ascii_isdigit(command[4]) || !g_ascii_isdigit(command[5])) return FALSE;
+  n=(command[4]-'0')*10+(command[5]-'0');
+  if(n>=slices) return FALSE;
+  slice_set_frequency(&slice[n],atoll(&command[6]));
+  return TRUE;
+}
+
+// reads the S Meter (in dB)
+static gboolean cat_zzsm_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  int v=atoi(&command[4]);
+  if(v==VFO_A || v==VFO_B) {
+    double m=receiver[v]->meter;
+    m=fmax(-140.0,m);
+    m=fmin(-10.0,m);
+    sprintf(reply,"ZZSM%d%03d;",v,(int)((m+140.0)*2));
+    send_resp(client,reply);
+  }
+  return TRUE;
+}
+
+// set/read split
+static gboolean cat_zzsp_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZSP%d;",split);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzsp_set(CLIENT *client,char *command) {
+  int val=atoi(&command[4]);
+  radio_set_split(val);
+  return TRUE;
+}
+
+// set/read split
+static gboolean cat_zzsw_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZSW%d;",split);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzsw_set(CLIENT *client,char *command) {
+  int val=atoi(&command[4]);
+  radio_set_split(val);
+  return TRUE;
+}
+
+// sets or reads TUN status
+static gboolean cat_zztu_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZTU%d;",tune);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zztu_set(CLIENT *client,char *command) {
+  tune_update(atoi(&command[4]));
+  return TRUE;
+}
+
+// sets or reads MOX status
+static gboolean cat_zztx_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZTX%d;",mox);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zztx_set(CLIENT *client,char *command) {
+  mox_update(atoi(&command[4]));
+  return TRUE;
+}
+
+// clear transmitter XIT
+static gboolean cat_zzxc_set(CLIENT *client,char *command) {
+  transmitter->xit=0;
+  vfo_update();
+  return TRUE;
+}
+
+// set/read XIT
+static gboolean cat_zzxf_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZXT%+05lld;",transmitter->xit);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_zzxf_set(CLIENT *client,char *command) {
+  transmitter->xit=(long long)atoi(&command[4]);
+  vfo_update();
+  return TRUE;
+}
+
+// read combined RX1 status
+static gboolean cat_zzxn_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  int status=0;
+  status=status|((receiver[0]->agc)&0x03);
+  int a=adc[receiver[0]->adc].attenuation;
+  if(a==0) {
+    a=1;
+  } else if(a<=-30) {
+    a=4;
+  } else if(a<=-20) {
+    a=0;
+  } else if(a<=-10) {
+    a=2;
+  } else {
+    a=3;
+  }
+  status=status|((a&0x03)<<3);
+  status=status|((receiver[0]->squelch_enable&0x01)<<6);
+  status=status|((receiver[0]->nb&0x01)<<7);
+  status=status|((receiver[0]->nb2&0x01)<<8);
+  status=status|((receiver[0]->nr&0x01)<<9);
+  status=status|((receiver[0]->nr2&0x01)<<10);
+  status=status|((receiver[0]->snb&0x01)<<11);
+  status=status|((receiver[0]->anf&0x01)<<12);
+  sprintf(reply,"ZZXN%04d;",status);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// read combined RX2 status
+static gboolean cat_zzxo(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  if(receivers==2) {
+    if(command[4]==';') {
+      int status=0;
+      status=status|((receiver[1]->agc)&0x03);
+      int a=adc[receiver[1]->adc].attenuation;
+      if(a==0) {
+        a=1;
+      } else if(a<=-30) {
+        a=4;
+      } else if(a<=-20) {
+        a=0;
+      } else if(a<=-10) {
+        a=2;
+      } else {
+        a=3;
+      }
+      status=status|((a&0x03)<<3);
+      status=status|((receiver[1]->squelch_enable&0x01)<<6);
+      status=status|((receiver[1]->nb&0x01)<<7);
+      status=status|((receiver[1]->nb2&0x01)<<8);
+      status=status|((receiver[1]->nr&0x01)<<9);
+      status=status|((receiver[1]->nr2&0x01)<<10);
+      status=status|((receiver[1]->snb&0x01)<<11);
+      status=status|((receiver[1]->anf&0x01)<<12);
+      sprintf(reply,"ZZXO%04d;",status);
+      send_resp(client,reply);
+    }
+  }
+  return TRUE;
+}
+
+// / set/read XIT enable
+static gboolean cat_zzxs_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  sprintf(reply,"ZZXS%d;",transmitter->xit_enabled);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_zzxs_set(CLIENT *client,char *command) {
+  transmitter->xit_enabled=atoi(&command[4]);
+  vfo_update();
+  return TRUE;
+}
+
+// read combined VFO status
+static gboolean cat_zzxv_query(CLIENT *client,char *command) {
+  char reply[256];
+  reply[0]='\0';
+
+  int status=0;
+  if(vfo[VFO_A].rit_enabled) {
+    status=status|0x01;
+  }
+  if(locked) {
+    status=status|0x02;
+    status=status|0x04;
+  }
+  if(split) {
+    status=status|0x08;
+  }
+  if(vfo[VFO_A].ctun) {
+    status=status|0x10;
+  }
+  if(vfo[VFO_B].ctun) {
+    status=status|0x20;
+  }
+  if(mox) {
+    status=status|0x40;
+  }
+  if(tune) {
+    status=status|0x80;
+  }
+  sprintf(reply,"ZZXV%03d;",status);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// switch receivers
+static gboolean cat_zzyr_set(CLIENT *client,char *command) {
+  int v=atoi(&command[4]);
+  if(v==0) {
+    active_receiver=receiver[0];
+  } else if(v==1) {
+    if(receivers==2) {
+      active_receiver=receiver[1];
+    }
+  }
+  vfo_update();
+  return TRUE;
+}
+
+// set/read AF Gain
+static gboolean cat_ag(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  if(command[3]==';' && command[2]=='0') { // query, main receiver
+    // send reply back (covert from 0..1 to 0..255)
+    sprintf(reply,"AG0%03d;",(int)(receiver[0]->volume*255.0+0.5));
+    send_resp(client,reply) ;
+  } else if(command[6]==';' && command[2] == '0') {
+    int gain=atoi(&command[3]);
+    receiver[0]->volume=(double)gain/255.0;
+    update_af_gain();
+  }
+  return TRUE;
+}
+
+// set/read Auto Information
+// many clients start the connection with an "AI0" command.
+// piHPSDR is constantly in an "AI0" state, therefore
+// silently ignore AI0 commands and flag an error for
+// all other possiblities
+static gboolean cat_ai(CLIENT *client,char *command) {
+  gboolean implemented=TRUE;
+
+  if (command[2] == '0' && command[3] == ';') {
+    // do nothing
+  } else {
+    implemented=FALSE;
+  }
+  return implemented;
+}
+
+// band down 1 band
+static gboolean cat_bd(CLIENT *client,char *command) {
+  band_minus(receiver[0]->id);
+  return TRUE;
+}
+
+// band up 1 band
+static gboolean cat_bu(CLIENT *client,char *command) {
+  band_plus(receiver[0]->id);
+  return TRUE;
+}
+
+// sets/reads CTCSS function
+static gboolean cat_cn_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"CN%02d;",transmitter->ctcss+1);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_cn_set(CLIENT *client,char *command) {
+  int i=atoi(&command[2])-1;
+  transmitter_set_ctcss(transmitter,transmitter->ctcss_enabled,i);
+  return TRUE;
+}
+
+// sets/reads CTCSS status
+static gboolean cat_ct_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"CT%d;",transmitter->ctcss_enabled);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_ct_set(CLIENT *client,char *command) {
+  int state=atoi(&command[2]);
+  transmitter_set_ctcss(transmitter,state,transmitter->ctcss);
+  return TRUE;
+}
+
+// move VFO A down 1 step size
+static gboolean cat_dn(CLIENT *client,char *command) {
+  vfo_id_step(VFO_A,-1);
+  return TRUE;
+}
+
+// set/read VFO-A frequency
+static gboolean cat_fa_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  if(vfo[VFO_A].ctun) {
+    sprintf(reply,"FA%011lld;",vfo[VFO_A].ctun_frequency);
+  } else {
+    sprintf(reply,"FA%011lld;",vfo[VFO_A].frequency);
+  }
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_fa_set(CLIENT *client,char *command) {
+  long long f=atoll(&command[2]);
+  vfo_set_frequency(VFO_A,f);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read VFO-B frequency
+static gboolean cat_fb_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  if(vfo[VFO_B].ctun) {
+    sprintf(reply,"FB%011lld;",vfo[VFO_B].ctun_frequency);
+  } else {
+    sprintf(reply,"FB%011lld;",vfo[VFO_B].frequency);
+  }
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_fb_set(CLIENT *client,char *command) {
+  long long f=atoll(&command[2]);
+  vfo_set_frequency(VFO_B,f);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read transceiver receive VFO
+static gboolean cat_fr_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"FR%d;",active_receiver->id);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_fr_set(CLIENT *client,char *command) {
+  gboolean implemented=TRUE;
+
+  int id=atoi(&command[2]);
+  switch(id) {
+    case 0:
+      active_receiver=receiver[id];
+      break;
+    case 1:
+      if(receivers==2) {
+        active_receiver=receiver[id];
+      } else {
+        implemented=FALSE;
+      }
+      break;
+    default:
+      implemented=FALSE;
+      break;
+  }
+  g_idle_add(ext_vfo_update, NULL);
+  return implemented;
+}
+
+// set/read transceiver transmit VFO
+static gboolean cat_ft_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"FT%d;",split);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_ft_set(CLIENT *client,char *command) {
+  int val=atoi(&command[2]);
+  radio_set_split(val);
+  return TRUE;
+}
+
+// set/read filter width. Switch to Var1 only when setting
+static gboolean cat_fw_query(CLIENT *client,char *command) {
+  gboolean implemented=TRUE;
+  char reply[80];
+  reply[0]='\0';
+
+  int val=0;
+  FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
+  FILTER *filter=&mode_filters[vfo[active_receiver->id].filter];
+  switch(vfo[active_receiver->id].mode) {
+    case modeCWL:
+    case modeCWU:
+      val=filter->low*2;
       break;
-    case 'Z': //ZZZx
-      switch(command[3]) {
-        case 'A': //ZZZA
-          implemented=FALSE;
-          break;
-	case 'B': //ZZZB
-          implemented=FALSE;
-          break;
-	case 'Z': //ZZZZ
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case modeAM:
+    case modeSAM:
+      val=filter->low>=-4000;
+      break;
+    case modeFMN:
+      val=active_receiver->deviation==5000;
       break;
     default:
-       implemented=FALSE;
-       break;
+      implemented=FALSE;
+      break;
+  }
+  if(implemented) {
+    sprintf(reply,"FW%04d;",val);
+    send_resp(client,reply) ;
   }
   return implemented;
 }
 
-// called with g_idle_add so that the processing is running on the main thread
-int parse_cmd(void *data) {
-  COMMAND *info=(COMMAND *)data;
-  CLIENT *client=info->client;
-  char *command=info->command;
-  char reply[80];
-  reply[0]='\0';
+static gboolean cat_fw_set(CLIENT *client,char *command) {
   gboolean implemented=TRUE;
-  gboolean errord=FALSE;
-
-  switch(command[0]) {
-    case 'A':
-      switch(command[1]) {
-        case 'C': //AC
-          // set/read internal atu status
-          implemented=FALSE;
-          break;
-        case 'G': //AG
-          // set/read AF Gain
-          if(command[3]==';' && command[2]=='0') { // query, main receiver
-            // send reply back (covert from 0..1 to 0..255)
-            sprintf(reply,"AG0%03d;",(int)(receiver[0]->volume*255.0+0.5));
-            send_resp(client->fd,reply) ;
-          } else if(command[6]==';' && command[2] == '0') {
-            int gain=atoi(&command[3]);
-            receiver[0]->volume=(double)gain/255.0;
-            update_af_gain();
-          }
-          break;
-        case 'I': //AI
-          // set/read Auto Information
-          // many clients start the connection with an "AI0" command.
-          // piHPSDR is constantly in an "AI0" state, therefore
-          // silently ignore AI0 commands and flag an error for
-          // all other possiblities
-          if (command[2] == '0' && command[3] == ';') {
-            // do nothing
-          } else {
-            implemented=FALSE;
-          }
-          break;
-        case 'L': // AL
-          // set/read Auto Notch level
-          implemented=FALSE;
-          break;
-        case 'M': // AM
-          // set/read Auto Mode
-          implemented=FALSE;
-          break;
-        case 'N': // AN
-          // set/read Antenna Connection
-          implemented=FALSE;
-          break;
-        case 'S': // AS
-          // set/read Auto Mode Function Parameters
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
-      break;
-    case 'B':
-      switch(command[1]) {
-        case 'C': //BC
-          // set/read Beat Canceller
-          implemented=FALSE;
-          break;
-        case 'D': //BD
-          //band down 1 band
-          band_minus(receiver[0]->id);
-          break;
-        case 'P': //BP
-          // set/read Manual Beat Canceller frequency
-          implemented=FALSE;
-          break;
-        case 'U': //BU
-          //band up 1 band
-          band_plus(receiver[0]->id);
-          break;
-        case 'Y': //BY
-          // read busy signal
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
-      break;
-    case 'C':
-      switch(command[1]) {
-        case 'A': //CA
-          // set/read CW Auto Tune
-          implemented=FALSE;
-          break;
-        case 'G': //CG
-          // set/read Carrier Gain
-          implemented=FALSE;
-          break;
-        case 'I': //CI
-          // sets the current frequency to the CALL Channel
-          implemented=FALSE;
-          break;
-        case 'M': //CM
-          // sets/reads the Packet Cluster Tune function
-          implemented=FALSE;
-          break;
-        case 'N': //CN
-          // sets/reads CTCSS function
-          if(command[3]==';') {
-            sprintf(reply,"CN%02d;",transmitter->ctcss+1);
-            send_resp(client->fd,reply) ;
-          } else if(command[4]==';') {
-            int i=atoi(&command[2])-1;
-            transmitter_set_ctcss(transmitter,transmitter->ctcss_enabled,i);
-          }
-          break;
-        case 'T': //CT
-          // sets/reads CTCSS status
-          if(command[2]==';') {
-            sprintf(reply,"CT%d;",transmitter->ctcss_enabled);
-            send_resp(client->fd,reply) ;
-          } else if(command[3]==';') {
-            int state=atoi(&command[2]);
-            transmitter_set_ctcss(transmitter,state,transmitter->ctcss);
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+
+  // make sure filter is filterVar1
+  if(vfo[active_receiver->id].filter!=filterVar1) {
+    vfo_filter_changed(filterVar1);
+  }
+  FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
+  FILTER *filter=&mode_filters[filterVar1];
+  int fw=atoi(&command[2]);
+  filter->low=fw;
+  switch(vfo[active_receiver->id].mode) {
+    case modeCWL:
+    case modeCWU:
+      filter->low=fw/2;
+      filter->high=fw/2;
       break;
-    case 'D':
-      switch(command[1]) {
-        case 'C': //DC
-          // set/read TX band status
-          implemented=FALSE;
-          break;
-        case 'N': //DN
-          // move VFO A down 1 step size
-          vfo_id_step(VFO_A,-1);
-          break;
-        case 'Q': //DQ
-          // set/read DCS function status
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
+    case modeFMN:
+      if(fw==0) {
+        filter->low=-5500;
+        filter->high=5500;
+        active_receiver->deviation=2500;
+      } else {
+        filter->low=-8000;
+        filter->high=8000;
+        active_receiver->deviation=5000;
       }
       break;
-    case 'E':
-      switch(command[1]) {
-        case 'X': //EX
-          // set/read the extension menu
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
+    case modeAM:
+    case modeSAM:
+      if(fw==0) {
+        filter->low=-4000;
+        filter->high=4000;
+      } else {
+        filter->low=-8000;
+        filter->high=8000;
       }
       break;
-    case 'F':
-      switch(command[1]) {
-        case 'A': //FA
-          // set/read VFO-A frequency
-          if(command[2]==';') {
-            if(vfo[VFO_A].ctun) {
-              sprintf(reply,"FA%011lld;",vfo[VFO_A].ctun_frequency);
-            } else {
-              sprintf(reply,"FA%011lld;",vfo[VFO_A].frequency);
-            }
-            send_resp(client->fd,reply) ;
-          } else if(command[13]==';') {
-            long long f=atoll(&command[2]);
-            vfo_set_frequency(VFO_A,f);
-            vfo_update();
-          }
-          break;
-        case 'B': //FB
-          // set/read VFO-B frequency
-          if(command[2]==';') {
-            if(vfo[VFO_B].ctun) {
-              sprintf(reply,"FB%011lld;",vfo[VFO_B].ctun_frequency);
-            } else {
-              sprintf(reply,"FB%011lld;",vfo[VFO_B].frequency);
-            }
-            send_resp(client->fd,reply) ;
-          } else if(command[13]==';') {
-            long long f=atoll(&command[2]);
-            vfo_set_frequency(VFO_B,f);
-            vfo_update();
-          }
-          break;
-        case 'C': //FC
-          // set/read the sub receiver VFO frequency menu
-          implemented=FALSE;
-          break;
-        case 'D': //FD
-          // set/read the filter display dot pattern
-          implemented=FALSE;
-          break;
-        case 'R': //FR
-          // set/read transceiver receive VFO
-          if(command[2]==';') {
-            sprintf(reply,"FR%d;",active_receiver->id);
-            send_resp(client->fd,reply) ;
-          } else if(command[3]==';') {
-            int id=atoi(&command[2]);
-            switch(id) {
-              case 0:
-                active_receiver=receiver[id];
-                break;
-              case 1:
-                if(receivers==2) {
-                  active_receiver=receiver[id];
-                } else {
-                  implemented=FALSE;
-                }
-                break;
-              default:
-                implemented=FALSE;
-                break;
-            }
-            g_idle_add(ext_vfo_update, NULL);
-          }
-          break;
-        case 'S': //FS
-          // set/read the fine tune function status
-          implemented=FALSE;
-          break;
-        case 'T': //FT
-          // set/read transceiver transmit VFO
-          if(command[2]==';') {
-            sprintf(reply,"FT%d;",split);
-            send_resp(client->fd,reply) ;
-          } else if(command[3]==';') {
-            int val=atoi(&command[2]);
-            radio_set_split(val);
-          }
-          break;
-        case 'W': //FW
-          // set/read filter width. Switch to Var1 only when setting
-          if(command[2]==';') {
-            int val=0;
-            FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
-            FILTER *filter=&mode_filters[vfo[active_receiver->id].filter];
-            switch(vfo[active_receiver->id].mode) {
-              case modeCWL:
-              case modeCWU:
-                val=filter->low*2;
-                break;
-              case modeAM:
-              case modeSAM:
-                val=filter->low>=-4000;
-                break;
-              case modeFMN:
-                val=active_receiver->deviation==5000;
-                break;
-              default:
-                implemented=FALSE;
-                break;
-            }
-            if(implemented) {
-              sprintf(reply,"FW%04d;",val);
-              send_resp(client->fd,reply) ;
-            }
-          } else if(command[6]==';') {
-            // make sure filter is filterVar1
-            if(vfo[active_receiver->id].filter!=filterVar1) {
-              vfo_filter_changed(filterVar1);
-            }
-            FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
-            FILTER *filter=&mode_filters[filterVar1];
-            int fw=atoi(&command[2]);
-            filter->low=fw;
-            switch(vfo[active_receiver->id].mode) {
-              case modeCWL:
-              case modeCWU:
-                filter->low=fw/2;
-                filter->high=fw/2;
-                break;
-              case modeFMN:
-                if(fw==0) {
-                  filter->low=-5500;
-                  filter->high=5500;
-                  active_receiver->deviation=2500;
-                } else {
-                  filter->low=-8000;
-                  filter->high=8000;
-                  active_receiver->deviation=5000;
-                }
-                break;
-              case modeAM:
-              case modeSAM:
-                if(fw==0) {
-                  filter->low=-4000;
-                  filter->high=4000;
-                } else {
-                  filter->low=-8000;
-                  filter->high=8000;
-                }
-                break;
-              default:
-                implemented=FALSE;
-                break;
-            }
-            if(implemented) {
-              vfo_filter_changed(filterVar1);
-            }
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    default:
+      implemented=FALSE;
       break;
-    case 'G':
-      switch(command[1]) {
-        case 'T': //GT
-          // set/read RX1 AGC
-          if(command[2]==';') {
-            sprintf(reply,"GT%03d;",receiver[0]->agc*5);
-            send_resp(client->fd,reply) ;
-          } else if(command[5]==';') {
-            // update RX1 AGC
-            receiver[0]->agc=atoi(&command[2])/5;
-            vfo_update();
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+  }
+  if(implemented) {
+    vfo_filter_changed(filterVar1);
+  }
+  return implemented;
+}
+
+// set/read RX1 AGC
+static gboolean cat_gt_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"GT%03d;",receiver[0]->agc*5);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_gt_set(CLIENT *client,char *command) {
+  // update RX1 AGC
+  receiver[0]->agc=atoi(&command[2])/5;
+  vfo_update();
+  return TRUE;
+}
+
+// get ID
+static gboolean cat_id(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  strcpy(reply,"ID019;"); // TS-2000
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_if(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  int mode=ts2000_mode(vfo[VFO_A].mode);
+  sprintf(reply,"IF%011lld%04lld%+06lld%d%d%d%02d%d%d%d%d%d%d%02d%d;",
+          vfo[VFO_A].ctun?vfo[VFO_A].ctun_frequency:vfo[VFO_A].frequency,
+          step,vfo[VFO_A].rit,vfo[VFO_A].rit_enabled,transmitter==NULL?0:transmitter->xit_enabled,
+          0,0,isTransmitting(),mode,0,0,split,transmitter->ctcss_enabled?2:0,transmitter->ctcss,0);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// set/read IF shift
+static gboolean cat_is_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  strcpy(reply,"IS 0000;");
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_is_set(CLIENT *client,char *command) {
+  gboolean implemented=TRUE;
+
+  implemented=FALSE;
+  return implemented;
+}
+
+// set/read keying speed
+static gboolean cat_ks_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"KS%03d;",cw_keyer_speed);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_ks_set(CLIENT *client,char *command) {
+  int speed=atoi(&command[2]);
+  if(speed>=1 && speed<=60) {
+    cw_keyer_speed=speed;
+#ifdef LOCALCW
+    keyer_update();
+#endif
+    vfo_update();
+  }
+  return TRUE;
+}
+
+// convert the chaaracters into Morse Code
+static gboolean cat_ky_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"KY%d;",cw_busy);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_ky_set(CLIENT *client,char *command) {
+  if(cw_busy==0) {
+    strncpy(cw_buf,&command[3],24);
+    // if command is too long, strncpy does not terminate destination
+    cw_buf[24]='\0';
+    cw_busy=1;
+  }
+  return TRUE;
+}
+
+// set/read key lock
+static gboolean cat_lk_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"LK%d%d;",locked,locked);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_lk_set(CLIENT *client,char *command) {
+  locked = atoi(&command[2]);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read operating mode
+static gboolean cat_md_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  int mode=ts2000_mode(vfo[VFO_A].mode);
+  sprintf(reply,"MD%d;",mode);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_md_set(CLIENT *client,char *command) {
+  int mode=modeUSB;
+  switch(atoi(&command[2])) {
+    case 1:
+      mode=modeLSB;
       break;
-    case 'H':
-      switch(command[1]) {
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 2:
+      mode=modeUSB;
       break;
-    case 'I':
-      switch(command[1]) {
-        case 'D': //ID
-          // get ID
-          strcpy(reply,"ID019;"); // TS-2000
-          send_resp(client->fd,reply);
-          break;
-        case 'F': //IF
-          {
-          int mode=ts2000_mode(vfo[VFO_A].mode);
-          sprintf(reply,"IF%011lld%04lld%+06lld%d%d%d%02d%d%d%d%d%d%d%02d%d;",
-                  vfo[VFO_A].ctun?vfo[VFO_A].ctun_frequency:vfo[VFO_A].frequency,
-                  step,vfo[VFO_A].rit,vfo[VFO_A].rit_enabled,transmitter==NULL?0:transmitter->xit_enabled,
-                  0,0,isTransmitting(),mode,0,0,split,transmitter->ctcss_enabled?2:0,transmitter->ctcss,0);
-          send_resp(client->fd,reply);
-          }
-          break;
-        case 'S': //IS
-          // set/read IF shift
-          if(command[2]==';') {
-            strcpy(reply,"IS 0000;");
-            send_resp(client->fd,reply);
-          } else {
-            implemented=FALSE;
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 3:
+      mode=modeCWU;
       break;
-    case 'J':
-      switch(command[1]) {
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 4:
+      mode=modeFMN;
       break;
-    case 'K':
-      switch(command[1]) {
-        case 'S': //KS
-          // set/read keying speed
-          if(command[2]==';') {
-            sprintf(reply,"KS%03d;",cw_keyer_speed);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            int speed=atoi(&command[2]);
-            if(speed>=1 && speed<=60) {
-              cw_keyer_speed=speed;
-#ifdef LOCALCW
-              keyer_update();
-#endif
-              vfo_update();
-            }
-          } else {
-          }
-          break;
-        case 'Y': //KY
-          // convert the chaaracters into Morse Code
-          if(command[2]==';') {
-            sprintf(reply,"KY%d;",cw_busy);
-            send_resp(client->fd,reply);
-          } else if(command[27]==';') {
-            if(cw_busy==0) {
-              strncpy(cw_buf,&command[3],24);
-              // if command is too long, strncpy does not terminate destination
-              cw_buf[24]='\0';
-              cw_busy=1;
-            }
-          } else {
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 5:
+      mode=modeAM;
       break;
-    case 'L':
-      switch(command[1]) {
-        case 'K': //LK
-          // set/read key lock
-          if(command[2]==';') {
-            sprintf(reply,"LK%d%d;",locked,locked);
-            send_resp(client->fd,reply);
-          } else if(command[4]==';') {
-            locked = atoi(&command[2]);
-            vfo_update();
-          }
-          break;
-        case 'M': //LM
-          // set/read keyer recording status
-          implemented=FALSE;
-          break;
-        case 'T': //LT
-          // set/read ALT fucntion status
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 6:
+      mode=modeDIGL;
       break;
-    case 'M':
-      switch(command[1]) {
-        case 'C': //MC
-          // set/read Memory Channel
-          implemented=FALSE;
-          break;
-        case 'D': //MD
-          // set/read operating mode
-          if(command[2]==';') {
-            int mode=ts2000_mode(vfo[VFO_A].mode);
-            sprintf(reply,"MD%d;",mode);
-            send_resp(client->fd,reply);
-          } else if(command[3]==';') {
-            int mode=modeUSB;
-            switch(atoi(&command[2])) {
-              case 1:
-                mode=modeLSB;
-                break;
-              case 2:
-                mode=modeUSB;
-                break;
-              case 3:
-                mode=modeCWU;
-                break;
-              case 4:
-                mode=modeFMN;
-                break;
-              case 5:
-                mode=modeAM;
-                break;
-              case 6:
-                mode=modeDIGL;
-                break;
-              case 7:
-                mode=modeCWL;
-                break;
-              case 9:
-                mode=modeDIGU;
-                break;
-              default:
-                break;
-            }
-            vfo_mode_changed(mode);
-          }
-          break;
-        case 'F': //MF
-          // set/read Menu
-          implemented=FALSE;
-          break;
-        case 'G': //MG
-          // set/read Menu Gain (-12..60 converts to 0..100)
-          if(command[2]==';') {
-            sprintf(reply,"MG%03d;",(int)(((mic_gain+12.0)/72.0)*100.0));
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            double gain=(double)atoi(&command[2]);
-            gain=((gain/100.0)*72.0)-12.0;
-            set_mic_gain(gain);
-          }
-          break;
-        case 'L': //ML
-          // set/read Monitor Function Level
-          implemented=FALSE;
-          break;
-        case 'O': //MO
-          // set/read Monitor Function On/Off
-          implemented=FALSE;
-          break;
-        case 'R': //MR
-          // read Memory Channel
-          implemented=FALSE;
-          break;
-        case 'U': //MU
-          // set/read Memory Group
-          implemented=FALSE;
-          break;
-        case 'W': //MW
-          // Write Memory Channel
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 7:
+      mode=modeCWL;
       break;
-    case 'N':
-      switch(command[1]) {
-        case 'B': //NB
-          // set/read noise blanker
-          if(command[2]==';') {
-            sprintf(reply,"NB%d;",active_receiver->nb);
-            send_resp(client->fd,reply);
-          } else if(command[3]==';') {
-            active_receiver->nb=atoi(&command[2]);
-            if(active_receiver->nb) {
-              active_receiver->nb2=0;
-            }
-            update_noise();
-          }
-          break;
-        case 'L': //NL
-          // set/read noise blanker level
-          implemented=FALSE;
-          break;
-        case 'R': //NR
-          // set/read noise reduction
-          if(command[2]==';') {
-            int n=0;
-            if(active_receiver->nr) {
-              n=1;
-            } else if(active_receiver->nr2) {
-              n=2;
-            }
-            sprintf(reply,"NR%d;",n);
-            send_resp(client->fd,reply);
-          } else if(command[3]==';') {
-            int n=atoi(&command[2]);
-            switch(n) {
-              case 0: // NR OFF
-                active_receiver->nr=0;
-                active_receiver->nr2=0;
-                break;
-              case 1: // NR ON
-                active_receiver->nr=1;
-                active_receiver->nr2=0;
-                break;
-              case 2: // NR2 ON
-                active_receiver->nr=0;
-                active_receiver->nr2=1;
-                break;
-            }
-            update_noise();
-          }
-          break;
-        case 'T': //NT
-          // set/read ANF
-          if(command[2]==';') {
-            sprintf(reply,"NT%d;",active_receiver->anf);
-            send_resp(client->fd,reply);
-          } else if(command[3]==';') {
-            active_receiver->anf=atoi(&command[2]);
-            SetRXAANFRun(active_receiver->id, active_receiver->anf);
-            vfo_update();
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    case 9:
+      mode=modeDIGU;
       break;
-    case 'O':
-      switch(command[1]) {
-        case 'F': //OF
-          // set/read offset frequency
-          implemented=FALSE;
-          break;
-        case 'I': //OI
-          // set/read offset frequency
-          implemented=FALSE;
-          break;
-        case 'S': //OS
-          // set/read offset function status
-          implemented=FALSE;
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+    default:
       break;
-    case 'P':
-      switch(command[1]) {
-        case 'A': //PA
-          // set/read preamp function status
-          if(command[2]==';') {
-            sprintf(reply,"PA%d0;",active_receiver->preamp);
-            send_resp(client->fd,reply);
-          } else if(command[4]==';') {
-            active_receiver->preamp=command[2]=='1';
-          }
-          break;
-        case 'B': //PB
-          // set/read FRU-3A playback status
-          implemented=FALSE;
-          break;
-        case 'C': //PC
-          // set/read PA Power
-          if(command[2]==';') {
-            sprintf(reply,"PC%03d;",(int)transmitter->drive);
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            set_drive((double)atoi(&command[2]));
-          }
-          break;
-        case 'I': //PI
-          // store in program memory channel
-          implemented=FALSE;
-          break;
-        case 'K': //PK
-          // read packet cluster data
-          implemented=FALSE;
-          break;
-        case 'L': //PL
-          // set/read speach processor input/output level
-          if(command[2]==';') {
-            sprintf(reply,"PL%03d000;",(int)((transmitter->compressor_level/20.0)*100.0));
-            send_resp(client->fd,reply);
-          } else if(command[8]==';') {
-            command[5]='\0';
-            double level=(double)atoi(&command[2]);
-            level=(level/100.0)*20.0;
-            transmitter_set_compressor_level(transmitter,level);
-            vfo_update();
-          }
-          break;
-        case 'M': //PM
-          // recall program memory
-          implemented=FALSE;
-          break;
-        case 'R': //PR
-          // set/read speech processor function
-          implemented=FALSE;
-          break;
-        case 'S': //PS
-          // set/read Power (always ON)
-          if(command[2]==';') {
-            sprintf(reply,"PS1;");
-            send_resp(client->fd,reply);
-          } else if(command[3]==';') {
-            // ignore set
-          }
-          break;
-        default:
-          implemented=FALSE;
-          break;
-      }
+  }
+  vfo_mode_changed(mode);
+  return TRUE;
+}
+
+// set/read Menu Gain (-12..60 converts to 0..100)
+static gboolean cat_mg_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"MG%03d;",(int)(((mic_gain+12.0)/72.0)*100.0));
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_mg_set(CLIENT *client,char *command) {
+  double gain=(double)atoi(&command[2]);
+  gain=((gain/100.0)*72.0)-12.0;
+  set_mic_gain(gain);
+  return TRUE;
+}
+
+// set/read noise blanker
+static gboolean cat_nb_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"NB%d;",active_receiver->nb);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_nb_set(CLIENT *client,char *command) {
+  active_receiver->nb=atoi(&command[2]);
+  if(active_receiver->nb) {
+    active_receiver->nb2=0;
+  }
+  update_noise();
+  return TRUE;
+}
+
+// set/read noise reduction
+static gboolean cat_nr_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  int n=0;
+  if(active_receiver->nr) {
+    n=1;
+  } else if(active_receiver->nr2) {
+    n=2;
+  }
+  sprintf(reply,"NR%d;",n);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_nr_set(CLIENT *client,char *command) {
+  int n=atoi(&command[2]);
+  switch(n) {
+    case 0: // NR OFF
+      active_receiver->nr=0;
+      active_receiver->nr2=0;
       break;
-    case 'Q':
-      switch(command[1]) {
-        case 'C': //QC
-          // set/read DCS code
-          implemented=FALSE;
-          break;
-        case 'I': //QI
-          // store in quick memory
-          implemented=FALSE;
+    case 1: // NR ON
+      active_receiver->nr=1;
+      active_receiver->nr2=0;
+      break;
+    case 2: // NR2 ON
+      active_receiver->nr=0;
+      active_receiver->nr2=1;
+      break;
+  }
+  update_noise();
+  return TRUE;
+}
+
+// set/read ANF
+static gboolean cat_nt_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"NT%d;",active_receiver->anf);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_nt_set(CLIENT *client,char *command) {
+  active_receiver->anf=atoi(&command[2]);
+  SetRXAANFRun(active_receiver->id, active_receiver->anf);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read preamp function status
+static gboolean cat_pa_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"PA%d0;",active_receiver->preamp);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_pa_set(CLIENT *client,char *command) {
+  active_receiver->preamp=command[2]=='1';
+  return TRUE;
+}
+
+// set/read PA Power
+static gboolean cat_pc_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"PC%03d;",(int)transmitter->drive);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_pc_set(CLIENT *client,char *command) {
+  set_drive((double)atoi(&command[2]));
+  return TRUE;
+}
+
+// set/read speach processor input/output level
+static gboolean cat_pl_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"PL%03d000;",(int)((transmitter->compressor_level/20.0)*100.0));
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_pl_set(CLIENT *client,char *command) {
+  command[5]='\0';
+  double level=(double)atoi(&command[2]);
+  level=(level/100.0)*20.0;
+  transmitter_set_compressor_level(transmitter,level);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read Power (always ON)
+static gboolean cat_ps_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"PS1;");
+  send_resp(client,reply);
+  return TRUE;
+}
+
+// set/read Attenuator function
+static gboolean cat_ra_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  int att=0;
+  if(have_rx_gain) {
+    att=(int)(adc[active_receiver->adc].attenuation+12);
+    att=(int)(((double)att/60.0)*99.0);
+  } else {
+    att=(int)(adc[active_receiver->adc].attenuation);
+    att=(int)(((double)att/31.0)*99.0);
+  }
+  sprintf(reply,"RA%02d00;",att);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_ra_set(CLIENT *client,char *command) {
+  int att=atoi(&command[2]);
+  if(have_rx_gain) {
+    att=(int)((((double)att/99.0)*60.0)-12.0);
+  } else {
+    att=(int)(((double)att/99.0)*31.0);
+  }
+  set_attenuation_value((double)att);
+  return TRUE;
+}
+
+// clears RIT
+static gboolean cat_rc_set(CLIENT *client,char *command) {
+  vfo[VFO_A].rit=0;
+  vfo_update();
+  return TRUE;
+}
+
+// decrements RIT Frequency
+static gboolean cat_rd_query(CLIENT *client,char *command) {
+  if(vfo[VFO_A].mode==modeCWL || vfo[VFO_A].mode==modeCWU) {
+    vfo[VFO_A].rit-=10;
+  } else {
+    vfo[VFO_A].rit-=50;
+  }
+  vfo_update();
+  return TRUE;
+}
+
+static gboolean cat_rd_set(CLIENT *client,char *command) {
+  vfo[VFO_A].rit=atoi(&command[2]);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read RIT enable
+static gboolean cat_rt_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"RT%d;",vfo[VFO_A].rit_enabled);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_rt_set(CLIENT *client,char *command) {
+  vfo[VFO_A].rit_enabled=atoi(&command[2]);
+  vfo_update();
+  return TRUE;
+}
+
+// increments RIT Frequency
+static gboolean cat_ru_query(CLIENT *client,char *command) {
+  if(vfo[VFO_A].mode==modeCWL || vfo[VFO_A].mode==modeCWU) {
+    vfo[VFO_A].rit+=10;
+  } else {
+    vfo[VFO_A].rit+=50;
+  }
+  vfo_update();
+  return TRUE;
+}
+
+static gboolean cat_ru_set(CLIENT *client,char *command) {
+  vfo[VFO_A].rit=atoi(&command[2]);
+  vfo_update();
+  return TRUE;
+}
+
+// set transceiver to RX mode
+static gboolean cat_rx_set(CLIENT *client,char *command) {
+  mox_update(0);
+  return TRUE;
+}
+
+// set/read stallite mode status
+static gboolean cat_sa(CLIENT *client,char *command) {
+  gboolean implemented=TRUE;
+  char reply[80];
+  reply[0]='\0';
+
+  if(command[2]==';') {
+    sprintf(reply,"SA%d%d%d%d%d%d%dSAT?    ;",(sat_mode==SAT_MODE)|(sat_mode==RSAT_MODE),0,0,0,sat_mode==SAT_MODE,sat_mode==RSAT_MODE,0);
+    send_resp(client,reply);
+  } else if(command[9]==';') {
+    if(command[2]=='0') {
+      sat_mode=SAT_NONE;
+    } else if(command[2]=='1') {
+      if(command[6]=='0' && command[7]=='0') {
+        sat_mode=SAT_NONE;
+      } else if(command[6]=='1' && command[7]=='0') {
+        sat_mode=SAT_MODE;
+      } else if(command[6]=='0' && command[7]=='1') {
+        sat_mode=RSAT_MODE;
+      } else {
+        implemented=FALSE;
+      }
+    }
+  } else {
+    implemented=FALSE;
+  }
+  return implemented;
+}
+
+// set/read CW break-in time delay
+static gboolean cat_sd(CLIENT *client,char *command) {
+  gboolean implemented=TRUE;
+  char reply[80];
+  reply[0]='\0';
+
+  if(command[2]==';') {
+    sprintf(reply,"SD%04d;",(int)fmin(cw_keyer_hang_time,1000));
+    send_resp(client,reply);
+  } else if(command[6]==';') {
+    int b=fmin(atoi(&command[2]),1000);
+    cw_breakin=b==0;
+    cw_keyer_hang_time=b;
+  } else {
+    implemented=FALSE;
+  }
+  return implemented;
+}
+
+// set/read filter high, switch to Var1 only when setting
+static gboolean cat_sh_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
+  FILTER *filter=&mode_filters[vfo[active_receiver->id].filter];
+  int fh=5;
+  int high=filter->high;
+  if(vfo[active_receiver->id].mode==modeLSB) {
+    high=abs(filter->low);
+  }
+  if(high<=1400) {
+    fh=0;
+  } else if(high<=1600) {
+    fh=1;
+  } else if(high<=1800) {
+    fh=2;
+  } else if(high<=2000) {
+    fh=3;
+  } else if(high<=2200) {
+    fh=4;
+  } else if(high<=2400) {
+    fh=5;
+  } else if(high<=2600) {
+    fh=6;
+  } else if(high<=2800) {
+    fh=7;
+  } else if(high<=3000) {
+    fh=8;
+  } else if(high<=3400) {
+    fh=9;
+  } else if(high<=4000) {
+    fh=10;
+  } else {
+    fh=11;
+  }
+  sprintf(reply,"SH%02d;",fh);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_sh_set(CLIENT *client,char *command) {
+  // make sure filter is filterVar1
+  if(vfo[active_receiver->id].filter!=filterVar1) {
+    vfo_filter_changed(filterVar1);
+  }
+  FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
+  FILTER *filter=&mode_filters[filterVar1];
+  int i=atoi(&command[2]);
+  int fh=100;
+  switch(vfo[active_receiver->id].mode) {
+    case modeLSB:
+    case modeUSB:
+    case modeFMN:
+      switch(i) {
+        case 0:
+          fh=1400;
           break;
-        case 'R': //QR
-          // set/read quick memory channel data
-          implemented=FALSE;
+        case 1:
+          fh=1600;
           break;
-        default:
-          implemented=FALSE;
+        case 2:
+          fh=1800;
           break;
-      }
-      break;
-    case 'R':
-      switch(command[1]) {
-        case 'A': //RA
-          // set/read Attenuator function
-          if(command[2]==';') {
-            int att=0;
-            if(have_rx_gain) {
-              att=(int)(adc[active_receiver->adc].attenuation+12);
-              att=(int)(((double)att/60.0)*99.0);
-            } else {
-              att=(int)(adc[active_receiver->adc].attenuation);
-              att=(int)(((double)att/31.0)*99.0);
-            }
-            sprintf(reply,"RA%02d00;",att);
-            send_resp(client->fd,reply);
-          } else if(command[4]==';') {
-            int att=atoi(&command[2]);
-            if(have_rx_gain) {
-              att=(int)((((double)att/99.0)*60.0)-12.0);
-            } else {
-              att=(int)(((double)att/99.0)*31.0);
-            }
-            set_attenuation_value((double)att);
-          }
+        case 3:
+          fh=2000;
           break;
-        case 'C': //RC
-          // clears RIT
-          if(command[2]==';') {
-            vfo[VFO_A].rit=0;
-            vfo_update();
-          }
+        case 4:
+          fh=2200;
           break;
-        case 'D': //RD
-          // decrements RIT Frequency
-          if(command[2]==';') {
-            if(vfo[VFO_A].mode==modeCWL || vfo[VFO_A].mode==modeCWU) {
-              vfo[VFO_A].rit-=10;
-            } else {
-              vfo[VFO_A].rit-=50;
-            }
-            vfo_update();
-          } else if(command[7]==';') {
-            vfo[VFO_A].rit=atoi(&command[2]);
-            vfo_update();
-          }
+        case 5:
+          fh=2400;
           break;
-        case 'G': //RG
-          // set/read RF gain status
-          implemented=FALSE;
+        case 6:
+          fh=2600;
           break;
-        case 'L': //RL
-          // set/read noise reduction level
-          implemented=FALSE;
+        case 7:
+          fh=2800;
           break;
-        case 'M': //RM
-          // set/read meter function
-          implemented=FALSE;
+        case 8:
+          fh=3000;
           break;
-        case 'T': //RT
-          // set/read RIT enable
-          if(command[2]==';') {
-            sprintf(reply,"RT%d;",vfo[VFO_A].rit_enabled);
-            send_resp(client->fd,reply);
-          } else if(command[3]==';') {
-            vfo[VFO_A].rit_enabled=atoi(&command[2]);
-            vfo_update();
-          }
+        case 9:
+          fh=3400;
           break;
-        case 'U': //RU
-          // increments RIT Frequency
-          if(command[2]==';') {
-            if(vfo[VFO_A].mode==modeCWL || vfo[VFO_A].mode==modeCWU) {
-              vfo[VFO_A].rit+=10;
-            } else {
-              vfo[VFO_A].rit+=50;
-            }
-            vfo_update();
-          } else if(command[7]==';') {
-            vfo[VFO_A].rit=atoi(&command[2]);
-            vfo_update();
-          }
+        case 10:
+          fh=4000;
           break;
-        case 'X': //RX
-          // set transceiver to RX mode
-          if(command[2]==';') {
-            mox_update(0);
-          }
+        case 11:
+          fh=5000;
           break;
         default:
-          implemented=FALSE;
+          fh=100;
           break;
       }
       break;
-    case 'S':
-      switch(command[1]) {
-        case 'A': //SA
-          // set/read stallite mode status
-          if(command[2]==';') {
-            sprintf(reply,"SA%d%d%d%d%d%d%dSAT?    ;",(sat_mode==SAT_MODE)|(sat_mode==RSAT_MODE),0,0,0,sat_mode==SAT_MODE,sat_mode==RSAT_MODE,0);
-            send_resp(client->fd,reply);
-          } else if(command[9]==';') {
-            if(command[2]=='0') {
-              sat_mode=SAT_NONE;
-            } else if(command[2]=='1') {
-              if(command[6]=='0' && command[7]=='0') {
-                sat_mode=SAT_NONE;
-              } else if(command[6]=='1' && command[7]=='0') {
-                sat_mode=SAT_MODE;
-              } else if(command[6]=='0' && command[7]=='1') {
-                sat_mode=RSAT_MODE;
-              } else {
-                implemented=FALSE;
-              }
-            }
-          } else {
-            implemented=FALSE;
-          }
-          break;
-        case 'B': //SB
-          // set/read SUB,TF-W status
-          implemented=FALSE;
-          break;
-        case 'C': //SC
-          // set/read SCAN function status
-          implemented=FALSE;
-          break;
-        case 'D': //SD
-          // set/read CW break-in time delay
-          if(command[2]==';') {
-            sprintf(reply,"SD%04d;",(int)fmin(cw_keyer_hang_time,1000));
-            send_resp(client->fd,reply);
-          } else if(command[6]==';') {
-            int b=fmin(atoi(&command[2]),1000);
-            cw_breakin=b==0;
-            cw_keyer_hang_time=b;
-          } else {
-            implemented=FALSE;
-          }
-          break;
-        case 'H': //SH
-          // set/read filter high, switch to Var1 only when setting
-	  if(command[2]==';') {
-            FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
-            FILTER *filter=&mode_filters[vfo[active_receiver->id].filter];
-            int fh=5;
-            int high=filter->high;
-            if(vfo[active_receiver->id].mode==modeLSB) {
-              high=abs(filter->low);
-            }
-            if(high<=1400) {
-              fh=0;
-            } else if(high<=1600) {
-              fh=1;
-            } else if(high<=1800) {
-              fh=2;
-            } else if(high<=2000) {
-              fh=3;
-            } else if(high<=2200) {
-              fh=4;
-            } else if(high<=2400) {
-              fh=5;
-            } else if(high<=2600) {
-              fh=6;
-            } else if(high<=2800) {
-              fh=7;
-            } else if(high<=3000) {
-              fh=8;
-            } else if(high<=3400) {
-              fh=9;
-            } else if(high<=4000) {
-              fh=10;
-            } else {
-              fh=11;
-            }
-            sprintf(reply,"SH%02d;",fh);
-            send_resp(client->fd,reply) ;
-          } else if(command[4]==';') {
-            // make sure filter is filterVar1
-            if(vfo[active_receiver->id].filter!=filterVar1) {
-              vfo_filter_changed(filterVar1);
-            }
-            FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
-            FILTER *filter=&mode_filters[filterVar1];
-            int i=atoi(&command[2]);
-            int fh=100;
-            switch(vfo[active_receiver->id].mode) {
-              case modeLSB:
-              case modeUSB:
-              case modeFMN:
-                switch(i) {
-                  case 0:
-                    fh=1400;
-                    break;
-                  case 1:
-                    fh=1600;
-                    break;
-                  case 2:
-                    fh=1800;
-                    break;
-                  case 3:
-                    fh=2000;
-                    break;
-                  case 4:
-                    fh=2200;
-                    break;
-                  case 5:
-                    fh=2400;
-                    break;
-                  case 6:
-                    fh=2600;
-                    break;
-                  case 7:
-                    fh=2800;
-                    break;
-                  case 8:
-                    fh=3000;
-                    break;
-                  case 9:
-                    fh=3400;
-                    break;
-                  case 10:
-                    fh=4000;
-                    break;
-                  case 11:
-                    fh=5000;
-                    break;
-                  default:
-                    fh=100;
-                    break;
-                }
-                break;
-              case modeAM:
-              case modeSAM:
-                switch(i) {
-                  case 0:
-                    fh=10;
-                    break;
-                  case 1:
-                    fh=100;
-                    break;
-                  case 2:
-                    fh=200;
-                    break;
-                  case 3:
-                    fh=500;
-                    break;
-                  default:
-                    fh=100;
-                    break;
-                }
-                break;
-            }
-            if(vfo[active_receiver->id].mode==modeLSB) {
-              filter->low=-fh;
-            } else {
-              filter->high=fh;
-            }
-            vfo_filter_changed(filterVar1);
-          }
-          break;
-        case 'I': //SI
-          // enter satellite memory name
-          implemented=FALSE;
-          break;
-        case 'L': //SL
-          // set/read filter low, switch to Var1 only when setting
-	  if(command[2]==';') {
-            FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
-            FILTER *filter=&mode_filters[vfo[active_receiver->id].filter];
-            int fl=2;
-            int low=filter->low;
-            if(vfo[active_receiver->id].mode==modeLSB) {
-              low=abs(filter->high);
-            }
-          
-            if(low<=10) {
-              fl=0;
-            } else if(low<=50) {
-              fl=1;
-            } else if(low<=100) {
-              fl=2;
-            } else if(low<=200) {
-              fl=3;
-            } else if(low<=300) {
-              fl=4;
-            } else if(low<=400) {
-              fl=5;
-            } else if(low<=500) {
-              fl=6;
-            } else if(low<=600) {
-              fl=7;
-            } else if(low<=700) {
-              fl=8;
-            } else if(low<=800) {
-              fl=9;
-            } else if(low<=900) {
-              fl=10;
-            } else {
-              fl=11;
-            }
-            sprintf(reply,"SL%02d;",fl);
-            send_resp(client->fd,reply) ;
-          } else if(command[4]==';') {
-            // make sure filter is filterVar1
-            if(vfo[active_receiver->id].filter!=filterVar1) {
-              vfo_filter_changed(filterVar1);
-            }
-            FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
-            FILTER *filter=&mode_filters[filterVar1];
-            int i=atoi(&command[2]);
-            int fl=100;
-            switch(vfo[active_receiver->id].mode) {
-              case modeLSB:
-              case modeUSB:
-              case modeFMN:
-                switch(i) {
-                  case 0:
-                    fl=10;
-                    break;
-                  case 1:
-                    fl=50;
-                    break;
-                  case 2:
-                    fl=100;
-                    break;
-                  case 3:
-                    fl=200;
-                    break;
-                  case 4:
-                    fl=300;
-                    break;
-                  case 5:
-                    fl=400;
-                    break;
-                  case 6:
-                    fl=500;
-                    break;
-                  case 7:
-                    fl=600;
-                    break;
-                  case 8:
-                    fl=700;
-                    break;
-                  case 9:
-                    fl=800;
-                    break;
-                  case 10:
-                    fl=900;
-                    break;
-                  case 11:
-                    fl=1000;
-                    break;
-                  default:
-                    fl=100;
-                    break;
-                }
-                break;
-              case modeAM:
-              case modeSAM:
-                switch(i) {
-                  case 0:
-                    fl=10;
-                    break;
-                  case 1:
-                    fl=100;
-                    break;
-                  case 2:
-                    fl=200;
-                    break;
-                  case 3:
-                    fl=500;
-                    break;
-                  default:
-                    fl=100;
-                    break;
-                }
-                break;
-            }
-            if(vfo[active_receiver->id].mode==modeLSB) {
-              filter->high=-fl;
-            } else {
-              filter->low=fl;
-            }
-            vfo_filter_changed(filterVar1);
-          }
-          break;
-        case 'M': //SM
-          // read the S meter
-          if(command[3]==';') {
-            int id=atoi(&command[2]);
-            if(id==0 || id==1) {
-              sprintf(reply,"SM%04d;",(int)receiver[id]->meter);
-              send_resp(client->fd,reply);
-            }
-          }
-          break;
-        case 'Q': //SQ
-          // set/read Squelch level
-          if(command[3]==';') {
-            int p1=atoi(&command[2]);
-            if(p1==0) { // Main receiver
-              sprintf(reply,"SQ%d%03d;",p1,(int)((double)active_receiver->squelch/100.0*255.0+0.5));
-              send_resp(client->fd,reply);
-            }
-          } else if(command[6]==';') {
-            if(command[2]=='0') {
-              int p2=atoi(&command[3]);
-              active_receiver->squelch=(int)((double)p2/255.0*100.0+0.5);
-              set_squelch(active_receiver);
-            }
-          } else {
-          }
-          break;
-        case 'R': //SR
-          // reset transceiver
-          implemented=FALSE;
-          break;
-        case 'S': //SS
-          // set/read program scan pause frequency
-          implemented=FALSE;
+    case modeAM:
+    case modeSAM:
+      switch(i) {
+        case 0:
+          fh=10;
           break;
-        case 'T': //ST
-          // set/read MULTI/CH channel frequency steps
-          implemented=FALSE;
+        case 1:
+          fh=100;
           break;
-        case 'U': //SU
-          // set/read program scan pause frequency
-          implemented=FALSE;
+        case 2:
+          fh=200;
           break;
-        case 'V': //SV
-          // execute memory transfer function
-          implemented=FALSE;
+        case 3:
+          fh=500;
           break;
         default:
-          implemented=FALSE;
+          fh=100;
           break;
       }
       break;
-    case 'T':
-      switch(command[1]) {
-        case 'C': //TC
-          // set/read internal TNC mode
-          implemented=FALSE;
-          break;
-        case 'D': //TD
-          // send DTMF memory channel data
-          implemented=FALSE;
-          break;
-        case 'I': //TI
-          // read TNC LED status
-          implemented=FALSE;
-          break;
-        case 'N': //TN
-          // set/read sub-tone frequency
-          implemented=FALSE;
-          break;
-        case 'O': //TO
-          // set/read TONE function
-          implemented=FALSE;
-          break;
-        case 'S': //TS
-          // set/read TF-SET function
-          implemented=FALSE;
+  }
+  if(vfo[active_receiver->id].mode==modeLSB) {
+    filter->low=-fh;
+  } else {
+    filter->high=fh;
+  }
+  vfo_filter_changed(filterVar1);
+  return TRUE;
+}
+
+// set/read filter low, switch to Var1 only when setting
+static gboolean cat_sl_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
+  FILTER *filter=&mode_filters[vfo[active_receiver->id].filter];
+  int fl=2;
+  int low=filter->low;
+  if(vfo[active_receiver->id].mode==modeLSB) {
+    low=abs(filter->high);
+  }
+
+  if(low<=10) {
+    fl=0;
+  } else if(low<=50) {
+    fl=1;
+  } else if(low<=100) {
+    fl=2;
+  } else if(low<=200) {
+    fl=3;
+  } else if(low<=300) {
+    fl=4;
+  } else if(low<=400) {
+    fl=5;
+  } else if(low<=500) {
+    fl=6;
+  } else if(low<=600) {
+    fl=7;
+  } else if(low<=700) {
+    fl=8;
+  } else if(low<=800) {
+    fl=9;
+  } else if(low<=900) {
+    fl=10;
+  } else {
+    fl=11;
+  }
+  sprintf(reply,"SL%02d;",fl);
+  send_resp(client,reply) ;
+  return TRUE;
+}
+
+static gboolean cat_sl_set(CLIENT *client,char *command) {
+  // make sure filter is filterVar1
+  if(vfo[active_receiver->id].filter!=filterVar1) {
+    vfo_filter_changed(filterVar1);
+  }
+  FILTER *mode_filters=filters[vfo[active_receiver->id].mode];
+  FILTER *filter=&mode_filters[filterVar1];
+  int i=atoi(&command[2]);
+  int fl=100;
+  switch(vfo[active_receiver->id].mode) {
+    case modeLSB:
+    case modeUSB:
+    case modeFMN:
+      switch(i) {
+        case 0:
+          fl=10;
           break;
-        case 'X': //TX
-          // set transceiver to TX mode
-          if(command[2]==';') {
-            mox_update(1);
-          }
+        case 1:
+          fl=50;
           break;
-        case 'Y': //TY
-          // set/read microprocessor firmware type
-          implemented=FALSE;
+        case 2:
+          fl=100;
           break;
-        default:
-          implemented=FALSE;
+        case 3:
+          fl=200;
           break;
-      }
-      break;
-    case 'U':
-      switch(command[1]) {
-        case 'L': //UL
-          // detects the PLL unlock status
-          implemented=FALSE;
+        case 4:
+          fl=300;
           break;
-        case 'P': //UP
-          // move VFO A up by step
-          if(command[2]==';') {
-            vfo_step(1);
-          }
+        case 5:
+          fl=400;
           break;
-        default:
-          implemented=FALSE;
+        case 6:
+          fl=500;
           break;
-      }
-      break;
-    case 'V':
-      switch(command[1]) {
-        case 'D': //VD
-          // set/read VOX delay time
-          implemented=FALSE;
+        case 7:
+          fl=600;
           break;
-        case 'G': //VG
-          // set/read VOX gain (0..9)
-          if(command[2]==';') {
-            // convert 0.0..1.0 to 0..9
-            sprintf(reply,"VG%03d;",(int)((vox_threshold*100.0)*0.9));
-            send_resp(client->fd,reply);
-          } else if(command[5]==';') {
-            // convert 0..9 to 0.0..1.0
-            vox_threshold=atof(&command[2])/9.0;
-            vfo_update();
-          }
+        case 8:
+          fl=700;
           break;
-        case 'R': //VR
-          // emulate VOICE1 or VOICE2 key
-          implemented=FALSE;
+        case 9:
+          fl=800;
           break;
-        case 'X': //VX
-          // set/read VOX status
-          if(command[2]==';') {
-            sprintf(reply,"VX%d;",vox_enabled);
-            send_resp(client->fd,reply);
-          } else if(command[3]==';') {
-            vox_enabled=atoi(&command[2]);
-            vfo_update();
-          }
+        case 10:
+          fl=900;
           break;
-        default:
-          implemented=FALSE;
+        case 11:
+          fl=1000;
           break;
-      }
-      break;
-    case 'W':
-      switch(command[1]) {
         default:
-          implemented=FALSE;
+          fl=100;
           break;
       }
       break;
-    case 'X':
-      switch(command[1]) {
-        case 'T': //XT
-          // set/read XIT enable
-          if(command[2]==';') {
-            sprintf(reply,"XT%d;",transmitter->xit_enabled);
-            send_resp(client->fd,reply);
-          } else if(command[3]==';') {
-            transmitter->xit_enabled=atoi(&command[2]);
-            vfo_update();
-          }
+    case modeAM:
+    case modeSAM:
+      switch(i) {
+        case 0:
+          fl=10;
           break;
-        default:
-          implemented=FALSE;
+        case 1:
+          fl=100;
           break;
-      }
-      break;
-    case 'Y':
-      switch(command[1]) {
-        default:
-          implemented=FALSE;
+        case 2:
+          fl=200;
           break;
-      }
-      break;
-    case 'Z':
-      switch(command[1]) {
-        case 'Z':
-          implemented=parse_extended_cmd (command,client);
+        case 3:
+          fl=500;
           break;
         default:
-          implemented=FALSE;
+          fl=100;
           break;
       }
       break;
-    default:
-      implemented=FALSE;
-      break;
+  }
+  if(vfo[active_receiver->id].mode==modeLSB) {
+    filter->high=-fl;
+  } else {
+    filter->low=fl;
+  }
+  vfo_filter_changed(filterVar1);
+  return TRUE;
+}
+
+// read the S meter
+static gboolean cat_sm_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  int id=atoi(&command[2]);
+  if(id==0 || id==1) {
+    sprintf(reply,"SM%04d;",(int)receiver[id]->meter);
+    send_resp(client,reply);
+  }
+  return TRUE;
+}
+
+// set/read Squelch level
+static gboolean cat_sq_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  int p1=atoi(&command[2]);
+  if(p1==0) { // Main receiver
+    sprintf(reply,"SQ%d%03d;",p1,(int)((double)active_receiver->squelch/100.0*255.0+0.5));
+    send_resp(client,reply);
+  }
+  return TRUE;
+}
+
+static gboolean cat_sq_set(CLIENT *client,char *command) {
+  if(command[2]=='0') {
+    int p2=atoi(&command[3]);
+    active_receiver->squelch=(int)((double)p2/255.0*100.0+0.5);
+    set_squelch(active_receiver);
+  }
+  return TRUE;
+}
+
+// set transceiver to TX mode
+static gboolean cat_tx_set(CLIENT *client,char *command) {
+  mox_update(1);
+  return TRUE;
+}
+
+// move VFO A up by step
+static gboolean cat_up_set(CLIENT *client,char *command) {
+  vfo_step(1);
+  return TRUE;
+}
+
+// set/read VOX gain (0..9)
+static gboolean cat_vg_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  // convert 0.0..1.0 to 0..9
+  sprintf(reply,"VG%03d;",(int)((vox_threshold*100.0)*0.9));
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_vg_set(CLIENT *client,char *command) {
+  // convert 0..9 to 0.0..1.0
+  vox_threshold=atof(&command[2])/9.0;
+  vfo_update();
+  return TRUE;
+}
+
+// set/read VOX status
+static gboolean cat_vx_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"VX%d;",vox_enabled);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_vx_set(CLIENT *client,char *command) {
+  vox_enabled=atoi(&command[2]);
+  vfo_update();
+  return TRUE;
+}
+
+// set/read XIT enable
+static gboolean cat_xt_query(CLIENT *client,char *command) {
+  char reply[80];
+  reply[0]='\0';
+
+  sprintf(reply,"XT%d;",transmitter->xit_enabled);
+  send_resp(client,reply);
+  return TRUE;
+}
+
+static gboolean cat_xt_set(CLIENT *client,char *command) {
+  transmitter->xit_enabled=atoi(&command[2]);
+  vfo_update();
+  return TRUE;
+}
+
+#define CAT_HANDLER(name) name
+
+static const CAT_COMMAND cat_commands[CAT_KEYS]={
+#include "rigctl_commands.h"
+};
+
+// called with g_idle_add so that the processing is running on the main thread
+int parse_cmd(void *data) {
+  COMMAND *info=(COMMAND *)data;
+  CLIENT *client=info->client;
+  char *command=info->command;
+  CAT_FUNCTION function;
+  gboolean implemented=FALSE;
+
+  TRACE_EVENT(TRACE_CAT_PARSE, client->fd, trace_mnemonic(command));
+  function=cat_lookup(cat_commands,command);
+  if(function!=NULL) {
+    implemented=function(client,command);
   }
 
   if(!implemented) {
     if(rigctl_debug) g_print("RIGCTL: UNIMPLEMENTED COMMAND: %s\n",info->command);
-    send_resp(client->fd,"?;");
+    send_resp(client,"?;");
+  }
+  // the command may have changed the state the I/O thread reads
+  rigctl_publish_state();
+  if(g_atomic_int_get(&client->pending)>0) {
+    // a FIFO may be read again if this was the last pending command
+    if(g_atomic_int_dec_and_test(&client->pending) && client->fifo) rigctl_wakeup();
   }
-  client->done=1; // possibly inform server that command is finished
 
   g_free(info->command);
   g_free(info);
@@ -3885,84 +3908,13 @@ void set_blocking (int fd, int should_block)
                 g_print("RIGCTL: error %d setting term attributes\n", errno);
 }
 
-static gpointer serial_server(gpointer data) {
-     // We're going to Read the Serial port and
-     // when we get data we'll send it to parse_cmd
-     CLIENT *client=(CLIENT *)data;
-     char cmd_input[MAXDATASIZE];
-     char *command=g_new(char,MAXDATASIZE);
-     int command_index=0;
-     int numbytes;
-     int i;
-     g_mutex_lock(&mutex_a->m);
-     cat_control++;
-     if(rigctl_debug) g_print("RIGCTL: SER INC cat_contro=%d\n",cat_control);
-     g_mutex_unlock(&mutex_a->m);
-     g_idle_add(ext_vfo_update,NULL);
-     serial_running=TRUE;
-     while(serial_running) {
-       //
-       // If the "serial line" is a FIFO, we must not drain it
-       // by reading our own responses (it must go to the other
-       // side). Therefore, wait until 50msec after the last
-       // CAT command of this client has been processed.
-       // If for some reason this does not happen, resume after
-       // waiting for about 500 msec.
-       // Check serial_running after the "pause" and after returning
-       // from "read".
-       //
-       while (client->fifo && client->busy > 0) {
-         if (client->done) {
-           // command done, possibly response sent:
-           // wait 50 msec then resume listening
-           usleep(50000L);
-           break;
-         }
-         usleep(50000L);
-         client->busy--;
-       }
-       client->busy=0;
-       client->done=0;
-       if (!serial_running) break;
-       numbytes = read (client->fd, cmd_input, sizeof cmd_input);
-       if (!serial_running || numbytes < 0) break;
-       if(numbytes>0) {
-         for(i=0;i<numbytes;i++) {
-           command[command_index]=cmd_input[i];
-           command_index++;
-           if(cmd_input[i]==';') { 
-             command[command_index]='\0';
-             if(rigctl_debug) g_print("RIGCTL: command=%s\n",command);
-             COMMAND *info=g_new(COMMAND,1);
-             info->client=client;
-             info->command=command;
-             g_mutex_lock(&mutex_busy->m);
-             client->busy=10;
-             g_idle_add(parse_cmd,info);
-             g_mutex_unlock(&mutex_busy->m);
-
-             command=g_new(char,MAXDATASIZE);
-             command_index=0;
-           }
-         }
-       }
-     }
-     g_mutex_lock(&mutex_a->m);
-     cat_control--;
-     if(rigctl_debug) g_print("RIGCTL: SER DEC - cat_control=%d\n",cat_control);
-     g_mutex_unlock(&mutex_a->m);
-     g_idle_add(ext_vfo_update,NULL);
-     return NULL;
-}
-
 int launch_serial () {
      int fd;
      g_print("RIGCTL: Launch Serial port %s\n",ser_port);
 
-     if(mutex_busy==NULL) {
-       mutex_busy = g_new(GT_MUTEX,1);
-       g_print("launch_serial: mutex_busy=%p\n",mutex_busy);
-       g_mutex_init(&mutex_busy->m);
+     if(!server_running) {
+       g_print("RIGCTL: rigctl is not running\n");
+       return 0;
      }
      
      fd = open (ser_port, O_RDWR | O_NOCTTY | O_SYNC);   
@@ -3974,8 +3926,6 @@ int launch_serial () {
 
      g_print("serial port fd=%d\n",fd);
 
-     serial_client.fd=fd;
-     serial_client.busy=0;
      serial_client.fifo=0;
 
      if (set_interface_attribs (fd, serial_baud_rate, serial_parity) == 0) {
@@ -3988,30 +3938,33 @@ int launch_serial () {
        g_print("serial port is probably a FIFO\n");
        serial_client.fifo=1;
      }
+     set_nonblocking(fd);
 
-     serial_server_thread_id = g_thread_new( "Serial server", serial_server, &serial_client);
+     //
+     // From now on, the serial port is served by the I/O thread
+     //
+     start_client(&serial_client);
+     g_mutex_lock(&serial_client.output_mutex);
+     serial_client.fd=fd;
+     g_mutex_unlock(&serial_client.output_mutex);
+     rigctl_wakeup();
      return 1;
 }
 
 // Serial Port close
 void disable_serial () {
      g_print("RIGCTL: Disable Serial port %s\n",ser_port);
-     serial_running=FALSE;
-     if (serial_client.fifo) {
-       //
-       // If the "serial port" is a fifo then the serial thread
-       // may hang in a blocking read().
-       // Fortunately, we can set the thread free
-       // by sending something to the FIFO
-       //
-       write (serial_client.fd, "ID;", 3);
+     if (rigctl_io_thread_id == NULL) return;   // closed with the other ports
+     //
+     // The I/O thread closes the serial port, wait until it is done
+     //
+     g_mutex_lock(&serial_client.output_mutex);
+     g_atomic_int_set(&serial_client.close_request,1);
+     rigctl_wakeup();
+     while (serial_client.fd >= 0) {
+       g_cond_wait(&serial_closed,&serial_client.output_mutex);
      }
-     // wait for the serial server actually terminating
-     if (serial_server_thread_id) {
-       g_thread_join(serial_server_thread_id);
-     }
-     serial_server_thread_id=NULL;
-     close(serial_client.fd);
+     g_mutex_unlock(&serial_client.output_mutex);
 }
 
 //
@@ -4019,18 +3972,34 @@ void disable_serial () {
 //                   (Port numbers now const ints instead of defines..) 
 //
 void launch_rigctl () {
+   int i;
    
    g_print( "LAUNCHING RIGCTL!!\n");
 
+   if (rigctl_io_thread_id != NULL) return;   // already running
+
    rigctl_busy = 1;
    cat_control = 0;
    mutex_a = g_new(GT_MUTEX,1);  // memory leak
    g_mutex_init(&mutex_a->m);
 
-   // This routine encapsulates the thread call
-   rigctl_server_thread_id = g_thread_new( "rigctl server", rigctl_server, GINT_TO_POINTER(rigctl_port_base));
-   if( ! rigctl_server_thread_id )
-   {
-     g_print("g_thread_new failed on rigctl_server\n");
+   rigctl_publish_state();
+   if(rigctl_state_timer_id==0) {
+     rigctl_state_timer_id=g_timeout_add(RIGCTL_STATE_INTERVAL,rigctl_state_timer,NULL);
+   }
+
+   for (i=0; i<MAX_CLIENTS; i++) {
+     client[i].fd=-1;
+   }
+   serial_client.fd=-1;
+   if (pipe(wakeup_pipe) < 0) {
+     perror("rigctl: wakeup pipe");
+     return;
    }
+   set_nonblocking(wakeup_pipe[0]);
+   set_nonblocking(wakeup_pipe[1]);
+   server_running=1;
+
+   // This routine encapsulates the thread call
+   rigctl_io_thread_id = g_thread_new( "rigctl io", rigctl_io_thread, GINT_TO_POINTER(rigctl_port_base));
 }
@@ -15,7 +15,11 @@ int set_alc(gpointer);
 extern int rigctl_busy;
 
 extern int rigctl_port_base;
+#define MAX_CLIENTS 32     // upper limit for rigctl_max_clients
+extern int rigctl_max_clients;
 extern int rigctl_enable;
 
+extern void rigctl_publish_state(void);
+
 
 #endif // RIGCTL_H
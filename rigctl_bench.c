@@ -0,0 +1,167 @@
+/*
+ * File rigctl_bench.c
+ *
+ * Measure the round trip time of CAT commands sent to the rigctl TCP
+ * server of a running piHPSDR, with one or more clients polling at the
+ * same time (as logging programs, digimode programs and panadapters do).
+ *
+ * Each client sends a command, waits for the reply (up to the ';') and
+ * sends the next one. At the end, the percentiles of the round trip
+ * times over all clients are printed.
+ *
+ * usage: rigctl_bench [-a address] [-p port] [-n commands] [-k clients] [-c command]
+ *
+ * The command defaults to "FA;". Commands that have no reply (set
+ * commands) cannot be timed.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define MAX_CLIENTS 32
+
+typedef struct _bench_client {
+  pthread_t thread;
+  int id;
+  int errors;
+  double *rtt;
+  int count;
+} BENCH_CLIENT;
+
+static const char *address="127.0.0.1";
+static int port=19090;
+static int commands=10000;
+static const char *command="FA;";
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + 1E-9 * (double) ts.tv_nsec;
+}
+
+static int compare(const void *a, const void *b) {
+  double x=*(const double *) a;
+  double y=*(const double *) b;
+  return (x > y) - (x < y);
+}
+
+//
+// read until the ';' that ends the reply
+//
+static int read_reply(int fd, char *reply, int size) {
+  int n=0;
+  char c;
+  while (n < size-1) {
+    if (recv(fd, &c, 1, 0) != 1) return -1;
+    reply[n++]=c;
+    if (c == ';') break;
+  }
+  reply[n]='\0';
+  return n;
+}
+
+static void *client_thread(void *data) {
+  BENCH_CLIENT *client=(BENCH_CLIENT *) data;
+  struct sockaddr_in addr;
+  char reply[128];
+  int fd, i, on=1;
+  int length=strlen(command);
+  double t;
+
+  fd=socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("socket");
+    client->errors++;
+    return NULL;
+  }
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family=AF_INET;
+  addr.sin_port=htons(port);
+  addr.sin_addr.s_addr=inet_addr(address);
+  if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+    perror("connect");
+    close(fd);
+    client->errors++;
+    return NULL;
+  }
+
+  for (i=0; i<commands; i++) {
+    t=now();
+    if (send(fd, command, length, 0) != length || read_reply(fd, reply, sizeof(reply)) <= 0) {
+      client->errors++;
+      break;
+    }
+    client->rtt[client->count++]=now()-t;
+  }
+  close(fd);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  BENCH_CLIENT client[MAX_CLIENTS];
+  int clients=1;
+  int c, i, j, total=0, errors=0;
+  double *all;
+  double t, elapsed, sum=0.0;
+
+  while ((c=getopt(argc, argv, "a:p:n:k:c:")) != -1) {
+    switch (c) {
+      case 'a': address=optarg; break;
+      case 'p': port=atoi(optarg); break;
+      case 'n': commands=atoi(optarg); break;
+      case 'k': clients=atoi(optarg); break;
+      case 'c': command=optarg; break;
+      default:
+        fprintf(stderr, "usage: %s [-a address] [-p port] [-n commands] [-k clients] [-c command]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (clients < 1 || clients > MAX_CLIENTS || commands < 1 || command[strlen(command)-1] != ';') {
+    fprintf(stderr, "invalid arguments (at most %d clients, command must end with ';')\n", MAX_CLIENTS);
+    return 1;
+  }
+
+  t=now();
+  for (i=0; i<clients; i++) {
+    client[i].id=i;
+    client[i].errors=0;
+    client[i].count=0;
+    client[i].rtt=malloc(commands*sizeof(double));
+    pthread_create(&client[i].thread, NULL, client_thread, &client[i]);
+  }
+  for (i=0; i<clients; i++) {
+    pthread_join(client[i].thread, NULL);
+    total+=client[i].count;
+    errors+=client[i].errors;
+  }
+  elapsed=now()-t;
+
+  if (total == 0) {
+    fprintf(stderr, "no replies from %s:%d\n", address, port);
+    return 1;
+  }
+  all=malloc(total*sizeof(double));
+  for (i=0, j=0; i<clients; i++) {
+    memcpy(&all[j], client[i].rtt, client[i].count*sizeof(double));
+    j+=client[i].count;
+  }
+  qsort(all, total, sizeof(double), compare);
+  for (i=0; i<total; i++) sum+=all[i];
+
+  printf("%s to %s:%d, %d clients, %d replies, %d errors, %0.0f commands/sec\n",
+         command, address, port, clients, total, errors, total/elapsed);
+  printf("round trip usec: mean %0.1f min %0.1f p50 %0.1f p90 %0.1f p99 %0.1f max %0.1f\n",
+         1E6*sum/total, 1E6*all[0], 1E6*all[total/2], 1E6*all[(total*9)/10],
+         1E6*all[(total*99)/100], 1E6*all[total-1]);
+  return errors != 0;
+}
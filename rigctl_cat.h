@@ -0,0 +1,69 @@
+/*
+ * File rigctl_cat.h
+ *
+ * Table driven dispatch of the CAT commands in rigctl.c
+ *
+ * A command is identified by its mnemonic: two letters for the TS-2000
+ * commands ("FA"), "ZZ" and two letters for the extended commands
+ * ("ZZFA"). The mnemonic maps to an index of the command table without
+ * collisions (a perfect hash the compiler evaluates for the table
+ * initializers), so the lookup is a few compares and one array access.
+ *
+ * A command has up to two forms, told apart by the number of characters
+ * between the mnemonic and the ';': the query ("FA;") and the set form
+ * ("FA00014074000;"). If there is no handler for the number of arguments
+ * received, the command is answered with "?;" as an unknown command.
+ *
+ */
+
+#ifndef _RIGCTL_CAT_H
+#define _RIGCTL_CAT_H
+
+#include <string.h>
+
+typedef struct _client CLIENT;
+
+typedef gboolean (*CAT_FUNCTION)(CLIENT *client,char *command);
+
+#define CAT_ARGS_ANY -1     // the handler checks the arguments
+
+typedef struct _cat_command {
+  CAT_FUNCTION query;
+  CAT_FUNCTION set;
+  signed char query_args;
+  signed char set_args;
+} CAT_COMMAND;
+
+#define CAT_LETTER(c) ((c)>='A' && (c)<='Z')
+#define CAT_KEY(a,b) (((a)-'A')*26+((b)-'A'))
+#define CAT_ZZKEY(a,b) (26*26+CAT_KEY(a,b))
+#define CAT_KEYS (2*26*26)
+
+//
+// Entries of the command list in rigctl_commands.h
+//
+#define CAT_TS(a,b,query,query_args,set,set_args) [CAT_KEY(a,b)]={query,set,query_args,set_args},
+#define CAT_ZZ(a,b,query,query_args,set,set_args) [CAT_ZZKEY(a,b)]={query,set,query_args,set_args},
+
+//
+// Returns the handler for a command (terminated by ';'),
+// or NULL if it is unknown or has the wrong number of arguments
+//
+static inline CAT_FUNCTION cat_lookup(const CAT_COMMAND *table,const char *command) {
+  const CAT_COMMAND *entry;
+  int args;
+
+  if(!CAT_LETTER(command[0]) || !CAT_LETTER(command[1])) return NULL;
+  if(command[0]=='Z' && command[1]=='Z' && CAT_LETTER(command[2]) && CAT_LETTER(command[3])) {
+    entry=&table[CAT_ZZKEY(command[2],command[3])];
+    args=strlen(&command[4])-1;
+  } else {
+    entry=&table[CAT_KEY(command[0],command[1])];
+    args=strlen(&command[2])-1;
+  }
+  if(entry->query!=NULL && (entry->query_args==CAT_ARGS_ANY || entry->query_args==args)) return entry->query;
+  if(entry->set!=NULL && (entry->set_args==CAT_ARGS_ANY || entry->set_args==args)) return entry->set;
+  return NULL;
+}
+
+#endif
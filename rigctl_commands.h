@@ -0,0 +1,248 @@
+/*
+ * File rigctl_commands.h
+ *
+ * The CAT commands implemented in rigctl.c, for the command table
+ * (see rigctl_cat.h). There is no include guard: the list is expanded
+ * where the table is defined, with CAT_HANDLER(name) giving the handler.
+ *
+ * CAT_TS(letter, letter, query, query arguments, set, set arguments)
+ * CAT_ZZ(third letter, fourth letter, ...) for the "ZZ" extended commands
+ *
+ * The number of arguments is the number of characters between the
+ * mnemonic and the ';', CAT_ARGS_ANY if the handler checks them.
+ *
+ */
+
+//
+// TS-2000 commands
+//
+CAT_TS('A','G', CAT_HANDLER(cat_ag), CAT_ARGS_ANY, CAT_HANDLER(cat_ag), CAT_ARGS_ANY)  // set/read AF Gain
+CAT_TS('A','I', CAT_HANDLER(cat_ai), CAT_ARGS_ANY, CAT_HANDLER(cat_ai), CAT_ARGS_ANY)  // set/read Auto Information
+// not implemented: AC AL AM AN AS
+
+CAT_TS('B','D', CAT_HANDLER(cat_bd), CAT_ARGS_ANY, CAT_HANDLER(cat_bd), CAT_ARGS_ANY)  // band down 1 band
+CAT_TS('B','U', CAT_HANDLER(cat_bu), CAT_ARGS_ANY, CAT_HANDLER(cat_bu), CAT_ARGS_ANY)  // band up 1 band
+// not implemented: BC BP BY
+
+CAT_TS('C','N', CAT_HANDLER(cat_cn_query), 1, CAT_HANDLER(cat_cn_set), 2)  // sets/reads CTCSS function
+CAT_TS('C','T', CAT_HANDLER(cat_ct_query), 0, CAT_HANDLER(cat_ct_set), 1)  // sets/reads CTCSS status
+// not implemented: CA CG CI CM
+
+CAT_TS('D','N', CAT_HANDLER(cat_dn), CAT_ARGS_ANY, CAT_HANDLER(cat_dn), CAT_ARGS_ANY)  // move VFO A down 1 step size
+// not implemented: DC DQ
+
+CAT_TS('F','A', CAT_HANDLER(cat_fa_query), 0, CAT_HANDLER(cat_fa_set), 11)  // set/read VFO-A frequency
+CAT_TS('F','B', CAT_HANDLER(cat_fb_query), 0, CAT_HANDLER(cat_fb_set), 11)  // set/read VFO-B frequency
+CAT_TS('F','R', CAT_HANDLER(cat_fr_query), 0, CAT_HANDLER(cat_fr_set), 1)  // set/read transceiver receive VFO
+CAT_TS('F','T', CAT_HANDLER(cat_ft_query), 0, CAT_HANDLER(cat_ft_set), 1)  // set/read transceiver transmit VFO
+CAT_TS('F','W', CAT_HANDLER(cat_fw_query), 0, CAT_HANDLER(cat_fw_set), 4)  // set/read filter width. Switch to Var1 only when setting
+// not implemented: FC FD FS
+
+CAT_TS('G','T', CAT_HANDLER(cat_gt_query), 0, CAT_HANDLER(cat_gt_set), 3)  // set/read RX1 AGC
+
+CAT_TS('I','D', CAT_HANDLER(cat_id), CAT_ARGS_ANY, CAT_HANDLER(cat_id), CAT_ARGS_ANY)  // get ID
+CAT_TS('I','F', CAT_HANDLER(cat_if), CAT_ARGS_ANY, CAT_HANDLER(cat_if), CAT_ARGS_ANY)
+CAT_TS('I','S', CAT_HANDLER(cat_is_query), 0, CAT_HANDLER(cat_is_set), CAT_ARGS_ANY)  // set/read IF shift
+
+CAT_TS('K','S', CAT_HANDLER(cat_ks_query), 0, CAT_HANDLER(cat_ks_set), 3)  // set/read keying speed
+CAT_TS('K','Y', CAT_HANDLER(cat_ky_query), 0, CAT_HANDLER(cat_ky_set), 25)  // convert the chaaracters into Morse Code
+
+CAT_TS('L','K', CAT_HANDLER(cat_lk_query), 0, CAT_HANDLER(cat_lk_set), 2)  // set/read key lock
+// not implemented: LM LT
+
+CAT_TS('M','D', CAT_HANDLER(cat_md_query), 0, CAT_HANDLER(cat_md_set), 1)  // set/read operating mode
+CAT_TS('M','G', CAT_HANDLER(cat_mg_query), 0, CAT_HANDLER(cat_mg_set), 3)  // set/read Menu Gain (-12..60 converts to 0..100)
+// not implemented: MC MF ML MO MR MU MW
+
+CAT_TS('N','B', CAT_HANDLER(cat_nb_query), 0, CAT_HANDLER(cat_nb_set), 1)  // set/read noise blanker
+CAT_TS('N','R', CAT_HANDLER(cat_nr_query), 0, CAT_HANDLER(cat_nr_set), 1)  // set/read noise reduction
+CAT_TS('N','T', CAT_HANDLER(cat_nt_query), 0, CAT_HANDLER(cat_nt_set), 1)  // set/read ANF
+// not implemented: NL
+
+CAT_TS('P','A', CAT_HANDLER(cat_pa_query), 0, CAT_HANDLER(cat_pa_set), 2)  // set/read preamp function status
+CAT_TS('P','C', CAT_HANDLER(cat_pc_query), 0, CAT_HANDLER(cat_pc_set), 3)  // set/read PA Power
+CAT_TS('P','L', CAT_HANDLER(cat_pl_query), 0, CAT_HANDLER(cat_pl_set), 6)  // set/read speach processor input/output level
+CAT_TS('P','S', CAT_HANDLER(cat_ps_query), 0, CAT_HANDLER(cat_set_ignored), 1)  // set/read Power (always ON)
+// not implemented: PB PI PK PM PR
+
+CAT_TS('R','A', CAT_HANDLER(cat_ra_query), 0, CAT_HANDLER(cat_ra_set), 2)  // set/read Attenuator function
+CAT_TS('R','C', NULL, 0, CAT_HANDLER(cat_rc_set), 0)  // clears RIT
+CAT_TS('R','D', CAT_HANDLER(cat_rd_query), 0, CAT_HANDLER(cat_rd_set), 5)  // decrements RIT Frequency
+CAT_TS('R','T', CAT_HANDLER(cat_rt_query), 0, CAT_HANDLER(cat_rt_set), 1)  // set/read RIT enable
+CAT_TS('R','U', CAT_HANDLER(cat_ru_query), 0, CAT_HANDLER(cat_ru_set), 5)  // increments RIT Frequency
+CAT_TS('R','X', NULL, 0, CAT_HANDLER(cat_rx_set), 0)  // set transceiver to RX mode
+// not implemented: RG RL RM
+
+CAT_TS('S','A', CAT_HANDLER(cat_sa), CAT_ARGS_ANY, CAT_HANDLER(cat_sa), CAT_ARGS_ANY)  // set/read stallite mode status
+CAT_TS('S','D', CAT_HANDLER(cat_sd), CAT_ARGS_ANY, CAT_HANDLER(cat_sd), CAT_ARGS_ANY)  // set/read CW break-in time delay
+CAT_TS('S','H', CAT_HANDLER(cat_sh_query), 0, CAT_HANDLER(cat_sh_set), 2)  // set/read filter high, switch to Var1 only when setting
+CAT_TS('S','L', CAT_HANDLER(cat_sl_query), 0, CAT_HANDLER(cat_sl_set), 2)  // set/read filter low, switch to Var1 only when setting
+CAT_TS('S','M', CAT_HANDLER(cat_sm_query), 1, NULL, 0)  // read the S meter
+CAT_TS('S','Q', CAT_HANDLER(cat_sq_query), 1, CAT_HANDLER(cat_sq_set), 4)  // set/read Squelch level
+// not implemented: SB SC SI SR SS ST SU SV
+
+CAT_TS('T','X', NULL, 0, CAT_HANDLER(cat_tx_set), 0)  // set transceiver to TX mode
+// not implemented: TC TD TI TN TO TS TY
+
+CAT_TS('U','P', NULL, 0, CAT_HANDLER(cat_up_set), 0)  // move VFO A up by step
+// not implemented: UL
+
+CAT_TS('V','G', CAT_HANDLER(cat_vg_query), 0, CAT_HANDLER(cat_vg_set), 3)  // set/read VOX gain (0..9)
+CAT_TS('V','X', CAT_HANDLER(cat_vx_query), 0, CAT_HANDLER(cat_vx_set), 1)  // set/read VOX status
+// not implemented: VD VR
+
+CAT_TS('X','T', CAT_HANDLER(cat_xt_query), 0, CAT_HANDLER(cat_xt_set), 1)  // set/read XIT enable
+
+// not implemented: EX
+
+// not implemented: OF OI OS
+
+// not implemented: QC QI QR
+
+//
+// ZZ extended commands
+//
+CAT_ZZ('A','C', CAT_HANDLER(cat_zzac_query), 0, CAT_HANDLER(cat_zzac_set), 2)  // sets or reads the Step Size
+CAT_ZZ('A','D', NULL, 0, CAT_HANDLER(cat_zzad_set), 2)  // move VFO A down by selected step
+CAT_ZZ('A','E', NULL, 0, CAT_HANDLER(cat_zzae_set), 2)  // move VFO A down nn tune steps
+CAT_ZZ('A','F', NULL, 0, CAT_HANDLER(cat_zzaf_set), 2)  // move VFO A up nn tune steps
+CAT_ZZ('A','G', CAT_HANDLER(cat_zzag_query), 0, CAT_HANDLER(cat_zzag_set), CAT_ARGS_ANY)  // read/set audio gain
+CAT_ZZ('A','R', CAT_HANDLER(cat_zzar_query), 0, CAT_HANDLER(cat_zzar_set), CAT_ARGS_ANY)  // read/set RX0 AGC Threshold
+CAT_ZZ('A','S', CAT_HANDLER(cat_zzas), CAT_ARGS_ANY, CAT_HANDLER(cat_zzas), CAT_ARGS_ANY)  // read/set RX1 AGC Threshold
+CAT_ZZ('A','U', NULL, 0, CAT_HANDLER(cat_zzau_set), 2)  // move VFO A up by selected step
+// not implemented: ZZAA ZZAB ZZAI ZZAP ZZAT
+
+CAT_ZZ('B','A', NULL, 0, CAT_HANDLER(cat_zzba_set), 0)  // move RX2 down one band
+CAT_ZZ('B','B', NULL, 0, CAT_HANDLER(cat_zzbb_set), 0)  // move RX2 up one band
+CAT_ZZ('B','D', NULL, 0, CAT_HANDLER(cat_zzbd_set), 0)  // move RX1 down one band
+CAT_ZZ('B','E', NULL, 0, CAT_HANDLER(cat_zzbe_set), 2)  // move VFO B down nn tune steps
+CAT_ZZ('B','F', NULL, 0, CAT_HANDLER(cat_zzbf_set), 2)  // move VFO B up nn tune steps
+CAT_ZZ('B','M', NULL, 0, CAT_HANDLER(cat_zzbm_set), 2)  // move VFO B down by selected step
+CAT_ZZ('B','P', NULL, 0, CAT_HANDLER(cat_zzbp_set), 2)  // move VFO B up by selected step
+CAT_ZZ('B','S', CAT_HANDLER(cat_zzbs_query), 0, CAT_HANDLER(cat_zzbs_set), 3)  // set/read RX1 band switch
+CAT_ZZ('B','T', CAT_HANDLER(cat_zzbt), CAT_ARGS_ANY, CAT_HANDLER(cat_zzbt), CAT_ARGS_ANY)  // set/read RX2 band switch
+CAT_ZZ('B','U', NULL, 0, CAT_HANDLER(cat_zzbu_set), 0)  // move RX1 up one band
+CAT_ZZ('B','Y', CAT_HANDLER(cat_zzby), CAT_ARGS_ANY, CAT_HANDLER(cat_zzby), CAT_ARGS_ANY)  // closes console (ignored)
+// not implemented: ZZBG ZZBI ZZBR
+
+CAT_ZZ('C','B', CAT_HANDLER(cat_zzcb), CAT_ARGS_ANY, CAT_HANDLER(cat_zzcb), CAT_ARGS_ANY)  // VFO A to B
+CAT_ZZ('C','D', CAT_HANDLER(cat_zzcd), CAT_ARGS_ANY, CAT_HANDLER(cat_zzcd), CAT_ARGS_ANY)  // VFO B to A
+CAT_ZZ('C','F', CAT_HANDLER(cat_zzcf), CAT_ARGS_ANY, CAT_HANDLER(cat_zzcf), CAT_ARGS_ANY)  // Swap VFO A and B
+CAT_ZZ('C','N', CAT_HANDLER(cat_zzcn_query), 0, CAT_HANDLER(cat_zzcn_set), 1)  // set/read VFO A CTUN
+CAT_ZZ('C','O', CAT_HANDLER(cat_zzco_query), 0, CAT_HANDLER(cat_zzco_set), 1)  // set/read VFO B CTUN
+CAT_ZZ('C','P', CAT_HANDLER(cat_zzcp_query), 0, CAT_HANDLER(cat_set_ignored), 1)  // set/read compander
+// not implemented: ZZCI ZZCL ZZCM ZZCS ZZCT ZZCU
+
+CAT_ZZ('D','A', CAT_HANDLER(cat_zzda), CAT_ARGS_ANY, CAT_HANDLER(cat_zzda), CAT_ARGS_ANY)
+CAT_ZZ('D','B', CAT_HANDLER(cat_zzdb_query), 0, CAT_HANDLER(cat_set_ignored), 1)  // set/read RX Reference
+CAT_ZZ('D','C', CAT_HANDLER(cat_zzdc_query), 0, CAT_HANDLER(cat_set_ignored), 4)  // set/get diversity gain
+CAT_ZZ('D','D', CAT_HANDLER(cat_zzdd_query), 0, CAT_HANDLER(cat_set_ignored), 4)  // set/get diversity phase
+CAT_ZZ('D','M', CAT_HANDLER(cat_zzdm_query), 0, CAT_HANDLER(cat_set_ignored), CAT_ARGS_ANY)  // set/read Display Mode
+CAT_ZZ('D','N', CAT_HANDLER(cat_zzdn_query), 0, CAT_HANDLER(cat_set_ignored), CAT_ARGS_ANY)  // set/read waterfall low
+CAT_ZZ('D','O', CAT_HANDLER(cat_zzdo_query), 0, CAT_HANDLER(cat_set_ignored), CAT_ARGS_ANY)  // set/read waterfall high
+CAT_ZZ('D','P', CAT_HANDLER(cat_zzdp_query), 0, CAT_HANDLER(cat_set_ignored), CAT_ARGS_ANY)  // set/read panadapter high
+CAT_ZZ('D','Q', CAT_HANDLER(cat_zzdq_query), 0, CAT_HANDLER(cat_set_ignored), CAT_ARGS_ANY)  // set/read panadapter low
+CAT_ZZ('D','R', CAT_HANDLER(cat_zzdr_query), 0, CAT_HANDLER(cat_set_ignored), CAT_ARGS_ANY)  // set/read panadapter step
+// not implemented: ZZDE ZZDF ZZDU ZZDX ZZDY
+
+CAT_ZZ('E','A', CAT_HANDLER(cat_zzea_query), 0, CAT_HANDLER(cat_zzea_set), 33)  // set/read rx equalizer values
+CAT_ZZ('E','B', CAT_HANDLER(cat_zzeb_query), 0, CAT_HANDLER(cat_zzeb_set), 33)  // set/read tx equalizer values
+CAT_ZZ('E','R', CAT_HANDLER(cat_zzer_query), 0, CAT_HANDLER(cat_zzer_set), 1)  // set/read rx equalizer
+CAT_ZZ('E','T', CAT_HANDLER(cat_zzet_query), 0, CAT_HANDLER(cat_zzet_set), 1)  // set/read tx equalizer
+// not implemented: ZZEM
+
+CAT_ZZ('F','A', CAT_HANDLER(cat_zzfa_query), 0, CAT_HANDLER(cat_zzfa_set), 11)  // set/read VFO-A frequency
+CAT_ZZ('F','B', CAT_HANDLER(cat_zzfb_query), 0, CAT_HANDLER(cat_zzfb_set), 11)  // set/read VFO-B frequency
+CAT_ZZ('F','D', CAT_HANDLER(cat_zzfd_query), 0, CAT_HANDLER(cat_zzfd_set), 1)  // set/read deviation
+CAT_ZZ('F','H', CAT_HANDLER(cat_zzfh_query), 0, CAT_HANDLER(cat_zzfh_set), 5)  // set/read RX1 filter high
+CAT_ZZ('F','I', CAT_HANDLER(cat_zzfi_query), 0, CAT_HANDLER(cat_zzfi_set), 2)  // set/read RX1 DSP receive filter
+CAT_ZZ('F','J', CAT_HANDLER(cat_zzfj_query), 0, CAT_HANDLER(cat_zzfj_set), 2)  // set/read RX2 DSP receive filter
+CAT_ZZ('F','L', CAT_HANDLER(cat_zzfl_query), 0, CAT_HANDLER(cat_zzfl_set), 5)  // set/read RX1 filter low
+// not implemented: ZZFM ZZFR ZZFS ZZFV ZZFW ZZFX ZZFY
+
+CAT_ZZ('G','T', CAT_HANDLER(cat_zzgt_query), 0, CAT_HANDLER(cat_zzgt_set), 1)  // set/read RX1 AGC
+CAT_ZZ('G','U', CAT_HANDLER(cat_zzgu_query), 0, CAT_HANDLER(cat_zzgu_set), 1)  // set/read RX2 AGC
+// not implemented: ZZGE ZZGL
+
+CAT_ZZ('I','D', CAT_HANDLER(cat_zzid), CAT_ARGS_ANY, CAT_HANDLER(cat_zzid), CAT_ARGS_ANY)
+// not implemented: ZZIF ZZIO ZZIS ZZIT ZZIU
+
+CAT_ZZ('J','S', CAT_HANDLER(cat_zzjs_query), 2, NULL, 0)  // read packet stream statistics, ZZJS99; resets them
+
+CAT_ZZ('L','A', CAT_HANDLER(cat_zzla_query), 0, CAT_HANDLER(cat_zzla_set), CAT_ARGS_ANY)  // read/set RX0 gain
+CAT_ZZ('L','C', CAT_HANDLER(cat_zzlc), CAT_ARGS_ANY, CAT_HANDLER(cat_zzlc), CAT_ARGS_ANY)  // read/set RX1 gain
+CAT_ZZ('L','I', CAT_HANDLER(cat_zzli), CAT_ARGS_ANY, CAT_HANDLER(cat_zzli), CAT_ARGS_ANY)
+// not implemented: ZZLB ZZLD ZZLE ZZLF ZZLG ZZLH
+
+CAT_ZZ('M','D', CAT_HANDLER(cat_zzmd_query), 0, CAT_HANDLER(cat_zzmd_set), 2)  // set/read RX1 operating mode
+CAT_ZZ('M','E', CAT_HANDLER(cat_zzme_query), 0, CAT_HANDLER(cat_zzme_set), 2)  // set/read RX2 operating mode
+CAT_ZZ('M','G', CAT_HANDLER(cat_zzmg_query), 0, CAT_HANDLER(cat_zzmg_set), 3)  // set/read mic gain
+CAT_ZZ('M','L', CAT_HANDLER(cat_zzml_query), 0, NULL, 0)  // read DSP modes and indexes
+CAT_ZZ('M','N', CAT_HANDLER(cat_zzmn_query), 2, NULL, 0)  // read Filter Names and indexes
+CAT_ZZ('M','O', CAT_HANDLER(cat_zzmo_query), 0, NULL, 0)  // set/read MON status
+CAT_ZZ('M','R', CAT_HANDLER(cat_zzmr_query), 0, CAT_HANDLER(cat_zzmr_set), 1)  // set/read RX Meter mode
+CAT_ZZ('M','T', CAT_HANDLER(cat_zzmt_query), 0, NULL, 0)
+// not implemented: ZZMA ZZMB ZZMS ZZMU ZZMV ZZMW ZZMX ZZMY ZZMZ
+
+CAT_ZZ('N','A', CAT_HANDLER(cat_zzna_query), 0, CAT_HANDLER(cat_zzna_set), 1)  // set/read RX1 NB1
+CAT_ZZ('N','B', CAT_HANDLER(cat_zznb_query), 0, CAT_HANDLER(cat_zznb_set), 1)  // set/read RX1 NB2
+CAT_ZZ('N','C', CAT_HANDLER(cat_zznc_query), 0, CAT_HANDLER(cat_zznc_set), 1)  // set/read RX2 NB1
+CAT_ZZ('N','D', CAT_HANDLER(cat_zznd_query), 0, CAT_HANDLER(cat_zznd_set), 1)  // set/read RX2 NB2
+CAT_ZZ('N','N', CAT_HANDLER(cat_zznn_query), 0, CAT_HANDLER(cat_zznn_set), 1)  // set/read RX1 SNB status
+CAT_ZZ('N','O', CAT_HANDLER(cat_zzno_query), 0, CAT_HANDLER(cat_zzno_set), 1)  // set/read RX2 SNB status
+CAT_ZZ('N','R', CAT_HANDLER(cat_zznr_query), 0, CAT_HANDLER(cat_zznr_set), 1)  // set/read RX1 NR
+CAT_ZZ('N','S', CAT_HANDLER(cat_zzns_query), 0, CAT_HANDLER(cat_zzns_set), 1)  // set/read RX1 NR2
+CAT_ZZ('N','T', CAT_HANDLER(cat_zznt_query), 0, CAT_HANDLER(cat_zznt_set), 1)  // set/read RX1 ANF
+CAT_ZZ('N','U', CAT_HANDLER(cat_zznu_query), 0, CAT_HANDLER(cat_zznu_set), 1)  // set/read RX2 ANF
+CAT_ZZ('N','V', CAT_HANDLER(cat_zznv_query), 0, CAT_HANDLER(cat_zznv_set), 1)  // set/read RX2 NR
+CAT_ZZ('N','W', CAT_HANDLER(cat_zznw_query), 0, CAT_HANDLER(cat_zznw_set), 1)  // set/read RX2 NR2
+// not implemented: ZZNL ZZNM
+
+CAT_ZZ('P','A', CAT_HANDLER(cat_zzpa_query), 0, CAT_HANDLER(cat_zzpa_set), 1)  // set/read preamp setting
+
+CAT_ZZ('R','C', NULL, 0, CAT_HANDLER(cat_zzrc_set), 0)  // clear RIT frequency
+CAT_ZZ('R','D', CAT_HANDLER(cat_zzrd_query), 0, CAT_HANDLER(cat_zzrd_set), 5)  // decrement RIT frequency
+CAT_ZZ('R','F', CAT_HANDLER(cat_zzrf_query), 0, CAT_HANDLER(cat_zzrf_set), 5)  // set/read RIT frequency
+CAT_ZZ('R','M', CAT_HANDLER(cat_zzrm_query), 1, NULL, 0)  // read meter value
+CAT_ZZ('R','S', CAT_HANDLER(cat_zzrs_query), 0, CAT_HANDLER(cat_zzrs_set), 1)  // set/read RX2 enable
+CAT_ZZ('R','T', CAT_HANDLER(cat_zzrt_query), 0, CAT_HANDLER(cat_zzrt_set), 1)  // set/read RIT enable
+CAT_ZZ('R','U', CAT_HANDLER(cat_zzru_query), 0, CAT_HANDLER(cat_zzru_set), 5)  // increments RIT Frequency
+
+CAT_ZZ('S','A', NULL, 0, CAT_HANDLER(cat_zzsa_set), 0)  // move VFO A down one step
+CAT_ZZ('S','B', NULL, 0, CAT_HANDLER(cat_zzsb_set), 0)  // move VFO A up one step
+CAT_ZZ('S','G', NULL, 0, CAT_HANDLER(cat_zzsg_set), 0)  // move VFO B down 1 step
+CAT_ZZ('S','H', NULL, 0, CAT_HANDLER(cat_zzsh_set), 0)  // move VFO B up 1 step
+CAT_ZZ('S','L', CAT_HANDLER(cat_zzsl_query), 2, CAT_HANDLER(cat_zzsl_set), 13)  // read the frequency and signal level of a slice, set its frequency
+CAT_ZZ('S','M', CAT_HANDLER(cat_zzsm_query), 1, NULL, 0)  // reads the S Meter (in dB)
+CAT_ZZ('S','P', CAT_HANDLER(cat_zzsp_query), 0, CAT_HANDLER(cat_zzsp_set), 1)  // set/read split
+CAT_ZZ('S','W', CAT_HANDLER(cat_zzsw_query), 0, CAT_HANDLER(cat_zzsw_set), 1)  // set/read split
+// not implemented: ZZSD ZZSF ZZSN ZZSR ZZSS ZZST ZZSU ZZSV ZZSY ZZSZ
+
+CAT_ZZ('T','U', CAT_HANDLER(cat_zztu_query), 0, CAT_HANDLER(cat_zztu_set), 1)  // sets or reads TUN status
+CAT_ZZ('T','X', CAT_HANDLER(cat_zztx_query), 0, CAT_HANDLER(cat_zztx_set), 1)  // sets or reads MOX status
+// not implemented: ZZTA ZZTB ZZTF ZZTH ZZTI ZZTL ZZTM ZZTO ZZTP ZZTS ZZTV
+
+CAT_ZZ('X','C', NULL, 0, CAT_HANDLER(cat_zzxc_set), 0)  // clear transmitter XIT
+CAT_ZZ('X','F', CAT_HANDLER(cat_zzxf_query), 0, CAT_HANDLER(cat_zzxf_set), 5)  // set/read XIT
+CAT_ZZ('X','N', CAT_HANDLER(cat_zzxn_query), 0, NULL, 0)  // read combined RX1 status
+CAT_ZZ('X','O', CAT_HANDLER(cat_zzxo), CAT_ARGS_ANY, CAT_HANDLER(cat_zzxo), CAT_ARGS_ANY)  // read combined RX2 status
+CAT_ZZ('X','S', CAT_HANDLER(cat_zzxs_query), 0, CAT_HANDLER(cat_zzxs_set), 1)  // / set/read XIT enable
+CAT_ZZ('X','V', CAT_HANDLER(cat_zzxv_query), 0, NULL, 0)  // read combined VFO status
+// not implemented: ZZXH ZZXT
+
+CAT_ZZ('Y','R', NULL, 0, CAT_HANDLER(cat_zzyr_set), 1)  // switch receivers
+// not implemented: ZZYA ZZYB ZZYC
+
+// not implemented: ZZHA ZZHR ZZHT ZZHU ZZHV ZZHW ZZHX
+
+// not implemented: ZZKM ZZKO ZZKS ZZKY
+
+// not implemented: ZZUA ZZUS ZZUT ZZUX ZZUY
+
+// not implemented: ZZVA ZZVB ZZVC ZZVD ZZVE ZZVF ZZVH ZZVI ZZVJ ZZVK ZZVL
+//   ZZVM ZZVN ZZVO ZZVP ZZVQ ZZVR ZZVS ZZVT ZZVU ZZVV ZZVW ZZVX ZZVY ZZVZ
+
+// not implemented: ZZWA ZZWB ZZWC ZZWD ZZWE ZZWF ZZWG ZZWH ZZWJ ZZWK ZZWL
+//   ZZWM ZZWN ZZWO ZZWP ZZWQ ZZWR ZZWS ZZWT ZZWU ZZWV ZZWW
+
+// not implemented: ZZZA ZZZB ZZZZ
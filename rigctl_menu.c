@@ -66,6 +66,10 @@ static void rigctl_value_changed_cb(GtkWidget *widget, gpointer data) {
    rigctl_port_base = gtk_spin_button_get_value(GTK_SPIN_BUTTON(widget)); 
 }
 
+static void max_clients_changed_cb(GtkWidget *widget, gpointer data) {
+   rigctl_max_clients = gtk_spin_button_get_value(GTK_SPIN_BUTTON(widget));
+}
+
 static void serial_value_changed_cb(GtkWidget *widget, gpointer data) {
      sprintf(ser_port,"/dev/ttyACM%0d",(int) gtk_spin_button_get_value(GTK_SPIN_BUTTON(widget))); 
      fprintf(stderr,"RIGCTL_MENU: New Serial port=%s\n",ser_port);
@@ -184,6 +188,17 @@ void rigctl_menu(GtkWidget *parent) {
   gtk_grid_attach(GTK_GRID(grid),rigctl_port_spinner,1,2,2,1);
   g_signal_connect(rigctl_port_spinner,"value_changed",G_CALLBACK(rigctl_value_changed_cb),NULL);
 
+  GtkWidget *max_clients_label =gtk_label_new(NULL);
+  gtk_label_set_markup(GTK_LABEL(max_clients_label), "<b>Max. Clients</b>");
+  gtk_widget_show(max_clients_label);
+  gtk_grid_attach(GTK_GRID(grid),max_clients_label,3,2,1,1);
+
+  GtkWidget *max_clients_spinner =gtk_spin_button_new_with_range(1,MAX_CLIENTS,1);
+  gtk_spin_button_set_value(GTK_SPIN_BUTTON(max_clients_spinner),(double)rigctl_max_clients);
+  gtk_widget_show(max_clients_spinner);
+  gtk_grid_attach(GTK_GRID(grid),max_clients_spinner,4,2,1,1);
+  g_signal_connect(max_clients_spinner,"value_changed",G_CALLBACK(max_clients_changed_cb),NULL);
+
   /* Put the Serial Port stuff here */
              serial_enable_b=gtk_check_button_new_with_label("Serial Port Enable");
   gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (serial_enable_b), serial_enable);
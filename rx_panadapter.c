@@ -39,6 +39,7 @@
 #include "vfo.h"
 #include "mode.h"
 #include "actions.h"
+#include "new_protocol.h"
 #ifdef GPIO
 #include "gpio.h"
 #endif
@@ -625,6 +626,46 @@ void rx_panadapter_update(RECEIVER *rx) {
         sequence_error_count=0;
       }
     }
+    //
+    // IQ blocks dropped because the DSP thread of this receiver
+    // could not keep up. Show the count and the ring buffer high-water mark.
+    //
+    if(rx->dsp_ring_overruns!=0) {
+      cairo_move_to(cr,100.0,70.0);
+      cairo_set_source_rgb(cr,1.0,0.0,0.0);
+      cairo_set_font_size(cr,DISPLAY_FONT_SIZE2);
+      sprintf(text,"DSP Overruns: %d (ring %d/%d)",rx->dsp_ring_overruns,rx->dsp_ring_max_fill,rx->dsp_ring_depth-1);
+      cairo_show_text(cr, text);
+    }
+    //
+    // IQ packets dropped in the P2 receive path because an iq_thread
+    // could not keep up (summed over all DDCs, shown on first receiver only)
+    //
+    if(rx->id==0 && protocol==NEW_PROTOCOL) {
+      int ddc, depth=0, hw, drops;
+      int max_hw=0, total=0;
+      for(ddc=0;ddc<MAX_DDC;ddc++) {
+        new_protocol_iq_queue_stats(ddc,&depth,&hw,&drops);
+        total+=drops;
+        if(hw>max_hw) max_hw=hw;
+      }
+      if(total!=0) {
+        cairo_move_to(cr,100.0,90.0);
+        cairo_set_source_rgb(cr,1.0,0.0,0.0);
+        cairo_set_font_size(cr,DISPLAY_FONT_SIZE2);
+        sprintf(text,"IQ Drops: %d (queue %d/%d)",total,max_hw,depth);
+        cairo_show_text(cr, text);
+      }
+      int size, in_use, pool_hw, failures;
+      new_protocol_buffer_stats(&size,&in_use,&pool_hw,&failures);
+      if(failures!=0) {
+        cairo_move_to(cr,100.0,110.0);
+        cairo_set_source_rgb(cr,1.0,0.0,0.0);
+        cairo_set_font_size(cr,DISPLAY_FONT_SIZE2);
+        sprintf(text,"Buffer Pool Exhausted: %d (in use %d, max %d/%d)",failures,in_use,pool_hw,size);
+        cairo_show_text(cr, text);
+      }
+    }
   }
 
   if(rx->id==0 && protocol==ORIGINAL_PROTOCOL && device==DEVICE_HERMES_LITE2) {
@@ -0,0 +1,597 @@
+/*
+ * File slice.c
+ *
+ * Receive slices (see slice.h) and the pool of worker threads
+ * that runs their WDSP channels
+ *
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#ifdef __APPLE__
+#include "MacOS.h"  // emulate clock_gettime on old MacOS systems
+#endif
+
+#include <wdsp.h>
+
+#include "agc.h"
+#include "channelizer.h"
+#include "discovered.h"
+#include "mode.h"
+#include "property.h"
+#include "radio.h"
+#include "new_protocol.h"
+#include "slice.h"
+#include "trace.h"
+#include "vfo.h"
+
+#define SLICE_RING_DEPTH 8
+
+int slices=0;
+int slice_channelizer=0;
+SLICE slice[MAX_SLICES];
+
+//
+// Slices with a block to process, popped by the workers
+//
+static GAsyncQueue *slice_queue=NULL;
+static int workers=0;
+
+//
+// The channelizer is only used by the DSP thread of the first receiver,
+// and by slices_destroy. Once slices_destroy has set channelizer_stopped,
+// the DSP thread neither recreates the channelizer nor feeds the slices.
+//
+static GMutex channelizer_mutex;
+static int channelizer_stopped=1;
+static CHANNELIZER *channelizer=NULL;
+static double *channelizer_output[MAX_SLICES];
+static int channelizer_samples=0;   // room in each output buffer
+
+//
+// Number of DDCs (old protocol: HPSDR receivers) the radio provides
+//
+static int hardware_ddcs() {
+  switch(protocol) {
+    case ORIGINAL_PROTOCOL:
+      switch(device) {
+        case DEVICE_HERMES:
+        case DEVICE_STEMLAB:
+        case DEVICE_HERMES_LITE2:
+          return 4;
+        case DEVICE_ANGELIA:
+        case DEVICE_ORION:
+        case DEVICE_ORION2:
+          return 7;
+        default:
+          return 2;
+      }
+      break;
+    case NEW_PROTOCOL:
+      switch(device) {
+        case NEW_DEVICE_ATLAS:
+        case NEW_DEVICE_HERMES:
+        case NEW_DEVICE_HERMES2:
+          return 4;
+        case NEW_DEVICE_ANGELIA:
+        case NEW_DEVICE_ORION:
+        case NEW_DEVICE_ORION2:
+          return 7;
+        default:
+          return 2;
+      }
+      break;
+  }
+  return 0;
+}
+
+//
+// The first DDC after those used by the receivers, PURESIGNAL and DIVERSITY:
+// DDC0/1 (HERMES) or DDC2/3 (ANGELIA and beyond) are the receivers in the
+// new protocol, HPSDR receivers 1 and 2 in the old protocol.
+//
+int slice_first_ddc() {
+  if(protocol==NEW_PROTOCOL &&
+     (device==NEW_DEVICE_ANGELIA || device==NEW_DEVICE_ORION || device==NEW_DEVICE_ORION2)) {
+    return 4;
+  }
+  return 2;
+}
+
+int slices_max() {
+  if(slice_channelizer) return MAX_SLICES;
+  int n=hardware_ddcs()-slice_first_ddc();
+  if(n<0) n=0;
+  if(n>MAX_SLICES) n=MAX_SLICES;
+  return n;
+}
+
+//
+// Number of DDCs (old protocol: HPSDR receivers) used by the slices
+//
+int slice_ddcs() {
+  return slice_channelizer ? 0 : slices;
+}
+
+int slice_workers() {
+  return workers;
+}
+
+static gint64 slice_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gint64)ts.tv_sec*1000000000LL+(gint64)ts.tv_nsec;
+}
+
+static void slice_process(SLICE *s, double *iq) {
+  int error;
+  gint64 t0;
+
+  g_mutex_lock(&s->mutex);
+  t0=slice_time();
+  fexchange0(s->channel, iq, s->audio_output_buffer, &error);
+  if(error!=0) {
+    s->fexchange_errors++;
+  }
+  s->dsp_time+=slice_time()-t0;
+  s->blocks++;
+  TRACE_EVENT(TRACE_RX_BLOCK_END, s->channel, error);
+  s->meter=GetRXAMeter(s->channel, smeter)+meter_calibration;
+  g_mutex_unlock(&s->mutex);
+}
+
+//
+// A worker takes a slice from the queue and processes all its blocks.
+// If a block arrives after the ring has been found empty, but before
+// the slice is released, the worker keeps the slice.
+//
+static gpointer slice_worker(gpointer data) {
+  SLICE *s;
+  int outptr;
+
+  g_print("%s: %d\n",__FUNCTION__,GPOINTER_TO_INT(data));
+  while(1) {
+    s=(SLICE *)g_async_queue_pop(slice_queue);
+    do {
+      outptr=g_atomic_int_get(&s->iq_ring_outptr);
+      while(outptr!=g_atomic_int_get(&s->iq_ring_inptr)) {
+        TRACE_EVENT(TRACE_RX_BLOCK_START, s->channel, outptr);
+        slice_process(s, s->iq_ring+2*s->buffer_size*outptr);
+        outptr++;
+        if(outptr>=s->ring_depth) outptr=0;
+        g_atomic_int_set(&s->iq_ring_outptr,outptr);
+      }
+      g_atomic_int_set(&s->scheduled,0);
+    } while(outptr!=g_atomic_int_get(&s->iq_ring_inptr) &&
+            g_atomic_int_compare_and_exchange(&s->scheduled,0,1));
+  }
+  return NULL;
+}
+
+//
+// One worker per core, but not more than there are slices
+//
+static void slice_pool_start(int n) {
+  int cores=g_get_num_processors();
+  GThread *thread;
+
+  if(n>cores) n=cores;
+  if(slice_queue==NULL) slice_queue=g_async_queue_new();
+  while(workers<n) {
+    thread=g_thread_new("slice worker", slice_worker, GINT_TO_POINTER(workers));
+    if(!thread) {
+      g_print("g_thread_new failed on slice_worker\n");
+      exit(-1);
+    }
+    workers++;
+  }
+  g_print("%s: %d workers for %d cores\n",__FUNCTION__,workers,cores);
+}
+
+//
+// Called from the protocol thread when a block is complete, as
+// queue_rx_buffer in receiver.c: if the ring is full, the block is
+// dropped, the protocol thread never waits
+//
+static void slice_queue_block(SLICE *s) {
+  int inptr=g_atomic_int_get(&s->iq_ring_inptr);
+  int next=inptr+1;
+
+  if(next>=s->ring_depth) next=0;
+  if(next==g_atomic_int_get(&s->iq_ring_outptr)) {
+    s->overruns++;
+    TRACE_EVENT(TRACE_RX_OVERRUN, s->channel, s->overruns);
+    return;
+  }
+  s->iq_input_buffer=s->iq_ring+2*s->buffer_size*next;
+  g_atomic_int_set(&s->iq_ring_inptr,next);
+  if(g_atomic_int_compare_and_exchange(&s->scheduled,0,1)) {
+    g_async_queue_push(slice_queue,s);
+  }
+}
+
+//
+// The protocol thread announces itself in s->feeding before it looks at
+// s->open, and slices_destroy sets s->open to 2 (closing) before it
+// waits for s->feeding to drop to zero: once slices_destroy frees the ring, no
+// protocol thread is using it, and the protocol thread never waits.
+//
+void slice_add_iq_samples_block(SLICE *s, const double *iq, int n) {
+  int count;
+
+  g_atomic_int_inc(&s->feeding);
+  if(g_atomic_int_get(&s->open)!=1) {
+    g_atomic_int_dec_and_test(&s->feeding);
+    return;
+  }
+  while(n>0) {
+    count=s->buffer_size-s->samples;
+    if(count>n) count=n;
+    memcpy(s->iq_input_buffer+2*s->samples, iq, 2*count*sizeof(double));
+    s->samples+=count;
+    iq+=2*count;
+    n-=count;
+    if(s->samples>=s->buffer_size) {
+      slice_queue_block(s);
+      s->samples=0;
+    }
+  }
+  g_atomic_int_dec_and_test(&s->feeding);
+}
+
+//
+// Centre frequency of the DDC of the first receiver, as set by the protocols
+//
+long long slice_source_frequency() {
+  long long frequency=vfo[0].frequency-vfo[0].lo;
+
+  if(vfo[0].rit_enabled) {
+    frequency+=vfo[0].rit;
+  }
+  if(cw_is_on_vfo_freq) {
+    if(vfo[0].mode==modeCWU) {
+      frequency-=(long long)cw_keyer_sidetone_frequency;
+    } else if(vfo[0].mode==modeCWL) {
+      frequency+=(long long)cw_keyer_sidetone_frequency;
+    }
+  }
+  return frequency;
+}
+
+//
+// WDSP moves the slice from its offset in the sub-channel to the centre,
+// as set_offset does for CTUN
+//
+static void slice_set_shift(SLICE *s) {
+  SetRXAShiftFreq(s->channel, (double)s->shift);
+  RXANBPSetShiftFrequency(s->channel, (double)s->shift);
+  SetRXAShiftRun(s->channel, s->shift!=0);
+}
+
+//
+// Called by the DSP thread of the first receiver for each block of n
+// IQ samples, centred on centre (Hz), at sample_rate. Each slice in the
+// span is fed from the sub-channel nearest to it.
+//
+void slices_channelize(const double *iq, int n, int sample_rate, long long centre) {
+  int bins[MAX_SLICES];
+  double *out[MAX_SLICES];
+  SLICE *fed[MAX_SLICES];
+  long long offset;
+  int i, bin, shift, samples;
+  int nbins=0;
+
+  if(!slice_channelizer || slices<=0) return;
+  g_mutex_lock(&channelizer_mutex);
+  if(channelizer_stopped) {
+    g_mutex_unlock(&channelizer_mutex);
+    return;
+  }
+  if(channelizer==NULL || channelizer->input_rate!=sample_rate) {
+    destroy_channelizer(channelizer);
+    channelizer=create_channelizer(sample_rate);
+  }
+  if(channelizer==NULL) {
+    g_mutex_unlock(&channelizer_mutex);
+    return;
+  }
+  if(n/channelizer->decimation+1>channelizer_samples) {
+    channelizer_samples=n/channelizer->decimation+1;
+    for(i=0;i<MAX_SLICES;i++) {
+      g_free(channelizer_output[i]);
+      channelizer_output[i]=g_new(double,2*channelizer_samples);
+    }
+  }
+
+  for(i=0;i<slices;i++) {
+    SLICE *s=&slice[i];
+    if(!s->open) continue;
+    offset=slice_ddc_frequency(s)-centre;
+    s->in_span=channelizer_bin(channelizer, offset, &bin);
+    if(!s->in_span) continue;
+    shift=(int)(offset-(long long)bin*CHANNELIZER_SPACING);
+    if(bin!=s->bin || shift!=s->shift) {
+      s->bin=bin;
+      s->shift=shift;
+      slice_set_shift(s);
+    }
+    bins[nbins]=bin;
+    out[nbins]=channelizer_output[nbins];
+    fed[nbins]=s;
+    nbins++;
+  }
+
+  // the history of the channelizer is updated even if no slice is in the span
+  samples=channelizer_process(channelizer, iq, n, bins, nbins, out);
+  for(i=0;i<nbins;i++) {
+    slice_add_iq_samples_block(fed[i], out[i], samples);
+  }
+  g_mutex_unlock(&channelizer_mutex);
+}
+
+//
+// Frequency of the DDC: for CW, the carrier is heard at the side tone frequency
+//
+long long slice_ddc_frequency(SLICE *s) {
+  long long frequency=s->frequency;
+
+  if(s->mode==modeCWU) {
+    frequency-=(long long)cw_keyer_sidetone_frequency;
+  } else if(s->mode==modeCWL) {
+    frequency+=(long long)cw_keyer_sidetone_frequency;
+  }
+  return frequency;
+}
+
+void slice_set_frequency(SLICE *s, long long frequency) {
+  g_mutex_lock(&s->mutex);
+  s->frequency=frequency;
+  g_mutex_unlock(&s->mutex);
+  if(protocol==NEW_PROTOCOL && s->open && !slice_channelizer) {
+    schedule_high_priority();
+  }
+}
+
+//
+// CW filters are centred on the side tone, as those of the receivers
+//
+static void slice_set_passband(SLICE *s) {
+  double low=s->filter_low;
+  double high=s->filter_high;
+
+  if(s->mode==modeCWU) {
+    low+=cw_keyer_sidetone_frequency;
+    high+=cw_keyer_sidetone_frequency;
+  } else if(s->mode==modeCWL) {
+    low-=cw_keyer_sidetone_frequency;
+    high-=cw_keyer_sidetone_frequency;
+  }
+  RXASetPassband(s->channel, low, high);
+}
+
+static void slice_open(SLICE *s, int sample_rate, int buffer_size) {
+  s->sample_rate=sample_rate;
+  s->buffer_size=buffer_size;
+  s->output_samples=buffer_size/(sample_rate/48000);
+  s->audio_output_buffer=g_new(double,2*s->output_samples);
+  s->ring_depth=SLICE_RING_DEPTH;
+  s->iq_ring=g_new(double,2*s->buffer_size*s->ring_depth);
+  s->iq_input_buffer=s->iq_ring;
+  s->samples=0;
+  s->iq_ring_inptr=0;
+  s->iq_ring_outptr=0;
+  s->scheduled=0;
+  s->overruns=0;
+  s->fexchange_errors=0;
+  s->blocks=0;
+  s->dsp_time=0;
+  s->meter=-140.0;
+  s->in_span=0;
+  s->bin=0;
+  s->shift=0;
+
+g_print("%s: slice=%d channel=%d frequency=%lld mode=%d sample_rate=%d buffer_size=%d\n",
+        __FUNCTION__,s->id,s->channel,s->frequency,s->mode,s->sample_rate,s->buffer_size);
+  OpenChannel(s->channel,
+              s->buffer_size,
+              fft_size,
+              s->sample_rate,
+              48000, // dsp rate
+              48000, // output rate
+              0, // receive
+              1, // run
+              0.010, 0.025, 0.0, 0.010, 1);
+
+  RXASetNC(s->channel, fft_size);
+  RXASetMP(s->channel, 0);
+  SetRXAShiftRun(s->channel, 0);
+  SetRXAPanelBinaural(s->channel, 0);
+  SetRXAPanelRun(s->channel, 1);
+  SetRXAMode(s->channel, s->mode);
+  slice_set_passband(s);
+  SetRXAAGCMode(s->channel, s->agc);
+  SetRXAAGCTop(s->channel, 80.0);
+  s->feeding=0;
+  g_atomic_int_set(&s->open,1);
+}
+
+//
+// Open the WDSP channels of the first "slices" slices. sample_rate is
+// that of their DDCs, with the channelizer that of the first receiver.
+//
+void slices_create(int sample_rate, int buffer_size) {
+  int i;
+
+  if(slices<=0) return;
+  if(slices>MAX_SLICES) slices=MAX_SLICES;
+  if(slice_channelizer) {
+    if(channelizer_channels(sample_rate)==0) {
+      g_print("%s: no channelizer for %d Hz\n",__FUNCTION__,sample_rate);
+    }
+    sample_rate=CHANNELIZER_RATE;
+  }
+  for(i=0;i<slices;i++) {
+    if(!slice[i].open) slice_open(&slice[i], sample_rate, buffer_size);
+  }
+  slice_pool_start(slices);
+  g_mutex_lock(&channelizer_mutex);
+  channelizer_stopped=0;
+  g_mutex_unlock(&channelizer_mutex);
+}
+
+//
+// For benchmarks: wait until the workers have processed all blocks
+//
+void slices_wait() {
+  int i;
+
+  for(i=0;i<MAX_SLICES;i++) {
+    SLICE *s=&slice[i];
+    if(!s->open) continue;
+    while(g_atomic_int_get(&s->iq_ring_outptr)!=g_atomic_int_get(&s->iq_ring_inptr) ||
+          g_atomic_int_get(&s->scheduled)) {
+      usleep(1000);
+    }
+  }
+}
+
+//
+// The protocol threads may still be running: the slices are closed
+// first, then the blocks in the rings are processed, then the
+// channels and buffers are freed
+//
+void slices_destroy() {
+  int i;
+
+  g_mutex_lock(&channelizer_mutex);
+  channelizer_stopped=1;
+  destroy_channelizer(channelizer);
+  channelizer=NULL;
+  for(i=0;i<MAX_SLICES;i++) {
+    g_free(channelizer_output[i]);
+    channelizer_output[i]=NULL;
+  }
+  channelizer_samples=0;
+  g_mutex_unlock(&channelizer_mutex);
+
+  for(i=0;i<MAX_SLICES;i++) {
+    SLICE *s=&slice[i];
+    if(!g_atomic_int_compare_and_exchange(&s->open,1,2)) continue;
+    while(g_atomic_int_get(&s->feeding)!=0) {
+      usleep(100);
+    }
+  }
+  slices_wait();
+  for(i=0;i<MAX_SLICES;i++) {
+    SLICE *s=&slice[i];
+    if(s->open!=2) continue;
+    g_atomic_int_set(&s->open,0);
+    g_print("%s: slice=%d CloseChannel: %d overruns=%d fexchange_errors=%d\n",
+            __FUNCTION__,s->id,s->channel,s->overruns,s->fexchange_errors);
+    CloseChannel(s->channel);
+    g_free(s->iq_ring);
+    s->iq_ring=NULL;
+    g_free(s->audio_output_buffer);
+    s->audio_output_buffer=NULL;
+  }
+}
+
+//
+// Old protocol: the slices follow the sample rate of the receivers.
+// The channelizer follows the first receiver by itself.
+//
+void slices_change_sample_rate(int sample_rate) {
+  int i;
+
+  if(slice_channelizer) return;
+
+  for(i=0;i<MAX_SLICES;i++) {
+    SLICE *s=&slice[i];
+    if(!s->open || s->sample_rate==sample_rate) continue;
+    g_mutex_lock(&s->mutex);
+    s->sample_rate=sample_rate;
+    s->output_samples=s->buffer_size/(sample_rate/48000);
+    g_free(s->audio_output_buffer);
+    s->audio_output_buffer=g_new(double,2*s->output_samples);
+    SetChannelState(s->channel,0,1);
+    SetInputSamplerate(s->channel, sample_rate);
+    SetChannelState(s->channel,1,0);
+    g_mutex_unlock(&s->mutex);
+  }
+}
+
+void slices_save_state() {
+  char name[128];
+  char value[128];
+  int i;
+
+  sprintf(value,"%d",slices);
+  setProperty("slices",value);
+  sprintf(value,"%d",slice_channelizer);
+  setProperty("slices.channelizer",value);
+  for(i=0;i<slices;i++) {
+    sprintf(name,"slice.%d.frequency",i);
+    sprintf(value,"%lld",slice[i].frequency);
+    setProperty(name,value);
+    sprintf(name,"slice.%d.mode",i);
+    sprintf(value,"%d",slice[i].mode);
+    setProperty(name,value);
+    sprintf(name,"slice.%d.filter_low",i);
+    sprintf(value,"%d",slice[i].filter_low);
+    setProperty(name,value);
+    sprintf(name,"slice.%d.filter_high",i);
+    sprintf(value,"%d",slice[i].filter_high);
+    setProperty(name,value);
+    sprintf(name,"slice.%d.agc",i);
+    sprintf(value,"%d",slice[i].agc);
+    setProperty(name,value);
+  }
+}
+
+//
+// Without properties, the slices are 1 kHz apart in the
+// CW part of 20m, with a 500 Hz filter
+//
+void slices_restore_state() {
+  char name[128];
+  char *value;
+  int i;
+
+  value=getProperty("slices");
+  if(value) slices=atoi(value);
+  value=getProperty("slices.channelizer");
+  if(value) slice_channelizer=atoi(value);
+  if(slices<0) slices=0;
+  if(slices>MAX_SLICES) slices=MAX_SLICES;
+  for(i=0;i<MAX_SLICES;i++) {
+    SLICE *s=&slice[i];
+    if(s->open) continue;
+    s->id=i;
+    s->channel=CHANNEL_SLICE0+i;
+    s->frequency=14010000LL+1000LL*i;
+    s->mode=modeCWU;
+    s->filter_low=-250;
+    s->filter_high=250;
+    s->agc=AGC_MEDIUM;
+    g_mutex_init(&s->mutex);
+    sprintf(name,"slice.%d.frequency",i);
+    value=getProperty(name);
+    if(value) s->frequency=atoll(value);
+    sprintf(name,"slice.%d.mode",i);
+    value=getProperty(name);
+    if(value) s->mode=atoi(value);
+    sprintf(name,"slice.%d.filter_low",i);
+    value=getProperty(name);
+    if(value) s->filter_low=atoi(value);
+    sprintf(name,"slice.%d.filter_high",i);
+    value=getProperty(name);
+    if(value) s->filter_high=atoi(value);
+    sprintf(name,"slice.%d.agc",i);
+    value=getProperty(name);
+    if(value) s->agc=atoi(value);
+  }
+}
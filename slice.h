@@ -0,0 +1,111 @@
+/*
+ * File slice.h
+ *
+ * Receive slices: receivers without panadapter, waterfall and audio
+ * output, for skimmers or for watching many frequencies in a contest.
+ *
+ * Each slice has its own DDC (old protocol: HPSDR receiver) and its own
+ * WDSP channel. The slices use the DDCs after those of the two receivers,
+ * so their number is limited by the hardware (see slices_max). In the
+ * old protocol, the slices have the sample rate of the receivers and are
+ * only fed while neither PURESIGNAL nor DIVERSITY is active; in the new
+ * protocol, their DDCs run at 48 kHz.
+ *
+ * The IQ blocks of the slices are not processed by a thread of their
+ * own but by a pool of worker threads, one per CPU core. A slice whose
+ * ring holds a block is queued for the pool, and one worker processes
+ * all its blocks. fexchange0 waits for WDSP (blocking mode), so no more
+ * WDSP channels than there are cores are busy at a time, however many
+ * slices there are.
+ *
+ * With the channelizer ("slices.channelizer"), the slices need no DDCs:
+ * the IQ samples of the first receiver are split into sub-channels
+ * (see channelizer.h) by its DSP thread, and each slice is fed at 48 kHz
+ * from the sub-channel nearest to its frequency, which WDSP shifts to
+ * the centre. Slices outside the span of the first receiver get no
+ * samples. Then the number of slices is only limited by the CPU, and
+ * the DDC of the first receiver can run at 768 or 1536 kHz to cover
+ * a whole band.
+ *
+ * The number of slices and their frequency, mode and filter are radio
+ * properties ("slices", "slice.N.frequency", ...) read at start-up.
+ * The CAT command ZZSL reads the frequency and the signal level of a
+ * slice, and sets its frequency.
+ *
+ */
+
+#ifndef _SLICE_H
+#define _SLICE_H
+
+#define MAX_SLICES 16
+#define CHANNEL_SLICE0 12   // WDSP channels CHANNEL_SLICE0 ... CHANNEL_SLICE0+MAX_SLICES-1
+
+typedef struct _slice {
+  int id;
+  int channel;               // WDSP channel
+  volatile gint open;        // the WDSP channel is open (2: being closed)
+  volatile gint feeding;     // protocol threads in slice_add_iq_samples_block
+
+  long long frequency;       // Hz
+  int mode;
+  int filter_low;            // Hz, relative to the frequency
+  int filter_high;
+  int agc;
+
+  int sample_rate;
+  int buffer_size;
+  int output_samples;
+  double *audio_output_buffer;
+
+  //
+  // Ring of IQ blocks, filled by the protocol thread (single producer)
+  // and emptied by the worker that has the slice (single consumer)
+  //
+  double *iq_ring;
+  int ring_depth;
+  double *iq_input_buffer;   // block currently filled
+  int samples;               // IQ samples in that block
+  volatile gint iq_ring_inptr;
+  volatile gint iq_ring_outptr;
+  volatile gint scheduled;   // queued for or processed by a worker
+
+  gint overruns;             // blocks dropped because the ring was full
+  gint fexchange_errors;
+  gint64 blocks;             // blocks processed
+  gint64 dsp_time;           // nsec in fexchange0
+  double meter;              // signal level in dBm, read with ZZSL
+
+  //
+  // Channelizer only: the sub-channel, relative to the centre of the
+  // first receiver, and the offset of the slice from its centre
+  //
+  int in_span;
+  int bin;
+  int shift;                 // Hz
+
+  GMutex mutex;
+} SLICE;
+
+extern int slices;
+extern int slice_channelizer;
+extern SLICE slice[MAX_SLICES];
+
+extern int slices_max(void);
+extern int slice_first_ddc(void);
+extern int slice_ddcs(void);
+extern void slices_create(int sample_rate, int buffer_size);
+extern void slices_destroy(void);
+extern void slices_change_sample_rate(int sample_rate);
+extern void slices_wait(void);
+extern int slice_workers(void);
+
+extern long long slice_ddc_frequency(SLICE *s);
+extern void slice_set_frequency(SLICE *s, long long frequency);
+extern void slice_add_iq_samples_block(SLICE *s, const double *iq, int n);
+extern long long slice_source_frequency(void);
+extern void slices_channelize(const double *iq, int n, int sample_rate, long long centre);
+
+extern void slices_save_state(void);
+extern void slices_restore_state(void);
+
+#endif
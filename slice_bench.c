@@ -0,0 +1,194 @@
+/*
+ * File slice_bench.c
+ *
+ * How many receive slices (see slice.h) does this computer sustain?
+ *
+ * A test signal is fed into 1, 2, ... slices through the real slice.c
+ * code, whose worker pool runs the WDSP channels as in piHPSDR. There is
+ * no radio and no display. The signal is fed as fast as the workers can
+ * take it: the feeding thread only waits while the ring of a slice is
+ * almost full, so no block is dropped.
+ *
+ * usage: slice_bench [-m max_slices] [-s sample_rate] [-b buffer_size]
+ *                    [-f fft_size] [-t seconds] [-c]
+ *
+ * Without -c, each slice has a DDC of its own at the sample rate: 48000
+ * for the new protocol, that of the receivers for the old protocol.
+ * With -c, the test signal is a wide DDC at the sample rate (e.g. 768000)
+ * that the channelizer splits into the slices (see channelizer.h), and
+ * the slices are spread over its span.
+ *
+ * To compare the CPU per slice of the approaches, e.g. for 768 kHz:
+ *   slice_bench -s 768000 -c    one wide DDC and the channelizer
+ *   slice_bench -s 768000       each WDSP channel decimates 768 kHz itself
+ *   slice_bench -s 48000        a DDC in the radio for each slice
+ *
+ * Results, for each number of slices: how many times faster than real
+ * time all slices were processed, the CPU time per slice (in percent of
+ * one core, including the channelizer), the time per fexchange0 and,
+ * with -c, the time the channelizer needs per block of the wide DDC.
+ * A number of slices is sustained if they run at least 1.25 times faster
+ * than real time, which leaves room for the receivers, the display and
+ * the network.
+ *
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <math.h>
+#include <sys/utsname.h>
+
+#include <wdsp.h>
+
+#include "discovered.h"
+#include "radio.h"
+#include "main.h"
+#include "slice.h"
+#include "channelizer.h"
+#include "bench_stubs.h"
+
+#define SUSTAINED 1.25
+
+//
+// One second of IQ samples: a CW carrier 600 Hz above the centre,
+// keyed at 20 wpm, and noise
+//
+static double *make_signal(int rate) {
+  double *iq=g_new(double, 2*rate);
+  unsigned int seed=1;
+  double phase=0.0;
+  double level;
+  int i;
+
+  for (i=0; i<rate; i++) {
+    level=((i/(rate/16)) & 1) ? 0.01 : 0.0;
+    seed=seed*1103515245+12345;
+    iq[2*i]  =level*cos(phase)+0.00001*((double)(seed>>16)/32768.0-1.0);
+    seed=seed*1103515245+12345;
+    iq[2*i+1]=level*sin(phase)+0.00001*((double)(seed>>16)/32768.0-1.0);
+    phase+=2.0*M_PI*600.0/(double)rate;
+    if (phase > 2.0*M_PI) phase-=2.0*M_PI;
+  }
+  return iq;
+}
+
+//
+// Wait until the ring of the slice has room for another block
+//
+static void wait_for_ring(SLICE *s) {
+  int fill;
+  for (;;) {
+    fill=g_atomic_int_get(&s->iq_ring_inptr)-g_atomic_int_get(&s->iq_ring_outptr);
+    if (fill < 0) fill+=s->ring_depth;
+    if (s->ring_depth-2 > fill) return;
+    sched_yield();
+  }
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [-m max_slices] [-s sample_rate] [-b buffer_size] [-f fft_size] [-t seconds] [-c]\n", name);
+  exit(1);
+}
+
+int main(int argc, char **argv) {
+  int max=MAX_SLICES;
+  int rate=48000;
+  int seconds=10;
+  int sustained=0;
+  int c, i, k, n, pos, overruns;
+  long long span=0;
+  gint64 blocks, dsp_time;
+  double *signal;
+  double t, t0, elapsed, cpu, realtime, split;
+  DISCOVERED bench_radio;
+
+  while ((c=getopt(argc, argv, "m:s:b:f:t:c")) != -1) {
+    switch (c) {
+      case 'm': max=atoi(optarg); break;
+      case 's': rate=atoi(optarg); break;
+      case 'b': buffer_size=atoi(optarg); break;
+      case 'f': fft_size=atoi(optarg); break;
+      case 't': seconds=atoi(optarg); break;
+      case 'c': slice_channelizer=1; break;
+      default: usage(argv[0]);
+    }
+  }
+  if (max < 1 || max > MAX_SLICES || rate < 48000 || rate % 48000 != 0 ||
+      buffer_size < 64 || rate % buffer_size != 0 || seconds < 1) usage(argv[0]);
+  if (slice_channelizer) {
+    if (channelizer_channels(rate) == 0) usage(argv[0]);
+    // the centre of the outermost sub-channels that are used
+    span=(long long)(channelizer_channels(rate)/2-1)*CHANNELIZER_SPACING;
+  }
+
+  uname(&unameData);
+  memset(&bench_radio, 0, sizeof(bench_radio));
+  radio=&bench_radio;
+  protocol=NEW_PROTOCOL;
+  device=NEW_DEVICE_ORION2;
+  radio->protocol=protocol;
+  radio->device=device;
+
+  signal=make_signal(rate);
+  slices_restore_state();   // no properties: the default slices
+
+  printf("%s %s, %d online cores, %d Hz, buffer %d, fft %d, %d seconds of signal, %s\n",
+         unameData.sysname, unameData.machine, g_get_num_processors(), rate, buffer_size, fft_size, seconds,
+         slice_channelizer ? "channelizer" : "a DDC per slice");
+  printf("slices workers  x real time  CPU/slice  fexchange0 (usec)  split (usec)\n");
+
+  for (k=1; k<=max; k++) {
+    slices=k;
+    for (i=0; i<k; i++) {
+      // with the channelizer, the slices are spread over the span of the wide DDC
+      slice[i].frequency=-span+(2*span*i+span)/k;
+    }
+    slices_create(rate, buffer_size);
+
+    split=0.0;
+    t0=bench_now();
+    cpu=bench_cpu_time();
+    for (n=0; n<seconds; n++) {
+      for (pos=0; pos<rate; pos+=buffer_size) {
+        if (slice_channelizer) {
+          for (i=0; i<k; i++) wait_for_ring(&slice[i]);
+          t=bench_now();
+          slices_channelize(signal+2*pos, buffer_size, rate, 0);
+          split+=bench_now()-t;
+        } else {
+          for (i=0; i<k; i++) {
+            wait_for_ring(&slice[i]);
+            slice_add_iq_samples_block(&slice[i], signal+2*pos, buffer_size);
+          }
+        }
+      }
+    }
+    slices_wait();
+    elapsed=bench_now()-t0;
+    cpu=bench_cpu_time()-cpu;
+
+    blocks=0;
+    dsp_time=0;
+    overruns=0;
+    for (i=0; i<k; i++) {
+      g_mutex_lock(&slice[i].mutex);
+      blocks+=slice[i].blocks;
+      dsp_time+=slice[i].dsp_time;
+      overruns+=slice[i].overruns;
+      g_mutex_unlock(&slice[i].mutex);
+    }
+    realtime=(double)seconds/elapsed;
+    printf("%6d %7d %12.2f %9.1f%% %18.1f %13.1f%s\n", k, slice_workers(), realtime,
+           100.0*cpu/(k*seconds), 1E-3*(double)dsp_time/(blocks ? blocks : 1),
+           1E6*split/(seconds*(rate/buffer_size)), overruns ? "  overruns!" : "");
+    if (realtime >= SUSTAINED && overruns == 0) sustained=k;
+
+    slices_destroy();
+  }
+  printf("sustained: %d slices (at least %0.2f x real time)\n", sustained, SUSTAINED);
+  return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * File spectrum_bench.c
+ *
+ * Compare the uncompressed spectrum frames (INFO_SPECTRUM) of the
+ * client/server mode with the compressed ones (INFO_SPECTRUM_COMPRESSED):
+ * bytes per frame and encoding CPU time per frame.
+ *
+ * The panadapter data is synthetic: a noise floor with some noise that is
+ * averaged over frames (as the display averaging does), a number of
+ * carriers with slowly fading levels, and a band edge.
+ * Every frame is also decoded to check that the round trip is within
+ * one quantization step.
+ *
+ * usage: spectrum_bench [-w width] [-n frames] [-l low] [-h high]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+
+#include "spectrum_codec.h"
+
+//
+// Sizes of the frames as in client_server.h
+//
+#define HEADER_SIZE 20
+#define SPECTRUM_DATA_SIZE 800
+#define RAW_FRAME_SIZE (HEADER_SIZE+1+6*8+2+2+2*SPECTRUM_DATA_SIZE)
+#define COMPRESSED_FIXED_SIZE (HEADER_SIZE+1+1+1+2+2+2)
+
+#define CARRIERS 12
+
+static double now(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (double) ts.tv_sec + 1E-9 * (double) ts.tv_nsec;
+}
+
+static double gauss() {
+  // sum of uniform numbers is good enough here
+  double sum=0.0;
+  int i;
+  for (i=0; i<12; i++) sum+=(double) rand() / (double) RAND_MAX;
+  return sum - 6.0;
+}
+
+int main(int argc, char **argv) {
+  int width=SPECTRUM_DATA_SIZE;
+  int frames=10000;
+  int low=-140;
+  int high=-40;
+  int c, f, i, keyframe, k, bytes;
+  int carrier_pos[CARRIERS];
+  double carrier_level[CARRIERS];
+  float *spectrum, *decoded, *noise;
+  uint16_t raw[SPECTRUM_DATA_SIZE];
+  unsigned char out[SPECTRUM_CODEC_MAX_BYTES];
+  SPECTRUM_CODEC encoder, decoder;
+  double t0, raw_cpu=0.0, codec_cpu=0.0;
+  double raw_bytes=0.0, codec_bytes=0.0, max_error=0.0;
+  int keyframes=0;
+  volatile uint16_t sink=0;
+
+  while ((c=getopt(argc, argv, "w:n:l:h:")) != -1) {
+    switch (c) {
+      case 'w': width=atoi(optarg); break;
+      case 'n': frames=atoi(optarg); break;
+      case 'l': low=atoi(optarg); break;
+      case 'h': high=atoi(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-w width] [-n frames] [-l low] [-h high]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (width < 1 || width > SPECTRUM_CODEC_MAX_SAMPLES || frames < 1 || high <= low) {
+    fprintf(stderr, "invalid arguments\n");
+    return 1;
+  }
+
+  srand(1);
+  spectrum=malloc(width*sizeof(float));
+  decoded=malloc(width*sizeof(float));
+  noise=calloc(width, sizeof(float));
+  for (c=0; c<CARRIERS; c++) {
+    carrier_pos[c]=rand() % width;
+    carrier_level[c]=-110.0 + 50.0 * (double) rand() / (double) RAND_MAX;
+  }
+  spectrum_codec_reset(&encoder);
+  spectrum_codec_reset(&decoder);
+
+  for (f=0; f<frames; f++) {
+    //
+    // generate the next frame
+    //
+    for (i=0; i<width; i++) {
+      double v;
+      noise[i]=0.7f * noise[i] + 0.3f * (float)(5.0 * gauss());
+      v=-125.0 + noise[i];
+      if (i < width/20) v-=10.0;                     // outside the band
+      spectrum[i]=(float) v;
+    }
+    for (c=0; c<CARRIERS; c++) {
+      carrier_level[c]+=0.5 * gauss();
+      if (carrier_level[c] > -50.0) carrier_level[c]=-50.0;
+      if (carrier_level[c] < -115.0) carrier_level[c]=-115.0;
+      for (i=-2; i<=2; i++) {
+        int p=carrier_pos[c]+i;
+        if (p >= 0 && p < width) {
+          float v=(float)(carrier_level[c] - 6.0 * abs(i));
+          if (v > spectrum[p]) spectrum[p]=v;
+        }
+      }
+    }
+
+    //
+    // current format: one 16-bit value per pixel, fixed size frame
+    //
+    t0=now(CLOCK_PROCESS_CPUTIME_ID);
+    for (i=0; i<width && i<SPECTRUM_DATA_SIZE; i++) {
+      raw[i]=htons((short) spectrum[i]);
+    }
+    raw_cpu+=now(CLOCK_PROCESS_CPUTIME_ID) - t0;
+    sink^=raw[f % SPECTRUM_DATA_SIZE];
+    raw_bytes+=RAW_FRAME_SIZE;
+
+    //
+    // compressed format
+    //
+    t0=now(CLOCK_PROCESS_CPUTIME_ID);
+    bytes=spectrum_encode(&encoder, spectrum, width, low, high, 0, out, &keyframe, &k);
+    codec_cpu+=now(CLOCK_PROCESS_CPUTIME_ID) - t0;
+    codec_bytes+=COMPRESSED_FIXED_SIZE + bytes;
+    if (keyframe) {
+      keyframes++;
+      codec_bytes+=6*8 + 2*2;    // VFO values and range
+    }
+
+    if (spectrum_decode(&decoder, out, bytes, width, low, high, keyframe, k, decoded) != 0) {
+      fprintf(stderr, "frame %d: decode failed\n", f);
+      return 1;
+    }
+    for (i=0; i<width; i++) {
+      double v=spectrum[i];
+      double e;
+      if (v < low) v=low;
+      if (v > high) v=high;
+      e=fabs(v - decoded[i]);
+      if (e > max_error) max_error=e;
+    }
+  }
+
+  printf("width=%d frames=%d range=%d...%d dB (%d key frames)\n", width, frames, low, high, keyframes);
+  printf("uncompressed: %8.1f bytes/frame %8.3f usec/frame\n",
+         raw_bytes / frames, 1E6 * raw_cpu / frames);
+  printf("compressed  : %8.1f bytes/frame %8.3f usec/frame (ratio %0.2f)\n",
+         codec_bytes / frames, 1E6 * codec_cpu / frames, raw_bytes / codec_bytes);
+  printf("max. round trip error %0.3f dB (step %0.3f dB)\n", max_error, (double)(high - low) / 255.0);
+  if (width > SPECTRUM_DATA_SIZE) {
+    printf("note: the uncompressed frame only holds %d samples\n", SPECTRUM_DATA_SIZE);
+  }
+  return 0;
+}
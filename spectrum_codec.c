@@ -0,0 +1,223 @@
+/*
+ * File spectrum_codec.c
+ *
+ * Encoding and decoding of compressed spectrum frames for the
+ * client/server (remote) mode, see spectrum_codec.h.
+ *
+ */
+
+#include <string.h>
+
+#include "spectrum_codec.h"
+
+//
+// A quotient (value >> k) of RICE_ESCAPE or more is sent as
+// RICE_ESCAPE one-bits followed by the 8-bit value.
+//
+#define RICE_ESCAPE 15
+#define RICE_MAX_K  7
+
+typedef struct _bit_writer {
+  unsigned char *buf;
+  int pos;              // byte position
+  unsigned int acc;
+  int nbits;
+} BIT_WRITER;
+
+typedef struct _bit_reader {
+  const unsigned char *buf;
+  int length;
+  int pos;
+  unsigned int acc;
+  int nbits;
+} BIT_READER;
+
+static void put_bits(BIT_WRITER *w, unsigned int value, int bits) {
+  w->acc=(w->acc << bits) | (value & ((1U << bits) - 1));
+  w->nbits+=bits;
+  while (w->nbits >= 8) {
+    w->nbits-=8;
+    w->buf[w->pos++]=(unsigned char)(w->acc >> w->nbits);
+  }
+}
+
+static void flush_bits(BIT_WRITER *w) {
+  if (w->nbits > 0) {
+    w->buf[w->pos++]=(unsigned char)(w->acc << (8 - w->nbits));
+    w->nbits=0;
+  }
+}
+
+static int get_bit(BIT_READER *r) {
+  if (r->nbits == 0) {
+    if (r->pos >= r->length) return -1;
+    r->acc=r->buf[r->pos++];
+    r->nbits=8;
+  }
+  r->nbits--;
+  return (r->acc >> r->nbits) & 1;
+}
+
+static int get_bits(BIT_READER *r, int bits) {
+  int i, b;
+  int value=0;
+  for (i=0; i<bits; i++) {
+    b=get_bit(r);
+    if (b < 0) return -1;
+    value=(value << 1) | b;
+  }
+  return value;
+}
+
+static int rice_cost(unsigned int u, int k) {
+  unsigned int q=u >> k;
+  if (q >= RICE_ESCAPE) return RICE_ESCAPE + 8;
+  return (int)q + 1 + k;
+}
+
+static void rice_put(BIT_WRITER *w, unsigned int u, int k) {
+  unsigned int q=u >> k;
+  if (q >= RICE_ESCAPE) {
+    put_bits(w, (1U << RICE_ESCAPE) - 1, RICE_ESCAPE);
+    put_bits(w, u, 8);
+  } else {
+    put_bits(w, ((1U << q) - 1) << 1, q + 1);   // q ones, then a zero
+    if (k > 0) put_bits(w, u, k);
+  }
+}
+
+static int rice_get(BIT_READER *r, int k) {
+  int q=0;
+  int b;
+  for (;;) {
+    b=get_bit(r);
+    if (b < 0) return -1;
+    if (b == 0) break;
+    if (++q == RICE_ESCAPE) return get_bits(r, 8);
+  }
+  if (k == 0) return q;
+  b=get_bits(r, k);
+  if (b < 0) return -1;
+  return (q << k) | b;
+}
+
+//
+// Map signed 8-bit deltas to 0..255: 0,-1,1,-2,2,...
+//
+static unsigned int zigzag(unsigned char delta) {
+  int d=(signed char) delta;
+  return (((unsigned int)d << 1) ^ (unsigned int)(d >> 31)) & 0xFF;
+}
+
+static unsigned char unzigzag(unsigned int u) {
+  return (unsigned char)((u >> 1) ^ (-(int)(u & 1)));
+}
+
+void spectrum_codec_reset(SPECTRUM_CODEC *codec) {
+  codec->valid=0;
+  codec->samples=0;
+  codec->low=0;
+  codec->high=0;
+}
+
+int spectrum_encode(SPECTRUM_CODEC *codec, const float *in, int n, int low, int high,
+                    int force_key, unsigned char *out, int *keyframe, int *k) {
+  unsigned char q[SPECTRUM_CODEC_MAX_SAMPLES];
+  unsigned int u[SPECTRUM_CODEC_MAX_SAMPLES];
+  int histogram[256];
+  int cost[RICE_MAX_K+1];
+  int i, j, best;
+  float scale;
+  BIT_WRITER w;
+
+  if (n > SPECTRUM_CODEC_MAX_SAMPLES) n=SPECTRUM_CODEC_MAX_SAMPLES;
+  if (high <= low) high=low+1;
+
+  *keyframe=force_key || !codec->valid || codec->samples != n || codec->low != low || codec->high != high;
+
+  //
+  // quantize, and zig-zag map the difference to the previous frame
+  //
+  scale=255.0f/(float)(high-low);
+  for (i=0; i<n; i++) {
+    float v=(in[i]-(float)low)*scale+0.5f;
+    if (v < 0.0f) v=0.0f;
+    if (v > 255.0f) v=255.0f;
+    q[i]=(unsigned char) v;
+  }
+  if (*keyframe) {
+    for (i=0; i<n; i++) u[i]=zigzag(q[i]);
+  } else {
+    for (i=0; i<n; i++) u[i]=zigzag((unsigned char)(q[i]-codec->prev[i]));
+  }
+
+  //
+  // choose the Rice parameter with the smallest output
+  //
+  memset(histogram, 0, sizeof(histogram));
+  for (i=0; i<n; i++) histogram[u[i]]++;
+  for (j=0; j<=RICE_MAX_K; j++) {
+    cost[j]=0;
+    for (i=0; i<256; i++) {
+      if (histogram[i]) cost[j]+=histogram[i]*rice_cost(i, j);
+    }
+  }
+  best=0;
+  for (j=1; j<=RICE_MAX_K; j++) {
+    if (cost[j] < cost[best]) best=j;
+  }
+  *k=best;
+
+  w.buf=out;
+  w.pos=0;
+  w.acc=0;
+  w.nbits=0;
+  for (i=0; i<n; i++) rice_put(&w, u[i], best);
+  flush_bits(&w);
+
+  memcpy(codec->prev, q, n);
+  codec->samples=n;
+  codec->low=low;
+  codec->high=high;
+  codec->valid=1;
+  return w.pos;
+}
+
+int spectrum_decode(SPECTRUM_CODEC *codec, const unsigned char *in, int length, int n,
+                    int low, int high, int keyframe, int k, float *out) {
+  BIT_READER r;
+  int i, u;
+  float step;
+
+  if (n > SPECTRUM_CODEC_MAX_SAMPLES || k < 0 || k > RICE_MAX_K) return -1;
+  if (high <= low) high=low+1;
+  if (!keyframe && (!codec->valid || codec->samples != n)) return -1;
+
+  r.buf=in;
+  r.length=length;
+  r.pos=0;
+  r.acc=0;
+  r.nbits=0;
+  for (i=0; i<n; i++) {
+    u=rice_get(&r, k);
+    if (u < 0) {
+      codec->valid=0;
+      return -1;
+    }
+    if (keyframe) {
+      codec->prev[i]=unzigzag(u);
+    } else {
+      codec->prev[i]=(unsigned char)(codec->prev[i]+unzigzag(u));
+    }
+  }
+  codec->samples=n;
+  codec->low=low;
+  codec->high=high;
+  codec->valid=1;
+
+  step=(float)(high-low)/255.0f;
+  for (i=0; i<n; i++) {
+    out[i]=(float)low+step*(float)codec->prev[i];
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * File spectrum_codec.h
+ *
+ * Compressed spectrum frames for the client/server (remote) mode.
+ *
+ */
+
+#ifndef _SPECTRUM_CODEC_H
+#define _SPECTRUM_CODEC_H
+
+//
+// Compact encoding of spectrum (panadapter) frames for the remote mode:
+//
+// - the dB values are quantized to 8 bits relative to a range low...high
+// - each quantized frame is delta-encoded against the previous frame
+//   (or against zero for a key frame)
+// - the deltas are zig-zag mapped and Rice-coded, with the Rice parameter
+//   chosen per frame for the smallest output
+//
+// Encoder and decoder each keep the previous quantized frame, so the
+// sequence of frames must arrive complete and in order. The encoder
+// sends a key frame whenever its state has been reset, or the number of
+// samples or the range has changed.
+//
+
+#define SPECTRUM_CODEC_MAX_SAMPLES 4096
+//
+// Worst case: escape code (15 bits) plus 8 raw bits per sample
+//
+#define SPECTRUM_CODEC_MAX_BYTES ((SPECTRUM_CODEC_MAX_SAMPLES*23+7)/8)
+
+typedef struct _spectrum_codec {
+  int valid;          // prev[] holds the previous frame
+  int samples;
+  int low;
+  int high;
+  unsigned char prev[SPECTRUM_CODEC_MAX_SAMPLES];
+} SPECTRUM_CODEC;
+
+extern void spectrum_codec_reset(SPECTRUM_CODEC *codec);
+
+//
+// Encode n samples (dB values). Returns the number of bytes written to out
+// (out must hold SPECTRUM_CODEC_MAX_BYTES), *keyframe and *k are the
+// parameters the decoder needs. If force_key is set, a key frame is
+// produced regardless of the state.
+//
+extern int spectrum_encode(SPECTRUM_CODEC *codec, const float *in, int n, int low, int high,
+                           int force_key, unsigned char *out, int *keyframe, int *k);
+
+//
+// Decode a frame. Returns 0 on success, -1 if the frame cannot be decoded
+// (corrupt data, or a delta frame without a previous frame).
+//
+extern int spectrum_decode(SPECTRUM_CODEC *codec, const unsigned char *in, int length, int n,
+                           int low, int high, int keyframe, int k, float *out);
+
+#endif
@@ -0,0 +1,238 @@
+/*
+ * File stream_stats.c
+ *
+ * Sequence number checks and inter-arrival times of the packet streams
+ * received from the radio
+ *
+ */
+
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __APPLE__
+#include "MacOS.h"  // emulate clock_gettime on old MacOS systems
+#endif
+
+#include "stream_stats.h"
+
+static STREAM_STATS stream_stats[STREAMS];
+
+//
+// incremented by stream_stats_reset()
+//
+static volatile gint stream_stats_generation=0;
+
+static const char *stream_name[STREAMS]={
+  [STREAM_EP6]="EP6",
+  [STREAM_DDC0]="DDC0",
+  [STREAM_DDC0+1]="DDC1",
+  [STREAM_DDC0+2]="DDC2",
+  [STREAM_DDC0+3]="DDC3",
+  [STREAM_DDC0+4]="DDC4",
+  [STREAM_DDC0+5]="DDC5",
+  [STREAM_DDC0+6]="DDC6",
+  [STREAM_MIC]="MIC",
+  [STREAM_HIGHPRIO]="HP",
+  [STREAM_TXECHO]="TXIQ",
+};
+
+const char *stream_stats_name(int stream) {
+  if(stream<0 || stream>=STREAMS) return "?";
+  return stream_name[stream];
+}
+
+//
+// Receive time of a packet, in nsec
+//
+gint64 stream_stats_now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (gint64) ts.tv_sec*1000000000LL+ts.tv_nsec;
+}
+
+//
+// Called by the receiving thread for the first packet after a reset
+//
+static void stream_stats_clear(STREAM_STATS *s, gint generation) {
+  int i;
+
+  s->received=0;
+  s->lost=0;
+  s->reordered=0;
+  s->duplicated=0;
+  s->late=0;
+  s->gaps=0;
+  s->longest=0;
+  s->restarts=0;
+  s->maximum=0;
+  for(i=0;i<STREAM_BINS;i++) {
+    s->bins[i]=0;
+  }
+  s->started=0;
+  s->last=0;
+  g_atomic_int_set(&s->generation, generation);
+}
+
+static void stream_stats_interval(STREAM_STATS *s, gint64 interval) {
+  gint usec;
+  int bin;
+
+  usec=interval>=(gint64)G_MAXINT*1000 ? G_MAXINT : (gint)(interval/1000);
+  if(usec<0) usec=0;
+  bin=usec==0 ? 0 : g_bit_storage(usec);
+  if(bin>=STREAM_BINS) bin=STREAM_BINS-1;
+  s->bins[bin]++;
+  if(usec>s->maximum) s->maximum=usec;
+}
+
+//
+// A packet that is ahead of the expected one opens a gap, whose packets
+// are counted as lost. If one of them arrives later (within the window),
+// it is counted as reordered and no longer as lost. A packet that has
+// already been received is a duplicate. A jump back to zero (or far
+// back) is a restart of the radio, and not counted as an error.
+//
+void stream_stats_packet(int stream, guint32 sequence, gint64 rxtime) {
+  STREAM_STATS *s=&stream_stats[stream];
+  gint generation=g_atomic_int_get(&stream_stats_generation);
+  guint32 ahead, back;
+
+  if(s->generation!=generation) stream_stats_clear(s, generation);
+  if(s->started && stream==STREAM_TXECHO && rxtime-s->last>STREAM_PAUSE) {
+    // start of the next transmission
+    s->started=0;
+    s->last=0;
+  }
+  if(s->last!=0) stream_stats_interval(s, rxtime-s->last);
+  s->last=rxtime;
+
+  if(!s->started || (sequence==0 && s->next>STREAM_WINDOW)) {
+    if(s->started) s->restarts++;
+    s->started=1;
+    s->next=sequence+1;
+    s->window=1;
+    s->received++;
+    return;
+  }
+  ahead=sequence-s->next;
+  if(ahead==0) {
+    s->window=(s->window<<1)|1;
+    s->next++;
+    s->received++;
+  } else if(ahead<0x80000000U) {
+    // a gap of "ahead" packets
+    s->lost+=ahead;
+    s->gaps++;
+    if((gint)ahead>s->longest) s->longest=ahead;
+    s->window=ahead>=63?1:(s->window<<(ahead+1))|1;
+    s->next=sequence+1;
+    s->received++;
+  } else {
+    back=s->next-1-sequence;
+    if(back>=STREAM_WINDOW) {
+      s->late++;
+    } else if(s->window & ((guint64)1<<back)) {
+      s->duplicated++;
+    } else {
+      s->window|=(guint64)1<<back;
+      s->reordered++;
+      s->lost--;
+      s->received++;
+    }
+  }
+}
+
+//
+// May be called from any thread at any time. The counters read zero
+// at once, and the sequence checks start over with the next packet.
+//
+void stream_stats_reset() {
+  g_atomic_int_inc(&stream_stats_generation);
+}
+
+//
+// Copy the counters of a stream, all zero if they have been reset
+// and the stream has not received a packet since
+//
+void stream_stats_get(int stream, STREAM_STATS *copy) {
+  STREAM_STATS *s;
+  int i;
+
+  memset(copy, 0, sizeof(STREAM_STATS));
+  if(stream<0 || stream>=STREAMS) return;
+  s=&stream_stats[stream];
+  if(g_atomic_int_get(&s->generation)!=g_atomic_int_get(&stream_stats_generation)) return;
+  copy->received=g_atomic_int_get(&s->received);
+  copy->lost=g_atomic_int_get(&s->lost);
+  copy->reordered=g_atomic_int_get(&s->reordered);
+  copy->duplicated=g_atomic_int_get(&s->duplicated);
+  copy->late=g_atomic_int_get(&s->late);
+  copy->gaps=g_atomic_int_get(&s->gaps);
+  copy->longest=g_atomic_int_get(&s->longest);
+  copy->restarts=g_atomic_int_get(&s->restarts);
+  copy->maximum=g_atomic_int_get(&s->maximum);
+  for(i=0;i<STREAM_BINS;i++) {
+    copy->bins[i]=g_atomic_int_get(&s->bins[i]);
+  }
+}
+
+//
+// Upper limit (usec) of the intervals below which "percent" of the
+// intervals fall, -1 if there are none
+//
+int stream_stats_percentile(const STREAM_STATS *copy, int percent) {
+  gint64 total, count, limit;
+  int i;
+
+  total=0;
+  for(i=0;i<STREAM_BINS;i++) {
+    total+=copy->bins[i];
+  }
+  if(total==0) return -1;
+  limit=(total*percent+99)/100;
+  count=0;
+  for(i=0;i<STREAM_BINS-1;i++) {
+    count+=copy->bins[i];
+    if(count>=limit) return MIN(1<<i, copy->maximum);
+  }
+  return copy->maximum;
+}
+
+void stream_stats_report() {
+  int i;
+  STREAM_STATS s;
+
+  for(i=0;i<STREAMS;i++) {
+    stream_stats_get(i, &s);
+    if(s.received==0) continue;
+    g_print("%s: %-4s received=%d lost=%d gaps=%d longest=%d reordered=%d duplicated=%d late=%d restarts=%d"
+            " interval(usec) p50=%d p99=%d max=%d\n",
+            __FUNCTION__, stream_name[i],
+            s.received, s.lost, s.gaps, s.longest, s.reordered, s.duplicated, s.late, s.restarts,
+            stream_stats_percentile(&s, 50), stream_stats_percentile(&s, 99), s.maximum);
+  }
+}
+
+static gboolean stream_stats_timer_cb(gpointer data) {
+  stream_stats_report();
+  return G_SOURCE_CONTINUE;
+}
+
+//
+// PIHPSDR_NETSTATS=n reports the counters every n seconds
+//
+void stream_stats_init() {
+  const char *env=getenv("PIHPSDR_NETSTATS");
+  int secs;
+
+  stream_stats_reset();
+  if(env!=NULL) {
+    secs=atoi(env);
+    if(secs>0) {
+      g_print("%s: report every %d seconds\n",__FUNCTION__,secs);
+      g_timeout_add_seconds(secs, stream_stats_timer_cb, NULL);
+    }
+  }
+}
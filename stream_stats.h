@@ -0,0 +1,88 @@
+/*
+ * File stream_stats.h
+ *
+ * Counters of the packet streams received from the radio: how many
+ * packets have been received, lost, reordered, duplicated or came
+ * too late, and how often (and how long) the stream was interrupted.
+ *
+ * For each stream, the times between two packets are collected in a
+ * histogram. The times are taken (CLOCK_MONOTONIC) when the receive
+ * thread gets the packets from the socket. With batched reception
+ * (net_rx_batch > 1), all packets of a batch have the same time and
+ * their intervals are counted in the first bin.
+ *
+ * This tells network problems from CPU starvation: packets lost on
+ * the network leave gaps in the sequence numbers while the intervals
+ * stay short. If the receive thread does not get the CPU in time, the
+ * intervals get long (the packets pile up in the socket buffer), and
+ * packets are only lost when the socket buffer overflows.
+ *
+ * Each stream is only updated by the thread that receives it, so no
+ * locks are needed. Other threads read the counters with
+ * stream_stats_get(). stream_stats_reset() can be called at any time:
+ * it only starts a new generation, and each stream clears its counters
+ * when it receives the next packet.
+ *
+ * The counters are shown in the Network Statistics menu, can be read
+ * (and reset, with ZZJS99;) with the CAT command ZZJS, are reported when the protocol stops and,
+ * if PIHPSDR_NETSTATS is set to a number of seconds, periodically.
+ * The reports can be compared with those of hpsdrsim when it injects
+ * network impairments (-loss, -burst, -reorder, -dup, -jitter).
+ *
+ */
+
+#ifndef _STREAM_STATS_H
+#define _STREAM_STATS_H
+
+enum {
+  STREAM_EP6=0,           // old protocol RX data
+  STREAM_DDC0,            // new protocol DDC0 ... DDC6
+  STREAM_MIC=STREAM_DDC0+7,
+  STREAM_HIGHPRIO,
+  STREAM_TXECHO,          // new protocol PURESIGNAL feedback (TX IQ echo)
+  STREAMS
+};
+
+#define STREAM_WINDOW 64  // a packet arriving later than this is "late"
+
+//
+// Bin 0 counts intervals below 1 usec, bin i those from 2^(i-1)
+// to 2^i usec, the last bin all that are longer.
+//
+#define STREAM_BINS 24
+
+//
+// The TX IQ echo only flows while transmitting. A pause that is longer
+// than this starts the sequence over, without counting lost packets.
+//
+#define STREAM_PAUSE 100000000LL   // nsec
+
+typedef struct _stream_stats {
+  volatile gint received;    // packets, not counting duplicates
+  volatile gint lost;        // missing packets (a reordered packet is not lost)
+  volatile gint reordered;   // packets that came after a later one
+  volatile gint duplicated;
+  volatile gint late;        // more than STREAM_WINDOW packets behind
+  volatile gint gaps;        // interruptions of the stream
+  volatile gint longest;     // packets missing in the longest gap
+  volatile gint restarts;    // the sequence numbers started over
+  volatile gint maximum;     // longest interval between two packets, usec
+  volatile gint bins[STREAM_BINS];
+  volatile gint generation;  // the counters are valid for this generation
+  // used by the receiving thread only
+  gint started;
+  guint32 next;              // next sequence number expected
+  guint64 window;            // bit i set: packet next-1-i has been received
+  gint64 last;               // receive time of the last packet
+} STREAM_STATS;
+
+extern void stream_stats_init(void);
+extern gint64 stream_stats_now(void);
+extern void stream_stats_packet(int stream, guint32 sequence, gint64 rxtime);
+extern void stream_stats_reset(void);
+extern void stream_stats_get(int stream, STREAM_STATS *copy);
+extern int stream_stats_percentile(const STREAM_STATS *copy, int percent);
+extern void stream_stats_report(void);
+extern const char *stream_stats_name(int stream);
+
+#endif
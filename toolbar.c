@@ -139,13 +139,13 @@ void tune_update(int state) {
 void switch_pressed_cb(GtkWidget *widget, gpointer data) {
   gint i=GPOINTER_TO_INT(data);
 fprintf(stderr,"%s: %d action=%d\n",__FUNCTION__,i,toolbar_switches[i].switch_function);
-  schedule_action(toolbar_switches[i].switch_function, PRESSED, 0);
+  schedule_action(SOURCE_TOOLBAR, toolbar_switches[i].switch_function, PRESSED, 0);
 }
 
 void switch_released_cb(GtkWidget *widget, gpointer data) {
   gint i=GPOINTER_TO_INT(data);
 fprintf(stderr,"%s: %d action=%d\n",__FUNCTION__,i,toolbar_switches[i].switch_function);
-  schedule_action(toolbar_switches[i].switch_function, RELEASED, 0);
+  schedule_action(SOURCE_TOOLBAR, toolbar_switches[i].switch_function, RELEASED, 0);
 }
 
 GtkWidget *toolbar_init(int my_width, int my_height, GtkWidget* parent) {
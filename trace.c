@@ -0,0 +1,255 @@
+/*
+ * File trace.c
+ *
+ * Per-thread ring buffers for the events of trace.h, and writing
+ * them to a file for offline analysis.
+ *
+ * The dump is a text file with one line per event, sorted by time:
+ *
+ *   time(sec) thread-id thread-name category event arg0 arg1
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE    // for pthread_getname_np
+#endif
+
+#include <gtk/gtk.h>
+#include <glib-unix.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#ifdef __APPLE__
+#include "MacOS.h"  // emulate clock_gettime on old MacOS systems
+#endif
+
+#include "trace.h"
+
+#define TRACE_DUMP_FILE "pihpsdr_trace.txt"
+
+#ifdef TRACE
+
+typedef struct _trace_record {
+  guint64 time;      // nsec, CLOCK_MONOTONIC
+  guint16 thread;
+  guint16 id;
+  gint32 arg[2];
+} TRACE_RECORD;
+
+typedef struct _trace_ring TRACE_RING;
+struct _trace_ring {
+  volatile gint head;           // number of events written (wraps)
+  int thread;
+  char name[16];
+  TRACE_RECORD record[TRACE_RING_SIZE];
+  TRACE_RING *next;
+};
+
+unsigned int trace_mask=0;
+
+static TRACE_RING *volatile rings=NULL;
+static volatile gint threads=0;
+static __thread TRACE_RING *ring=NULL;
+
+static const char *category_name[TRACE_CATEGORIES]={
+  [TRACE_PROTOCOL]="protocol",
+  [TRACE_RECEIVER]="receiver",
+  [TRACE_TRANSMITTER]="transmitter",
+  [TRACE_RIGCTL]="rigctl",
+  [TRACE_MIDI]="midi",
+  [TRACE_GPIO]="gpio",
+};
+
+static const struct {
+  int id;
+  const char *name;
+} event_name[]={
+  {TRACE_OLD_SEQ_ERROR,		"OLD_SEQ_ERROR"},
+  {TRACE_DDC_SEQ_ERROR,		"DDC_SEQ_ERROR"},
+  {TRACE_DDC_PACKET,		"DDC_PACKET"},
+  {TRACE_HIGHPRIO_SEQ_ERROR,	"HIGHPRIO_SEQ_ERROR"},
+  {TRACE_MIC_SEQ_ERROR,		"MIC_SEQ_ERROR"},
+  {TRACE_CMDRES_SEQ_ERROR,	"CMDRES_SEQ_ERROR"},
+  {TRACE_RX_BLOCK_START,	"RX_BLOCK_START"},
+  {TRACE_RX_BLOCK_END,		"RX_BLOCK_END"},
+  {TRACE_RX_OVERRUN,		"RX_OVERRUN"},
+  {TRACE_TX_BLOCK_START,	"TX_BLOCK_START"},
+  {TRACE_TX_BLOCK_END,		"TX_BLOCK_END"},
+  {TRACE_CAT_COMMAND,		"CAT_COMMAND"},
+  {TRACE_CAT_FAST_REPLY,	"CAT_FAST_REPLY"},
+  {TRACE_CAT_PARSE,		"CAT_PARSE"},
+  {TRACE_CAT_REPLY_DROPPED,	"CAT_REPLY_DROPPED"},
+  {TRACE_MIDI_EVENT,		"MIDI_EVENT"},
+  {TRACE_MIDI_UNASSIGNED,	"MIDI_UNASSIGNED"},
+  {TRACE_GPIO_EDGE,		"GPIO_EDGE"},
+  {TRACE_GPIO_ENCODER,		"GPIO_ENCODER"},
+  {TRACE_GPIO_SWITCH,		"GPIO_SWITCH"},
+  {TRACE_GPIO_LATENCY,		"GPIO_LATENCY"},
+};
+
+//
+// The ring of a thread is allocated when it records its first event
+// and is never freed, so the dump can still show threads that are gone.
+// Rings are pushed onto a list without locking.
+//
+static TRACE_RING *new_ring() {
+  TRACE_RING *r=g_new0(TRACE_RING,1);
+  r->thread=g_atomic_int_add(&threads,1);
+#ifdef __linux__
+  pthread_getname_np(pthread_self(), r->name, sizeof(r->name));
+#endif
+  if(r->name[0]=='\0') {
+    snprintf(r->name, sizeof(r->name), "thread%d", r->thread);
+  }
+  do {
+    r->next=g_atomic_pointer_get(&rings);
+  } while(!g_atomic_pointer_compare_and_exchange(&rings, r->next, r));
+  return r;
+}
+
+void trace_event(int id, int arg0, int arg1) {
+  struct timespec ts;
+  TRACE_RECORD *e;
+  gint head;
+
+  if(ring==NULL) ring=new_ring();
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  head=ring->head;
+  e=&ring->record[head & (TRACE_RING_SIZE-1)];
+  e->time=(guint64)ts.tv_sec*1000000000ULL+(guint64)ts.tv_nsec;
+  e->thread=ring->thread;
+  e->id=id;
+  e->arg[0]=arg0;
+  e->arg[1]=arg1;
+  g_atomic_int_set(&ring->head, (gint)((guint)head+1));
+}
+
+static const char *trace_event_name(int id) {
+  int i;
+  for(i=0;i<(int)(sizeof(event_name)/sizeof(event_name[0]));i++) {
+    if(event_name[i].id==id) return event_name[i].name;
+  }
+  return "UNKNOWN";
+}
+
+static int compare_time(const void *a, const void *b) {
+  const TRACE_RECORD *x=(const TRACE_RECORD *)a;
+  const TRACE_RECORD *y=(const TRACE_RECORD *)b;
+  return (x->time > y->time) - (x->time < y->time);
+}
+
+//
+// The rings are copied while the threads go on recording. An event is
+// only used if it has not been over-written during the copy, which is
+// checked by reading the head again afterwards.
+//
+int trace_dump(const char *filename) {
+  TRACE_RING *r;
+  TRACE_RECORD *all;
+  const char **names;
+  int total=0;
+  int n, i;
+  guint head, first, after, lost, k;
+  FILE *f;
+
+  n=g_atomic_int_get(&threads);
+  if(n==0) {
+    g_print("%s: no events recorded (mask=0x%x)\n",__FUNCTION__,trace_mask);
+    return 0;
+  }
+  all=g_new(TRACE_RECORD, n*TRACE_RING_SIZE);
+  names=g_new0(const char *, n);
+  for(r=g_atomic_pointer_get(&rings);r!=NULL;r=r->next) {
+    if(r->thread>=n) continue;  // started recording just now
+    names[r->thread]=r->name;
+    head=(guint)g_atomic_int_get(&r->head);
+    first=head>TRACE_RING_SIZE?head-TRACE_RING_SIZE:0;
+    for(k=first;k!=head;k++) {
+      all[total+(k-first)]=r->record[k & (TRACE_RING_SIZE-1)];
+    }
+    after=(guint)g_atomic_int_get(&r->head);
+    lost=0;
+    if(after-first > TRACE_RING_SIZE) {
+      // the oldest events have been over-written meanwhile
+      lost=after-first-TRACE_RING_SIZE;
+      if(lost>head-first) lost=head-first;
+      memmove(&all[total], &all[total+lost], (head-first-lost)*sizeof(TRACE_RECORD));
+    }
+    total+=head-first-lost;
+  }
+  qsort(all, total, sizeof(TRACE_RECORD), compare_time);
+
+  f=fopen(filename, "w");
+  if(f==NULL) {
+    g_print("%s: cannot open %s\n",__FUNCTION__,filename);
+    g_free(names);
+    g_free(all);
+    return -1;
+  }
+  fprintf(f, "# piHPSDR trace: %d events of %d threads, mask=0x%x\n", total, n, trace_mask);
+  fprintf(f, "# time(sec) thread name category event arg0 arg1\n");
+  for(i=0;i<total;i++) {
+    TRACE_RECORD *e=&all[i];
+    int category=e->id>>8;
+    fprintf(f, "%.9f %d %s %s %s %d %d\n",
+            1E-9*(double)(e->time-all[0].time), e->thread, names[e->thread],
+            category<TRACE_CATEGORIES?category_name[category]:"?",
+            trace_event_name(e->id), e->arg[0], e->arg[1]);
+  }
+  fclose(f);
+  g_print("%s: %d events written to %s\n",__FUNCTION__,total,filename);
+  g_free(names);
+  g_free(all);
+  return total;
+}
+
+static gboolean trace_signal_cb(gpointer data) {
+  trace_dump(TRACE_DUMP_FILE);
+  return G_SOURCE_CONTINUE;
+}
+
+//
+// PIHPSDR_TRACE is a number ("0x3f") or a list of category names
+// ("protocol,rigctl"), "all" enables every category.
+//
+void trace_init() {
+  const char *env=getenv("PIHPSDR_TRACE");
+  char *list, *name, *save;
+  int i;
+
+  if(env!=NULL) {
+    if(env[0]>='0' && env[0]<='9') {
+      trace_mask=strtoul(env, NULL, 0);
+    } else {
+      list=g_strdup(env);
+      for(name=strtok_r(list, ",", &save);name!=NULL;name=strtok_r(NULL, ",", &save)) {
+        if(strcmp(name, "all")==0) {
+          trace_mask=(1U<<TRACE_CATEGORIES)-1;
+          continue;
+        }
+        for(i=0;i<TRACE_CATEGORIES;i++) {
+          if(strcmp(name, category_name[i])==0) trace_mask|=1U<<i;
+        }
+      }
+      g_free(list);
+    }
+  }
+  g_print("%s: mask=0x%x, dump with kill -USR1 %d to %s\n",__FUNCTION__,trace_mask,getpid(),TRACE_DUMP_FILE);
+  g_unix_signal_add(SIGUSR1, trace_signal_cb, NULL);
+}
+
+#else
+
+void trace_init() {
+}
+
+int trace_dump(const char *filename) {
+  g_print("%s: compiled without TRACE\n",__FUNCTION__);
+  return -1;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * File trace.h
+ *
+ * Tracing of events in the hot paths (protocol, receiver, transmitter,
+ * rigctl, MIDI, GPIO) with very little overhead.
+ *
+ * An event is a time stamp, the thread, an event id and two integer
+ * arguments. It is written into a ring buffer of the thread that
+ * records it, so no locks are needed and nothing is printed. The rings
+ * keep the last TRACE_RING_SIZE events of each thread and are written
+ * to a file on request (trace_dump, or "kill -USR1" to the process).
+ *
+ * Each event belongs to a category, and only the categories set in
+ * trace_mask are recorded. The mask is taken from the environment
+ * variable PIHPSDR_TRACE at start-up, either a number or a comma
+ * separated list of category names, e.g.
+ *
+ *   PIHPSDR_TRACE=protocol,receiver ./pihpsdr
+ *
+ * Without -D TRACE (see Makefile) the TRACE_EVENT macro expands to
+ * nothing.
+ *
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+//
+// categories (bit numbers of trace_mask)
+//
+#define TRACE_PROTOCOL    0
+#define TRACE_RECEIVER    1
+#define TRACE_TRANSMITTER 2
+#define TRACE_RIGCTL      3
+#define TRACE_MIDI        4
+#define TRACE_GPIO        5
+#define TRACE_CATEGORIES  6
+
+//
+// event ids: the category is the upper byte
+//
+enum TRACE_EVENT_ID {
+  TRACE_OLD_SEQ_ERROR=(TRACE_PROTOCOL<<8),  // last, received sequence number
+  TRACE_DDC_SEQ_ERROR,                      // ddc, received sequence number
+  TRACE_DDC_PACKET,                         // ddc, sequence number
+  TRACE_HIGHPRIO_SEQ_ERROR,                 // expected, received sequence number
+  TRACE_MIC_SEQ_ERROR,                      // expected, received sequence number
+  TRACE_CMDRES_SEQ_ERROR,                   // expected, received sequence number
+
+  TRACE_RX_BLOCK_START=(TRACE_RECEIVER<<8), // rx, ring position
+  TRACE_RX_BLOCK_END,                       // rx, fexchange0 error
+  TRACE_RX_OVERRUN,                         // rx, overruns so far
+
+  TRACE_TX_BLOCK_START=(TRACE_TRANSMITTER<<8), // tx, mode
+  TRACE_TX_BLOCK_END,                          // tx, fexchange0 error
+
+  TRACE_CAT_COMMAND=(TRACE_RIGCTL<<8),      // fd, first 4 characters
+  TRACE_CAT_FAST_REPLY,                     // fd, first 4 characters
+  TRACE_CAT_PARSE,                          // fd, first 4 characters
+  TRACE_CAT_REPLY_DROPPED,                  // fd, bytes buffered
+
+  TRACE_MIDI_EVENT=(TRACE_MIDI<<8),         // event<<8 | channel, note<<8 | value
+  TRACE_MIDI_UNASSIGNED,                    // event<<8 | channel, note<<8 | value
+
+  TRACE_GPIO_EDGE=(TRACE_GPIO<<8),          // line, PRESSED/RELEASED
+  TRACE_GPIO_ENCODER,                       // encoder<<8 | level, steps
+  TRACE_GPIO_SWITCH,                        // action, PRESSED/RELEASED
+  TRACE_GPIO_LATENCY,                       // encoder, usec from edge to action queue
+};
+
+#define TRACE_RING_SIZE 4096   // events per thread, power of two
+
+#ifdef TRACE
+extern unsigned int trace_mask;
+extern void trace_event(int id, int arg0, int arg1);
+
+#define TRACE_EVENT(id,arg0,arg1) \
+  do { \
+    if(trace_mask & (1U<<((id)>>8))) trace_event((id),(arg0),(arg1)); \
+  } while(0)
+#else
+#define TRACE_EVENT(id,arg0,arg1) do { } while(0)
+#endif
+
+//
+// the first four characters of a CAT command, as an argument
+//
+static inline int trace_mnemonic(const char *command) {
+  unsigned int m=0;
+  int i;
+  for(i=0;i<4 && command[i]!='\0';i++) {
+    m|=(unsigned int)(unsigned char)command[i]<<(24-8*i);
+  }
+  return (int)m;
+}
+
+extern void trace_init(void);
+extern int trace_dump(const char *filename);
+
+#endif
@@ -51,6 +51,7 @@
 #include "audio.h"
 #include "ext.h"
 #include "sliders.h"
+#include "trace.h"
 
 double getNextSideToneSample();
 double getNextInternalSideToneSample();
@@ -1205,10 +1206,9 @@ static void full_tx_buffer(TRANSMITTER *tx) {
       }
     }
 
+    TRACE_EVENT(TRACE_TX_BLOCK_START, tx->id, tx->mode);
     fexchange0(tx->id, tx->mic_input_buffer, tx->iq_output_buffer, &error);
-    if(error!=0) {
-      fprintf(stderr,"full_tx_buffer: id=%d fexchange0: error=%d\n",tx->id,error);
-    }
+    TRACE_EVENT(TRACE_TX_BLOCK_END, tx->id, error);
   }
 
   if(tx->displaying && !(tx->puresignal && tx->feedback)) {
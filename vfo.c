@@ -1064,6 +1064,9 @@ void vfo_update() {
     int id=active_receiver->id;
     int txvfo=get_tx_vfo();
 
+    // the state CAT read queries are answered from
+    rigctl_publish_state();
+
     FILTER* band_filters=filters[vfo[id].mode];
     FILTER* band_filter=&band_filters[vfo[id].filter];
     if(vfo_surface) {
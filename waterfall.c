@@ -44,6 +44,81 @@ static int colorHighR=255; // yellow
 static int colorHighG=255;
 static int colorHighB=0;
 
+//
+// Colour look-up tables. Each palette maps the range waterfall_low ... waterfall_high
+// linearly onto WATERFALL_LUT_SIZE entries, such that the conversion from a
+// dB value to a colour is a simple scale-and-index operation.
+// Entry 0 is used for values below waterfall_low, entry WATERFALL_LUT_SIZE+1
+// for values above waterfall_high.
+// Since the tables are normalized, they need not be re-calculated
+// when the waterfall levels change.
+//
+#define WATERFALL_LUT_SIZE 1024
+
+static guint32 palette[WATERFALL_PALETTES][WATERFALL_LUT_SIZE+2];
+static int palette_initialized=0;
+
+//
+// Pixel value in the (native-endian) CAIRO_FORMAT_RGB24 layout
+//
+static guint32 rgb(int r, int g, int b) {
+  return ((guint32)r << 16) | ((guint32)g << 8) | (guint32)b;
+}
+
+static void waterfall_init_palettes() {
+  int i;
+  guint32 *p;
+
+  //
+  // Colour palette: this is the colour ramp piHPSDR always had
+  //
+  p=palette[WATERFALL_PALETTE_COLOUR];
+  *p++=rgb(colorLowR, colorLowG, colorLowB);
+  for (i=0; i<WATERFALL_LUT_SIZE; i++) {
+    float percent=((float)i+0.5f)/(float)WATERFALL_LUT_SIZE;
+    if(percent<(2.0f/9.0f)) {
+        float local_percent = percent / (2.0f/9.0f);
+        *p++ = rgb((int)((1.0f-local_percent)*colorLowR),
+                   (int)((1.0f-local_percent)*colorLowG),
+                   (int)(colorLowB + local_percent*(255-colorLowB)));
+    } else if(percent<(3.0f/9.0f)) {
+        float local_percent = (percent - 2.0f/9.0f) / (1.0f/9.0f);
+        *p++ = rgb(0, (int)(local_percent*255), 255);
+    } else if(percent<(4.0f/9.0f)) {
+        float local_percent = (percent - 3.0f/9.0f) / (1.0f/9.0f);
+        *p++ = rgb(0, 255, (int)((1.0f-local_percent)*255));
+    } else if(percent<(5.0f/9.0f)) {
+        float local_percent = (percent - 4.0f/9.0f) / (1.0f/9.0f);
+        *p++ = rgb((int)(local_percent*255), 255, 0);
+    } else if(percent<(7.0f/9.0f)) {
+        float local_percent = (percent - 5.0f/9.0f) / (2.0f/9.0f);
+        *p++ = rgb(255, (int)((1.0f-local_percent)*255), 0);
+    } else if(percent<(8.0f/9.0f)) {
+        float local_percent = (percent - 7.0f/9.0f) / (1.0f/9.0f);
+        *p++ = rgb(255, 0, (int)(local_percent*255));
+    } else {
+        float local_percent = (percent - 8.0f/9.0f) / (1.0f/9.0f);
+        *p++ = rgb((int)((0.75f + 0.25f*(1.0f-local_percent))*255.0f),
+                   (int)(local_percent*255.0f*0.5f),
+                   255);
+    }
+  }
+  *p++=rgb(colorHighR, colorHighG, colorHighB);
+
+  //
+  // Grayscale palette: black ... white
+  //
+  p=palette[WATERFALL_PALETTE_GRAYSCALE];
+  *p++=rgb(0, 0, 0);
+  for (i=0; i<WATERFALL_LUT_SIZE; i++) {
+    int c=(255*i)/(WATERFALL_LUT_SIZE-1);
+    *p++=rgb(c, c, c);
+  }
+  *p++=rgb(255, 255, 255);
+
+  palette_initialized=1;
+}
+
 
 static gint first_x;
 static gint last_x;
@@ -55,6 +130,21 @@ static double hz_per_pixel;
 static int display_width;
 static int display_height;
 
+//
+// Clear the waterfall: all rows black, no horizontal shift
+//
+static void waterfall_clear(RECEIVER *rx) {
+  int height=cairo_image_surface_get_height(rx->waterfall_surface);
+  int stride=cairo_image_surface_get_stride(rx->waterfall_surface);
+
+  cairo_surface_flush(rx->waterfall_surface);
+  memset(cairo_image_surface_get_data(rx->waterfall_surface), 0, height*stride);
+  cairo_surface_mark_dirty(rx->waterfall_surface);
+  memset(rx->waterfall_row_shift, 0, height*sizeof(gint));
+  rx->waterfall_head=0;
+  rx->waterfall_shift=0;
+}
+
 /* Create a new surface of the appropriate size to store our scribbles */
 static gboolean
 waterfall_configure_event_cb (GtkWidget         *widget,
@@ -64,11 +154,15 @@ waterfall_configure_event_cb (GtkWidget         *widget,
   RECEIVER *rx=(RECEIVER *)data;
   display_width=gtk_widget_get_allocated_width (widget);
   display_height=gtk_widget_get_allocated_height (widget);
-  rx->pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, display_width, display_height);
 
-  unsigned char *pixels = gdk_pixbuf_get_pixels (rx->pixbuf);
+  if (rx->waterfall_surface) {
+    cairo_surface_destroy(rx->waterfall_surface);
+  }
+  rx->waterfall_surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, display_width, display_height);
+  g_free(rx->waterfall_row_shift);
+  rx->waterfall_row_shift = g_new0(gint, display_height);
 
-  memset(pixels, 0, display_width*display_height*3);
+  waterfall_clear(rx);
 
   return TRUE;
 }
@@ -76,6 +170,12 @@ waterfall_configure_event_cb (GtkWidget         *widget,
 /* Redraw the screen from the surface. Note that the ::draw
  * signal receives a ready-to-be-used cairo_t that is already
  * clipped to only draw the exposed areas of the widget
+ *
+ * The rows are stored as a ring, so the image is painted in two
+ * slices (from the head row to the bottom of the surface, then
+ * from the top of the surface to the row above the head). A slice
+ * is further split where rows have been drawn with a different
+ * horizontal shift, which only happens after frequency changes.
  */
 static gboolean
 waterfall_draw_cb (GtkWidget *widget,
@@ -83,8 +183,29 @@ waterfall_draw_cb (GtkWidget *widget,
  gpointer   data)
 {
   RECEIVER *rx=(RECEIVER *)data;
-  gdk_cairo_set_source_pixbuf (cr, rx->pixbuf, 0, 0);
-  cairo_paint (cr);
+  int width, height;
+  int y, n, row, dx;
+
+  cairo_set_source_rgb(cr, 0.0, 0.0, 0.0);
+  cairo_paint(cr);
+  if (rx->waterfall_surface == NULL) return FALSE;
+
+  width=cairo_image_surface_get_width(rx->waterfall_surface);
+  height=cairo_image_surface_get_height(rx->waterfall_surface);
+
+  y=0;
+  while (y < height) {
+    row=(rx->waterfall_head+y) % height;
+    n=1;
+    while (y+n < height && row+n < height && rx->waterfall_row_shift[row+n] == rx->waterfall_row_shift[row]) n++;
+    dx=rx->waterfall_shift - rx->waterfall_row_shift[row];
+    if (dx < width && dx > -width) {
+      cairo_set_source_surface(cr, rx->waterfall_surface, (double) dx, (double) (y-row));
+      cairo_rectangle(cr, 0.0, (double) y, (double) width, (double) n);
+      cairo_fill(cr);
+    }
+    y+=n;
+  }
   return FALSE;
 }
 
@@ -135,12 +256,10 @@ void waterfall_update(RECEIVER *rx) {
   }
 #endif
 
-  if(rx->pixbuf) {
-    unsigned char *pixels = gdk_pixbuf_get_pixels (rx->pixbuf);
-
-    int width=gdk_pixbuf_get_width(rx->pixbuf);
-    int height=gdk_pixbuf_get_height(rx->pixbuf);
-    int rowstride=gdk_pixbuf_get_rowstride(rx->pixbuf);
+  if(rx->waterfall_surface) {
+    int width=cairo_image_surface_get_width(rx->waterfall_surface);
+    int height=cairo_image_surface_get_height(rx->waterfall_surface);
+    int stride=cairo_image_surface_get_stride(rx->waterfall_surface);
 
     hz_per_pixel=(double)rx->sample_rate/((double)display_width*rx->zoom);
 
@@ -168,28 +287,16 @@ void waterfall_update(RECEIVER *rx) {
           //
           // If horizontal shift is too large, re-init waterfall
           //
-          memset(pixels, 0, display_width*display_height*3);
+          waterfall_clear(rx);
           rx->waterfall_frequency=vfofreq;
           rx->waterfall_pan=pan;
         } else {
           //
           // If rotate_pixels != 0, shift waterfall horizontally and set "freq changed" flag
-          // calculated which VFO/pan value combination the shifted waterfall corresponds to
-          //  
+          // calculated which VFO/pan value combination the shifted waterfall corresponds to.
+          // The shift is only recorded, and applied when drawing the rows.
           //
-          if(rotate_pixels<0) {
-            // shift left, and clear the right-most part
-            memmove(pixels,&pixels[-rotate_pixels*3],((display_width*display_height)+rotate_pixels)*3);
-            for(i=0;i<display_height;i++) {
-              memset(&pixels[((i*display_width)+(width+rotate_pixels))*3], 0, -rotate_pixels*3);
-            }
-          } else if (rotate_pixels > 0) {
-            // shift right, and clear left-most part
-            memmove(&pixels[rotate_pixels*3],pixels,((display_width*display_height)-rotate_pixels)*3);
-            for(i=0;i<display_height;i++) {
-              memset(&pixels[(i*display_width)*3], 0, rotate_pixels*3);
-            }
-          }
+          rx->waterfall_shift += rotate_pixels;
           if (rotfreq != 0) {
             freq_changed=1;
             rx->waterfall_frequency -= lround(rotfreq*hz_per_pixel); // this is not necessarily vfofreq!
@@ -202,7 +309,7 @@ void waterfall_update(RECEIVER *rx) {
       // waterfall frequency not (yet) set, sample rate changed, or zoom value changed:
       // (re-) init waterfall
       //
-      memset(pixels, 0, display_width*display_height*3);
+      waterfall_clear(rx);
       rx->waterfall_frequency=vfofreq;
       rx->waterfall_pan=pan;
       rx->waterfall_zoom=zoom;
@@ -221,72 +328,56 @@ void waterfall_update(RECEIVER *rx) {
     //
     if (!freq_changed) {
 
-      memmove(&pixels[rowstride],pixels,(height-1)*rowstride);
+      //
+      // The new line goes into the row "above" the current head
+      //
+      rx->waterfall_head=(rx->waterfall_head+height-1) % height;
+      rx->waterfall_row_shift[rx->waterfall_head]=rx->waterfall_shift;
+      cairo_surface_flush(rx->waterfall_surface);
 
       float sample;
+      float index;
       int average=0;
-      unsigned char *p;
-      p=pixels;
+      guint32 *p;
+      guint32 *lut;
+      p=(guint32 *)(cairo_image_surface_get_data(rx->waterfall_surface)+rx->waterfall_head*stride);
       samples=rx->pixel_samples;
 
+      //
+      // calibration offset, and scale factor from dB to LUT index
+      //
+      float offset;
+      if(have_rx_gain) {
+        offset=(float)(rx_gain_calibration-adc[rx->adc].gain);
+      } else {
+        offset=(float)adc[rx->adc].attenuation;
+      }
+      float low=(float)rx->waterfall_low;
+      float range=(float)rx->waterfall_high-low;
+      if (range < 1.0f) range=1.0f;
+      float high=low+range;
+      float scale=(float)WATERFALL_LUT_SIZE/range;
+
+      if (rx->waterfall_palette < 0 || rx->waterfall_palette >= WATERFALL_PALETTES) {
+        lut=palette[WATERFALL_PALETTE_COLOUR];
+      } else {
+        lut=palette[rx->waterfall_palette];
+      }
+
       for(i=0;i<width;i++) {
-            if(have_rx_gain) {
-              sample=samples[i+pan]+(float)(rx_gain_calibration-adc[rx->adc].gain);
-            } else {
-              sample=samples[i+pan]+(float)adc[rx->adc].attenuation;
-            }
-            average+=(int)sample;
-            if(sample<(float)rx->waterfall_low) {
-                *p++=colorLowR;
-                *p++=colorLowG;
-                *p++=colorLowB;
-            } else if(sample>(float)rx->waterfall_high) {
-                *p++=colorHighR;
-                *p++=colorHighG;
-                *p++=colorHighB;
-            } else {
-                float range=(float)rx->waterfall_high-(float)rx->waterfall_low;
-                float offset=sample-(float)rx->waterfall_low;
-                float percent=offset/range;
-                if(percent<(2.0f/9.0f)) {
-                    float local_percent = percent / (2.0f/9.0f);
-                    *p++ = (int)((1.0f-local_percent)*colorLowR);
-                    *p++ = (int)((1.0f-local_percent)*colorLowG);
-                    *p++ = (int)(colorLowB + local_percent*(255-colorLowB));
-                } else if(percent<(3.0f/9.0f)) {
-                    float local_percent = (percent - 2.0f/9.0f) / (1.0f/9.0f);
-                    *p++ = 0;
-                    *p++ = (int)(local_percent*255);
-                    *p++ = 255;
-                } else if(percent<(4.0f/9.0f)) {
-                     float local_percent = (percent - 3.0f/9.0f) / (1.0f/9.0f);
-                     *p++ = 0;
-                     *p++ = 255;
-                     *p++ = (int)((1.0f-local_percent)*255);
-                } else if(percent<(5.0f/9.0f)) {
-                     float local_percent = (percent - 4.0f/9.0f) / (1.0f/9.0f);
-                     *p++ = (int)(local_percent*255);
-                     *p++ = 255;
-                     *p++ = 0;
-                } else if(percent<(7.0f/9.0f)) {
-                     float local_percent = (percent - 5.0f/9.0f) / (2.0f/9.0f);
-                     *p++ = 255;
-                     *p++ = (int)((1.0f-local_percent)*255);
-                     *p++ = 0;
-                } else if(percent<(8.0f/9.0f)) {
-                     float local_percent = (percent - 7.0f/9.0f) / (1.0f/9.0f);
-                     *p++ = 255;
-                     *p++ = 0;
-                     *p++ = (int)(local_percent*255);
-                } else {
-                     float local_percent = (percent - 8.0f/9.0f) / (1.0f/9.0f);
-                     *p++ = (int)((0.75f + 0.25f*(1.0f-local_percent))*255.0f);
-                     *p++ = (int)(local_percent*255.0f*0.5f);
-                     *p++ = 255;
-                }
-            }
-        
+        sample=samples[i+pan]+offset;
+        average+=(int)sample;
+        index=(sample-low)*scale+1.0f;
+        if (!(index >= 0.0f)) {
+          index=0.0f;                                 // below the range, or NaN
+        } else if (sample > high) {
+          index=(float)(WATERFALL_LUT_SIZE+1);
+        } else if (index > (float)WATERFALL_LUT_SIZE) {
+          index=(float)WATERFALL_LUT_SIZE;            // sample == waterfall_high
+        }
+        *p++=lut[(int)index];
       }
+      cairo_surface_mark_dirty_rectangle(rx->waterfall_surface, 0, rx->waterfall_head, width, 1);
 
     
       if(rx->waterfall_automatic) {
@@ -303,7 +394,12 @@ void waterfall_init(RECEIVER *rx,int width,int height) {
   display_width=width;
   display_height=height;
 
-  rx->pixbuf=NULL;
+  if (!palette_initialized) waterfall_init_palettes();
+
+  rx->waterfall_surface=NULL;
+  rx->waterfall_row_shift=NULL;
+  rx->waterfall_head=0;
+  rx->waterfall_shift=0;
   rx->waterfall_frequency=0;
   rx->waterfall_sample_rate=0;
 
@@ -20,6 +20,13 @@
 #ifndef _WATERFALL_H
 #define _WATERFALL_H
 
+//
+// Waterfall colour palettes (receiver.waterfall_palette)
+//
+#define WATERFALL_PALETTE_COLOUR    0
+#define WATERFALL_PALETTE_GRAYSCALE 1
+#define WATERFALL_PALETTES          2
+
 extern void waterfall_update(RECEIVER *rx);
 extern void waterfall_init(RECEIVER *rx,int width,int height);
 